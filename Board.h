@@ -94,6 +94,7 @@ extern "C" {
 /* Board specific I2C addresses */
 #define Board_TMP_ADDR               (0x41)
 #define Board_SENSORS_BP_TMP_ADDR    (0x40)
+#define Board_PRESSURE_ADDR          (0x5C)
 
 #ifdef __cplusplus
 }
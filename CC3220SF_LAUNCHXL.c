@@ -61,6 +61,7 @@
 #include <ti/drivers/power/PowerCC32XX.h>
 
 #include "CC3220SF_LAUNCHXL.h"
+#include "supervisor.h"
 
 /*
  *  This define determines whether to use the UARTCC32XXDMA driver
@@ -68,7 +69,7 @@
  *  driver.
  */
 #ifndef TI_DRIVERS_UART_DMA
-#define TI_DRIVERS_UART_DMA 0
+#define TI_DRIVERS_UART_DMA 1
 #endif
 
 /*
@@ -176,10 +177,7 @@ static void dmaErrorFxn(uintptr_t arg)
     int status = MAP_uDMAErrorStatusGet();
     MAP_uDMAErrorStatusClear();
 
-    /* Suppress unused variable warning */
-    (void)status;
-
-    while (1);
+    Supervisor_fatal("uDMA error", status);
 }
 
 UDMACC32XX_Object udmaCC3220SObject;
@@ -582,6 +580,14 @@ const uint_least8_t SD_count = CC3220SF_LAUNCHXL_SDCOUNT;
 #include <ti/drivers/SPI.h>
 #include <ti/drivers/spi/SPICC32XXDMA.h>
 
+/*
+ *  Turbo mode drops the idle cycle between GSPI words. Only enable it for
+ *  front-ends that can take words back to back (see sensorspi.h).
+ */
+#ifndef BOARD_GSPI_TURBO
+#define BOARD_GSPI_TURBO 0
+#endif
+
 SPICC32XXDMA_Object spiCC3220SDMAObjects[CC3220SF_LAUNCHXL_SPICOUNT];
 
 #if defined(__TI_COMPILER_VERSION__)
@@ -622,7 +628,11 @@ const SPICC32XXDMA_HWAttrsV1 spiCC3220SDMAHWAttrs[CC3220SF_LAUNCHXL_SPICOUNT] =
         .csControl = SPI_HW_CTRL_CS,
         .csPolarity = SPI_CS_ACTIVELOW,
         .pinMode = SPI_4PIN_MODE,
+#if BOARD_GSPI_TURBO
+        .turboMode = SPI_TURBO_ON,
+#else
         .turboMode = SPI_TURBO_OFF,
+#endif
         .scratchBufPtr = &spiCC3220SDMAscratchBuf[CC3220SF_LAUNCHXL_SPI1],
         .defaultTxBufValue = 0,
         .rxChannelIndex = UDMA_CH6_GSPI_RX,
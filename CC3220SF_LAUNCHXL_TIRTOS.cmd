@@ -45,12 +45,17 @@
 
 HEAPSIZE = 0x8000;  /* Size of heap buffer used by HeapMem */
 
+/* Console command table entries are never referenced by name */
+--retain="*(.consolecmds)"
+
 MEMORY
 {
     /* Bootloader uses FLASH_HDR during initialization */
     FLASH_HDR (RX)  : origin = 0x01000000, length = 0x7FF      /* 2 KB */
     FLASH     (RX)  : origin = 0x01000800, length = 0x0FF800   /* 1022KB */
-    SRAM      (RWX) : origin = 0x20000000, length = 0x00040000 /* 256KB */
+    SRAM      (RWX) : origin = 0x20000000, length = 0x0003F000 /* 252KB */
+    /* Crash records, kept across MCU resets (see crashdump.h) */
+    SRAM_RET  (RW)  : origin = 0x2003F000, length = 0x00001000 /* 4KB */
 }
 
 /* Section allocation in memory */
@@ -65,8 +70,14 @@ SECTIONS
     .pinit      : > FLASH
     .init_array : > FLASH
 
+    /* Console command registry, see CONSOLE_COMMAND() in console.h */
+    .consolecmds : > FLASH, RUN_START(__consolecmds_start__), RUN_END(__consolecmds_end__)
+
     .data       : > SRAM
     .bss        : > SRAM
+
+    /* Not zeroed at startup so crash records survive an MCU reset */
+    .retained   : > SRAM_RET, type = NOINIT
     .sysmem     : > SRAM
 
     /* Heap buffer used by HeapMem */
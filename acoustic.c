@@ -0,0 +1,432 @@
+/*
+ *  ======== acoustic.c ========
+ *  I2S capture and fixed point band energy features for leak detection
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+
+#include <ti/drivers/I2S.h>
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "Board.h"
+#include "acoustic.h"
+#include "alarms.h"
+#include "console.h"
+#include "cycles.h"
+#include "fixmath.h"
+#include "supervisor.h"
+#include "timebase.h"
+
+#define ACOUSTIC_THREAD_PRIORITY    (1)
+#define ACOUSTIC_STACK_SIZE         (1536)
+
+/* Reclaim timeout, many block periods */
+#define ACOUSTIC_RECLAIM_MS         (500)
+
+#define ACOUSTIC_DEADLINE_MS        (5000)
+
+#define ACOUSTIC_CPU_HZ             (80000000)
+
+/* log2(ACOUSTIC_BLOCK_SIZE) */
+#define ACOUSTIC_FFT_STAGES         (8)
+
+/*
+ *  Largest input magnitude a stage takes with its outputs shifted right
+ *  by 0 and by 1. A butterfly output is at most (1 + sqrt(2)) times its
+ *  largest input; anything above the second limit is shifted by 2.
+ */
+#define ACOUSTIC_FFT_MAX_SHIFT0     (13572)
+#define ACOUSTIC_FFT_MAX_SHIFT1     (27145)
+
+/* Band edges in FFT bins (62.5 Hz each), roughly octaves up to 8 kHz */
+static const uint16_t bandEdge[ACOUSTIC_NUM_BANDS + 1] = {
+    1, 2, 4, 8, 16, 32, 64, 96, 128
+};
+
+static I2S_Handle       i2sHandle = NULL;
+static I2S_BufDesc      bufDesc[ACOUSTIC_NUM_BUFFERS];
+static int16_t          buffers[ACOUSTIC_NUM_BUFFERS][ACOUSTIC_BLOCK_SIZE];
+
+/* Q15 tables, filled once by initTables() */
+static int16_t          window[ACOUSTIC_BLOCK_SIZE];
+static int16_t          cosTable[ACOUSTIC_BLOCK_SIZE / 2];
+static int16_t          sinTable[ACOUSTIC_BLOCK_SIZE / 2];
+
+/* FFT work area */
+static int16_t          re[ACOUSTIC_BLOCK_SIZE];
+static int16_t          im[ACOUSTIC_BLOCK_SIZE];
+
+/* Accumulated over the current feature window */
+static uint64_t         bandSum[ACOUSTIC_NUM_BANDS];
+static uint64_t         squareSum;
+static uint32_t         windowBlocks;
+
+static Acoustic_Features features;
+static bool             featuresValid = false;
+static Acoustic_Stats   stats;
+
+/*
+ *  ======== initTables ========
+ *  The only floating point in the module, run once.
+ */
+static void initTables(void)
+{
+    const float pi = 3.14159265f;
+    int         i;
+
+    for (i = 0; i < ACOUSTIC_BLOCK_SIZE; i++) {
+        window[i] = (int16_t)(16383.5f *
+                (1.0f - cosf(2.0f * pi * i / ACOUSTIC_BLOCK_SIZE)));
+    }
+    for (i = 0; i < ACOUSTIC_BLOCK_SIZE / 2; i++) {
+        cosTable[i] = (int16_t)(32767.0f *
+                cosf(2.0f * pi * i / ACOUSTIC_BLOCK_SIZE));
+        sinTable[i] = (int16_t)(32767.0f *
+                sinf(2.0f * pi * i / ACOUSTIC_BLOCK_SIZE));
+    }
+}
+
+/*
+ *  ======== magnitude ========
+ *  Largest |re| or |im| in the work area
+ */
+static int32_t magnitude(void)
+{
+    int32_t max = 0;
+    int32_t v;
+    int     i;
+
+    for (i = 0; i < ACOUSTIC_BLOCK_SIZE; i++) {
+        v = (re[i] < 0) ? -(int32_t)re[i] : re[i];
+        max = (v > max) ? v : max;
+        v = (im[i] < 0) ? -(int32_t)im[i] : im[i];
+        max = (v > max) ? v : max;
+    }
+
+    return (max);
+}
+
+/*
+ *  ======== fft ========
+ *  In-place radix-2 decimation in time on re[]/im[], block floating
+ *  point: a stage only scales its outputs down when its inputs are
+ *  large enough to overflow. Quiet input keeps its low bits instead of
+ *  losing one per stage.
+ *
+ *  Returns the exponent: the result is the DFT divided by 2^exponent.
+ */
+static int fft(void)
+{
+    int     i, j, k;
+    int     len, half, step;
+    int     a, b;
+    int     shift;
+    int     exponent = 0;
+    int32_t max;
+    int32_t tr, ti;
+    int32_t v;
+    int16_t t;
+
+    /* Bit reversal permutation */
+    for (i = 0, j = 0; i < ACOUSTIC_BLOCK_SIZE; i++) {
+        if (i < j) {
+            t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+        k = ACOUSTIC_BLOCK_SIZE >> 1;
+        while ((k != 0) && (j & k)) {
+            j ^= k;
+            k >>= 1;
+        }
+        j |= k;
+    }
+
+    max = magnitude();
+    for (len = 2; len <= ACOUSTIC_BLOCK_SIZE; len <<= 1) {
+        half = len >> 1;
+        step = ACOUSTIC_BLOCK_SIZE / len;
+        shift = (max <= ACOUSTIC_FFT_MAX_SHIFT0) ? 0 :
+                (max <= ACOUSTIC_FFT_MAX_SHIFT1) ? 1 : 2;
+        exponent += shift;
+        max = 0;
+        for (i = 0; i < ACOUSTIC_BLOCK_SIZE; i += len) {
+            for (k = 0; k < half; k++) {
+                a = i + k;
+                b = a + half;
+
+                /* (re[b] + j im[b]) * e^(-j 2 pi k / len) */
+                tr = ((int32_t)re[b] * cosTable[k * step] +
+                      (int32_t)im[b] * sinTable[k * step]) >> 15;
+                ti = ((int32_t)im[b] * cosTable[k * step] -
+                      (int32_t)re[b] * sinTable[k * step]) >> 15;
+
+                re[b] = (int16_t)((re[a] - tr) >> shift);
+                im[b] = (int16_t)((im[a] - ti) >> shift);
+                re[a] = (int16_t)((re[a] + tr) >> shift);
+                im[a] = (int16_t)((im[a] + ti) >> shift);
+
+                /* The next stage's scaling */
+                v = (re[a] < 0) ? -(int32_t)re[a] : re[a];
+                max = (v > max) ? v : max;
+                v = (im[a] < 0) ? -(int32_t)im[a] : im[a];
+                max = (v > max) ? v : max;
+                v = (re[b] < 0) ? -(int32_t)re[b] : re[b];
+                max = (v > max) ? v : max;
+                v = (im[b] < 0) ? -(int32_t)im[b] : im[b];
+                max = (v > max) ? v : max;
+            }
+        }
+    }
+
+    return (exponent);
+}
+
+/*
+ *  ======== processBlock ========
+ */
+static void processBlock(const int16_t *samples)
+{
+    uint32_t power;
+    uint32_t peakPower = 0;
+    uint16_t peakBin = 0;
+    uint64_t sum;
+    int      exponent;
+    int      band;
+    int      i;
+    uintptr_t key;
+
+    for (i = 0; i < ACOUSTIC_BLOCK_SIZE; i++) {
+        squareSum += (uint32_t)((int32_t)samples[i] * samples[i]);
+        re[i] = (int16_t)(((int32_t)samples[i] * window[i]) >> 15);
+        im[i] = 0;
+    }
+
+    exponent = fft();
+
+    for (band = 0; band < ACOUSTIC_NUM_BANDS; band++) {
+        sum = 0;
+        for (i = bandEdge[band]; i < bandEdge[band + 1]; i++) {
+            power = (uint32_t)((int32_t)re[i] * re[i]) +
+                    (uint32_t)((int32_t)im[i] * im[i]);
+            if (power > peakPower) {
+                peakPower = power;
+                peakBin = (uint16_t)i;
+            }
+            sum += power;
+        }
+
+        /*
+         *  Back to DFT units, so blocks with different exponents add up.
+         *  A loud band at the largest exponent (2 per stage) does not fit
+         *  64 bits any more: saturate, the feature clips at UINT32_MAX
+         *  anyway, rather than let the shift or the sum wrap.
+         */
+        if ((sum > (UINT64_MAX >> (2 * exponent))) ||
+                ((sum << (2 * exponent)) > UINT64_MAX - bandSum[band])) {
+            bandSum[band] = UINT64_MAX;
+        }
+        else {
+            bandSum[band] += sum << (2 * exponent);
+        }
+    }
+
+    if (++windowBlocks < ACOUSTIC_BLOCKS_PER_FEATURE) {
+        return;
+    }
+
+    key = HwiP_disable();
+    for (band = 0; band < ACOUSTIC_NUM_BANDS; band++) {
+        /* Reported as (DFT / ACOUSTIC_BLOCK_SIZE)^2, rounded only here */
+        sum = (bandSum[band] / windowBlocks) >> (2 * ACOUSTIC_FFT_STAGES);
+        features.band[band] = (sum > UINT32_MAX) ? UINT32_MAX : (uint32_t)sum;
+        bandSum[band] = 0;
+    }
+    features.rms = (uint16_t)FixMath_isqrt(squareSum /
+            ((uint64_t)windowBlocks * ACOUSTIC_BLOCK_SIZE));
+    features.peakBin = peakBin;
+    features.timeMs = Timebase_monoMs();
+    features.sequence++;
+    featuresValid = true;
+    HwiP_restore(key);
+
+    sum = 0;
+    for (band = ACOUSTIC_LEAK_FIRST_BAND; band <= ACOUSTIC_LEAK_LAST_BAND;
+            band++) {
+        sum += features.band[band];
+    }
+    Alarms_feed(Alarms_Source_ACOUSTIC,
+            (sum > INT32_MAX) ? INT32_MAX : (int32_t)sum, features.timeMs);
+
+    squareSum = 0;
+    windowBlocks = 0;
+}
+
+/*
+ *  ======== acousticThread ========
+ */
+static void *acousticThread(void *arg)
+{
+    I2S_BufDesc  *desc;
+    Supervisor_Id watchdogId;
+    uint32_t      start;
+    uint32_t      cycles;
+    size_t        len;
+
+    watchdogId = Supervisor_register("acoustic", ACOUSTIC_DEADLINE_MS);
+
+    while (1) {
+        Supervisor_checkin(watchdogId, (int32_t)stats.blocks);
+
+        desc = NULL;
+        len = I2S_readReclaim(i2sHandle, &desc);
+        if (desc == NULL) {
+            /* Timed out; the buffers are still with the driver */
+            continue;
+        }
+
+        if (len == sizeof(buffers[0])) {
+            start = Cycles_now();
+            processBlock((const int16_t *)desc->bufPtr);
+            cycles = Cycles_now() - start;
+
+            stats.blocks++;
+            if (cycles > stats.maxCycles) {
+                stats.maxCycles = cycles;
+            }
+            stats.avgCycles = (stats.avgCycles == 0) ? cycles :
+                    stats.avgCycles - (stats.avgCycles >> 4) + (cycles >> 4);
+        }
+        else {
+            stats.dropped++;
+        }
+
+        desc->bufSize = sizeof(buffers[0]);
+        I2S_readIssue(i2sHandle, desc);
+    }
+}
+
+/*
+ *  ======== Acoustic_init ========
+ */
+int Acoustic_init(void)
+{
+    I2S_Params         i2sParams;
+    pthread_t          thread;
+    pthread_attr_t     pAttrs;
+    struct sched_param priParam;
+    int                i;
+
+    initTables();
+
+    Cycles_enable();
+    stats.budgetCycles = (uint32_t)((uint64_t)ACOUSTIC_CPU_HZ *
+            ACOUSTIC_BLOCK_SIZE / ACOUSTIC_SAMPLE_RATE);
+
+    I2S_Params_init(&i2sParams);
+    i2sParams.operationMode = I2S_OPMODE_RX_ONLY;
+    i2sParams.samplingFrequency = ACOUSTIC_SAMPLE_RATE;
+    i2sParams.slotLength = 16;
+    i2sParams.bitsPerSample = 16;
+    i2sParams.numChannels = 1;
+    i2sParams.readMode = I2S_MODE_ISSUERECLAIM;
+    i2sParams.readTimeout = ACOUSTIC_RECLAIM_MS;
+    i2sHandle = I2S_open(Board_I2S0, &i2sParams);
+    if (i2sHandle == NULL) {
+        return (-1);
+    }
+
+    for (i = 0; i < ACOUSTIC_NUM_BUFFERS; i++) {
+        bufDesc[i].bufPtr = buffers[i];
+        bufDesc[i].bufSize = sizeof(buffers[i]);
+        I2S_readIssue(i2sHandle, &bufDesc[i]);
+    }
+
+    pthread_attr_init(&pAttrs);
+    priParam.sched_priority = ACOUSTIC_THREAD_PRIORITY;
+    pthread_attr_setschedparam(&pAttrs, &priParam);
+    pthread_attr_setstacksize(&pAttrs, ACOUSTIC_STACK_SIZE);
+    pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &pAttrs, acousticThread, NULL) != 0) {
+        I2S_close(i2sHandle);
+        i2sHandle = NULL;
+        return (-1);
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== Acoustic_getFeatures ========
+ */
+bool Acoustic_getFeatures(Acoustic_Features *out)
+{
+    uintptr_t key;
+    bool      valid;
+
+    key = HwiP_disable();
+    *out = features;
+    valid = featuresValid;
+    HwiP_restore(key);
+
+    return (valid);
+}
+
+/*
+ *  ======== Acoustic_getStats ========
+ */
+void Acoustic_getStats(Acoustic_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdAcoustic ========
+ */
+static void cmdAcoustic(Console_Session *session, const Console_Args *args)
+{
+    char              printString[CONSOLE_PRINT_SIZE];
+    Acoustic_Stats    s;
+    Acoustic_Features f;
+    int               len;
+    int               i;
+
+    Acoustic_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "blocks %lu, dropped %lu, cycles avg %lu max %lu of %lu (%lu%%)",
+            (unsigned long)s.blocks, (unsigned long)s.dropped,
+            (unsigned long)s.avgCycles, (unsigned long)s.maxCycles,
+            (unsigned long)s.budgetCycles,
+            (unsigned long)(s.budgetCycles ?
+                    (uint64_t)s.maxCycles * 100 / s.budgetCycles : 0));
+    Console_print(session, printString);
+
+    if (!Acoustic_getFeatures(&f)) {
+        Console_print(session, "No features yet");
+        return;
+    }
+    len = snprintf(printString, sizeof(printString),
+            "#%lu rms %u peak %u Hz bands",
+            (unsigned long)f.sequence, f.rms,
+            (unsigned int)((uint32_t)f.peakBin * ACOUSTIC_SAMPLE_RATE /
+                    ACOUSTIC_BLOCK_SIZE));
+    for (i = 0; (i < ACOUSTIC_NUM_BANDS) &&
+            (len < (int)sizeof(printString)); i++) {
+        len += snprintf(printString + len, sizeof(printString) - len,
+                " %lu", (unsigned long)f.band[i]);
+    }
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(acoustic, "acoustic", cmdAcoustic, "", "",
+                "acoustic features and DSP load");
@@ -0,0 +1,86 @@
+/*
+ *  ======== acoustic.h ========
+ *  Acoustic leak detection front end.
+ *
+ *  A MEMS or piezo microphone on I2S0 is captured by DMA into a small
+ *  pool of buffers that are issued to and reclaimed from the driver.
+ *  Each block is windowed and transformed with a block floating point
+ *  FFT on Q15 data and its power is summed into ACOUSTIC_NUM_BANDS
+ *  octave bands. Blocks
+ *  are averaged into one compact feature vector per
+ *  ACOUSTIC_BLOCKS_PER_FEATURE blocks; raw audio never leaves the device.
+ *
+ *  The DSP cost of every block is measured with the cycle counter and
+ *  compared with the block period, see "acoustic" on the console.
+ */
+#ifndef __ACOUSTIC_H
+#define __ACOUSTIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ACOUSTIC_SAMPLE_RATE        (16000)
+
+/* FFT length and samples per block, a power of two */
+#define ACOUSTIC_BLOCK_SIZE         (256)
+
+/* Buffers circulating through the I2S driver */
+#define ACOUSTIC_NUM_BUFFERS        (3)
+
+#define ACOUSTIC_NUM_BANDS          (8)
+
+/* About one second at 16 kHz */
+#define ACOUSTIC_BLOCKS_PER_FEATURE (62)
+
+/* Bands where leak noise shows, fed to the alarm rules (1-6 kHz) */
+#define ACOUSTIC_LEAK_FIRST_BAND    (4)
+#define ACOUSTIC_LEAK_LAST_BAND     (6)
+
+/*!
+ *  @brief  Feature vector, averaged over ACOUSTIC_BLOCKS_PER_FEATURE
+ *          blocks
+ */
+typedef struct Acoustic_Features {
+    uint32_t    sequence;           /* increments with every vector */
+    uint32_t    timeMs;             /* completed, Timebase_monoMs() */
+    uint32_t    band[ACOUSTIC_NUM_BANDS];   /* mean power per band */
+    uint16_t    rms;                /* time domain, Q15 full scale */
+    uint16_t    peakBin;            /* strongest bin of the last block */
+} Acoustic_Features;
+
+/*!
+ *  @brief  DSP load
+ */
+typedef struct Acoustic_Stats {
+    uint32_t    blocks;
+    uint32_t    dropped;            /* blocks the driver reported short */
+    uint32_t    avgCycles;          /* per block, exponential average */
+    uint32_t    maxCycles;
+    uint32_t    budgetCycles;       /* one block period */
+} Acoustic_Stats;
+
+/*!
+ *  @brief  Open I2S0 and start the capture thread
+ *
+ *  @return 0 on success
+ */
+extern int Acoustic_init(void);
+
+/*!
+ *  @brief  Latest feature vector
+ *
+ *  @return false if none is complete yet
+ */
+extern bool Acoustic_getFeatures(Acoustic_Features *features);
+
+extern void Acoustic_getStats(Acoustic_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ACOUSTIC_H */
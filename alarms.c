@@ -0,0 +1,354 @@
+/*
+ *  ======== alarms.c ========
+ *  Threshold, rate of change and duration rules on the measurements
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "alarms.h"
+#include "console.h"
+#include "hibernate.h"
+#include "timebase.h"
+#include "uploader.h"
+
+/* Rate of change is smoothed over about this many feeds */
+#define ALARMS_RATE_SHIFT           (2)
+
+static const Alarms_Rule rules[] = {
+    /* Pipe burst: more than 0.5 L/s for 5 s */
+    {"burst", Alarms_Source_FLOW, Alarms_Type_ABOVE,
+        500000000, 50000000, 5000},
+    /* Leak: flow never stops for 2 hours */
+    {"leak", Alarms_Source_FLOW, Alarms_Type_ABOVE,
+        1000, 500, 2 * 60 * 60 * 1000},
+    /* Sudden pressure loss */
+    {"pdrop", Alarms_Source_PRESSURE, Alarms_Type_FALL,
+        5000, 1000, 0},
+    {"plow", Alarms_Source_PRESSURE, Alarms_Type_BELOW,
+        100000, 5000, 10000},
+    /* Hiss in the acoustic leak bands for 30 s */
+    {"hiss", Alarms_Source_ACOUSTIC, Alarms_Type_ABOVE,
+        4000, 1000, 30000},
+    /* Meter at risk of freezing */
+    {"freeze", Alarms_Source_TEMPERATURE, Alarms_Type_BELOW,
+        2000, 1000, 60000},
+};
+
+#define ALARMS_NUM_RULES    (sizeof(rules) / sizeof(rules[0]))
+
+/* Per source: last value and smoothed rate of change */
+typedef struct SourceState {
+    int32_t     lastValue;
+    uint32_t    lastMs;
+    int32_t     ratePerS;
+    bool        primed;
+} SourceState;
+
+/* Per rule */
+typedef struct RuleState {
+    uint32_t    sinceMs;            /* condition true since */
+    bool        pending;            /* condition true, not held long enough */
+    bool        active;
+} RuleState;
+
+static SourceState      sources[Alarms_Source_COUNT];
+static RuleState        states[ALARMS_NUM_RULES];
+
+/* Guarded by HwiP */
+static Alarms_Event     queue[ALARMS_QUEUE_SIZE];
+static unsigned int     queueHead = 0;      /* next to deliver */
+static unsigned int     queueCount = 0;
+static uint32_t         queueSeq = 0;       /* seq of the newest event */
+static uint32_t         activeMask = 0;
+static Alarms_Stats     stats;
+
+/*
+ *  ======== post ========
+ */
+static void post(int rule, bool raised, int32_t value, uint32_t timeMs)
+{
+    Alarms_Event *event;
+    uintptr_t     key;
+
+    key = HwiP_disable();
+    if (raised) {
+        activeMask |= (1U << rule);
+        stats.raised++;
+    }
+    else {
+        activeMask &= ~(1U << rule);
+        stats.cleared++;
+    }
+    if (queueCount == ALARMS_QUEUE_SIZE) {
+        /* Keep the newest: drop the oldest */
+        queueHead = (queueHead + 1) % ALARMS_QUEUE_SIZE;
+        queueCount--;
+        stats.dropped++;
+    }
+    event = &queue[(queueHead + queueCount) % ALARMS_QUEUE_SIZE];
+    event->seq = ++queueSeq;
+    event->timeMs = timeMs;
+    event->value = value;
+    event->rule = (uint8_t)rule;
+    event->raised = raised ? 1 : 0;
+    queueCount++;
+    HwiP_restore(key);
+
+    Uploader_urgent();
+}
+
+/*
+ *  ======== Alarms_feed ========
+ *  Each source is fed from one thread only, so the rule state needs no
+ *  lock; only the queue and the stats are shared.
+ */
+void Alarms_feed(Alarms_Source source, int32_t value, uint32_t timeMs)
+{
+    SourceState *src = &sources[source];
+    RuleState   *state;
+    int64_t      rate;
+    int32_t      x;
+    uintptr_t    key;
+    uint32_t     dt;
+    bool         trip;
+    bool         clear;
+    unsigned int i;
+
+    if (src->primed) {
+        dt = timeMs - src->lastMs;
+        if (dt != 0) {
+            /* A full scale step in 1 ms would overflow 32 bits twice */
+            rate = ((int64_t)value - src->lastValue) * 1000 / dt;
+            if (rate > INT32_MAX) {
+                rate = INT32_MAX;
+            }
+            else if (rate < INT32_MIN) {
+                rate = INT32_MIN;
+            }
+            src->ratePerS += (int32_t)((rate - src->ratePerS) >>
+                    ALARMS_RATE_SHIFT);
+        }
+    }
+    src->lastValue = value;
+    src->lastMs = timeMs;
+    src->primed = true;
+
+    key = HwiP_disable();
+    stats.feeds++;
+    HwiP_restore(key);
+
+    for (i = 0; i < ALARMS_NUM_RULES; i++) {
+        if (rules[i].source != source) {
+            continue;
+        }
+        state = &states[i];
+
+        switch (rules[i].type) {
+            case Alarms_Type_ABOVE:
+                x = value;
+                trip = x > rules[i].threshold;
+                clear = x < rules[i].threshold - rules[i].hysteresis;
+                break;
+            case Alarms_Type_BELOW:
+                x = value;
+                trip = x < rules[i].threshold;
+                clear = x > rules[i].threshold + rules[i].hysteresis;
+                break;
+            case Alarms_Type_RISE:
+                x = src->ratePerS;
+                trip = x > rules[i].threshold;
+                clear = x < rules[i].threshold - rules[i].hysteresis;
+                break;
+            default:
+                x = src->ratePerS;
+                trip = x < -rules[i].threshold;
+                clear = x > -rules[i].threshold + rules[i].hysteresis;
+                break;
+        }
+
+        if (state->active) {
+            if (clear) {
+                state->active = false;
+                state->pending = false;
+                post(i, false, x, timeMs);
+            }
+            continue;
+        }
+        if (!trip) {
+            state->pending = false;
+            continue;
+        }
+        if (!state->pending) {
+            state->pending = true;
+            state->sinceMs = timeMs;
+        }
+        if ((timeMs - state->sinceMs) >= rules[i].holdMs) {
+            state->active = true;
+            post(i, true, x, timeMs);
+        }
+    }
+}
+
+/*
+ *  ======== Alarms_peek ========
+ */
+int Alarms_peek(Alarms_Event *events, int max)
+{
+    uintptr_t key;
+    int       i;
+
+    key = HwiP_disable();
+    for (i = 0; (i < max) && (i < (int)queueCount); i++) {
+        events[i] = queue[(queueHead + i) % ALARMS_QUEUE_SIZE];
+    }
+    HwiP_restore(key);
+
+    return (i);
+}
+
+/*
+ *  ======== Alarms_ack ========
+ *  By seq rather than by count: an overflow since the peek has dropped
+ *  the oldest events and queued new ones, which must stay.
+ */
+void Alarms_ack(uint32_t lastSeq)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    while ((queueCount > 0) &&
+            ((int32_t)(queue[queueHead].seq - lastSeq) <= 0)) {
+        queueHead = (queueHead + 1) % ALARMS_QUEUE_SIZE;
+        queueCount--;
+    }
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== Alarms_rule ========
+ */
+const Alarms_Rule *Alarms_rule(int index)
+{
+    return (((unsigned int)index < ALARMS_NUM_RULES) ? &rules[index] : NULL);
+}
+
+/*
+ *  ======== Alarms_active ========
+ */
+uint32_t Alarms_active(void)
+{
+    return (activeMask);
+}
+
+/*
+ *  ======== Alarms_pending ========
+ */
+uint32_t Alarms_pending(void)
+{
+    uint32_t     mask = 0;
+    unsigned int i;
+
+    for (i = 0; i < ALARMS_NUM_RULES; i++) {
+        if (states[i].pending && !states[i].active) {
+            mask |= (1U << i);
+        }
+    }
+
+    return (mask);
+}
+
+/*
+ *  ======== Alarms_persist ========
+ *  Hold times are kept relative, so time asleep does not count.
+ */
+void Alarms_persist(void)
+{
+    Hibernate_Alarms saved;
+    uint32_t         now = Timebase_monoMs();
+    unsigned int     i;
+
+    memset(&saved, 0, sizeof(saved));
+    saved.activeMask = activeMask;
+    for (i = 0; (i < ALARMS_NUM_RULES) && (i < HIBERNATE_MAX_RULES); i++) {
+        if (states[i].pending && !states[i].active) {
+            saved.pendingMask |= (1U << i);
+            saved.heldMs[i] = now - states[i].sinceMs;
+        }
+    }
+    Hibernate_noteAlarms(&saved);
+}
+
+/*
+ *  ======== Alarms_restore ========
+ *  Raised rules come back raised without a new event; the server
+ *  already has the one from before.
+ */
+void Alarms_restore(void)
+{
+    Hibernate_Alarms saved;
+    uint32_t         now = Timebase_monoMs();
+    uintptr_t        key;
+    unsigned int     i;
+
+    if (!Hibernate_lastAlarms(&saved)) {
+        return;
+    }
+    for (i = 0; (i < ALARMS_NUM_RULES) && (i < HIBERNATE_MAX_RULES); i++) {
+        if (saved.activeMask & (1U << i)) {
+            states[i].active = true;
+            states[i].pending = true;
+        }
+        else if (saved.pendingMask & (1U << i)) {
+            states[i].pending = true;
+            states[i].sinceMs = now - saved.heldMs[i];
+        }
+    }
+    key = HwiP_disable();
+    activeMask |= saved.activeMask;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== Alarms_getStats ========
+ */
+void Alarms_getStats(Alarms_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdAlarms ========
+ */
+static void cmdAlarms(Console_Session *session, const Console_Args *args)
+{
+    char         printString[CONSOLE_PRINT_SIZE];
+    Alarms_Stats s;
+    uint32_t     active = Alarms_active();
+    unsigned int i;
+
+    Alarms_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "feeds %lu, raised %lu, cleared %lu, dropped %lu",
+            (unsigned long)s.feeds, (unsigned long)s.raised,
+            (unsigned long)s.cleared, (unsigned long)s.dropped);
+    Console_print(session, printString);
+
+    for (i = 0; i < ALARMS_NUM_RULES; i++) {
+        snprintf(printString, sizeof(printString), "%-8s %s",
+                rules[i].name, (active & (1U << i)) ? "RAISED" :
+                (states[i].pending ? "pending" : "ok"));
+        Console_print(session, printString);
+    }
+}
+
+CONSOLE_COMMAND(alarms, "alarms", cmdAlarms, "", "",
+                "alarm rules and their state");
@@ -0,0 +1,127 @@
+/*
+ *  ======== alarms.h ========
+ *  Rule engine for leak and burst alarms.
+ *
+ *  Measurement modules feed every new value with Alarms_feed(). Each
+ *  rule watches one source and compares either the value or its rate of
+ *  change (per second, smoothed) with a threshold; the condition must
+ *  hold for holdMs before the alarm is raised, and the value has to come
+ *  back past the threshold by the hysteresis before it clears. A feed
+ *  only touches the rules of its source and keeps no history, so the
+ *  cost per reading is constant.
+ *
+ *  Raised and cleared alarms are queued and the uploader is woken right
+ *  away, ahead of the routine reports.
+ *
+ *  Which rules are raised and how long the pending ones have held is
+ *  kept across hibernate (hibernate.h). The time asleep does not count
+ *  towards a hold, since nothing was measured.
+ */
+#ifndef __ALARMS_H
+#define __ALARMS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Events waiting for the uploader */
+#define ALARMS_QUEUE_SIZE           (8)
+
+typedef enum Alarms_Source {
+    Alarms_Source_FLOW = 0,         /* nL/s */
+    Alarms_Source_PRESSURE,         /* Pa */
+    Alarms_Source_TEMPERATURE,      /* milli degrees C */
+    Alarms_Source_ACOUSTIC,         /* leak band power */
+    Alarms_Source_COUNT
+} Alarms_Source;
+
+typedef enum Alarms_Type {
+    Alarms_Type_ABOVE = 0,          /* value > threshold */
+    Alarms_Type_BELOW,              /* value < threshold */
+    Alarms_Type_RISE,               /* rate of change > threshold per s */
+    Alarms_Type_FALL                /* rate of change < -threshold per s */
+} Alarms_Type;
+
+typedef struct Alarms_Rule {
+    const char     *name;
+    Alarms_Source   source;
+    Alarms_Type     type;
+    int32_t         threshold;
+    int32_t         hysteresis;
+    uint32_t        holdMs;
+} Alarms_Rule;
+
+typedef struct Alarms_Event {
+    uint32_t    seq;                /* counts up from 1, never reused */
+    uint32_t    timeMs;             /* Timebase_monoMs() */
+    int32_t     value;              /* value or rate that triggered it */
+    uint8_t     rule;               /* index into the rule table */
+    uint8_t     raised;             /* 1 raised, 0 cleared */
+} Alarms_Event;
+
+typedef struct Alarms_Stats {
+    uint32_t    feeds;
+    uint32_t    raised;
+    uint32_t    cleared;
+    uint32_t    dropped;            /* events lost to a full queue */
+} Alarms_Stats;
+
+/*!
+ *  @brief  Evaluate the rules of source against a new value, read at
+ *          timeMs (Timebase_monoMs())
+ */
+extern void Alarms_feed(Alarms_Source source, int32_t value, uint32_t timeMs);
+
+/*!
+ *  @brief  Copy up to max queued events, oldest first, without removing
+ *          them
+ *
+ *  @return number copied
+ */
+extern int Alarms_peek(Alarms_Event *events, int max);
+
+/*!
+ *  @brief  Remove the events up to and including seq lastSeq once they
+ *          are delivered
+ *
+ *  Events queued after the peek, and events the peek never saw, stay
+ *  queued even if an overflow has moved the queue in between.
+ */
+extern void Alarms_ack(uint32_t lastSeq);
+
+/*!
+ *  @brief  Rule for an event, or NULL
+ */
+extern const Alarms_Rule *Alarms_rule(int index);
+
+/*!
+ *  @brief  Bit per rule that is currently raised
+ */
+extern uint32_t Alarms_active(void);
+
+/*!
+ *  @brief  Bit per rule whose condition holds but not yet for long
+ *          enough
+ */
+extern uint32_t Alarms_pending(void);
+
+/*!
+ *  @brief  Hand the rule state to hibernate.c before shutting down
+ */
+extern void Alarms_persist(void);
+
+/*!
+ *  @brief  Take the rule state back after a wake-up from hibernate
+ */
+extern void Alarms_restore(void);
+
+extern void Alarms_getStats(Alarms_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ALARMS_H */
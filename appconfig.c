@@ -0,0 +1,276 @@
+/*
+ *  ======== appconfig.c ========
+ *  Persistent application configuration
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "appconfig.h"
+#include "console.h"
+
+#define APPCONFIG_VERSION           (1)
+
+typedef struct AppConfig_Field {
+    const char     *name;
+    uint16_t        offset;
+    uint16_t        size;
+} AppConfig_Field;
+
+/* Every field is a NUL terminated string */
+#define APPCONFIG_STR(name, field)                                          \
+    { (name), offsetof(AppConfig, field), sizeof(((AppConfig *)0)->field) }
+
+static const AppConfig_Field fields[] = {
+    APPCONFIG_STR("name", deviceName),
+    APPCONFIG_STR("server", serverHost),
+};
+
+#define APPCONFIG_FIELD_COUNT   (sizeof(fields) / sizeof(fields[0]))
+
+static const AppConfig defaults = {
+    .version = APPCONFIG_VERSION,
+    .deviceName = "flowness",
+    .serverHost = "https://httpbin.org",
+};
+
+/* Only whole records are copied in and out, see AppConfig_publish() */
+static AppConfig appConfig;
+
+static char adminKey[APPCONFIG_ADMIN_KEY_SIZE];
+
+/*
+ *  ======== findField ========
+ */
+static const AppConfig_Field *findField(const char *key)
+{
+    unsigned int i;
+
+    for (i = 0; i < APPCONFIG_FIELD_COUNT; i++) {
+        if (strcmp(fields[i].name, key) == 0) {
+            return (&fields[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== loadAdminKey ========
+ */
+static void loadAdminKey(void)
+{
+    _u32 token = 0;
+    _i32 fd;
+    _i32 len;
+
+    memset(adminKey, 0, sizeof(adminKey));
+
+    fd = sl_FsOpen((const _u8 *)APPCONFIG_ADMIN_KEY_FILE, SL_FS_READ,
+            &token);
+    if (fd < 0) {
+        return;
+    }
+    len = sl_FsRead(fd, 0, (_u8 *)adminKey, sizeof(adminKey) - 1);
+    sl_FsClose(fd, NULL, NULL, 0);
+
+    /* Provisioning tools tend to leave a line end */
+    while ((len > 0) && ((adminKey[len - 1] == '\n') ||
+            (adminKey[len - 1] == '\r'))) {
+        len--;
+    }
+    adminKey[(len > 0) ? len : 0] = '\0';
+}
+
+/*
+ *  ======== AppConfig_init ========
+ */
+void AppConfig_init(void)
+{
+    AppConfig stored;
+    _u32      token = 0;
+    _i32      fd;
+    _i32      len;
+
+    appConfig = defaults;
+    loadAdminKey();
+
+    fd = sl_FsOpen((const _u8 *)APPCONFIG_FILE_NAME, SL_FS_READ, &token);
+    if (fd < 0) {
+        return;
+    }
+
+    len = sl_FsRead(fd, 0, (_u8 *)&stored, sizeof(stored));
+    sl_FsClose(fd, NULL, NULL, 0);
+
+    /* Fields missing from an older, shorter record keep their defaults */
+    if ((len >= (_i32)sizeof(stored.version)) &&
+            (stored.version <= APPCONFIG_VERSION)) {
+        memcpy(&appConfig, &stored, len);
+        appConfig.version = APPCONFIG_VERSION;
+        appConfig.deviceName[sizeof(appConfig.deviceName) - 1] = '\0';
+        appConfig.serverHost[sizeof(appConfig.serverHost) - 1] = '\0';
+    }
+}
+
+/*
+ *  ======== AppConfig_save ========
+ */
+int32_t AppConfig_save(void)
+{
+    AppConfig config;
+    _u32      token = 0;
+    _i32      fd;
+    _i32      ret;
+
+    AppConfig_copy(&config);
+
+    fd = sl_FsOpen((const _u8 *)APPCONFIG_FILE_NAME,
+            SL_FS_CREATE | SL_FS_OVERWRITE |
+            SL_FS_CREATE_MAX_SIZE(sizeof(AppConfig)), &token);
+    if (fd < 0) {
+        return (fd);
+    }
+
+    ret = sl_FsWrite(fd, 0, (_u8 *)&config, sizeof(config));
+    sl_FsClose(fd, NULL, NULL, 0);
+
+    return ((ret == sizeof(config)) ? 0 : ((ret < 0) ? ret : -1));
+}
+
+/*
+ *  ======== AppConfig_copy ========
+ */
+void AppConfig_copy(AppConfig *config)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *config = appConfig;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== AppConfig_publish ========
+ */
+void AppConfig_publish(const AppConfig *config)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    appConfig = *config;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== AppConfig_authorize ========
+ */
+bool AppConfig_authorize(const char *key)
+{
+    uint8_t diff = 0;
+    size_t  len = strlen(adminKey);
+    size_t  i;
+
+    if ((len == 0) || (strlen(key) != len)) {
+        return (false);
+    }
+
+    /* Same time for every mismatch position */
+    for (i = 0; i < len; i++) {
+        diff |= (uint8_t)(key[i] ^ adminKey[i]);
+    }
+
+    return (diff == 0);
+}
+
+/*
+ *  ======== AppConfig_set ========
+ */
+bool AppConfig_set(AppConfig *config, const char *key, const char *value)
+{
+    const AppConfig_Field *field = findField(key);
+
+    if ((field == NULL) || (strlen(value) >= field->size)) {
+        return (false);
+    }
+    strcpy((char *)config + field->offset, value);
+
+    return (true);
+}
+
+/*
+ *  ======== AppConfig_get ========
+ */
+bool AppConfig_get(const char *key, char *buf, size_t len)
+{
+    const AppConfig_Field *field = findField(key);
+    AppConfig              config;
+
+    if (field == NULL) {
+        return (false);
+    }
+    AppConfig_copy(&config);
+    snprintf(buf, len, "%s", (const char *)&config + field->offset);
+
+    return (true);
+}
+
+/*
+ *  ======== AppConfig_keyName ========
+ */
+const char *AppConfig_keyName(int index)
+{
+    if ((index < 0) || (index >= (int)APPCONFIG_FIELD_COUNT)) {
+        return (NULL);
+    }
+
+    return (fields[index].name);
+}
+
+/*
+ *  ======== cmdConfig ========
+ */
+static void cmdConfig(Console_Session *session, const Console_Args *args)
+{
+    char        printString[CONSOLE_PRINT_SIZE];
+    char        value[sizeof(((AppConfig *)0)->serverHost)];
+    AppConfig   config;
+    const char *key;
+    int         i;
+
+    if (args->argc == 0) {
+        for (i = 0; (key = AppConfig_keyName(i)) != NULL; i++) {
+            AppConfig_get(key, value, sizeof(value));
+            snprintf(printString, sizeof(printString), "%s = %s", key, value);
+            Console_print(session, printString);
+        }
+        return;
+    }
+
+    if (args->argc == 1) {
+        if (!AppConfig_get(args->str[0], value, sizeof(value))) {
+            Console_print(session, "Unknown key");
+            return;
+        }
+        Console_print(session, value);
+        return;
+    }
+
+    AppConfig_copy(&config);
+    if (!AppConfig_set(&config, args->str[0], args->str[1])) {
+        Console_print(session, "Unknown key or bad value");
+        return;
+    }
+    AppConfig_publish(&config);
+    if (AppConfig_save() < 0) {
+        Console_print(session, "Saving configuration failed");
+    }
+}
+
+CONSOLE_COMMAND(config, "cfg", cmdConfig, "ss", "[key] [value]",
+                "show or change configuration");
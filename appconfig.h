@@ -0,0 +1,101 @@
+/*
+ *  ======== appconfig.h ========
+ *  Persistent application configuration.
+ *
+ *  The configuration lives in one record in the NWP file system. Fields
+ *  are read and written by name so the console and the REST interface
+ *  share one set of keys and one validation path.
+ *
+ *  Writers from several threads (console, REST in sl_Task, the remote
+ *  configuration poll) change a copy and publish it whole, so a reader
+ *  never sees a half-written string or a half-applied set of changes.
+ *
+ *  Remote writes (TCP console, REST) need the admin key, a separate file
+ *  provisioned with the device and never shown by the configuration
+ *  commands. Without the file, remote access stays locked.
+ */
+#ifndef __APPCONFIG_H
+#define __APPCONFIG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define APPCONFIG_FILE_NAME         "/flowness/config.bin"
+#define APPCONFIG_ADMIN_KEY_FILE    "/flowness/admin.key"
+
+/* Longest admin key, including the terminating NUL */
+#define APPCONFIG_ADMIN_KEY_SIZE    (64)
+
+/*!
+ *  @brief  Configuration record as stored in flash
+ *
+ *  New fields must be appended: a shorter record from an older firmware
+ *  loads with defaults for the fields it does not have.
+ */
+typedef struct AppConfig {
+    uint32_t    version;
+    char        deviceName[32];
+    char        serverHost[64];
+} AppConfig;
+
+/*!
+ *  @brief  Load the record from flash, or apply defaults
+ */
+extern void AppConfig_init(void);
+
+/*!
+ *  @brief  Consistent copy of the live configuration
+ */
+extern void AppConfig_copy(AppConfig *config);
+
+/*!
+ *  @brief  Replace the live configuration with config, which should
+ *          come from AppConfig_copy() and AppConfig_set()
+ */
+extern void AppConfig_publish(const AppConfig *config);
+
+/*!
+ *  @brief  Check a key presented by a remote client
+ *
+ *  @return true if an admin key is provisioned and key matches it
+ */
+extern bool AppConfig_authorize(const char *key);
+
+/*!
+ *  @brief  Set one field of config from its text form. config is
+ *          left unchanged on error.
+ *
+ *  @return true if key is known and value valid
+ */
+extern bool AppConfig_set(AppConfig *config, const char *key,
+                          const char *value);
+
+/*!
+ *  @brief  Format one field of the live configuration as text
+ *
+ *  @return true if key is known
+ */
+extern bool AppConfig_get(const char *key, char *buf, size_t len);
+
+/*!
+ *  @brief  Name of field index, or NULL past the last one
+ */
+extern const char *AppConfig_keyName(int index);
+
+/*!
+ *  @brief  Write the live configuration to flash. Needs the NWP.
+ *
+ *  @return 0 on success, negative SimpleLink error otherwise
+ */
+extern int32_t AppConfig_save(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPCONFIG_H */
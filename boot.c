@@ -0,0 +1,84 @@
+/*
+ *  ======== boot.c ========
+ *  Boot phase profile
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "boot.h"
+#include "console.h"
+#include "netsched.h"
+
+static const char *const phaseNames[Boot_Phase_COUNT] = {
+    "drivers",
+    "nwp start",
+    "console",
+    "nwp ready",
+    "role switch",
+    "config",
+    "wlan connected",
+    "ip acquired",
+    "first reading",
+    "first upload"
+};
+
+static volatile uint32_t phaseMs[Boot_Phase_COUNT];
+static volatile uint32_t reachedMask = 0;
+
+/*
+ *  ======== Boot_mark ========
+ *  Called from several threads and from the SimpleLink callbacks; a
+ *  phase reached twice keeps its first stamp.
+ */
+void Boot_mark(Boot_Phase phase)
+{
+    uint32_t  bit = 1 << phase;
+    uintptr_t key;
+
+    key = HwiP_disable();
+    if ((reachedMask & bit) == 0) {
+        phaseMs[phase] = NetSched_nowMs();
+        reachedMask |= bit;
+    }
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== Boot_elapsedMs ========
+ */
+bool Boot_elapsedMs(Boot_Phase phase, uint32_t *ms)
+{
+    if ((reachedMask & (1 << phase)) == 0) {
+        return (false);
+    }
+    *ms = phaseMs[phase];
+
+    return (true);
+}
+
+/*
+ *  ======== cmdBoot ========
+ */
+static void cmdBoot(Console_Session *session, const Console_Args *args)
+{
+    char     printString[CONSOLE_PRINT_SIZE];
+    uint32_t ms;
+    int      i;
+
+    for (i = 0; i < Boot_Phase_COUNT; i++) {
+        if (Boot_elapsedMs((Boot_Phase)i, &ms)) {
+            snprintf(printString, sizeof(printString), "%-16s %6lu ms",
+                    phaseNames[i], (unsigned long)ms);
+        }
+        else {
+            snprintf(printString, sizeof(printString), "%-16s      -",
+                    phaseNames[i]);
+        }
+        Console_print(session, printString);
+    }
+}
+
+CONSOLE_COMMAND(boot, "boot", cmdBoot, "", "", "boot phase timing");
@@ -0,0 +1,54 @@
+/*
+ *  ======== boot.h ========
+ *  Boot phase profile.
+ *
+ *  Each phase is stamped once, the first time it is reached, in ms since
+ *  the kernel started. The profile shows where the time from reset to
+ *  the first reading and the first upload goes; see "boot" on the
+ *  console.
+ */
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*!
+ *  @brief  Boot phases, roughly in the order they are reached. The NWP
+ *          phases run in parallel with the local ones.
+ */
+typedef enum Boot_Phase {
+    Boot_Phase_DRIVERS = 0,         /* UART and SPI open */
+    Boot_Phase_NWP_START,           /* sl_Start() issued */
+    Boot_Phase_CONSOLE,             /* console threads running */
+    Boot_Phase_NWP_READY,           /* NWP init complete */
+    Boot_Phase_ROLE_SWITCH,         /* NWP restarted into STA role */
+    Boot_Phase_CONFIG,              /* configuration loaded */
+    Boot_Phase_WLAN_CONNECTED,
+    Boot_Phase_IP_ACQUIRED,
+    Boot_Phase_FIRST_READING,       /* first measurement available */
+    Boot_Phase_FIRST_UPLOAD,        /* first upload acknowledged */
+    Boot_Phase_COUNT
+} Boot_Phase;
+
+/*!
+ *  @brief  Stamp phase, unless it was already reached
+ */
+extern void Boot_mark(Boot_Phase phase);
+
+/*!
+ *  @brief  Time phase was reached
+ *
+ *  @return false if it was not reached yet
+ */
+extern bool Boot_elapsedMs(Boot_Phase phase, uint32_t *ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOT_H */
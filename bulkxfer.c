@@ -0,0 +1,246 @@
+/*
+ *  ======== bulkxfer.c ========
+ *  Bulk transfers over the console UART
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bulkxfer.h"
+#include "console.h"
+#include "crashdump.h"
+#include "uartio.h"
+
+/* Host answer to the BULK announcement */
+#define BULKXFER_ACCEPT_MS          (1000)
+
+/* Time the host gets to send SYNC at the new rate */
+#define BULKXFER_SYNC_MS            (1000)
+
+/* No ACK within this time resends the window */
+#define BULKXFER_ACK_MS             (250)
+
+/* Resends of one frame before giving up */
+#define BULKXFER_MAX_RETRIES        (8)
+
+#define BULKXFER_FRAME_OVERHEAD     (6)
+
+/*
+ *  ======== crashSize ========
+ */
+static uint32_t crashSize(void)
+{
+    return ((CrashDump_last() != NULL) ? sizeof(CrashDump_Record) : 0);
+}
+
+/*
+ *  ======== crashRead ========
+ */
+static void crashRead(uint32_t offset, uint8_t *buf, size_t len)
+{
+    memcpy(buf, (const uint8_t *)CrashDump_last() + offset, len);
+}
+
+static const BulkXfer_Source sources[] = {
+    {"crash", crashSize, crashRead},
+};
+
+#define BULKXFER_NUM_SOURCES    (sizeof(sources) / sizeof(sources[0]))
+
+/*
+ *  ======== BulkXfer_crc16 ========
+ */
+uint16_t BulkXfer_crc16(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    int i;
+
+    while (len--) {
+        crc ^= (uint16_t)(*buf++) << 8;
+        for (i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+
+    return (crc);
+}
+
+/*
+ *  ======== sendFrame ========
+ *  Frame index i carries bytes i * BULKXFER_FRAME_PAYLOAD onwards; the
+ *  frame past the end is empty and marks the end of the transfer.
+ */
+static void sendFrame(const BulkXfer_Source *src, uint32_t index,
+                      uint32_t total)
+{
+    uint8_t  frame[BULKXFER_FRAME_PAYLOAD + BULKXFER_FRAME_OVERHEAD];
+    uint32_t offset = index * BULKXFER_FRAME_PAYLOAD;
+    uint16_t len = 0;
+    uint16_t crc;
+
+    if (offset < total) {
+        len = ((total - offset) < BULKXFER_FRAME_PAYLOAD) ?
+                (uint16_t)(total - offset) : BULKXFER_FRAME_PAYLOAD;
+        src->readFxn(offset, &frame[4], len);
+    }
+
+    frame[0] = BULKXFER_SOF;
+    frame[1] = (uint8_t)index;
+    frame[2] = (uint8_t)len;
+    frame[3] = (uint8_t)(len >> 8);
+    crc = BulkXfer_crc16(0xFFFF, &frame[1], 3 + len);
+    frame[4 + len] = (uint8_t)crc;
+    frame[5 + len] = (uint8_t)(crc >> 8);
+
+    UartIo_write(frame, len + BULKXFER_FRAME_OVERHEAD);
+}
+
+/*
+ *  ======== sendFrames ========
+ *  Go-back-N over a window of BULKXFER_WINDOW frames.
+ */
+static bool sendFrames(const BulkXfer_Source *src, uint32_t total)
+{
+    uint32_t frames = total / BULKXFER_FRAME_PAYLOAD + 1;
+    uint32_t base = 0;
+    uint32_t next = 0;
+    uint32_t index;
+    int      retries = 0;
+    char     type;
+    char     seq;
+
+    while (base < frames) {
+        while ((next < frames) && (next < base + BULKXFER_WINDOW)) {
+            sendFrame(src, next++, total);
+        }
+
+        if (!UartIo_readTimeout(&type, BULKXFER_ACK_MS) ||
+                !UartIo_readTimeout(&seq, BULKXFER_ACK_MS)) {
+            if (++retries > BULKXFER_MAX_RETRIES) {
+                return (false);
+            }
+            next = base;
+            continue;
+        }
+
+        /* Only sequence numbers inside the window mean anything */
+        index = base + (uint8_t)((uint8_t)seq - (uint8_t)base);
+        if (index >= next) {
+            continue;
+        }
+
+        if (type == BULKXFER_ACK) {
+            base = index + 1;
+            retries = 0;
+        }
+        else if (type == BULKXFER_NAK) {
+            if (++retries > BULKXFER_MAX_RETRIES) {
+                return (false);
+            }
+            base = index;
+            next = index;
+        }
+    }
+
+    return (true);
+}
+
+/*
+ *  ======== waitSync ========
+ */
+static bool waitSync(void)
+{
+    char c;
+
+    while (UartIo_readTimeout(&c, BULKXFER_SYNC_MS)) {
+        if ((uint8_t)c == BULKXFER_SYNC) {
+            UartIo_discardInput();
+            c = (char)BULKXFER_SYNC_ACK;
+            UartIo_write(&c, 1);
+            return (true);
+        }
+    }
+
+    return (false);
+}
+
+/*
+ *  ======== cmdBulk ========
+ *  Runs on the UART console thread, which is what lets it read the
+ *  host's answers straight from the UART.
+ */
+static void cmdBulk(Console_Session *session, const Console_Args *args)
+{
+    char                   printString[CONSOLE_PRINT_SIZE];
+    const BulkXfer_Source *src = NULL;
+    uint32_t               consoleBaud = UartIo_baud();
+    uint32_t               baud = BULKXFER_DEFAULT_BAUD;
+    uint32_t               total;
+    unsigned int           i;
+    bool                   synced;
+    bool                   ok = false;
+    char                   answer;
+
+    if (!Console_isUart(session)) {
+        Console_print(session, "Bulk transfers need the UART console");
+        return;
+    }
+    for (i = 0; i < BULKXFER_NUM_SOURCES; i++) {
+        if (strcmp(args->str[0], sources[i].name) == 0) {
+            src = &sources[i];
+        }
+    }
+    if (src == NULL) {
+        Console_print(session, "Unknown source");
+        return;
+    }
+    if (args->argc > 1) {
+        baud = (uint32_t)args->num[1];
+    }
+    total = src->sizeFxn();
+    if (total == 0) {
+        Console_print(session, "Nothing to send");
+        return;
+    }
+
+    /* Other threads' prints would corrupt the framed stream */
+    if (!UartIo_claim()) {
+        Console_print(session, "UART busy");
+        return;
+    }
+
+    snprintf(printString, sizeof(printString), "BULK %s %lu %lu",
+            src->name, (unsigned long)total, (unsigned long)baud);
+    UartIo_discardInput();
+    Console_print(session, printString);
+
+    if (!UartIo_readTimeout(&answer, BULKXFER_ACCEPT_MS)) {
+        UartIo_release();
+        return;
+    }
+    if ((answer == 'Y') && (baud != consoleBaud) &&
+            (UartIo_setBaud(baud) != 0)) {
+        /* Refused by the driver; the host will not find us and fall back */
+        baud = consoleBaud;
+    }
+
+    synced = waitSync();
+    if (!synced && (UartIo_baud() != consoleBaud)) {
+        UartIo_setBaud(consoleBaud);
+        synced = waitSync();
+    }
+    if (synced) {
+        ok = sendFrames(src, total);
+    }
+
+    if (UartIo_baud() != consoleBaud) {
+        UartIo_setBaud(consoleBaud);
+    }
+    UartIo_discardInput();
+    UartIo_release();
+
+    Console_print(session, ok ? "Bulk transfer done" : "Bulk transfer failed");
+}
+
+CONSOLE_COMMAND(bulk, "bulk", cmdBulk, "Si", "<crash> [baud]",
+                "send data to the host transfer tool");
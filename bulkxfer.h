@@ -0,0 +1,69 @@
+/*
+ *  ======== bulkxfer.h ========
+ *  Bulk transfers over the console UART.
+ *
+ *  "bulk <source> [baud]" on the UART console streams a data source
+ *  (crash dump, ...) to a host tool at a negotiated rate. The exchange,
+ *  all multi-byte fields little endian:
+ *
+ *      device  "BULK <source> <bytes> <baud>\r\n"     at the console rate
+ *      host    'Y' accepts the rate, 'N' keeps the console rate
+ *      both    switch rate
+ *      host    SYNC (0x55), repeated until answered
+ *      device  SYNC_ACK (0xAA)
+ *      device  frames, at most BULKXFER_WINDOW unacknowledged
+ *      host    ACK seq  (cumulative: every frame up to seq arrived)
+ *              NAK seq  (frame seq was bad, resend from there)
+ *      both    back to the console rate after the empty last frame is
+ *              acknowledged, or on any error
+ *
+ *  Frame:  0x7E | seq (1) | len (2) | payload (len) | CRC-16 (2)
+ *
+ *  The CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over seq,
+ *  len and payload. seq counts frames modulo 256, starting at 0.
+ *
+ *  If there is no SYNC at the negotiated rate, the device goes back to
+ *  the console rate and waits for SYNC there once more, so a host that
+ *  could not switch still gets the data, slowly.
+ */
+#ifndef __BULKXFER_H
+#define __BULKXFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BULKXFER_DEFAULT_BAUD       (921600)
+#define BULKXFER_FRAME_PAYLOAD      (256)
+#define BULKXFER_WINDOW             (4)
+
+#define BULKXFER_SOF                (0x7E)
+#define BULKXFER_SYNC               (0x55)
+#define BULKXFER_SYNC_ACK           (0xAA)
+#define BULKXFER_ACK                (0x06)
+#define BULKXFER_NAK                (0x15)
+
+/*!
+ *  @brief  Something that can be transferred
+ */
+typedef struct BulkXfer_Source {
+    const char *name;
+    /*! Current size in bytes, 0 if there is nothing to send */
+    uint32_t  (*sizeFxn)(void);
+    /*! Copy len bytes from offset into buf */
+    void      (*readFxn)(uint32_t offset, uint8_t *buf, size_t len);
+} BulkXfer_Source;
+
+/*!
+ *  @brief  CRC-16/CCITT-FALSE
+ */
+extern uint16_t BulkXfer_crc16(uint16_t crc, const uint8_t *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BULKXFER_H */
@@ -54,36 +54,39 @@
 
 /* Example/Board Header files */
 #include "Board.h"
+#include "console.h"
+#include "uartio.h"
+#include "wifiscan.h"
 
 /* Console display strings */
 const char consoleDisplay[]   = "\fConsole (h for help)\r\n";
-const char helpPrompt[]       = "Valid Commands\r\n"                  \
-                                "--------------\r\n"                  \
-                                "h: help\r\n"                         \
-                                "x: clear the screen\r\n"             \
-                                "l: wifi List\r\n"                    \
-                                "c: Connect wifi\r\n"                 \
-                                "s: wifi Status";
-
-const char byeDisplay[]       = "Bye! Hit button1 to start UART again\r\n";
+const char helpHeader[]       = "Valid Commands\r\n"                  \
+                                "--------------";
+const char byeDisplay[]       = "Bye!\r\n";
 const char tempStartDisplay[] = "Current temp = ";
-const char SSIDinput[] = "Please enter new SSID: ";
-const char Passwordinput[] = "Please enter SSID password: ";
-
 const char tempMidDisplay[]   = "C (";
 const char tempEndDisplay[]   = "F)\r\n";
 const char cleanDisplay[]     = "\f";
 const char userPrompt[]       = "> ";
 const char readErrDisplay[]   = "Problem read UART.\r\n";
-UART_Handle uart;
 
 /* Used to determine whether to have the thread block */
 volatile bool uartEnabled = true;
 sem_t semConsole;
 
-/* Used itoa instead of sprintf to help minimize the size of the stack */
-static void itoa(int n, char s[]);
-extern void print(const char *String);
+/* Telnet command bytes (RFC 854) */
+#define TELNET_SE               (240)
+#define TELNET_SB               (250)
+#define TELNET_WILL             (251)
+#define TELNET_DONT             (254)
+#define TELNET_IAC              (255)
+
+/* Console_Session.telnetState */
+#define CONSOLE_TELNET_DATA     (0)
+#define CONSOLE_TELNET_IAC      (1)     /* after IAC */
+#define CONSOLE_TELNET_OPTION   (2)     /* after IAC WILL/WONT/DO/DONT */
+#define CONSOLE_TELNET_SB       (3)     /* in a subnegotiation */
+#define CONSOLE_TELNET_SB_IAC   (4)     /* after IAC in one */
 
 /*
  *  ======== gpioButtonFxn ========
@@ -102,249 +105,541 @@ void gpioButtonFxn(uint_least8_t index)
     }
 }
 
+#if defined(__TI_COMPILER_VERSION__)
+/* Bounds of the .consolecmds section, defined in the linker command file */
+extern const Console_Cmd __consolecmds_start__[];
+extern const Console_Cmd __consolecmds_end__[];
+#define CONSOLE_CMDS_BEGIN  (__consolecmds_start__)
+#define CONSOLE_CMDS_END    (__consolecmds_end__)
+#else
+/* GNU ld provides these for sections without a leading dot only */
+extern const Console_Cmd __start_consolecmds[];
+extern const Console_Cmd __stop_consolecmds[];
+#define CONSOLE_CMDS_BEGIN  (__start_consolecmds)
+#define CONSOLE_CMDS_END    (__stop_consolecmds)
+#endif
+
 /*
- *  ======== simpleConsole ========
- *  Handle the user input. Currently this console does not handle
- *  user back-spaces or other "hard" characters.
+ *  ======== nextToken ========
+ *  Split off the next space separated token of a command line. A token
+ *  may be double quoted to include spaces.
  */
-void *consoleThread(void *arg0)
-
-//void simpleConsole(void)
+static char *nextToken(char **cursor)
 {
-    char cmd;
-    int status;
-    int i=0;
-
-    char newSSID[256]={0};
-    char SSIDpass[256]={0};
-    SlWlanSecParams_t   secParams = {0};
-    char printString[512]={0};
-    _u16 len = sizeof(SlNetCfgIpV4Args_t);
-    _u16 ConfigOpt = 0;   //return value could be one of the following: SL_NETCFG_ADDR_DHCP / SL_NETCFG_ADDR_DHCP_LLA / SL_NETCFG_ADDR_STATIC
-    SlNetCfgIpV4Args_t ipV4 = {0};
-    _u16 WlanLen = sizeof(SlWlanConnStatusParam_t) ;
-    SlWlanConnStatusParam_t WlanConnectInfo = {0};
-    SlWlanNetworkEntry_t netEntries[10];
-    _i16 resultsCount;
+    char *token;
+    char *p = *cursor;
+    char  end = ' ';
 
+    while (*p == ' ') {
+        p++;
+    }
+    if (*p == '\0') {
+        *cursor = p;
+        return (NULL);
+    }
+    if (*p == '"') {
+        end = '"';
+        p++;
+    }
+    token = p;
+    while ((*p != end) && (*p != '\0')) {
+        p++;
+    }
+    if (*p != '\0') {
+        *p++ = '\0';
+    }
+    *cursor = p;
 
-    UART_write(uart, consoleDisplay, sizeof(consoleDisplay));
+    return (token);
+}
 
-    /* Loop until read fails or user quits */
-    while (1) {
-        UART_write(uart, userPrompt, sizeof(userPrompt));
-        status = UART_read(uart, &cmd, sizeof(cmd));
-        if (status == 0) {
-            UART_write(uart, readErrDisplay, sizeof(readErrDisplay));
-            cmd = 'q';
+/*
+ *  ======== parseInt ========
+ *  Decimal or 0x-prefixed hexadecimal, optionally negative.
+ */
+static bool parseInt(const char *s, int32_t *value)
+{
+    uint32_t result = 0;
+    uint32_t base = 10;
+    uint32_t digit;
+    bool     negative = false;
+
+    if (*s == '-') {
+        negative = true;
+        s++;
+    }
+    if ((s[0] == '0') && ((s[1] == 'x') || (s[1] == 'X'))) {
+        base = 16;
+        s += 2;
+    }
+    if (*s == '\0') {
+        return (false);
+    }
+
+    for (; *s != '\0'; s++) {
+        if ((*s >= '0') && (*s <= '9')) {
+            digit = *s - '0';
+        }
+        else if ((base == 16) && ((*s | 0x20) >= 'a') && ((*s | 0x20) <= 'f')) {
+            digit = (*s | 0x20) - 'a' + 10;
+        }
+        else {
+            return (false);
         }
+        result = result * base + digit;
+    }
 
-        switch (cmd) {
-            case 'c':
-                i=0;
-                sl_Memset(newSSID,0,256);
-                sl_Memset(SSIDpass,0,256);
-                print(SSIDinput);
-                do
-                {
-                    UART_read(uart,&newSSID[i],1);
-                    if(newSSID[i]!=0x0D)
-                    {
-                        UART_write(uart, &newSSID[i],1);
-                    }
-                    else
-                    {
-                        newSSID[i]=0;
-                        break;
-                    }
-                    i++;
-                }while(1);
-                i=0;
-                print("");
-                print(Passwordinput);
-                do
-                {
-                    UART_read(uart,&SSIDpass[i],1);
-                    if(SSIDpass[i]!=0x0D)
-                    {
-                        UART_write(uart, &SSIDpass[i],1);
-                    }
-                    else
-                    {
-                        SSIDpass[i]=0;
-                        break;
-                    }
-                    i++;
-                }while(1);
-                print("");
-                secParams.Key = (signed char*)SSIDpass;
-                secParams.KeyLen = strlen(SSIDpass);
-                secParams.Type = SL_WLAN_SEC_TYPE_WPA_WPA2;
-                if(sl_WlanConnect((signed char*)newSSID, strlen(newSSID), 0, &secParams, 0)==0)
-                {
-                    sprintf(printString, "Wifi Connected to %s",newSSID);
-                }
-                else
-                {
-                    sprintf(printString, "Wifi not Connected to %s",newSSID);
-                }
-                print(printString);
-                break;
-            case 'l':
-                print("getting network list");
-                resultsCount = sl_WlanGetNetworkList(0,2,&netEntries[0]);
-                print("printing network list");
-                for(i=0; i< resultsCount; i++)
-                {
-                    sprintf(printString,"%d. - SSID: %.32s Security type: %d  RSSI: %d",i+1,netEntries[i].Ssid,SL_WLAN_SCAN_RESULT_SEC_TYPE_BITMAP(netEntries[i].SecurityInfo),netEntries[i].Rssi);
-                    //sprintf(printString,"SSID: %.32s        ",netEntries[i].Ssid);
-                    //sprintf(printString,"BSSID: %x:%x:%x:%x:%x:%x    ",netEntries[i].Bssid[0],netEntries[i].Bssid[1],netEntries[i].Bssid[2],netEntries[i].Bssid[3],netEntries[i].Bssid[4],netEntries[i].Bssid[5]);
-                    //sprintf(printString,"Channel: %d    ",netEntries[i].Channel);
-                    //sprintf(printString,"RSSI: %d    ",netEntries[i].Rssi);
-                    //sprintf(printString,"Security type: %d    ",SL_WLAN_SCAN_RESULT_SEC_TYPE_BITMAP(netEntries[i].SecurityInfo));
-/*                    sprintf(printString,"Group Cipher: %d    ",SL_WLAN_SCAN_RESULT_GROUP_CIPHER(netEntries[i].SecurityInfo));
-                    sprintf(printString,"Unicast Cipher bitmap: %d    ",SL_WLAN_SCAN_RESULT_UNICAST_CIPHER_BITMAP(netEntries[i].SecurityInfo));
-                    sprintf(printString,"Key Mgmt suites bitmap: %d    ",SL_WLAN_SCAN_RESULT_KEY_MGMT_SUITES_BITMAP(netEntries[i].SecurityInfo));
-                    sprintf(printString,"Hidden SSID: %d\r\n",SL_WLAN_SCAN_RESULT_HIDDEN_SSID(netEntries[i].SecurityInfo));*/
-                    print(printString);
-                }
+    *value = negative ? -(int32_t)result : (int32_t)result;
 
-                break;
-            case 's':
-                sl_WlanGet(SL_WLAN_CONNECTION_INFO, NULL , &WlanLen, (_u8*)&WlanConnectInfo);
-                sprintf(printString,"WLAN connected to: %s", WlanConnectInfo.ConnectionInfo.StaConnect.SsidName);
-                print(printString);
+    return (true);
+}
+
+/*
+ *  ======== Console_parseArgs ========
+ */
+int Console_parseArgs(char *line, const char *schema, Console_Args *args)
+{
+    char *token;
+    int   i;
 
-                sl_NetCfgGet(SL_NETCFG_IPV4_STA_ADDR_MODE,&ConfigOpt,&len,(_u8 *)&ipV4);
+    args->argc = 0;
 
-                sprintf(printString,"DHCP is %s IP %d.%d.%d.%d MASK %d.%d.%d.%d GW %d.%d.%d.%d DNS %d.%d.%d.%d\n",
-                    (ConfigOpt == SL_NETCFG_ADDR_DHCP) ? "ON" : "OFF",
-                    SL_IPV4_BYTE(ipV4.Ip,3),SL_IPV4_BYTE(ipV4.Ip,2),SL_IPV4_BYTE(ipV4.Ip,1),SL_IPV4_BYTE(ipV4.Ip,0),
-                    SL_IPV4_BYTE(ipV4.IpMask,3),SL_IPV4_BYTE(ipV4.IpMask,2),SL_IPV4_BYTE(ipV4.IpMask,1),SL_IPV4_BYTE(ipV4.IpMask,0),
-                    SL_IPV4_BYTE(ipV4.IpGateway,3),SL_IPV4_BYTE(ipV4.IpGateway,2),SL_IPV4_BYTE(ipV4.IpGateway,1),SL_IPV4_BYTE(ipV4.IpGateway,0),
-                    SL_IPV4_BYTE(ipV4.IpDnsServer,3),SL_IPV4_BYTE(ipV4.IpDnsServer,2),SL_IPV4_BYTE(ipV4.IpDnsServer,1),SL_IPV4_BYTE(ipV4.IpDnsServer,0));
+    for (i = 0; schema[i] != '\0'; i++) {
+        token = nextToken(&line);
+        if (token == NULL) {
+            /* Optional arguments are lower case */
+            return (((schema[i] == 'S') || (schema[i] == 'I')) ? i + 1 : 0);
+        }
 
-                print(printString);
-                break;
-            case 'x':
-                UART_write(uart, cleanDisplay, sizeof(cleanDisplay));
-                break;
-            case 'q':
-                UART_write(uart, byeDisplay, sizeof(byeDisplay));
-                //return;
-            case 'h':
-            default:
-                UART_write(uart, helpPrompt, sizeof(helpPrompt));
-                break;
+        args->str[i] = token;
+        args->num[i] = 0;
+        if (((schema[i] == 'i') || (schema[i] == 'I')) &&
+                !parseInt(token, &args->num[i])) {
+            return (i + 1);
         }
+        args->argc++;
     }
+
+    return ((nextToken(&line) != NULL) ? i + 1 : 0);
 }
 
 /*
- *  ======== consoleThread ========
+ *  ======== Console_findCmd ========
  */
+const Console_Cmd *Console_findCmd(const char *name)
+{
+    const Console_Cmd *cmd;
+
+    for (cmd = CONSOLE_CMDS_BEGIN; cmd < CONSOLE_CMDS_END; cmd++) {
+        if (strcmp(cmd->name, name) == 0) {
+            return (cmd);
+        }
+    }
+
+    return (NULL);
+}
+
 /*
-void *consoleThread(void *arg0)
+ *  ======== Console_printHelp ========
+ */
+void Console_printHelp(Console_Session *session)
 {
-    UART_Params uartParams;
-    int retc;
+    char               printString[CONSOLE_PRINT_SIZE];
+    const Console_Cmd *cmd;
+
+    Console_print(session, helpHeader);
+    for (cmd = CONSOLE_CMDS_BEGIN; cmd < CONSOLE_CMDS_END; cmd++) {
+        snprintf(printString, sizeof(printString), "%s %s: %s", cmd->name,
+                cmd->usage, cmd->help);
+        Console_print(session, printString);
+    }
+}
 
-#ifdef CC32XX
-     //  The CC3220 examples by default do not have power management enabled.
-     //  This allows a better debug experience. With the power management
-     //  enabled, if the device goes into a low power mode the emulation
-     //  session is lost.
-     //  Let's enable it and also configure the button to wake us up.
-     //
-    PowerCC32XX_Wakeup wakeup;
-
-    PowerCC32XX_getWakeup(&wakeup);
-    wakeup.wakeupGPIOFxnLPDS = gpioButtonFxn;
-    PowerCC32XX_configureWakeup(&wakeup);
-    Power_enablePolicy();
-#endif
+/*
+ *  ======== Console_write ========
+ */
+void Console_write(Console_Session *session, const char *buf, size_t len)
+{
+    session->writeFxn(session, buf, len);
+}
 
-    // Configure the button pin
-    GPIO_setConfig(Board_GPIO_BUTTON1, GPIO_CFG_IN_PU | GPIO_CFG_IN_INT_FALLING);
+/*
+ *  ======== Console_print ========
+ */
+void Console_print(Console_Session *session, const char *string)
+{
+    session->writeFxn(session, string, strlen(string));
+    session->writeFxn(session, "\r\n", 2);
+}
 
-    // install Button callback and enable it
-    GPIO_setCallback(Board_GPIO_BUTTON1, gpioButtonFxn);
-    GPIO_enableInt(Board_GPIO_BUTTON1);
+/*
+ *  ======== Console_prompt ========
+ */
+void Console_prompt(Console_Session *session)
+{
+    session->writeFxn(session, userPrompt, strlen(userPrompt));
+}
 
-    retc = sem_init(&semConsole, 0, 0);
-    if (retc == -1) {
-        while (1);
-    }
+/*
+ *  ======== Console_attach ========
+ */
+void Console_attach(Console_Session *session, Console_WriteFxn writeFxn,
+                    void *arg, bool echo)
+{
+    memset(session, 0, sizeof(Console_Session));
+    session->writeFxn = writeFxn;
+    session->arg = arg;
+    session->echo = echo;
+}
 
-    UART_init();
+/*
+ *  ======== Console_banner ========
+ */
+void Console_banner(Console_Session *session)
+{
+    Console_write(session, consoleDisplay, strlen(consoleDisplay));
+    Console_prompt(session);
+}
 
-     // Initialize the UART parameters outside the loop. Let's keep
-     //  most of the defaults (e.g. baudrate = 115200) and only change the
-     //  following.
+/*
+ *  ======== Console_open ========
+ */
+void Console_open(Console_Session *session, Console_WriteFxn writeFxn,
+                  void *arg, bool echo)
+{
+    Console_attach(session, writeFxn, arg, echo);
+    Console_banner(session);
+}
 
-    UART_Params_init(&uartParams);
-    uartParams.writeDataMode  = UART_DATA_BINARY;
-    uartParams.readDataMode   = UART_DATA_BINARY;
-    uartParams.readReturnMode = UART_RETURN_FULL;
-    uart = UART_open(Board_UART0, &uartParams);
+/*
+ *  ======== telnet ========
+ *  Telnet commands (RFC 854) in the input: option negotiation and
+ *  subnegotiation are dropped, IAC IAC is a data byte.
+ *
+ *  @return true if c was part of a command
+ */
+static bool telnet(Console_Session *session, uint8_t c)
+{
+    switch (session->telnetState) {
+        case CONSOLE_TELNET_DATA:
+            if (c != TELNET_IAC) {
+                return (false);
+            }
+            session->telnetState = CONSOLE_TELNET_IAC;
+            return (true);
+
+        case CONSOLE_TELNET_IAC:
+            if (c == TELNET_IAC) {
+                /* Escaped 0xFF: data */
+                session->telnetState = CONSOLE_TELNET_DATA;
+                return (false);
+            }
+            if (c == TELNET_SB) {
+                session->telnetState = CONSOLE_TELNET_SB;
+            }
+            else if ((c >= TELNET_WILL) && (c <= TELNET_DONT)) {
+                session->telnetState = CONSOLE_TELNET_OPTION;
+            }
+            else {
+                /* NOP, AYT and the like: no argument */
+                session->telnetState = CONSOLE_TELNET_DATA;
+            }
+            return (true);
 
-    // Loop forever to start the console
-    while (1) {
-        if (uartEnabled == false) {
-            retc = sem_wait(&semConsole);
-            if (retc == -1) {
-                while (1);
+        case CONSOLE_TELNET_OPTION:
+            session->telnetState = CONSOLE_TELNET_DATA;
+            return (true);
+
+        case CONSOLE_TELNET_SB:
+            if (c == TELNET_IAC) {
+                session->telnetState = CONSOLE_TELNET_SB_IAC;
             }
-        }
+            return (true);
 
-        // Create a UART for the console
-        uart = UART_open(Board_UART0, &uartParams);
-        if (uart == NULL) {
-            while (1);
-        }
+        case CONSOLE_TELNET_SB_IAC:
+            /* IAC SE ends the subnegotiation, IAC IAC is data in it */
+            session->telnetState = (c == TELNET_SE) ?
+                    CONSOLE_TELNET_DATA : CONSOLE_TELNET_SB;
+            return (true);
 
-        simpleConsole();
+        default:
+            session->telnetState = CONSOLE_TELNET_DATA;
+            return (false);
+    }
+}
+
+/*
+ *  ======== Console_input ========
+ *  Line editing. Handles backspace, CR/LF/CRLF line ends and drops
+ *  telnet commands so raw TCP and telnet clients both work.
+ */
+void Console_input(Console_Session *session, char c)
+{
+    if (telnet(session, (uint8_t)c)) {
+        return;
+    }
 
+    switch ((uint8_t)c) {
+        case '\0':
+            break;
+        case '\n':
+            if (session->lastWasCr) {
+                break;
+            }
+            /* fall through */
+        case '\r':
+            if (session->echo) {
+                Console_write(session, "\r\n", 2);
+            }
+            session->line[session->lineLen] = '\0';
+            session->lineLen = 0;
+            if (session->lineFxn != NULL) {
+                session->lineFxn(session, session->line);
+                break;
+            }
+            Console_execute(session, session->line);
+            if (!session->closeRequested) {
+                Console_prompt(session);
+            }
+            break;
+        case 0x08:                      /* backspace */
+        case 0x7F:                      /* delete */
+            if (session->lineLen > 0) {
+                session->lineLen--;
+                if (session->echo) {
+                    Console_write(session, "\b \b", 3);
+                }
+            }
+            break;
+        default:
+            if (((uint8_t)c >= ' ') && ((uint8_t)c < 0x7F) &&
+                    (session->lineLen < CONSOLE_LINE_SIZE - 1)) {
+                session->line[session->lineLen++] = c;
+                if (session->echo) {
+                    Console_write(session, &c, 1);
+                }
+            }
+            break;
+    }
 
-         // Since we returned from the console, we need to close the UART.
-         // The Power Manager will go into a lower power mode when the UART
-         // is closed.
+    session->lastWasCr = (c == '\r');
+}
 
-        UART_close(uart);
-        uartEnabled = false;
+/*
+ *  ======== cmdConnect ========
+ */
+static void cmdConnect(Console_Session *session, const Console_Args *args)
+{
+    char printString[CONSOLE_PRINT_SIZE];
+    SlWlanSecParams_t secParams = {0};
+    const char *ssid = args->str[0];
+    char *password = (args->argc > 1) ? args->str[1] : NULL;
+
+    if (password != NULL) {
+        secParams.Key = (signed char*)password;
+        secParams.KeyLen = strlen(password);
+        secParams.Type = SL_WLAN_SEC_TYPE_WPA_WPA2;
+    }
+    else {
+        secParams.Type = SL_WLAN_SEC_TYPE_OPEN;
     }
-}*/
+
+    if (sl_WlanConnect((signed char*)ssid, strlen(ssid), 0, &secParams, 0) == 0) {
+        snprintf(printString, sizeof(printString), "Wifi Connected to %s", ssid);
+    }
+    else {
+        snprintf(printString, sizeof(printString), "Wifi not Connected to %s", ssid);
+    }
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(connect, "c", cmdConnect, "Ss", "<ssid> [password]",
+                "Connect wifi");
+
+/*
+ *  ======== cmdList ========
+ *  Served from the scan cache; never waits for the radio.
+ */
+static void cmdList(Console_Session *session, const Console_Args *args)
+{
+    char printString[CONSOLE_PRINT_SIZE];
+    WifiScan_Entry scanEntry;
+    uint32_t scanAge;
+    int resultsCount;
+    int i;
+
+    resultsCount = WifiScan_count(&scanAge);
+    if (scanAge > WIFISCAN_MAX_AGE_MS && !WifiScan_busy()) {
+        WifiScan_request();
+    }
+    if (resultsCount == 0) {
+        Console_print(session, (scanAge == UINT32_MAX) ?
+                "Scanning, press l again for results" : "No networks found");
+        return;
+    }
+
+    if (session->scanPage * WIFISCAN_PAGE_SIZE >= resultsCount) {
+        session->scanPage = 0;
+    }
+    i = session->scanPage * WIFISCAN_PAGE_SIZE;
+    snprintf(printString, sizeof(printString), "Networks %d-%d of %d (%u s old)", i + 1,
+            (i + WIFISCAN_PAGE_SIZE < resultsCount) ? i + WIFISCAN_PAGE_SIZE : resultsCount,
+            resultsCount, (unsigned)(scanAge / 1000));
+    Console_print(session, printString);
+
+    for (; (i < resultsCount) && (i < (session->scanPage + 1) * WIFISCAN_PAGE_SIZE); i++) {
+        if (!WifiScan_get(i, &scanEntry)) {
+            break;
+        }
+        snprintf(printString, sizeof(printString),
+                "%d. - SSID: %.32s BSSID: %02x:%02x:%02x:%02x:%02x:%02x Ch: %d RSSI: %d "
+                "Sec: %d Group: %d Unicast: %d KeyMgmt: %d Hidden: %d",
+                i + 1, scanEntry.ssid,
+                scanEntry.bssid[0], scanEntry.bssid[1], scanEntry.bssid[2],
+                scanEntry.bssid[3], scanEntry.bssid[4], scanEntry.bssid[5],
+                scanEntry.channel, scanEntry.rssi,
+                SL_WLAN_SCAN_RESULT_SEC_TYPE_BITMAP(scanEntry.securityInfo),
+                SL_WLAN_SCAN_RESULT_GROUP_CIPHER(scanEntry.securityInfo),
+                SL_WLAN_SCAN_RESULT_UNICAST_CIPHER_BITMAP(scanEntry.securityInfo),
+                SL_WLAN_SCAN_RESULT_KEY_MGMT_SUITES_BITMAP(scanEntry.securityInfo),
+                SL_WLAN_SCAN_RESULT_HIDDEN_SSID(scanEntry.securityInfo));
+        Console_print(session, printString);
+    }
+    session->scanPage++;
+}
+
+CONSOLE_COMMAND(list, "l", cmdList, "", "", "wifi List (repeat for next page)");
+
+/*
+ *  ======== cmdStatus ========
+ */
+static void cmdStatus(Console_Session *session, const Console_Args *args)
+{
+    char printString[CONSOLE_PRINT_SIZE];
+    _u16 len = sizeof(SlNetCfgIpV4Args_t);
+    _u16 ConfigOpt = 0;   //return value could be one of the following: SL_NETCFG_ADDR_DHCP / SL_NETCFG_ADDR_DHCP_LLA / SL_NETCFG_ADDR_STATIC
+    SlNetCfgIpV4Args_t ipV4 = {0};
+    _u16 WlanLen = sizeof(SlWlanConnStatusParam_t) ;
+    SlWlanConnStatusParam_t WlanConnectInfo = {0};
+
+    sl_WlanGet(SL_WLAN_CONNECTION_INFO, NULL , &WlanLen, (_u8*)&WlanConnectInfo);
+    snprintf(printString, sizeof(printString), "WLAN connected to: %s",
+            WlanConnectInfo.ConnectionInfo.StaConnect.SsidName);
+    Console_print(session, printString);
+
+    sl_NetCfgGet(SL_NETCFG_IPV4_STA_ADDR_MODE,&ConfigOpt,&len,(_u8 *)&ipV4);
+
+    snprintf(printString, sizeof(printString),
+        "DHCP is %s IP %d.%d.%d.%d MASK %d.%d.%d.%d GW %d.%d.%d.%d DNS %d.%d.%d.%d",
+        (ConfigOpt == SL_NETCFG_ADDR_DHCP) ? "ON" : "OFF",
+        SL_IPV4_BYTE(ipV4.Ip,3),SL_IPV4_BYTE(ipV4.Ip,2),SL_IPV4_BYTE(ipV4.Ip,1),SL_IPV4_BYTE(ipV4.Ip,0),
+        SL_IPV4_BYTE(ipV4.IpMask,3),SL_IPV4_BYTE(ipV4.IpMask,2),SL_IPV4_BYTE(ipV4.IpMask,1),SL_IPV4_BYTE(ipV4.IpMask,0),
+        SL_IPV4_BYTE(ipV4.IpGateway,3),SL_IPV4_BYTE(ipV4.IpGateway,2),SL_IPV4_BYTE(ipV4.IpGateway,1),SL_IPV4_BYTE(ipV4.IpGateway,0),
+        SL_IPV4_BYTE(ipV4.IpDnsServer,3),SL_IPV4_BYTE(ipV4.IpDnsServer,2),SL_IPV4_BYTE(ipV4.IpDnsServer,1),SL_IPV4_BYTE(ipV4.IpDnsServer,0));
+
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(status, "s", cmdStatus, "", "", "wifi Status");
+
+/*
+ *  ======== cmdHelp ========
+ */
+static void cmdHelp(Console_Session *session, const Console_Args *args)
+{
+    Console_printHelp(session);
+}
+
+CONSOLE_COMMAND(help, "h", cmdHelp, "", "", "help");
+
+/*
+ *  ======== cmdClear ========
+ */
+static void cmdClear(Console_Session *session, const Console_Args *args)
+{
+    Console_write(session, cleanDisplay, strlen(cleanDisplay));
+}
+
+CONSOLE_COMMAND(clear, "x", cmdClear, "", "", "clear the screen");
 
 /*
- * The following function is from good old K & R.
+ *  ======== cmdQuit ========
  */
-static void reverse(char s[])
+static void cmdQuit(Console_Session *session, const Console_Args *args)
 {
-    int i, j;
-    char c;
+    Console_write(session, byeDisplay, strlen(byeDisplay));
+    session->closeRequested = true;
+}
 
-    for (i = 0, j = strlen(s)-1; i<j; i++, j--) {
-        c = s[i];
-        s[i] = s[j];
-        s[j] = c;
+CONSOLE_COMMAND(quit, "q", cmdQuit, "", "", "end session");
+
+/*
+ *  ======== Console_execute ========
+ *  Command dispatcher shared by every console transport.
+ */
+void Console_execute(Console_Session *session, char *line)
+{
+    char               printString[CONSOLE_PRINT_SIZE];
+    const Console_Cmd *cmd;
+    Console_Args       args;
+    char              *name;
+    int                badArg;
+
+    name = nextToken(&line);
+    if (name == NULL) {
+        return;
+    }
+
+    cmd = Console_findCmd(name);
+    if (cmd == NULL) {
+        Console_printHelp(session);
+        return;
     }
+
+    badArg = Console_parseArgs(line, cmd->schema, &args);
+    if (badArg != 0) {
+        snprintf(printString, sizeof(printString),
+                "Bad argument %d. Usage: %s %s", badArg, cmd->name, cmd->usage);
+        Console_print(session, printString);
+        return;
+    }
+
+    cmd->fxn(session, &args);
 }
 
 /*
- * The following function is from good old K & R.
+ *  ======== uartConsoleWrite ========
  */
-static void itoa(int n, char s[])
+static void uartConsoleWrite(Console_Session *session, const char *buf,
+                             size_t len)
 {
-    int i, sign;
-
-    if ((sign = n) < 0)  /* record sign */
-        n = -n;          /* make n positive */
-    i = 0;
-    do {       /* generate digits in reverse order */
-        s[i++] = n % 10 + '0';   /* get next digit */
-    } while ((n /= 10) > 0);     /* delete it */
-    if (sign < 0)
-         s[i++] = '-';
-    s[i] = '\0';
-    reverse(s);
+    UartIo_write(buf, len);
+}
+
+/*
+ *  ======== Console_isUart ========
+ */
+bool Console_isUart(const Console_Session *session)
+{
+    return (session->writeFxn == uartConsoleWrite);
+}
+
+/*
+ *  ======== consoleThread ========
+ *  UART transport for the console.
+ */
+void *consoleThread(void *arg0)
+{
+    Console_Session uartSession;
+    Console_open(&uartSession, uartConsoleWrite, NULL, true);
+
+    while (1) {
+        Console_input(&uartSession, UartIo_readChar());
+
+        /* The UART cannot be hung up; just start over */
+        if (uartSession.closeRequested) {
+            uartSession.closeRequested = false;
+            Console_prompt(&uartSession);
+        }
+    }
 }
@@ -0,0 +1,193 @@
+/*
+ *  ======== console.h ========
+ *  Transport independent console.
+ *
+ *  Every console connection (the UART, each TCP session) is a
+ *  Console_Session. The transport feeds received characters into
+ *  Console_input(), which does line editing and hands complete lines to
+ *  the command dispatcher. All output goes through the session's write
+ *  function, which must not block for long. A transport that must not
+ *  run commands on its own thread sets a line function and executes the
+ *  lines elsewhere.
+ *
+ *  Commands are not listed anywhere centrally. Any source file declares
+ *  its own with CONSOLE_COMMAND(); the entries are collected by the
+ *  linker into the .consolecmds section (see CC3220SF_LAUNCHXL_TIRTOS.cmd)
+ *  and the dispatcher and the help text walk that table. Arguments are
+ *  tokenized once, checked against the command's schema and handed to
+ *  the handler already converted.
+ */
+#ifndef __CONSOLE_H
+#define __CONSOLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Longest command line, including the terminating NUL */
+#define CONSOLE_LINE_SIZE       (128)
+
+/* Scratch buffer for formatted command output */
+#define CONSOLE_PRINT_SIZE      (256)
+
+/* Most arguments a command can take */
+#define CONSOLE_MAX_ARGS        (6)
+
+typedef struct Console_Session Console_Session;
+
+/*!
+ *  @brief  Transport write function
+ */
+typedef void (*Console_WriteFxn)(Console_Session *session, const char *buf,
+                                 size_t len);
+
+/*!
+ *  @brief  Takes a complete line instead of Console_input() executing it.
+ *          The transport then runs Console_execute() and
+ *          Console_prompt() itself.
+ */
+typedef void (*Console_LineFxn)(Console_Session *session, char *line);
+
+/*!
+ *  @brief  Per-connection console state
+ */
+struct Console_Session {
+    Console_WriteFxn    writeFxn;
+    Console_LineFxn     lineFxn;        /* NULL to execute in place */
+    void               *arg;            /* transport private data */
+    bool                echo;           /* echo typed characters */
+    bool                closeRequested; /* set by the 'q' command */
+    bool                lastWasCr;
+    uint8_t             telnetState;    /* in a telnet command */
+    uint16_t            lineLen;
+    int                 scanPage;       /* next 'l' page */
+    char                line[CONSOLE_LINE_SIZE];
+};
+
+/*!
+ *  @brief  Parsed command arguments
+ *
+ *  str[i] always points at the i'th token (NUL terminated, quotes
+ *  removed). For integer arguments num[i] also holds its value.
+ */
+typedef struct Console_Args {
+    int         argc;
+    char       *str[CONSOLE_MAX_ARGS];
+    int32_t     num[CONSOLE_MAX_ARGS];
+} Console_Args;
+
+typedef void (*Console_CmdFxn)(Console_Session *session,
+                               const Console_Args *args);
+
+/*!
+ *  @brief  Command table entry
+ *
+ *  schema has one character per argument:
+ *      's' string      'S' required string
+ *      'i' integer     'I' required integer
+ *  Required arguments must come before optional ones.
+ */
+typedef struct Console_Cmd {
+    const char     *name;
+    Console_CmdFxn  fxn;
+    const char     *schema;
+    const char     *usage;
+    const char     *help;
+} Console_Cmd;
+
+#if defined(__TI_COMPILER_VERSION__)
+#define CONSOLE_CMD_SECTION \
+    __attribute__ ((section (".consolecmds"), used, aligned (4)))
+#elif defined(__GNUC__)
+#define CONSOLE_CMD_SECTION \
+    __attribute__ ((section ("consolecmds"), used, aligned (4)))
+#else
+#error "CONSOLE_COMMAND() needs section placement for this compiler"
+#endif
+
+/*!
+ *  @brief  Define a console command
+ *
+ *  @code
+ *  static void cmdReboot(Console_Session *session, const Console_Args *args);
+ *  CONSOLE_COMMAND(reboot, "reboot", cmdReboot, "i", "[delay_ms]",
+ *                  "restart the device");
+ *  @endcode
+ */
+#define CONSOLE_COMMAND(id, name, fxn, schema, usage, help)                \
+    CONSOLE_CMD_SECTION const Console_Cmd consoleCmd_##id =                \
+        { (name), (fxn), (schema), (usage), (help) }
+
+/*!
+ *  @brief  Split line (in place) into args according to schema
+ *
+ *  Tokens are separated by spaces; double quotes group a token that
+ *  contains spaces.
+ *
+ *  @return 0 on success, or the 1-based position of the first missing,
+ *          malformed or surplus argument
+ */
+extern int Console_parseArgs(char *line, const char *schema,
+                             Console_Args *args);
+
+/*!
+ *  @brief  Look up a command by name
+ */
+extern const Console_Cmd *Console_findCmd(const char *name);
+
+/*!
+ *  @brief  Print the generated command list
+ */
+extern void Console_printHelp(Console_Session *session);
+
+/*!
+ *  @brief  Initialize a session without printing anything
+ */
+extern void Console_attach(Console_Session *session,
+                           Console_WriteFxn writeFxn, void *arg, bool echo);
+
+/*!
+ *  @brief  Print the banner and prompt
+ */
+extern void Console_banner(Console_Session *session);
+
+/*!
+ *  @brief  Initialize a session and print the banner and prompt
+ */
+extern void Console_open(Console_Session *session, Console_WriteFxn writeFxn,
+                         void *arg, bool echo);
+
+/*!
+ *  @brief  Feed one received character into the session
+ */
+extern void Console_input(Console_Session *session, char c);
+
+/*!
+ *  @brief  Run one command line (modified in place)
+ */
+extern void Console_execute(Console_Session *session, char *line);
+
+extern void Console_write(Console_Session *session, const char *buf,
+                          size_t len);
+
+/*!
+ *  @brief  Write a string followed by CR LF
+ */
+extern void Console_print(Console_Session *session, const char *string);
+
+extern void Console_prompt(Console_Session *session);
+
+/*!
+ *  @brief  True for the UART session, which owns the serial line
+ */
+extern bool Console_isUart(const Console_Session *session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONSOLE_H */
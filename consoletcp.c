@@ -0,0 +1,364 @@
+/*
+ *  ======== consoletcp.c ========
+ *  TCP (telnet) transport for the console
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <ti/net/slnetsock.h>
+#include <ti/net/slnetutils.h>
+
+#include "appconfig.h"
+#include "console.h"
+#include "consoletcp.h"
+#include "netsched.h"
+
+/* Bytes read from a session socket per poll */
+#define CONSOLETCP_RX_CHUNK         (64)
+
+/* Delay before retrying a failed listen */
+#define CONSOLETCP_RETRY_MS         (1000)
+
+typedef struct ConsoleTcp_Session {
+    Console_Session     console;
+    int16_t             sd;             /* -1 when the slot is free */
+    bool                loggedIn;
+    uint8_t             loginFailures;
+    volatile bool       busy;           /* cmd queued or running */
+    uint8_t             rxPos;          /* next unread byte of rx */
+    uint8_t             rxLen;
+    uint16_t            txHead;
+    uint16_t            txCount;
+    char                tx[CONSOLETCP_TX_SIZE];
+    char                rx[CONSOLETCP_RX_CHUNK];
+    char                cmd[CONSOLE_LINE_SIZE];
+} ConsoleTcp_Session;
+
+typedef struct ConsoleTcp_Ctx {
+    NetSched_Task       task;
+    int16_t             listenSd;
+    uint32_t            txDropped;
+    pthread_mutex_t     txLock;         /* worker writes, scheduler sends */
+    sem_t               workSem;
+    ConsoleTcp_Session  sessions[CONSOLETCP_MAX_SESSIONS];
+} ConsoleTcp_Ctx;
+
+extern const char consoleDisplay[];
+
+static const char passwordPrompt[] = "Password: ";
+
+static ConsoleTcp_Ctx tcpCtx;
+
+/*
+ *  ======== tcpConsoleWrite ========
+ *  Queue output; never blocks.
+ */
+static void tcpConsoleWrite(Console_Session *console, const char *buf,
+                            size_t len)
+{
+    ConsoleTcp_Session *session = (ConsoleTcp_Session *)console->arg;
+    uint16_t            tail;
+
+    pthread_mutex_lock(&tcpCtx.txLock);
+    while (len > 0) {
+        if (session->txCount == CONSOLETCP_TX_SIZE) {
+            tcpCtx.txDropped += len;
+            break;
+        }
+        tail = (session->txHead + session->txCount) % CONSOLETCP_TX_SIZE;
+        session->tx[tail] = *buf++;
+        session->txCount++;
+        len--;
+    }
+    pthread_mutex_unlock(&tcpCtx.txLock);
+}
+
+/*
+ *  ======== flushSession ========
+ *  Send as much queued output as the socket will take right now.
+ */
+static void flushSession(ConsoleTcp_Session *session)
+{
+    int32_t  ret = 1;
+    uint16_t chunk;
+
+    /* Sends do not block, so holding the lock across them is cheap */
+    pthread_mutex_lock(&tcpCtx.txLock);
+    while ((session->txCount > 0) && (ret > 0)) {
+        chunk = CONSOLETCP_TX_SIZE - session->txHead;
+        if (chunk > session->txCount) {
+            chunk = session->txCount;
+        }
+
+        ret = SlNetSock_send(session->sd, &session->tx[session->txHead],
+                chunk, 0);
+        if (ret > 0) {
+            session->txHead = (session->txHead + ret) % CONSOLETCP_TX_SIZE;
+            session->txCount -= ret;
+        }
+    }
+    pthread_mutex_unlock(&tcpCtx.txLock);
+}
+
+/*
+ *  ======== closeSession ========
+ */
+static void closeSession(ConsoleTcp_Session *session)
+{
+    if (session->sd >= 0) {
+        flushSession(session);
+        SlNetSock_close(session->sd);
+        session->sd = -1;
+    }
+}
+
+/*
+ *  ======== tcpConsoleLine ========
+ *  Runs on the scheduler: checks the login, and queues commands for the
+ *  worker so a slow command cannot hold up the other network tasks.
+ */
+static void tcpConsoleLine(Console_Session *console, char *line)
+{
+    ConsoleTcp_Session *session = (ConsoleTcp_Session *)console->arg;
+
+    if (!session->loggedIn) {
+        if (AppConfig_authorize(line)) {
+            session->loggedIn = true;
+            Console_banner(console);
+        }
+        else if (++session->loginFailures >= CONSOLETCP_LOGIN_TRIES) {
+            console->closeRequested = true;
+        }
+        else {
+            Console_write(console, passwordPrompt, strlen(passwordPrompt));
+        }
+        memset(line, 0, CONSOLE_LINE_SIZE);
+        return;
+    }
+
+    strcpy(session->cmd, line);
+    session->busy = true;
+    sem_post(&tcpCtx.workSem);
+}
+
+/*
+ *  ======== consoleWorkerThread ========
+ *  Executes queued commands, one at a time, for every session.
+ */
+static void *consoleWorkerThread(void *arg0)
+{
+    ConsoleTcp_Session *session;
+    int                 i;
+
+    while (1) {
+        sem_wait(&tcpCtx.workSem);
+
+        for (i = 0; i < CONSOLETCP_MAX_SESSIONS; i++) {
+            session = &tcpCtx.sessions[i];
+            if (!session->busy) {
+                continue;
+            }
+            Console_execute(&session->console, session->cmd);
+            if (!session->console.closeRequested) {
+                Console_prompt(&session->console);
+            }
+            session->busy = false;
+        }
+    }
+}
+
+/*
+ *  ======== acceptSessions ========
+ */
+static void acceptSessions(ConsoleTcp_Ctx *ctx)
+{
+    ConsoleTcp_Session *session = NULL;
+    SlNetSock_AddrIn_t  clientAddr;
+    SlNetSocklen_t      addrLen = sizeof(clientAddr);
+    int16_t             sd;
+    int                 i;
+
+    sd = SlNetSock_accept(ctx->listenSd, (SlNetSock_Addr_t *)&clientAddr,
+            &addrLen);
+    if (sd < 0) {
+        return;
+    }
+
+    for (i = 0; i < CONSOLETCP_MAX_SESSIONS; i++) {
+        /* A slot whose command still runs keeps its output buffer */
+        if ((ctx->sessions[i].sd < 0) && !ctx->sessions[i].busy) {
+            session = &ctx->sessions[i];
+            break;
+        }
+    }
+    if (session == NULL) {
+        SlNetSock_send(sd, "Console busy\r\n", 14, 0);
+        SlNetSock_close(sd);
+        return;
+    }
+
+    NetSched_setNonBlocking(sd);
+    session->sd = sd;
+    session->loggedIn = false;
+    session->loginFailures = 0;
+    session->rxPos = 0;
+    session->rxLen = 0;
+    session->txHead = 0;
+    session->txCount = 0;
+
+    /* Clients echo locally in line mode */
+    Console_attach(&session->console, tcpConsoleWrite, session, false);
+    session->console.lineFxn = tcpConsoleLine;
+    Console_write(&session->console, passwordPrompt,
+            strlen(passwordPrompt));
+    flushSession(session);
+}
+
+/*
+ *  ======== serviceSession ========
+ */
+static void serviceSession(ConsoleTcp_Session *session)
+{
+    int32_t ret;
+
+    /* Input waits until the running command is done */
+    if (session->busy) {
+        flushSession(session);
+        return;
+    }
+    if (session->console.closeRequested) {
+        closeSession(session);
+        return;
+    }
+
+    if (session->rxPos == session->rxLen) {
+        ret = SlNetSock_recv(session->sd, session->rx, sizeof(session->rx),
+                0);
+        if ((ret == 0) || ((ret < 0) && !NetSched_wouldBlock(ret))) {
+            closeSession(session);
+            return;
+        }
+        session->rxPos = 0;
+        session->rxLen = (ret > 0) ? ret : 0;
+    }
+
+    /* Stop at a queued command and keep the rest for after it */
+    while ((session->rxPos < session->rxLen) && !session->busy) {
+        Console_input(&session->console, session->rx[session->rxPos++]);
+        if (session->console.closeRequested) {
+            closeSession(session);
+            return;
+        }
+    }
+
+    flushSession(session);
+}
+
+/*
+ *  ======== openListener ========
+ */
+static int16_t openListener(void)
+{
+    SlNetSock_AddrIn_t localAddr;
+    int16_t            sd;
+
+    sd = SlNetSock_create(SLNETSOCK_AF_INET, SLNETSOCK_SOCK_STREAM,
+            SLNETSOCK_PROTO_TCP, 0, 0);
+    if (sd < 0) {
+        return (sd);
+    }
+
+    memset(&localAddr, 0, sizeof(localAddr));
+    localAddr.sin_family = SLNETSOCK_AF_INET;
+    localAddr.sin_port = SlNetUtil_htons(CONSOLETCP_PORT);
+    localAddr.sin_addr.s_addr = SLNETSOCK_INADDR_ANY;
+
+    if ((SlNetSock_bind(sd, (SlNetSock_Addr_t *)&localAddr,
+                sizeof(localAddr)) < 0) ||
+            (SlNetSock_listen(sd, CONSOLETCP_MAX_SESSIONS) < 0) ||
+            (NetSched_setNonBlocking(sd) < 0)) {
+        SlNetSock_close(sd);
+        return (-1);
+    }
+
+    return (sd);
+}
+
+/*
+ *  ======== consoleTcpFxn ========
+ */
+static PT_THREAD(consoleTcpFxn(NetSched_Task *task))
+{
+    ConsoleTcp_Ctx *ctx = (ConsoleTcp_Ctx *)task->arg;
+    int             i;
+
+    PT_BEGIN(&task->pt);
+
+    while (1) {
+        NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_IP_ACQUIRED);
+        NetSched_clearEvents(task, NETSCHED_EVENT_IP_LOST);
+
+        while ((ctx->listenSd = openListener()) < 0) {
+            NETSCHED_SLEEP(task, CONSOLETCP_RETRY_MS);
+        }
+
+        while ((task->events & NETSCHED_EVENT_IP_LOST) == 0) {
+            acceptSessions(ctx);
+            for (i = 0; i < CONSOLETCP_MAX_SESSIONS; i++) {
+                if (ctx->sessions[i].sd >= 0) {
+                    serviceSession(&ctx->sessions[i]);
+                }
+            }
+            NETSCHED_SLEEP(task, CONSOLETCP_POLL_MS);
+        }
+
+        for (i = 0; i < CONSOLETCP_MAX_SESSIONS; i++) {
+            closeSession(&ctx->sessions[i]);
+        }
+        SlNetSock_close(ctx->listenSd);
+        ctx->listenSd = -1;
+        NetSched_clearEvents(task, NETSCHED_EVENT_IP_ACQUIRED |
+                NETSCHED_EVENT_IP_LOST);
+    }
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== ConsoleTcp_init ========
+ */
+void ConsoleTcp_init(void)
+{
+    pthread_t          thread;
+    pthread_attr_t     pAttrs;
+    struct sched_param priParam;
+    int                i;
+
+    tcpCtx.listenSd = -1;
+    for (i = 0; i < CONSOLETCP_MAX_SESSIONS; i++) {
+        tcpCtx.sessions[i].sd = -1;
+    }
+    pthread_mutex_init(&tcpCtx.txLock, NULL);
+    sem_init(&tcpCtx.workSem, 0, 0);
+
+    pthread_attr_init(&pAttrs);
+    priParam.sched_priority = CONSOLETCP_WORKER_PRIORITY;
+    pthread_attr_setschedparam(&pAttrs, &priParam);
+    pthread_attr_setstacksize(&pAttrs, CONSOLETCP_WORKER_STACK_SIZE);
+    pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    pthread_create(&thread, &pAttrs, consoleWorkerThread, NULL);
+
+    NetSched_start(&tcpCtx.task, consoleTcpFxn, &tcpCtx);
+}
+
+/*
+ *  ======== ConsoleTcp_droppedBytes ========
+ */
+uint32_t ConsoleTcp_droppedBytes(void)
+{
+    return (tcpCtx.txDropped);
+}
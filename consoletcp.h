@@ -0,0 +1,54 @@
+/*
+ *  ======== consoletcp.h ========
+ *  TCP (telnet) transport for the console.
+ *
+ *  A task on the network scheduler listens on CONSOLETCP_PORT and serves
+ *  up to CONSOLETCP_MAX_SESSIONS sessions with non-blocking sockets.
+ *  Output is queued in a per-session buffer and drained as the socket
+ *  accepts it; if a client stops reading, excess output is dropped and
+ *  counted rather than stalling the scheduler.
+ *
+ *  A session must first give the admin key (see appconfig.h); without a
+ *  provisioned key nobody can log in. Commands run on a worker thread,
+ *  one at a time, so a slow one (``time sync``, a connect) holds up only
+ *  the console and never the other tasks on the scheduler.
+ */
+#ifndef __CONSOLETCP_H
+#define __CONSOLETCP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define CONSOLETCP_PORT             (23)
+#define CONSOLETCP_MAX_SESSIONS     (3)
+#define CONSOLETCP_TX_SIZE          (1024)
+
+/* Poll period for the listening and session sockets */
+#define CONSOLETCP_POLL_MS          (50)
+
+/* Wrong passwords before the session is dropped */
+#define CONSOLETCP_LOGIN_TRIES      (3)
+
+/* Below the scheduler, like the UART console thread */
+#define CONSOLETCP_WORKER_PRIORITY  (1)
+#define CONSOLETCP_WORKER_STACK_SIZE (2048)
+
+/*!
+ *  @brief  Register the TCP console task with the network scheduler.
+ *          Must be called before the NWP acquires an IP address.
+ */
+extern void ConsoleTcp_init(void);
+
+/*!
+ *  @brief  Bytes of output dropped because a session buffer was full
+ */
+extern uint32_t ConsoleTcp_droppedBytes(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CONSOLETCP_H */
@@ -0,0 +1,398 @@
+/*
+ *  ======== crashdump.c ========
+ *  Crash dump capture into retained RAM, uploaded after the next boot
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/family/arm/m3/Hwi.h>
+
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/driverlib/rom.h>
+#include <ti/devices/cc32xx/driverlib/rom_map.h>
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/net/http/httpclient.h>
+
+#include "appconfig.h"
+#include "console.h"
+#include "crashdump.h"
+#include "netsched.h"
+#include "packbits.h"
+
+#define CRASHDUMP_SRAM_START        (0x20000000)
+#define CRASHDUMP_SRAM_END          (0x20040000)
+
+#define CRASHDUMP_UPLOAD_PRIORITY   (1)
+#define CRASHDUMP_UPLOAD_STACK_SIZE (3072)
+#define CRASHDUMP_UPLOAD_ATTEMPTS   (3)
+#define CRASHDUMP_RETRY_MS          (30000)
+
+#define CRASHDUMP_PACKED_SIZE       PACKBITS_MAX_SIZE(sizeof(CrashDump_Record))
+
+/*
+ *  Not initialized by the C runtime, see CC3220SF_LAUNCHXL_TIRTOS.cmd.
+ */
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_SECTION(dumpRecord, ".retained")
+#elif defined(__IAR_SYSTEMS_ICC__)
+#pragma location=".retained"
+__no_init
+#elif defined(__GNUC__)
+__attribute__ ((section (".retained")))
+#endif
+static CrashDump_Record dumpRecord;
+
+/* Console output ring, snapshotted into the dump. Guarded by HwiP. */
+static char             logRing[CRASHDUMP_LOG_SIZE];
+static uint32_t         logHead = 0;        /* total bytes ever written */
+
+static bool             capturedThisBoot = false;
+static bool             lastValid = false;
+
+static NetSched_Task    ipWaitTask;
+static sem_t            uploadSem;
+static uint8_t          packed[CRASHDUMP_PACKED_SIZE];
+
+/*
+ *  ======== checksum ========
+ */
+static uint32_t checksum(const CrashDump_Record *rec)
+{
+    const uint8_t *p = (const uint8_t *)&rec->version;
+    const uint8_t *end = (const uint8_t *)(rec + 1);
+    uint32_t       sum = 0x811C9DC5;
+
+    /* FNV-1a, good enough to reject power-up garbage */
+    while (p < end) {
+        sum = (sum ^ *p++) * 0x01000193;
+    }
+
+    return (sum);
+}
+
+/*
+ *  ======== snapshotLog ========
+ *  Linearize the log ring, oldest byte first.
+ */
+static uint16_t snapshotLog(char *out)
+{
+    uint32_t len;
+    uint32_t start;
+    uint32_t first;
+
+    len = (logHead < CRASHDUMP_LOG_SIZE) ? logHead : CRASHDUMP_LOG_SIZE;
+    start = (logHead - len) % CRASHDUMP_LOG_SIZE;
+    first = CRASHDUMP_LOG_SIZE - start;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(out, &logRing[start], first);
+    memcpy(out + first, logRing, len - first);
+
+    return ((uint16_t)len);
+}
+
+/*
+ *  ======== snapshotStack ========
+ *  Copy the stack window at sp, clipped to the thread's stack and to
+ *  SRAM so a corrupted sp cannot fault again in here.
+ */
+static void snapshotStack(uint32_t sp, uint32_t stackEnd)
+{
+    uint32_t len = CRASHDUMP_STACK_SIZE;
+
+    dumpRecord.stackAddr = sp;
+    dumpRecord.stackLen = 0;
+
+    if ((sp < CRASHDUMP_SRAM_START) || (sp >= CRASHDUMP_SRAM_END)) {
+        return;
+    }
+
+    /* Always, also when sp is past the thread's stack (an overflow) */
+    if (CRASHDUMP_SRAM_END - sp < len) {
+        len = CRASHDUMP_SRAM_END - sp;
+    }
+    if ((stackEnd != 0) && (sp < stackEnd) && (stackEnd - sp < len)) {
+        len = stackEnd - sp;
+    }
+    memcpy(dumpRecord.stack, (const void *)sp, len);
+    dumpRecord.stackLen = (uint16_t)len;
+}
+
+/*
+ *  ======== beginRecord ========
+ *  Returns false if this boot already captured a dump; the first fault
+ *  is the interesting one.
+ */
+static bool beginRecord(CrashDump_Cause cause, const char *reason,
+                        int32_t code)
+{
+    if (capturedThisBoot) {
+        return (false);
+    }
+    capturedThisBoot = true;
+
+    memset(&dumpRecord, 0, sizeof(dumpRecord));
+    dumpRecord.version = CRASHDUMP_VERSION;
+    dumpRecord.cause = cause;
+    dumpRecord.uptimeMs = NetSched_nowMs();
+    dumpRecord.code = code;
+    strncpy(dumpRecord.reason, reason, sizeof(dumpRecord.reason) - 1);
+    dumpRecord.logLen = snapshotLog(dumpRecord.log);
+
+    return (true);
+}
+
+/*
+ *  ======== commitRecord ========
+ */
+static void commitRecord(void)
+{
+    dumpRecord.checksum = checksum(&dumpRecord);
+    dumpRecord.state = CrashDump_State_PENDING;
+    dumpRecord.magic = CRASHDUMP_MAGIC;
+}
+
+/*
+ *  ======== CrashDump_log ========
+ */
+void CrashDump_log(const char *str)
+{
+    uintptr_t key;
+    size_t    len = strlen(str);
+    size_t    i;
+
+    key = HwiP_disable();
+    for (i = 0; i < len; i++) {
+        logRing[logHead++ % CRASHDUMP_LOG_SIZE] = str[i];
+    }
+    logRing[logHead++ % CRASHDUMP_LOG_SIZE] = '\n';
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== CrashDump_capture ========
+ */
+void CrashDump_capture(CrashDump_Cause cause, const char *reason,
+                       int32_t code)
+{
+    uint32_t  marker;
+    uintptr_t key;
+
+    key = HwiP_disable();
+    if (beginRecord(cause, reason, code)) {
+        /* A stall is detected from the watchdog interrupt: no useful stack */
+        if (cause != CrashDump_Cause_STALL) {
+            dumpRecord.regs[13] = (uint32_t)&marker;
+            snapshotStack((uint32_t)&marker, 0);
+        }
+        commitRecord();
+    }
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== CrashDump_excHook ========
+ */
+void CrashDump_excHook(void *excContext)
+{
+    Hwi_ExcContext *ctx = (Hwi_ExcContext *)excContext;
+
+    if (beginRecord(CrashDump_Cause_EXCEPTION, "exception", 0)) {
+        dumpRecord.regs[0] = (uint32_t)ctx->r0;
+        dumpRecord.regs[1] = (uint32_t)ctx->r1;
+        dumpRecord.regs[2] = (uint32_t)ctx->r2;
+        dumpRecord.regs[3] = (uint32_t)ctx->r3;
+        dumpRecord.regs[4] = (uint32_t)ctx->r4;
+        dumpRecord.regs[5] = (uint32_t)ctx->r5;
+        dumpRecord.regs[6] = (uint32_t)ctx->r6;
+        dumpRecord.regs[7] = (uint32_t)ctx->r7;
+        dumpRecord.regs[8] = (uint32_t)ctx->r8;
+        dumpRecord.regs[9] = (uint32_t)ctx->r9;
+        dumpRecord.regs[10] = (uint32_t)ctx->r10;
+        dumpRecord.regs[11] = (uint32_t)ctx->r11;
+        dumpRecord.regs[12] = (uint32_t)ctx->r12;
+        dumpRecord.regs[13] = (uint32_t)ctx->sp;
+        dumpRecord.regs[14] = (uint32_t)ctx->lr;
+        dumpRecord.regs[15] = (uint32_t)ctx->pc;
+        dumpRecord.regs[16] = (uint32_t)ctx->psr;
+        dumpRecord.cfsr = (uint32_t)ctx->MMFSR |
+                ((uint32_t)ctx->BFSR << 8) | ((uint32_t)ctx->UFSR << 16);
+        dumpRecord.hfsr = ctx->HFSR;
+        dumpRecord.mmar = ctx->MMAR;
+        dumpRecord.bfar = ctx->BFAR;
+        dumpRecord.thread = (uint32_t)ctx->threadHandle;
+        dumpRecord.code = (int32_t)ctx->threadType;
+        snapshotStack((uint32_t)ctx->sp, (ctx->threadStack == NULL) ? 0 :
+                (uint32_t)ctx->threadStack + ctx->threadStackSize);
+        commitRecord();
+    }
+
+    /* The kernel would spin in its abort handler; reset instead */
+    MAP_PRCMMCUReset(true);
+}
+
+/*
+ *  ======== upload ========
+ */
+static int16_t upload(const uint8_t *body, size_t len)
+{
+    HTTPClient_extSecParams httpClientSecParams;
+    HTTPClient_Handle       httpClientHandle;
+    AppConfig               config;
+    int16_t                 statusCode;
+    int16_t                 ret;
+
+    AppConfig_copy(&config);
+    httpClientSecParams.rootCa = "dst-root-ca-x3.der";
+    httpClientSecParams.clientCert = NULL;
+    httpClientSecParams.privateKey = NULL;
+
+    httpClientHandle = HTTPClient_create(&statusCode, 0);
+    if (statusCode < 0) {
+        return (statusCode);
+    }
+
+    ret = HTTPClient_setHeader(httpClientHandle,
+            HTTPClient_HFIELD_REQ_CONTENT_TYPE, "application/octet-stream",
+            strlen("application/octet-stream"),
+            HTTPClient_HFIELD_PERSISTENT);
+    if (ret >= 0) {
+        ret = HTTPClient_connect(httpClientHandle, config.serverHost,
+                &httpClientSecParams, 0);
+    }
+    if (ret >= 0) {
+        ret = HTTPClient_sendRequest(httpClientHandle, HTTP_METHOD_POST,
+                CRASHDUMP_UPLOAD_URI, (const char *)body, len, 0);
+        HTTPClient_disconnect(httpClientHandle);
+    }
+    HTTPClient_destroy(httpClientHandle);
+
+    return (ret);
+}
+
+/*
+ *  ======== crashUploadThread ========
+ *  HTTPClient blocks, so the one-off upload gets its own short-lived
+ *  thread instead of holding up the network scheduler.
+ */
+static void *crashUploadThread(void *arg0)
+{
+    size_t  len;
+    int16_t ret;
+    int     attempt;
+
+    len = PackBits_encode((const uint8_t *)&dumpRecord,
+            sizeof(dumpRecord), packed, sizeof(packed));
+
+    sem_wait(&uploadSem);
+
+    for (attempt = 0; attempt < CRASHDUMP_UPLOAD_ATTEMPTS; attempt++) {
+        ret = upload(packed, len);
+        if ((ret >= 200) && (ret < 300)) {
+            dumpRecord.state = CrashDump_State_UPLOADED;
+            break;
+        }
+        sleep(CRASHDUMP_RETRY_MS / 1000);
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== ipWaitFxn ========
+ *  Releases the upload thread once the device has an address.
+ */
+static PT_THREAD(ipWaitFxn(NetSched_Task *task))
+{
+    PT_BEGIN(&task->pt);
+
+    NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_IP_ACQUIRED);
+    sem_post(&uploadSem);
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== CrashDump_init ========
+ */
+bool CrashDump_init(void)
+{
+    pthread_t          thread;
+    pthread_attr_t     pAttrs;
+    struct sched_param priParam;
+
+    lastValid = (dumpRecord.magic == CRASHDUMP_MAGIC) &&
+            (dumpRecord.version == CRASHDUMP_VERSION) &&
+            (dumpRecord.checksum == checksum(&dumpRecord));
+    if (!lastValid) {
+        dumpRecord.magic = 0;
+        return (false);
+    }
+    if (dumpRecord.state != CrashDump_State_PENDING) {
+        return (false);
+    }
+
+    sem_init(&uploadSem, 0, 0);
+
+    pthread_attr_init(&pAttrs);
+    priParam.sched_priority = CRASHDUMP_UPLOAD_PRIORITY;
+    pthread_attr_setschedparam(&pAttrs, &priParam);
+    pthread_attr_setstacksize(&pAttrs, CRASHDUMP_UPLOAD_STACK_SIZE);
+    pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &pAttrs, crashUploadThread, NULL) == 0) {
+        NetSched_start(&ipWaitTask, ipWaitFxn, NULL);
+    }
+
+    return (true);
+}
+
+/*
+ *  ======== CrashDump_last ========
+ */
+const CrashDump_Record *CrashDump_last(void)
+{
+    return (lastValid ? &dumpRecord : NULL);
+}
+
+/*
+ *  ======== cmdCrashDump ========
+ */
+static void cmdCrashDump(Console_Session *session, const Console_Args *args)
+{
+    char                    printString[CONSOLE_PRINT_SIZE];
+    const CrashDump_Record *rec = CrashDump_last();
+
+    if (rec == NULL) {
+        Console_print(session, "No crash dump");
+        return;
+    }
+
+    snprintf(printString, sizeof(printString),
+            "%s (%s), cause %lu, code %ld, uptime %lu ms",
+            rec->reason,
+            (rec->state == CrashDump_State_PENDING) ? "pending" : "uploaded",
+            (unsigned long)rec->cause, (long)rec->code,
+            (unsigned long)rec->uptimeMs);
+    Console_print(session, printString);
+    snprintf(printString, sizeof(printString),
+            "pc 0x%08lx lr 0x%08lx sp 0x%08lx cfsr 0x%08lx hfsr 0x%08lx",
+            (unsigned long)rec->regs[15], (unsigned long)rec->regs[14],
+            (unsigned long)rec->regs[13], (unsigned long)rec->cfsr,
+            (unsigned long)rec->hfsr);
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(crashdump, "dump", cmdCrashDump, "", "",
+                "crash dump from before the last reset");
@@ -0,0 +1,124 @@
+/*
+ *  ======== crashdump.h ========
+ *  Crash dump capture into retained RAM, uploaded after the next boot.
+ *
+ *  A dump is captured by the kernel's exception hook on a hard fault, by
+ *  Supervisor_fatal() and by the supervisor when a thread stalls. It
+ *  holds the fault registers, a window of the faulting stack and the
+ *  last lines printed on the console, and is written to the .retained
+ *  section (SRAM_RET in CC3220SF_LAUNCHXL_TIRTOS.cmd), which the C
+ *  runtime leaves alone on an MCU reset.
+ *
+ *  On the next boot the dump is PackBits compressed and POSTed to
+ *  the configured server once an IP address is acquired, then marked as
+ *  uploaded.
+ *
+ *  The hard fault path needs this in the kernel configuration (.cfg):
+ *
+ *      var Hwi = xdc.useModule('ti.sysbios.family.arm.m3.Hwi');
+ *      Hwi.excHookFunc = "&CrashDump_excHook";
+ *
+ *  Upload format: CrashDump_Record, little endian and packed as declared
+ *  (every field is naturally aligned), compressed with PackBits
+ *  (packbits.c). Each run starts with a signed control byte n: 0..127
+ *  copies the next n + 1 bytes, -127..-1 repeats the next byte 1 - n
+ *  times, -128 is unused.
+ */
+#ifndef __CRASHDUMP_H
+#define __CRASHDUMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRASHDUMP_MAGIC             (0x504D4443)    /* "CDMP" */
+#define CRASHDUMP_VERSION           (1)
+
+/* Bytes of the faulting stack kept, starting at the stack pointer */
+#define CRASHDUMP_STACK_SIZE        (512)
+
+/* Console output kept, oldest first */
+#define CRASHDUMP_LOG_SIZE          (1024)
+
+#define CRASHDUMP_UPLOAD_URI        "/post"
+
+/*!
+ *  @brief  What captured the dump
+ */
+typedef enum CrashDump_Cause {
+    CrashDump_Cause_NONE = 0,
+    CrashDump_Cause_EXCEPTION,      /* hard fault, registers are valid */
+    CrashDump_Cause_FATAL,          /* Supervisor_fatal() */
+    CrashDump_Cause_STALL           /* supervised thread missed a deadline */
+} CrashDump_Cause;
+
+typedef enum CrashDump_State {
+    CrashDump_State_EMPTY = 0,
+    CrashDump_State_PENDING,        /* captured, not uploaded yet */
+    CrashDump_State_UPLOADED
+} CrashDump_State;
+
+typedef struct CrashDump_Record {
+    uint32_t    magic;
+    uint32_t    state;              /* CrashDump_State */
+    uint32_t    checksum;           /* over everything from version on */
+    uint32_t    version;
+    uint32_t    cause;              /* CrashDump_Cause */
+    uint32_t    uptimeMs;
+    int32_t     code;
+    char        reason[48];
+    uint32_t    regs[17];           /* r0-r12, sp, lr, pc, psr */
+    uint32_t    cfsr;               /* MMFSR | BFSR << 8 | UFSR << 16 */
+    uint32_t    hfsr;
+    uint32_t    mmar;
+    uint32_t    bfar;
+    uint32_t    thread;             /* kernel handle of the faulting thread */
+    uint32_t    stackAddr;          /* address of stack[0] */
+    uint16_t    stackLen;
+    uint16_t    logLen;
+    uint8_t     stack[CRASHDUMP_STACK_SIZE];
+    char        log[CRASHDUMP_LOG_SIZE];
+} CrashDump_Record;
+
+/*!
+ *  @brief  Check for a pending dump and, if there is one, schedule its
+ *          upload. Call after NetSched_init().
+ *
+ *  @return true if a dump from before the last reset is pending
+ */
+extern bool CrashDump_init(void);
+
+/*!
+ *  @brief  Append a console line to the log ring
+ */
+extern void CrashDump_log(const char *str);
+
+/*!
+ *  @brief  Capture a dump outside of an exception, from the caller's
+ *          stack. The first capture since boot wins.
+ */
+extern void CrashDump_capture(CrashDump_Cause cause, const char *reason,
+                              int32_t code);
+
+/*!
+ *  @brief  Kernel exception hook, see the top of this file. Resets the
+ *          device after capturing.
+ */
+extern void CrashDump_excHook(void *excContext);
+
+/*!
+ *  @brief  Dump from before the last reset, pending or uploaded
+ *
+ *  @return NULL if there is none
+ */
+extern const CrashDump_Record *CrashDump_last(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRASHDUMP_H */
@@ -0,0 +1,45 @@
+/*
+ *  ======== cycles.h ========
+ *  Cortex-M4 DWT cycle counter, for measuring the cost of DSP and
+ *  measurement code. Counts CPU clocks (80 MHz) and wraps every 53 s;
+ *  differences of two values give elapsed cycles.
+ */
+#ifndef __CYCLES_H
+#define __CYCLES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include <ti/devices/cc32xx/inc/hw_types.h>
+
+#define CYCLES_DEMCR                (0xE000EDFC)
+#define CYCLES_DEMCR_TRCENA         (0x01000000)
+#define CYCLES_DWT_CTRL             (0xE0001000)
+#define CYCLES_DWT_CTRL_CYCCNTENA   (0x00000001)
+#define CYCLES_DWT_CYCCNT           (0xE0001004)
+
+/*!
+ *  @brief  Start the counter. Idempotent, so every user may call it.
+ */
+static inline void Cycles_enable(void)
+{
+    HWREG(CYCLES_DEMCR) |= CYCLES_DEMCR_TRCENA;
+    HWREG(CYCLES_DWT_CTRL) |= CYCLES_DWT_CTRL_CYCCNTENA;
+}
+
+/*!
+ *  @brief  Current count
+ */
+static inline uint32_t Cycles_now(void)
+{
+    return (HWREG(CYCLES_DWT_CYCCNT));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CYCLES_H */
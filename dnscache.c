@@ -0,0 +1,280 @@
+/*
+ *  ======== dnscache.c ========
+ *  Host name cache with deferred refresh and stale fallback
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/net/slnetutils.h>
+
+#include "console.h"
+#include "dnscache.h"
+#include "hibernate.h"
+#include "netsched.h"
+
+typedef struct Entry {
+    char        host[DNSCACHE_MAX_HOST];
+    uint32_t    addr;               /* network order */
+    uint32_t    resolvedMs;
+    uint32_t    restoredHash;       /* host of an address from hibernate */
+    bool        valid;
+    bool        expired;            /* forced stale, e.g. after hibernate */
+    bool        refreshPending;
+} Entry;
+
+/* Only the upload thread resolves, so the entries need no lock */
+static Entry            entries[DNSCACHE_ENTRIES];
+static DnsCache_Stats   stats;
+
+/*
+ *  ======== hostHash ========
+ *  FNV-1a, identifies the host across hibernate.
+ */
+static uint32_t hostHash(const char *host)
+{
+    uint32_t hash = 0x811C9DC5;
+
+    while (*host) {
+        hash = (hash ^ (uint8_t)*host++) * 0x01000193;
+    }
+
+    return (hash);
+}
+
+/*
+ *  ======== lookup ========
+ */
+static int32_t lookup(const char *host, uint32_t *addr)
+{
+    SlNetUtil_addrInfo_t  hints;
+    SlNetUtil_addrInfo_t *res = NULL;
+    int32_t               ret;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = SLNETSOCK_AF_INET;
+    hints.ai_socktype = SLNETSOCK_SOCK_STREAM;
+
+    ret = SlNetUtil_getAddrInfo(0, host, NULL, &hints, &res);
+    if (ret != 0) {
+        stats.failures++;
+        return ((ret < 0) ? ret : SLNETERR_RET_CODE_INVALID_INPUT);
+    }
+    *addr = ((SlNetSock_AddrIn_t *)res->ai_addr)->sin_addr.s_addr;
+    SlNetUtil_freeAddrInfo(res);
+
+    return (0);
+}
+
+/*
+ *  ======== store ========
+ */
+static void store(Entry *e, uint32_t addr)
+{
+    e->addr = addr;
+    e->resolvedMs = NetSched_nowMs();
+    e->valid = true;
+    e->expired = false;
+    e->refreshPending = false;
+
+    if (e == &entries[0]) {
+        Hibernate_noteServer(hostHash(e->host), addr);
+    }
+}
+
+/*
+ *  ======== find ========
+ */
+static Entry *find(const char *host)
+{
+    int i;
+
+    for (i = 0; i < DNSCACHE_ENTRIES; i++) {
+        if (entries[i].host[0] && (strcmp(entries[i].host, host) == 0)) {
+            return (&entries[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== allocate ========
+ *  A free entry, or the least recently resolved one. The first entry
+ *  is held while it has an address from hibernate no host has claimed.
+ */
+static Entry *allocate(const char *host)
+{
+    Entry *e = NULL;
+    int    i;
+
+    for (i = 0; i < DNSCACHE_ENTRIES; i++) {
+        if ((entries[i].host[0] == '\0') && (entries[i].restoredHash != 0)) {
+            continue;
+        }
+        if (entries[i].host[0] == '\0') {
+            e = &entries[i];
+            break;
+        }
+        if ((e == NULL) ||
+                ((int32_t)(entries[i].resolvedMs - e->resolvedMs) < 0)) {
+            e = &entries[i];
+        }
+    }
+
+    memset(e, 0, sizeof(*e));
+    strncpy(e->host, host, sizeof(e->host) - 1);
+
+    return (e);
+}
+
+/*
+ *  ======== DnsCache_restore ========
+ */
+void DnsCache_restore(void)
+{
+    uint32_t addr;
+    uint32_t hash;
+
+    if (!Hibernate_lastServer(&hash, &addr)) {
+        return;
+    }
+
+    /* Only the hash of the host was saved; it is matched on first use */
+    entries[0].addr = addr;
+    entries[0].restoredHash = hash;
+    entries[0].expired = true;
+}
+
+/*
+ *  ======== DnsCache_resolve ========
+ */
+int32_t DnsCache_resolve(const char *host, SlNetSock_AddrIn_t *addr)
+{
+    Entry   *e = find(host);
+    uint32_t resolved;
+    int32_t  ret;
+
+    if ((e == NULL) && (entries[0].host[0] == '\0') &&
+            (entries[0].restoredHash != 0) &&
+            (entries[0].restoredHash == hostHash(host))) {
+        /* The server address saved across hibernate */
+        e = &entries[0];
+        strncpy(e->host, host, sizeof(e->host) - 1);
+        e->valid = true;
+    }
+
+    if ((e != NULL) && e->valid) {
+        if (e->expired ||
+                ((NetSched_nowMs() - e->resolvedMs) >= DNSCACHE_TTL_MS)) {
+            e->refreshPending = true;
+            stats.stale++;
+        }
+        else {
+            stats.hits++;
+        }
+        addr->sin_addr.s_addr = e->addr;
+        return (0);
+    }
+
+    stats.misses++;
+    ret = lookup(host, &resolved);
+    if (ret < 0) {
+        return (ret);
+    }
+    if (e == NULL) {
+        e = allocate(host);
+    }
+    store(e, resolved);
+    addr->sin_addr.s_addr = resolved;
+
+    return (0);
+}
+
+/*
+ *  ======== DnsCache_invalidate ========
+ */
+void DnsCache_invalidate(const char *host)
+{
+    Entry *e = find(host);
+
+    if (e != NULL) {
+        e->valid = false;
+        e->refreshPending = false;
+    }
+}
+
+/*
+ *  ======== DnsCache_refresh ========
+ */
+void DnsCache_refresh(void)
+{
+    uint32_t addr;
+    int      i;
+
+    for (i = 0; i < DNSCACHE_ENTRIES; i++) {
+        if (!entries[i].refreshPending) {
+            continue;
+        }
+        if (lookup(entries[i].host, &addr) == 0) {
+            store(&entries[i], addr);
+            stats.refreshes++;
+        }
+        else {
+            /* Keep serving the old address; try again after the next use */
+            entries[i].refreshPending = false;
+        }
+    }
+}
+
+/*
+ *  ======== DnsCache_getStats ========
+ */
+void DnsCache_getStats(DnsCache_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdDnsCache ========
+ */
+static void cmdDnsCache(Console_Session *session, const Console_Args *args)
+{
+    char           printString[CONSOLE_PRINT_SIZE];
+    DnsCache_Stats s;
+    uint32_t       a;
+    int            i;
+
+    DnsCache_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "hits %lu, stale %lu, misses %lu, refreshes %lu, failures %lu",
+            (unsigned long)s.hits, (unsigned long)s.stale,
+            (unsigned long)s.misses, (unsigned long)s.refreshes,
+            (unsigned long)s.failures);
+    Console_print(session, printString);
+
+    for (i = 0; i < DNSCACHE_ENTRIES; i++) {
+        if (!entries[i].valid) {
+            continue;
+        }
+        a = SlNetUtil_ntohl(entries[i].addr);
+        snprintf(printString, sizeof(printString),
+                "%s %lu.%lu.%lu.%lu, %lu s old%s", entries[i].host,
+                (unsigned long)(a >> 24), (unsigned long)((a >> 16) & 0xFF),
+                (unsigned long)((a >> 8) & 0xFF), (unsigned long)(a & 0xFF),
+                (unsigned long)((NetSched_nowMs() - entries[i].resolvedMs) /
+                        1000),
+                entries[i].expired ? ", from hibernate" : "");
+        Console_print(session, printString);
+    }
+}
+
+CONSOLE_COMMAND(dnscache, "dns", cmdDnsCache, "", "",
+                "DNS cache entries and counters");
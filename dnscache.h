@@ -0,0 +1,79 @@
+/*
+ *  ======== dnscache.h ========
+ *  Host name cache in front of SlNetUtil_getAddrInfo().
+ *
+ *  A fresh entry (younger than DNSCACHE_TTL_MS) is returned without any
+ *  network traffic. An expired entry is still returned at once and
+ *  marked for refresh; the caller runs DnsCache_refresh() when it has
+ *  finished its time critical work, so the lookup never sits in front of
+ *  a request. Only a host that has never been resolved costs a lookup
+ *  up front. If a lookup fails the old address keeps being served.
+ *
+ *  The NWP resolver does not report record TTLs, so DNSCACHE_TTL_MS is
+ *  a fixed upper bound on the age of an address.
+ *
+ *  The address of the first entry (the report server) is carried across
+ *  hibernate in Hibernate_State and comes back expired, i.e. served
+ *  while it is refreshed.
+ *
+ *  The cache only covers plain http. HTTPClient_connect2(), the only
+ *  way to hand the client an address, has no way to pass the host name
+ *  for SNI and the certificate's domain check, so an https server is
+ *  connected by name and resolved by the NWP on every connect; no entry
+ *  is made for it.
+ */
+#ifndef __DNSCACHE_H
+#define __DNSCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ti/net/slnetsock.h>
+
+#define DNSCACHE_ENTRIES            (4)
+#define DNSCACHE_MAX_HOST           (64)
+#define DNSCACHE_TTL_MS             (60 * 60 * 1000)
+
+typedef struct DnsCache_Stats {
+    uint32_t    hits;               /* fresh entry */
+    uint32_t    stale;              /* expired entry served */
+    uint32_t    misses;             /* looked up before returning */
+    uint32_t    refreshes;          /* deferred lookups that succeeded */
+    uint32_t    failures;           /* lookups that failed */
+} DnsCache_Stats;
+
+/*!
+ *  @brief  Bring back the server address saved across hibernate.
+ *          Call after Hibernate_restore().
+ */
+extern void DnsCache_restore(void);
+
+/*!
+ *  @brief  IPv4 address of host, port and family left to the caller
+ *
+ *  @return 0 on success, negative SlNetSock error otherwise
+ */
+extern int32_t DnsCache_resolve(const char *host, SlNetSock_AddrIn_t *addr);
+
+/*!
+ *  @brief  Forget the address of host, e.g. after it refused a
+ *          connection; the next resolve looks it up
+ */
+extern void DnsCache_invalidate(const char *host);
+
+/*!
+ *  @brief  Run the lookups deferred by DnsCache_resolve(). Blocks.
+ */
+extern void DnsCache_refresh(void);
+
+extern void DnsCache_getStats(DnsCache_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DNSCACHE_H */
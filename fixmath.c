@@ -0,0 +1,32 @@
+/*
+ *  ======== fixmath.c ========
+ *  Integer helpers shared by the signal and statistics code
+ */
+#include <stdint.h>
+
+#include "fixmath.h"
+
+/*
+ *  ======== FixMath_isqrt ========
+ */
+uint32_t FixMath_isqrt(uint64_t x)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return ((uint32_t)root);
+}
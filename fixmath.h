@@ -0,0 +1,23 @@
+/*
+ *  ======== fixmath.h ========
+ *  Integer helpers shared by the signal and statistics code
+ */
+#ifndef __FIXMATH_H
+#define __FIXMATH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*!
+ *  @brief  floor(sqrt(x)), bit by bit; no division, no floating point
+ */
+extern uint32_t FixMath_isqrt(uint64_t x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FIXMATH_H */
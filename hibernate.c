@@ -0,0 +1,323 @@
+/*
+ *  ======== hibernate.c ========
+ *  Hibernate between reports, with a warm restore on wake-up
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/driverlib/rom.h>
+#include <ti/devices/cc32xx/driverlib/rom_map.h>
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC32XX.h>
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "alarms.h"
+#include "boot.h"
+#include "console.h"
+#include "hibernate.h"
+#include "netsched.h"
+#include "totalizer.h"
+
+/* Time the NWP gets to close connections before it is stopped */
+#define HIBERNATE_NWP_STOP_MS       (200)
+
+Hibernate_State hibernateState;
+
+static Hibernate_Wake   wake = Hibernate_Wake_COLD;
+static NetSched_Task    hibernateTask;
+static volatile uint32_t requestedMs;
+
+/*
+ *  ======== Hibernate_init ========
+ */
+Hibernate_Wake Hibernate_init(void)
+{
+    memset(&hibernateState, 0, sizeof(hibernateState));
+    wake = Hibernate_Wake_COLD;
+
+    if ((MAP_PRCMSysResetCauseGet() == PRCM_HIB_EXIT) &&
+            (MAP_PRCMOCRRegisterRead(HIBERNATE_OCR_MAGIC_INDEX) ==
+             HIBERNATE_OCR_MAGIC)) {
+        wake = (MAP_PRCMHibernateWakeupCauseGet() ==
+                PRCM_HIB_WAKEUP_CAUSE_GPIO) ?
+                Hibernate_Wake_GPIO : Hibernate_Wake_TIMER;
+    }
+
+    /* A reset from here on is a cold boot */
+    MAP_PRCMOCRRegisterWrite(HIBERNATE_OCR_MAGIC_INDEX, 0);
+
+    return (wake);
+}
+
+/*
+ *  ======== Hibernate_wake ========
+ */
+Hibernate_Wake Hibernate_wake(void)
+{
+    return (wake);
+}
+
+/*
+ *  ======== Hibernate_restore ========
+ */
+bool Hibernate_restore(void)
+{
+    Hibernate_State stored;
+    _u32            token = 0;
+    _i32            fd;
+    _i32            len;
+
+    if (wake == Hibernate_Wake_COLD) {
+        return (false);
+    }
+
+    fd = sl_FsOpen((const _u8 *)HIBERNATE_FILE_NAME, SL_FS_READ, &token);
+    if (fd < 0) {
+        wake = Hibernate_Wake_COLD;
+        return (false);
+    }
+    len = sl_FsRead(fd, 0, (_u8 *)&stored, sizeof(stored));
+    sl_FsClose(fd, NULL, NULL, 0);
+
+    if ((len != sizeof(stored)) || (stored.sequence !=
+            MAP_PRCMOCRRegisterRead(HIBERNATE_OCR_SEQ_INDEX))) {
+        wake = Hibernate_Wake_COLD;
+        return (false);
+    }
+
+    hibernateState = stored;
+    hibernateState.wakeCount++;
+
+    return (true);
+}
+
+/*
+ *  ======== Hibernate_noteAp ========
+ */
+void Hibernate_noteAp(const uint8_t *bssid)
+{
+    memcpy(hibernateState.apBssid, bssid, sizeof(hibernateState.apBssid));
+}
+
+/*
+ *  ======== Hibernate_lastAp ========
+ */
+bool Hibernate_lastAp(uint8_t *bssid)
+{
+    static const uint8_t none[6] = {0};
+
+    if ((wake == Hibernate_Wake_COLD) ||
+            (memcmp(hibernateState.apBssid, none, sizeof(none)) == 0)) {
+        return (false);
+    }
+    memcpy(bssid, hibernateState.apBssid, sizeof(hibernateState.apBssid));
+
+    return (true);
+}
+
+/*
+ *  ======== Hibernate_noteServer ========
+ */
+void Hibernate_noteServer(uint32_t hostHash, uint32_t addr)
+{
+    hibernateState.serverHash = hostHash;
+    hibernateState.serverAddr = addr;
+}
+
+/*
+ *  ======== Hibernate_lastServer ========
+ */
+bool Hibernate_lastServer(uint32_t *hostHash, uint32_t *addr)
+{
+    if ((wake == Hibernate_Wake_COLD) || (hibernateState.serverAddr == 0)) {
+        return (false);
+    }
+    *hostHash = hibernateState.serverHash;
+    *addr = hibernateState.serverAddr;
+
+    return (true);
+}
+
+/*
+ *  ======== Hibernate_noteClock ========
+ */
+void Hibernate_noteClock(const Hibernate_Clock *clock)
+{
+    hibernateState.clock = *clock;
+}
+
+/*
+ *  ======== Hibernate_lastClock ========
+ */
+bool Hibernate_lastClock(Hibernate_Clock *clock)
+{
+    if ((wake == Hibernate_Wake_COLD) ||
+            (hibernateState.clock.baseUtcUs == 0)) {
+        return (false);
+    }
+    *clock = hibernateState.clock;
+
+    return (true);
+}
+
+/*
+ *  ======== Hibernate_noteAlarms ========
+ */
+void Hibernate_noteAlarms(const Hibernate_Alarms *alarms)
+{
+    hibernateState.alarms = *alarms;
+}
+
+/*
+ *  ======== Hibernate_lastAlarms ========
+ */
+bool Hibernate_lastAlarms(Hibernate_Alarms *alarms)
+{
+    if (wake == Hibernate_Wake_COLD) {
+        return (false);
+    }
+    *alarms = hibernateState.alarms;
+
+    return (true);
+}
+
+/*
+ *  ======== Hibernate_noteSchedule ========
+ */
+void Hibernate_noteSchedule(const Hibernate_Schedule *schedule)
+{
+    hibernateState.schedule = *schedule;
+}
+
+/*
+ *  ======== Hibernate_lastSchedule ========
+ */
+bool Hibernate_lastSchedule(Hibernate_Schedule *schedule)
+{
+    if ((wake == Hibernate_Wake_COLD) ||
+            (hibernateState.schedule.monoMs == 0)) {
+        return (false);
+    }
+    *schedule = hibernateState.schedule;
+
+    return (true);
+}
+
+/*
+ *  ======== save ========
+ */
+static int32_t save(void)
+{
+    _u32 token = 0;
+    _i32 fd;
+    _i32 ret;
+    uint32_t toIpMs;
+
+    if (Boot_elapsedMs(Boot_Phase_IP_ACQUIRED, &toIpMs)) {
+        if (wake == Hibernate_Wake_COLD) {
+            hibernateState.coldToIpMs = toIpMs;
+        }
+        else {
+            hibernateState.warmToIpMs = toIpMs;
+        }
+    }
+    hibernateState.sequence =
+            MAP_PRCMOCRRegisterRead(HIBERNATE_OCR_SEQ_INDEX) + 1;
+    hibernateState.sleepMs = requestedMs;
+
+    fd = sl_FsOpen((const _u8 *)HIBERNATE_FILE_NAME,
+            SL_FS_CREATE | SL_FS_OVERWRITE |
+            SL_FS_CREATE_MAX_SIZE(sizeof(Hibernate_State)), &token);
+    if (fd < 0) {
+        return (fd);
+    }
+    ret = sl_FsWrite(fd, 0, (_u8 *)&hibernateState, sizeof(hibernateState));
+    sl_FsClose(fd, NULL, NULL, 0);
+    if (ret != sizeof(hibernateState)) {
+        return ((ret < 0) ? ret : -1);
+    }
+
+    MAP_PRCMOCRRegisterWrite(HIBERNATE_OCR_SEQ_INDEX,
+            hibernateState.sequence);
+    MAP_PRCMOCRRegisterWrite(HIBERNATE_OCR_MAGIC_INDEX, HIBERNATE_OCR_MAGIC);
+
+    return (0);
+}
+
+/*
+ *  ======== hibernateFxn ========
+ *  Runs on the network scheduler because the state goes through the NWP
+ *  file system and the NWP has to be stopped cleanly.
+ */
+static PT_THREAD(hibernateFxn(NetSched_Task *task))
+{
+    PT_BEGIN(&task->pt);
+
+    while (1) {
+        NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_HIBERNATE);
+
+        /* Without saved state the wake-up would be a cold boot anyway */
+        Totalizer_save();
+        Alarms_persist();
+        save();
+        sl_Stop(HIBERNATE_NWP_STOP_MS);
+        Power_shutdown(0, requestedMs);
+
+        /* Only reached if the shutdown was refused */
+        MAP_PRCMOCRRegisterWrite(HIBERNATE_OCR_MAGIC_INDEX, 0);
+        sl_Start(0, 0, 0);
+    }
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== Hibernate_start ========
+ */
+void Hibernate_start(void)
+{
+    NetSched_start(&hibernateTask, hibernateFxn, NULL);
+}
+
+/*
+ *  ======== Hibernate_request ========
+ */
+void Hibernate_request(uint32_t sleepMs)
+{
+    requestedMs = sleepMs;
+    NetSched_signal(NETSCHED_EVENT_HIBERNATE);
+}
+
+/*
+ *  ======== cmdHibernate ========
+ */
+static void cmdHibernate(Console_Session *session, const Console_Args *args)
+{
+    static const char *const wakeNames[] = {"cold", "timer", "gpio"};
+    char printString[CONSOLE_PRINT_SIZE];
+
+    if (args->argc > 0) {
+        if (args->num[0] <= 0) {
+            Console_print(session, "Sleep time must be positive");
+            return;
+        }
+        Console_print(session, "Hibernating");
+        Hibernate_request((uint32_t)args->num[0] * 1000);
+        return;
+    }
+
+    snprintf(printString, sizeof(printString),
+            "Boot: %s, cycles %lu, boot to IP: cold %lu ms, warm %lu ms",
+            wakeNames[wake], (unsigned long)hibernateState.wakeCount,
+            (unsigned long)hibernateState.coldToIpMs,
+            (unsigned long)hibernateState.warmToIpMs);
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(hibernate, "hib", cmdHibernate, "i", "[seconds]",
+                "hibernate, or show the last cycles");
@@ -0,0 +1,193 @@
+/*
+ *  ======== hibernate.h ========
+ *  Hibernate between reports, with a warm restore on wake-up.
+ *
+ *  Hibernate keeps only the RTC and the on-chip retention (OCR)
+ *  registers powered; SRAM is lost. Before shutting down, the state
+ *  below is written to HIBERNATE_FILE_NAME in the NWP file system and a
+ *  sequence number is put in an OCR register. After a wake-up from
+ *  hibernate the file is only trusted if its sequence number matches,
+ *  so a stale file from an earlier cycle or a cold boot never restores.
+ *
+ *  The device wakes on the RTC after the requested time or on the
+ *  shutdown GPIO configured in PowerCC32XX_config: GPIO13, the pin of
+ *  the pulse input (Board_CAPTURE0). Flow that starts while the device
+ *  hibernates therefore wakes it with its first pulse, which the
+ *  totalizer counts. Everything else the measurement does stops while
+ *  it sleeps, so the uploader only asks for hibernate once the flow has
+ *  stopped and no alarm rule is pending.
+ */
+#ifndef __HIBERNATE_H
+#define __HIBERNATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HIBERNATE_FILE_NAME         "/flowness/hib.bin"
+
+/* OCR register layout */
+#define HIBERNATE_OCR_MAGIC_INDEX   (0)
+#define HIBERNATE_OCR_SEQ_INDEX     (1)
+#define HIBERNATE_OCR_MAGIC         (0x48494221)    /* "HIB!" */
+
+/* Alarm rules whose state is kept, see alarms.h */
+#define HIBERNATE_MAX_RULES         (8)
+
+/*!
+ *  @brief  Wall clock discipline, see timebase.h
+ */
+typedef struct Hibernate_Clock {
+    uint64_t    baseMonoUs;         /* monotonic time of the last sync */
+    int64_t     baseUtcUs;          /* UTC at baseMonoUs, 0 if never set */
+    int32_t     freqPpb;            /* rate correction */
+    int32_t     slewUs;             /* offset being slewed in */
+} Hibernate_Clock;
+
+/*!
+ *  @brief  Alarm rule state, see alarms.h
+ */
+typedef struct Hibernate_Alarms {
+    uint32_t    activeMask;         /* raised rules */
+    uint32_t    pendingMask;        /* condition true, not held long enough */
+    uint32_t    heldMs[HIBERNATE_MAX_RULES];    /* of the pending ones */
+} Hibernate_Alarms;
+
+/*!
+ *  @brief  Upload schedule, see upsched.h. Deadlines are kept as the
+ *          time left at monoMs, so the time asleep can be taken off.
+ */
+typedef struct Hibernate_Schedule {
+    uint32_t    monoMs;             /* Timebase_monoMs() of the save, 0 none */
+    uint32_t    routineInMs;
+    uint32_t    pollInMs;
+    uint32_t    retryInMs;          /* urgent retry, if pending */
+    uint32_t    deviceHash;
+    uint32_t    random;
+    uint32_t    urgentLastMs;
+    uint32_t    urgentFailures;
+    uint32_t    routineLastMs;
+    uint32_t    routineFailures;
+    uint8_t     identified;
+    uint8_t     urgentPending;
+    uint16_t    reserved;
+} Hibernate_Schedule;
+
+/*!
+ *  @brief  State carried across hibernate. Append new fields.
+ */
+typedef struct Hibernate_State {
+    uint32_t    sequence;           /* must match the OCR register */
+    uint32_t    wakeCount;          /* hibernate cycles since cold boot */
+    uint32_t    sleepMs;            /* last requested sleep */
+    uint8_t     apBssid[6];         /* AP we were connected to, or zero */
+    uint16_t    reserved;
+    uint32_t    coldToIpMs;         /* boot to IP, last cold boot */
+    uint32_t    warmToIpMs;         /* boot to IP, last warm restore */
+    uint32_t    serverHash;         /* report server host, see dnscache.h */
+    uint32_t    serverAddr;         /* its IPv4 address, network order */
+    Hibernate_Clock clock;
+    Hibernate_Alarms alarms;
+    Hibernate_Schedule schedule;
+} Hibernate_State;
+
+/*!
+ *  @brief  How this boot started
+ */
+typedef enum Hibernate_Wake {
+    Hibernate_Wake_COLD = 0,        /* power-up or reset */
+    Hibernate_Wake_TIMER,           /* RTC after Hibernate_request() */
+    Hibernate_Wake_GPIO             /* pulse input (SW3 on the LaunchPad) */
+} Hibernate_Wake;
+
+/*!
+ *  @brief  Live state, valid after Hibernate_restore()
+ */
+extern Hibernate_State hibernateState;
+
+/*!
+ *  @brief  Classify the boot from the reset cause and the OCR
+ *          registers. Needs neither the NWP nor the kernel clock.
+ */
+extern Hibernate_Wake Hibernate_init(void);
+
+extern Hibernate_Wake Hibernate_wake(void);
+
+/*!
+ *  @brief  Load the saved state after a wake-up from hibernate; falls
+ *          back to a cold state if the file is missing or stale. Needs
+ *          the NWP.
+ *
+ *  @return true if the state was restored
+ */
+extern bool Hibernate_restore(void);
+
+/*!
+ *  @brief  Record the AP from a connect event for the next fast connect
+ */
+extern void Hibernate_noteAp(const uint8_t *bssid);
+
+/*!
+ *  @brief  AP from before hibernate, if any
+ */
+extern bool Hibernate_lastAp(uint8_t *bssid);
+
+/*!
+ *  @brief  Record the resolved report server for the next wake-up
+ */
+extern void Hibernate_noteServer(uint32_t hostHash, uint32_t addr);
+
+/*!
+ *  @brief  Report server address from before hibernate, if any
+ */
+extern bool Hibernate_lastServer(uint32_t *hostHash, uint32_t *addr);
+
+/*!
+ *  @brief  Record the clock discipline after a time sync
+ */
+extern void Hibernate_noteClock(const Hibernate_Clock *clock);
+
+/*!
+ *  @brief  Clock discipline from before hibernate, if any
+ */
+extern bool Hibernate_lastClock(Hibernate_Clock *clock);
+
+/*!
+ *  @brief  Record the alarm rule state before hibernate
+ */
+extern void Hibernate_noteAlarms(const Hibernate_Alarms *alarms);
+
+/*!
+ *  @brief  Alarm rule state from before hibernate, if any
+ */
+extern bool Hibernate_lastAlarms(Hibernate_Alarms *alarms);
+
+/*!
+ *  @brief  Record the upload schedule before hibernate
+ */
+extern void Hibernate_noteSchedule(const Hibernate_Schedule *schedule);
+
+/*!
+ *  @brief  Upload schedule from before hibernate, if any
+ */
+extern bool Hibernate_lastSchedule(Hibernate_Schedule *schedule);
+
+/*!
+ *  @brief  Save state, stop the NWP and hibernate for sleepMs. Runs on
+ *          the network scheduler; returns immediately.
+ */
+extern void Hibernate_request(uint32_t sleepMs);
+
+/*!
+ *  @brief  Start the task that carries out Hibernate_request()
+ */
+extern void Hibernate_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HIBERNATE_H */
@@ -0,0 +1,171 @@
+/*
+ *  ======== httpcache.c ========
+ *  Conditional GET with a flash backed copy of the last response
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <ti/drivers/net/wifi/simplelink.h>
+#include <ti/net/http/httpclient.h>
+
+#include "httpcache.h"
+#include "httpreq.h"
+
+/* Body of a response being received; only the upload thread polls */
+static char incoming[HTTPCACHE_BODY_SIZE];
+
+/*
+ *  ======== save ========
+ */
+static int32_t save(const HttpCache_Resource *res)
+{
+    _u32 token = 0;
+    _i32 fd;
+    _i32 ret;
+
+    fd = sl_FsOpen((const _u8 *)res->fileName,
+            SL_FS_CREATE | SL_FS_OVERWRITE |
+            SL_FS_CREATE_MAX_SIZE(sizeof(HttpCache_Record)), &token);
+    if (fd < 0) {
+        return (fd);
+    }
+
+    ret = sl_FsWrite(fd, 0, (_u8 *)&res->record, sizeof(res->record));
+    sl_FsClose(fd, NULL, NULL, 0);
+
+    return ((ret == sizeof(res->record)) ? 0 : ((ret < 0) ? ret : -1));
+}
+
+/*
+ *  ======== HttpCache_load ========
+ */
+bool HttpCache_load(HttpCache_Resource *res)
+{
+    _u32 token = 0;
+    _i32 fd;
+    _i32 len;
+
+    res->valid = false;
+
+    fd = sl_FsOpen((const _u8 *)res->fileName, SL_FS_READ, &token);
+    if (fd < 0) {
+        return (false);
+    }
+    len = sl_FsRead(fd, 0, (_u8 *)&res->record, sizeof(res->record));
+    sl_FsClose(fd, NULL, NULL, 0);
+
+    if ((len != sizeof(res->record)) ||
+            (res->record.magic != HTTPCACHE_MAGIC) ||
+            (res->record.length >= HTTPCACHE_BODY_SIZE)) {
+        memset(&res->record, 0, sizeof(res->record));
+        return (false);
+    }
+    res->record.etag[HTTPCACHE_ETAG_SIZE - 1] = '\0';
+    res->record.lastModified[HTTPCACHE_DATE_SIZE - 1] = '\0';
+    res->record.body[res->record.length] = '\0';
+    res->valid = true;
+
+    return (true);
+}
+
+/*
+ *  ======== HttpCache_invalidate ========
+ */
+void HttpCache_invalidate(HttpCache_Resource *res)
+{
+    res->valid = false;
+    res->record.etag[0] = '\0';
+    res->record.lastModified[0] = '\0';
+}
+
+/*
+ *  ======== HttpCache_get ========
+ */
+int16_t HttpCache_get(HttpCache_Resource *res, HttpReq_Session *session)
+{
+    HttpCache_Record *r = &res->record;
+    HTTPClient_Handle handle = session->handle;
+    HttpReq_Endpoint  endpoint = {HTTP_METHOD_GET, res->uri, NULL};
+    uint32_t          size;
+    size_t            len;
+    int16_t           status;
+    int16_t           ret;
+
+    /* Connected first, so a failure leaves no conditional header behind */
+    ret = HttpReq_open(session);
+    if (ret < 0) {
+        res->failed++;
+        return (ret);
+    }
+
+    /* Ask HTTPClient to keep the validators of the response */
+    HTTPClient_setHeader(handle, HTTPClient_HFIELD_RES_ETAG, NULL, 0,
+            HTTPClient_HFIELD_PERSISTENT);
+    HTTPClient_setHeader(handle, HTTPClient_HFIELD_RES_LAST_MODIFIED, NULL,
+            0, HTTPClient_HFIELD_PERSISTENT);
+
+    /* ETag is exact; Last-Modified only when the server gave no ETag */
+    if (res->valid && r->etag[0]) {
+        HTTPClient_setHeader(handle, HTTPClient_HFIELD_REQ_IF_NONE_MATCH,
+                r->etag, strlen(r->etag), HTTPClient_HFIELD_NOT_PERSISTENT);
+    }
+    else if (res->valid && r->lastModified[0]) {
+        HTTPClient_setHeader(handle, HTTPClient_HFIELD_REQ_IF_MODIFIED_SINCE,
+                r->lastModified, strlen(r->lastModified),
+                HTTPClient_HFIELD_NOT_PERSISTENT);
+    }
+
+    status = HttpReq_fetch(session, &endpoint, NULL, 0, incoming,
+            sizeof(incoming), &len);
+    if (status < 0) {
+        res->failed++;
+        return (status);
+    }
+    res->bytes += len;
+
+    if (status == HTTP_SC_NOT_MODIFIED) {
+        res->notModified++;
+        return (status);
+    }
+    if (status != HTTP_SC_OK) {
+        res->failed++;
+        return (status);
+    }
+    if (len >= sizeof(incoming)) {
+        res->failed++;
+        return (HTTPCACHE_ETOOLARGE);
+    }
+
+    r->magic = HTTPCACHE_MAGIC;
+    memcpy(r->body, incoming, len + 1);
+    r->length = (uint16_t)len;
+
+    size = sizeof(r->etag);
+    ret = HTTPClient_getHeader(handle, HTTPClient_HFIELD_RES_ETAG, r->etag,
+            &size, 0);
+    if ((ret < 0) || (size >= sizeof(r->etag))) {
+        r->etag[0] = '\0';
+    }
+    else {
+        r->etag[size] = '\0';
+    }
+    size = sizeof(r->lastModified);
+    ret = HTTPClient_getHeader(handle, HTTPClient_HFIELD_RES_LAST_MODIFIED,
+            r->lastModified, &size, 0);
+    if ((ret < 0) || (size >= sizeof(r->lastModified))) {
+        r->lastModified[0] = '\0';
+    }
+    else {
+        r->lastModified[size] = '\0';
+    }
+
+    res->valid = true;
+    res->full++;
+
+    /* A copy that cannot be written is still used until the next reset */
+    save(res);
+
+    return (status);
+}
@@ -0,0 +1,88 @@
+/*
+ *  ======== httpcache.h ========
+ *  Conditional GET for resources that are polled but seldom change,
+ *  such as the remote configuration and the firmware manifest.
+ *
+ *  Each resource keeps the validators of its last full response (ETag,
+ *  else Last-Modified) and the body in RAM and in one NWP file. A poll
+ *  sends If-None-Match / If-Modified-Since, so an unchanged resource
+ *  costs a 304 with no body; only a changed one is transferred and
+ *  written to flash. The cached copy survives resets and hibernate, so
+ *  the first poll after boot is conditional as well.
+ */
+#ifndef __HTTPCACHE_H
+#define __HTTPCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ti/net/http/httpclient.h>
+
+#include "httpreq.h"
+
+#define HTTPCACHE_MAGIC             (0x48544331)    /* "HTC1" */
+#define HTTPCACHE_ETAG_SIZE         (64)
+#define HTTPCACHE_DATE_SIZE         (32)
+#define HTTPCACHE_BODY_SIZE         (512)
+
+/* Returned by HttpCache_get() when a changed body does not fit */
+#define HTTPCACHE_ETOOLARGE         (-1)
+
+/*!
+ *  @brief  Cached copy of one resource, as stored in flash
+ */
+typedef struct HttpCache_Record {
+    uint32_t    magic;
+    char        etag[HTTPCACHE_ETAG_SIZE];
+    char        lastModified[HTTPCACHE_DATE_SIZE];
+    uint16_t    length;
+    char        body[HTTPCACHE_BODY_SIZE];  /* NUL terminated */
+} HttpCache_Record;
+
+/*!
+ *  @brief  A polled resource. Set uri and fileName, clear the rest.
+ */
+typedef struct HttpCache_Resource {
+    const char         *uri;
+    const char         *fileName;
+    HttpCache_Record    record;
+    bool                valid;          /* record holds a body */
+    uint32_t            full;           /* 200 responses */
+    uint32_t            notModified;    /* 304 responses */
+    uint32_t            failed;
+    uint32_t            bytes;          /* body bytes received */
+} HttpCache_Resource;
+
+/*!
+ *  @brief  Load the cached copy from flash. Needs the NWP.
+ *
+ *  @return true if a copy was found
+ */
+extern bool HttpCache_load(HttpCache_Resource *res);
+
+/*!
+ *  @brief  Conditional GET of res on the session, which connects if
+ *          needed and keeps the Retry-After hint. A 200 replaces the
+ *          cached copy and writes it to flash. Must not run on the
+ *          SimpleLink event thread.
+ *
+ *  @return HTTP status (200 changed, 304 unchanged), or a negative
+ *          HTTPClient error
+ */
+extern int16_t HttpCache_get(HttpCache_Resource *res,
+        HttpReq_Session *session);
+
+/*!
+ *  @brief  Forget the cached copy, so the next poll is unconditional
+ */
+extern void HttpCache_invalidate(HttpCache_Resource *res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HTTPCACHE_H */
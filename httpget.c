@@ -45,10 +45,11 @@
 #include <ti/drivers/net/wifi/slnetifwifi.h>
 
 #include "semaphore.h"
+#include "appconfig.h"
 
 #define APPLICATION_NAME      "HTTP GET"
 
-#define HOSTNAME "https://httpbin.org"
+/* The server is configurable, see AppConfig.serverHost */
 #define REQUEST_URI "/get"
 /*
 #define HOSTNAME              "http://www.google.com"
@@ -61,7 +62,6 @@
 extern sem_t    ipEventSyncObj;
 extern void printError(char *errString, int code);
 extern void print(const char *String);
-extern UART_Handle uart;
 
 //*****************************************************************************
 //
@@ -83,6 +83,7 @@ void* httpTask(void* pvParameters)
     char data[HTTP_MIN_RECV];
     int16_t ret = 0;
     int16_t len = 0;
+    AppConfig config;
 
     /* Print Application name */
     HTTPClient_extSecParams httpClientSecParams;
@@ -108,7 +109,8 @@ void* httpTask(void* pvParameters)
         printError("httpTask: setting request header failed", ret);
     }
 
-    ret = HTTPClient_connect(httpClientHandle,HOSTNAME,&httpClientSecParams,0);
+    AppConfig_copy(&config);
+    ret = HTTPClient_connect(httpClientHandle,config.serverHost,&httpClientSecParams,0);
     if (ret < 0) {
         printError("httpTask: connect failed", ret);
     }
@@ -0,0 +1,337 @@
+/*
+ *  ======== httpreq.c ========
+ *  Report server requests on a long lived client
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ti/net/http/httpclient.h>
+#include <ti/net/slnetutils.h>
+
+#include "appconfig.h"
+#include "dnscache.h"
+#include "httpreq.h"
+#include "netsched.h"
+#include "netshim.h"
+
+/*
+ *  ======== splitServer ========
+ *  "https://host[:port]" into host name, port and scheme.
+ *
+ *  @return false if the host name does not fit
+ */
+static bool splitServer(const char *server, char *host, size_t size,
+        uint16_t *port, bool *secure)
+{
+    const char *p = server;
+    size_t      n;
+
+    *secure = true;
+    if (strncmp(p, "https://", 8) == 0) {
+        p += 8;
+    }
+    else if (strncmp(p, "http://", 7) == 0) {
+        p += 7;
+        *secure = false;
+    }
+    *port = *secure ? 443 : 80;
+
+    n = strcspn(p, ":/");
+    if ((n == 0) || (n >= size)) {
+        return (false);
+    }
+    memcpy(host, p, n);
+    host[n] = '\0';
+    if (p[n] == ':') {
+        *port = (uint16_t)strtoul(p + n + 1, NULL, 10);
+    }
+
+    return (true);
+}
+
+/*
+ *  ======== setHeaders ========
+ *  The persistent headers, set again only when one of them changed.
+ */
+static int16_t setHeaders(HttpReq_Session *session, const char *host,
+        const char *device)
+{
+    int16_t ret = 0;
+
+    if ((strcmp(session->host, host) != 0) ||
+            (strcmp(session->device, device) != 0)) {
+        session->stats.headerSets++;
+        ret = HTTPClient_setHeader(session->handle,
+                HTTPClient_HFIELD_REQ_HOST, host, strlen(host),
+                HTTPClient_HFIELD_PERSISTENT);
+        if (ret >= 0) {
+            ret = HTTPClient_setHeaderByName(session->handle,
+                    HTTPClient_REQUEST_HEADER_MASK, HTTPREQ_DEVICE_HEADER,
+                    device, strlen(device),
+                    HTTPClient_HFIELD_PERSISTENT);
+        }
+        if (ret < 0) {
+            /* Forces a full rebuild next time */
+            session->host[0] = '\0';
+            return (ret);
+        }
+        strcpy(session->host, host);
+        strncpy(session->device, device,
+                sizeof(session->device) - 1);
+    }
+
+    return (ret);
+}
+
+/*
+ *  ======== HttpReq_init ========
+ */
+int16_t HttpReq_init(HttpReq_Session *session)
+{
+    int16_t statusCode;
+    int16_t ret;
+
+    memset(session, 0, sizeof(*session));
+
+    session->handle = HTTPClient_create(&statusCode, 0);
+    if (statusCode < 0) {
+        session->handle = NULL;
+        return (statusCode);
+    }
+
+    ret = HTTPClient_setHeader(session->handle,
+            HTTPClient_HFIELD_REQ_USER_AGENT, HTTPREQ_USER_AGENT,
+            strlen(HTTPREQ_USER_AGENT), HTTPClient_HFIELD_PERSISTENT);
+    if (ret >= 0) {
+        /* Keep Retry-After from the responses */
+        ret = HTTPClient_setHeader(session->handle,
+                HTTPClient_HFIELD_RES_RETRY_AFTER, NULL, 0,
+                HTTPClient_HFIELD_PERSISTENT);
+    }
+    if (ret < 0) {
+        HTTPClient_destroy(session->handle);
+        session->handle = NULL;
+    }
+
+    return (ret);
+}
+
+/*
+ *  ======== HttpReq_open ========
+ */
+int16_t HttpReq_open(HttpReq_Session *session)
+{
+    HTTPClient_extSecParams secParams;
+    SlNetSock_AddrIn_t      addr;
+    AppConfig               config;
+    char                    host[DNSCACHE_MAX_HOST];
+    uint16_t                port;
+    bool                    secure;
+    int16_t                 ret;
+
+    if (session->handle == NULL) {
+        return (HTTPClient_ENOCONNECTION);
+    }
+    if (session->connected) {
+        return (0);
+    }
+
+    AppConfig_copy(&config);
+    if (!splitServer(config.serverHost, host, sizeof(host), &port,
+            &secure)) {
+        return (HTTPClient_EHOSTNAMERESOLVE);
+    }
+    ret = setHeaders(session, host, config.deviceName);
+    if (ret < 0) {
+        return (ret);
+    }
+
+    secParams.rootCa = HTTPREQ_ROOT_CA;
+    secParams.clientCert = NULL;
+    secParams.privateKey = NULL;
+
+    session->stats.connects++;
+#if NET_SHIM
+    if (!NetShim_connect()) {
+        return (HTTPClient_ENOCONNECTION);
+    }
+#endif
+    if (secure) {
+        /*
+         *  By name, past the DNS cache: only then does the client send
+         *  SNI and check the certificate against the host. Connecting
+         *  to a bare address would accept any certificate from the CA.
+         */
+        ret = HTTPClient_connect(session->handle, config.serverHost,
+                &secParams, 0);
+        if (ret < 0) {
+            return (ret);
+        }
+    }
+    else {
+        memset(&addr, 0, sizeof(addr));
+        if (DnsCache_resolve(host, &addr) < 0) {
+            return (HTTPClient_EHOSTNAMERESOLVE);
+        }
+        addr.sin_family = SLNETSOCK_AF_INET;
+        addr.sin_port = SlNetUtil_htons(port);
+
+        ret = HTTPClient_connect2(session->handle,
+                (SlNetSock_Addr_t *)&addr, NULL, 0);
+        if (ret < 0) {
+            /* The server may have moved; look it up again next time */
+            DnsCache_invalidate(host);
+            return (ret);
+        }
+    }
+    session->connected = true;
+    session->openedMs = NetSched_nowMs();
+
+    return (0);
+}
+
+/*
+ *  ======== readHints ========
+ *  Scheduling hints from the response, see httpreq.h.
+ */
+static void readHints(HttpReq_Session *session, const char *start,
+        int16_t len)
+{
+    char        value[16];
+    uint32_t    size = sizeof(value) - 1;
+    const char *next;
+    char        first[65];
+
+    if ((HTTPClient_getHeader(session->handle,
+            HTTPClient_HFIELD_RES_RETRY_AFTER, value, &size, 0) >= 0) &&
+            (size > 0) && (size < sizeof(value))) {
+        /* Only the delta-seconds form; a date falls back to backoff */
+        value[size] = '\0';
+        session->retryAfterS = strtoul(value, NULL, 10);
+    }
+
+    if (len > 0) {
+        if (len > (int16_t)sizeof(first) - 1) {
+            len = sizeof(first) - 1;
+        }
+        memcpy(first, start, len);
+        first[len] = '\0';
+        next = strstr(first, "\"next\":");
+        if (next != NULL) {
+            session->nextSlotS = strtoul(next + 7, NULL, 10);
+        }
+    }
+}
+
+/*
+ *  ======== HttpReq_send ========
+ */
+int16_t HttpReq_send(HttpReq_Session *session,
+        const HttpReq_Endpoint *endpoint, const char *body, size_t len)
+{
+    return (HttpReq_fetch(session, endpoint, body, len, NULL, 0, NULL));
+}
+
+/*
+ *  ======== HttpReq_fetch ========
+ */
+int16_t HttpReq_fetch(HttpReq_Session *session,
+        const HttpReq_Endpoint *endpoint, const char *body, size_t len,
+        char *response, size_t size, size_t *received)
+{
+    char    discard[64];
+    char   *chunk;
+    size_t  total = 0;
+    size_t  chunkSize;
+    bool    moreData = true;
+    bool    first = true;
+    bool    reused = session->connected;
+    int16_t status;
+    int16_t ret;
+
+    session->retryAfterS = 0;
+    session->nextSlotS = 0;
+
+    ret = HttpReq_open(session);
+    if (ret < 0) {
+        return (ret);
+    }
+
+    if (endpoint->contentType != NULL) {
+        ret = HTTPClient_setHeader(session->handle,
+                HTTPClient_HFIELD_REQ_CONTENT_TYPE, endpoint->contentType,
+                strlen(endpoint->contentType),
+                HTTPClient_HFIELD_NOT_PERSISTENT);
+        if (ret < 0) {
+            HttpReq_close(session);
+            return (ret);
+        }
+    }
+
+    session->stats.requests++;
+    if (reused) {
+        session->stats.reused++;
+    }
+#if NET_SHIM
+    if (!NetShim_request(len)) {
+        HttpReq_close(session);
+        return (HTTPClient_ENOCONNECTION);
+    }
+#endif
+    status = HTTPClient_sendRequest(session->handle, endpoint->method,
+            endpoint->uri, body, len, 0);
+    if (status < 0) {
+        HttpReq_close(session);
+        return (status);
+    }
+
+    /*
+     *  Read the whole response so the connection can carry the next
+     *  request; whatever does not fit the caller's buffer is discarded.
+     */
+    while (moreData) {
+        if ((response != NULL) && (total < size - 1)) {
+            chunk = response + total;
+            chunkSize = size - 1 - total;
+        }
+        else {
+            chunk = discard;
+            chunkSize = sizeof(discard);
+        }
+        ret = HTTPClient_readResponseBody(session->handle, chunk,
+                chunkSize, &moreData);
+        if (ret < 0) {
+            /* The request got its status; only a fetched body is lost */
+            HttpReq_close(session);
+            return ((response != NULL) ? ret : status);
+        }
+        if (first) {
+            readHints(session, chunk, ret);
+            first = false;
+        }
+        total += ret;
+    }
+    if (response != NULL) {
+        response[(total < size - 1) ? total : size - 1] = '\0';
+    }
+    if (received != NULL) {
+        *received = total;
+    }
+
+    return (status);
+}
+
+/*
+ *  ======== HttpReq_close ========
+ */
+void HttpReq_close(HttpReq_Session *session)
+{
+    if (session->connected) {
+        HTTPClient_disconnect(session->handle);
+        session->connected = false;
+        session->stats.activeMs += NetSched_nowMs() - session->openedMs;
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ *  ======== httpreq.h ========
+ *  Requests to the report server from fixed endpoint templates.
+ *
+ *  An endpoint (method, URI, content type) is a const table entry, so
+ *  it is laid out at build time and costs nothing per request. A
+ *  session owns one HTTPClient handle for its lifetime: the headers that
+ *  never change between requests (User-Agent, Host, device ID) are set
+ *  on it once as persistent headers and only set again if the
+ *  configuration changes. A request then only adds its per-request
+ *  fields, and the body is sent straight from the caller's buffer.
+ *
+ *  The connection is kept open between requests until HttpReq_close(),
+ *  so the work of one wake-up shares one TLS handshake.
+ *
+ *  The server steers the device's schedule (upsched.h) through the
+ *  response: Retry-After in seconds on a refusal, and on success an
+ *  optional "next" member, in seconds, at the start of a JSON body.
+ *
+ *  A session is used by one thread.
+ */
+#ifndef __HTTPREQ_H
+#define __HTTPREQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ti/net/http/httpclient.h>
+
+#include "dnscache.h"
+
+#define HTTPREQ_USER_AGENT          "flowness (CC3220SF; TI-RTOS)"
+#define HTTPREQ_DEVICE_HEADER       "X-Device-Id"
+#define HTTPREQ_ROOT_CA             "dst-root-ca-x3.der"
+
+/*!
+ *  @brief  Request template
+ */
+typedef struct HttpReq_Endpoint {
+    const char *method;             /* HTTP_METHOD_xxx */
+    const char *uri;
+    const char *contentType;        /* NULL without a body */
+} HttpReq_Endpoint;
+
+typedef struct HttpReq_Stats {
+    uint32_t    headerSets;         /* persistent header (re)builds */
+    uint32_t    connects;
+    uint32_t    requests;
+    uint32_t    reused;             /* requests on an open connection */
+    uint32_t    activeMs;           /* connections open, i.e. radio busy */
+} HttpReq_Stats;
+
+typedef struct HttpReq_Session {
+    HTTPClient_Handle   handle;
+    bool                connected;
+    uint32_t            openedMs;
+    char                host[DNSCACHE_MAX_HOST];    /* in the headers */
+    char                device[32];
+    uint32_t            retryAfterS;    /* last response, 0 if none */
+    uint32_t            nextSlotS;      /* last response, 0 if none */
+    HttpReq_Stats       stats;
+} HttpReq_Session;
+
+/*!
+ *  @brief  Create the session's client
+ *
+ *  @return 0 on success, negative HTTPClient error otherwise
+ */
+extern int16_t HttpReq_init(HttpReq_Session *session);
+
+/*!
+ *  @brief  Connect to the configured server unless already connected
+ *
+ *  @return 0 on success, negative HTTPClient error otherwise
+ */
+extern int16_t HttpReq_open(HttpReq_Session *session);
+
+/*!
+ *  @brief  Send one request and discard the response body
+ *
+ *  @return HTTP status, or a negative HTTPClient error. After an error
+ *          the connection is closed.
+ */
+extern int16_t HttpReq_send(HttpReq_Session *session,
+        const HttpReq_Endpoint *endpoint, const char *body, size_t len);
+
+/*!
+ *  @brief  Send one request and keep the start of the response body.
+ *          Fields of the response, such as validators, can be read from
+ *          the handle afterwards.
+ *
+ *  @param  response    receives up to size - 1 bytes, NUL terminated
+ *  @param  received    full body length, more than size - 1 if the body
+ *                      did not fit
+ *
+ *  @return as HttpReq_send()
+ */
+extern int16_t HttpReq_fetch(HttpReq_Session *session,
+        const HttpReq_Endpoint *endpoint, const char *body, size_t len,
+        char *response, size_t size, size_t *received);
+
+/*!
+ *  @brief  Close the connection; the client and its headers are kept
+ */
+extern void HttpReq_close(HttpReq_Session *session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HTTPREQ_H */
@@ -0,0 +1,408 @@
+/*
+ *  ======== i2cbus.c ========
+ *  Batched polling of the I2C0 sensors
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "Board.h"
+#include "alarms.h"
+#include "console.h"
+#include "i2cbus.h"
+#include "netsched.h"
+#include "supervisor.h"
+#include "timebase.h"
+
+#define I2CBUS_THREAD_PRIORITY      (1)
+#define I2CBUS_STACK_SIZE           (1024)
+#define I2CBUS_DEADLINE_MS          (5000)
+#define I2CBUS_BITRATE_HZ           (400000)
+
+/* Longest register read of any device */
+#define I2CBUS_MAX_READ             (4)
+
+/* LPS22HB control register 1: 10 Hz output data rate */
+#define LPS22HB_CTRL_REG1           (0x10)
+#define LPS22HB_ODR_10HZ            (0x20)
+
+/*
+ *  A polled device: read len bytes from register reg every periodMs
+ *  and convert them with decodeFxn. initCmd, if any, is written once
+ *  before the first poll.
+ */
+typedef struct Device {
+    const char  *name;
+    uint8_t      address;
+    uint8_t      reg;
+    uint8_t      len;
+    uint16_t     periodMs;
+    int32_t    (*decodeFxn)(const uint8_t *buf);
+    uint8_t      initCmd[2];
+} Device;
+
+/*
+ *  ======== decodeTmp006 ========
+ *  Die temperature, 14 bits left aligned, 1/32 degree per LSB.
+ */
+static int32_t decodeTmp006(const uint8_t *buf)
+{
+    int16_t raw = (int16_t)(((uint16_t)buf[0] << 8) | buf[1]);
+
+    return ((int32_t)(raw >> 2) * 1000 / 32);
+}
+
+/*
+ *  ======== decodeLps22hb ========
+ *  24 bit two's complement, 4096 LSB per hPa.
+ */
+static int32_t decodeLps22hb(const uint8_t *buf)
+{
+    int32_t raw = (int32_t)(((uint32_t)buf[2] << 24) |
+            ((uint32_t)buf[1] << 16) | ((uint32_t)buf[0] << 8)) >> 8;
+
+    return ((int32_t)((int64_t)raw * 100 / 4096));
+}
+
+/* Indexed by I2cBus_Value */
+static const Device devices[I2cBus_Value_COUNT] = {
+    {"temp", Board_TMP_ADDR, 0x01, 2, 1000, decodeTmp006, {0, 0}},
+    {"pressure", Board_PRESSURE_ADDR, 0x28, 3, 200, decodeLps22hb,
+        {LPS22HB_CTRL_REG1, LPS22HB_ODR_10HZ}},
+};
+
+static I2C_Handle       i2cHandle = NULL;
+static I2C_Transaction  transactions[I2cBus_Value_COUNT];
+static uint8_t          readBufs[I2cBus_Value_COUNT][I2CBUS_MAX_READ];
+static volatile bool    succeeded[I2cBus_Value_COUNT];
+static volatile int     pending = 0;
+static sem_t            batchSem;
+
+static uint32_t         nextDue[I2cBus_Value_COUNT];
+static I2cBus_Reading   cache[I2cBus_Value_COUNT];
+static I2cBus_Stats     stats;
+
+/*
+ *  ======== busUs ========
+ *  Start, address and ACK per direction plus 9 bits per byte.
+ */
+static uint32_t busUs(const I2C_Transaction *t)
+{
+    uint32_t bits = 0;
+
+    if (t->writeCount) {
+        bits += 10 + 9 * t->writeCount;
+    }
+    if (t->readCount) {
+        bits += 10 + 9 * t->readCount;
+    }
+    bits += 1;      /* stop */
+
+    return ((uint32_t)((uint64_t)bits * 1000000 / I2CBUS_BITRATE_HZ));
+}
+
+/*
+ *  ======== transferCallback ========
+ */
+static void transferCallback(I2C_Handle handle, I2C_Transaction *t,
+                             bool status)
+{
+    succeeded[(uintptr_t)t->arg] = status;
+    if (--pending == 0) {
+        sem_post(&batchSem);
+    }
+}
+
+/*
+ *  ======== runBatch ========
+ *  Queue count transactions and wait for all of them.
+ */
+static bool runBatch(int count)
+{
+    struct timespec ts;
+    uintptr_t       key;
+    uint32_t        us = 0;
+    int             i;
+
+    pending = count;
+    for (i = 0; i < count; i++) {
+        us += busUs(&transactions[i]);
+        if (!I2C_transfer(i2cHandle, &transactions[i])) {
+            /* Not queued: account for it here */
+            succeeded[(uintptr_t)transactions[i].arg] = false;
+            key = HwiP_disable();
+            if (--pending == 0) {
+                sem_post(&batchSem);
+            }
+            HwiP_restore(key);
+        }
+    }
+
+    stats.batches++;
+    stats.transfers += count;
+    stats.lastBusUs = us;
+    if (us > stats.maxBusUs) {
+        stats.maxBusUs = us;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += I2CBUS_BATCH_TIMEOUT_MS * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    if (sem_timedwait(&batchSem, &ts) != 0) {
+        /*
+         *  Drop whatever is still queued. Its callbacks still run and
+         *  the last one posts; a bus that never gets there is a stall
+         *  for the supervisor.
+         */
+        stats.timeouts++;
+        I2C_cancel(i2cHandle);
+        sem_wait(&batchSem);
+        return (false);
+    }
+
+    return (true);
+}
+
+/*
+ *  ======== initDevices ========
+ */
+static void initDevices(void)
+{
+    int count = 0;
+    int i;
+
+    for (i = 0; i < I2cBus_Value_COUNT; i++) {
+        if (devices[i].initCmd[0] == 0) {
+            continue;
+        }
+        transactions[count].slaveAddress = devices[i].address;
+        transactions[count].writeBuf = (void *)devices[i].initCmd;
+        transactions[count].writeCount = sizeof(devices[i].initCmd);
+        transactions[count].readBuf = NULL;
+        transactions[count].readCount = 0;
+        transactions[count].arg = (void *)(uintptr_t)i;
+        count++;
+    }
+    if (count) {
+        runBatch(count);
+    }
+}
+
+/*
+ *  ======== pollDue ========
+ *  Read every device due within the slack window.
+ *
+ *  @return ms until the next device is due
+ */
+static uint32_t pollDue(void)
+{
+    uint32_t  now = NetSched_nowMs();
+    uint32_t  stamp;
+    uint32_t  sleepMs = UINT32_MAX;
+    int32_t   untilDue;
+    int32_t   value;
+    uintptr_t index;
+    uintptr_t key;
+    int       count = 0;
+    int       i;
+
+    for (i = 0; i < I2cBus_Value_COUNT; i++) {
+        if ((int32_t)(nextDue[i] - now) > I2CBUS_BATCH_SLACK_MS) {
+            continue;
+        }
+        transactions[count].slaveAddress = devices[i].address;
+        transactions[count].writeBuf = (void *)&devices[i].reg;
+        transactions[count].writeCount = 1;
+        transactions[count].readBuf = readBufs[i];
+        transactions[count].readCount = devices[i].len;
+        transactions[count].arg = (void *)(uintptr_t)i;
+        count++;
+    }
+
+    if (count) {
+        runBatch(count);
+        now = NetSched_nowMs();
+        stamp = Timebase_monoMs();
+        for (i = 0; i < count; i++) {
+            index = (uintptr_t)transactions[i].arg;
+
+            /* Keep the schedule: a late batch does not shift the period */
+            nextDue[index] += devices[index].periodMs;
+            if ((int32_t)(nextDue[index] - now) < 0) {
+                nextDue[index] = now + devices[index].periodMs;
+            }
+
+            if (!succeeded[index]) {
+                stats.errors++;
+                key = HwiP_disable();
+                cache[index].errors++;
+                HwiP_restore(key);
+                continue;
+            }
+            value = devices[index].decodeFxn(readBufs[index]);
+            key = HwiP_disable();
+            cache[index].value = value;
+            cache[index].timeMs = stamp;
+            cache[index].valid = true;
+            HwiP_restore(key);
+
+            Alarms_feed((index == I2cBus_Value_PRESSURE) ?
+                    Alarms_Source_PRESSURE : Alarms_Source_TEMPERATURE,
+                    value, stamp);
+        }
+    }
+
+    for (i = 0; i < I2cBus_Value_COUNT; i++) {
+        untilDue = (int32_t)(nextDue[i] - now);
+        if (untilDue <= 0) {
+            return (0);
+        }
+        if ((uint32_t)untilDue < sleepMs) {
+            sleepMs = (uint32_t)untilDue;
+        }
+    }
+
+    return (sleepMs);
+}
+
+/*
+ *  ======== i2cBusThread ========
+ */
+static void *i2cBusThread(void *arg)
+{
+    Supervisor_Id watchdogId;
+    uint32_t      sleepMs;
+    uint32_t      now = NetSched_nowMs();
+    int           i;
+
+    watchdogId = Supervisor_register("i2cbus", I2CBUS_DEADLINE_MS);
+
+    initDevices();
+    for (i = 0; i < I2cBus_Value_COUNT; i++) {
+        nextDue[i] = now;
+    }
+
+    while (1) {
+        Supervisor_checkin(watchdogId, (int32_t)stats.batches);
+        sleepMs = pollDue();
+        if (sleepMs) {
+            usleep(sleepMs * 1000);
+        }
+    }
+}
+
+/*
+ *  ======== I2cBus_init ========
+ */
+int I2cBus_init(void)
+{
+    I2C_Params         i2cParams;
+    pthread_t          thread;
+    pthread_attr_t     pAttrs;
+    struct sched_param priParam;
+
+    sem_init(&batchSem, 0, 0);
+
+    I2C_Params_init(&i2cParams);
+    i2cParams.bitRate = I2C_400kHz;
+    i2cParams.transferMode = I2C_MODE_CALLBACK;
+    i2cParams.transferCallbackFxn = transferCallback;
+    i2cHandle = I2C_open(Board_I2C0, &i2cParams);
+    if (i2cHandle == NULL) {
+        return (-1);
+    }
+
+    pthread_attr_init(&pAttrs);
+    priParam.sched_priority = I2CBUS_THREAD_PRIORITY;
+    pthread_attr_setschedparam(&pAttrs, &priParam);
+    pthread_attr_setstacksize(&pAttrs, I2CBUS_STACK_SIZE);
+    pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &pAttrs, i2cBusThread, NULL) != 0) {
+        I2C_close(i2cHandle);
+        i2cHandle = NULL;
+        return (-1);
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== I2cBus_read ========
+ */
+bool I2cBus_read(I2cBus_Value id, I2cBus_Reading *reading)
+{
+    uintptr_t key;
+
+    if ((unsigned int)id >= I2cBus_Value_COUNT) {
+        return (false);
+    }
+
+    key = HwiP_disable();
+    *reading = cache[id];
+    HwiP_restore(key);
+
+    return (reading->valid);
+}
+
+/*
+ *  ======== I2cBus_getStats ========
+ */
+void I2cBus_getStats(I2cBus_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdI2cBus ========
+ */
+static void cmdI2cBus(Console_Session *session, const Console_Args *args)
+{
+    char           printString[CONSOLE_PRINT_SIZE];
+    I2cBus_Stats   s;
+    I2cBus_Reading r;
+    int            i;
+
+    I2cBus_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "batches %lu, transfers %lu, errors %lu, timeouts %lu, "
+            "bus us last %lu max %lu",
+            (unsigned long)s.batches, (unsigned long)s.transfers,
+            (unsigned long)s.errors, (unsigned long)s.timeouts,
+            (unsigned long)s.lastBusUs, (unsigned long)s.maxBusUs);
+    Console_print(session, printString);
+
+    for (i = 0; i < I2cBus_Value_COUNT; i++) {
+        if (!I2cBus_read((I2cBus_Value)i, &r)) {
+            snprintf(printString, sizeof(printString), "%-8s -- (%lu errors)",
+                    devices[i].name, (unsigned long)r.errors);
+        }
+        else {
+            snprintf(printString, sizeof(printString),
+                    "%-8s %ld, %lu ms ago (%lu errors)", devices[i].name,
+                    (long)r.value,
+                    (unsigned long)(Timebase_monoMs() - r.timeMs),
+                    (unsigned long)r.errors);
+        }
+        Console_print(session, printString);
+    }
+}
+
+CONSOLE_COMMAND(i2cbus, "i2c", cmdI2cBus, "", "",
+                "cached sensor values and bus counters");
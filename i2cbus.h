@@ -0,0 +1,76 @@
+/*
+ *  ======== i2cbus.h ========
+ *  Manager for the sensors on I2C0.
+ *
+ *  One thread owns the bus. Every device is polled at its own period;
+ *  when a poll is due, every other device due within I2CBUS_BATCH_SLACK_MS
+ *  is pulled forward so the whole set goes out as one queue of callback
+ *  mode transfers and the CPU wakes once per batch rather than once per
+ *  device. The decoded values are cached with the time they were read,
+ *  and consumers only ever read the cache.
+ */
+#ifndef __I2CBUS_H
+#define __I2CBUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Devices due within this window share a wake-up */
+#define I2CBUS_BATCH_SLACK_MS       (50)
+
+/* A batch that takes longer than this is abandoned */
+#define I2CBUS_BATCH_TIMEOUT_MS     (100)
+
+/*!
+ *  @brief  Cached values
+ */
+typedef enum I2cBus_Value {
+    I2cBus_Value_TEMPERATURE = 0,   /* milli degrees C */
+    I2cBus_Value_PRESSURE,          /* Pa */
+    I2cBus_Value_COUNT
+} I2cBus_Value;
+
+typedef struct I2cBus_Reading {
+    int32_t     value;
+    uint32_t    timeMs;             /* when read, Timebase_monoMs() */
+    uint32_t    errors;             /* failed reads of this device */
+    bool        valid;              /* read successfully at least once */
+} I2cBus_Reading;
+
+/*!
+ *  @brief  Bus counters
+ */
+typedef struct I2cBus_Stats {
+    uint32_t    batches;
+    uint32_t    transfers;
+    uint32_t    errors;
+    uint32_t    timeouts;           /* batches abandoned */
+    uint32_t    lastBusUs;          /* estimated bus time, last batch */
+    uint32_t    maxBusUs;
+} I2cBus_Stats;
+
+/*!
+ *  @brief  Open I2C0 and start polling
+ *
+ *  @return 0 on success
+ */
+extern int I2cBus_init(void);
+
+/*!
+ *  @brief  Latest cached value
+ *
+ *  @return false if the device has never been read
+ */
+extern bool I2cBus_read(I2cBus_Value id, I2cBus_Reading *reading);
+
+extern void I2cBus_getStats(I2cBus_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __I2CBUS_H */
@@ -47,6 +47,7 @@
 
 /* Example/Board Header files */
 #include "Board.h"
+#include "supervisor.h"
 
 extern void *mainThread(void *arg0);
 
@@ -75,7 +76,7 @@ int main(void)
     retc = pthread_attr_setdetachstate(&pAttrs, detachState);
     if (retc != 0) {
         /* pthread_attr_setdetachstate() failed */
-        while (1);
+        Supervisor_fatal("pthread_attr_setdetachstate failed", retc);
     }
 
     pthread_attr_setschedparam(&pAttrs, &priParam);
@@ -83,13 +84,13 @@ int main(void)
     retc |= pthread_attr_setstacksize(&pAttrs, THREADSTACKSIZE);
     if (retc != 0) {
         /* pthread_attr_setstacksize() failed */
-        while (1);
+        Supervisor_fatal("pthread_attr_setstacksize failed", retc);
     }
 
     retc = pthread_create(&thread, &pAttrs, mainThread, NULL);
     if (retc != 0) {
         /* pthread_create() failed */
-        while (1);
+        Supervisor_fatal("mainThread create failed", retc);
     }
 
     BIOS_start();
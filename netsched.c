@@ -0,0 +1,237 @@
+/*
+ *  ======== netsched.c ========
+ *  Cooperative scheduler for network state machines
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <ti/drivers/dpl/ClockP.h>
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "netsched.h"
+#include "supervisor.h"
+
+static NetSched_Task   *taskList = NULL;        /* owned by netSchedThread */
+static NetSched_Task   *incomingList = NULL;    /* guarded by HwiP */
+static volatile uint32_t pendingEvents = 0;     /* guarded by HwiP */
+static sem_t            wakeSem;
+
+/*
+ *  ======== NetSched_init ========
+ */
+int NetSched_init(void)
+{
+    return (sem_init(&wakeSem, 0, 0));
+}
+
+/*
+ *  ======== NetSched_nowMs ========
+ *  Needs nothing initialized, so it also serves the boot profile, the
+ *  watchdog interrupt and the crash handler.
+ */
+uint32_t NetSched_nowMs(void)
+{
+    return ((uint32_t)(((uint64_t)ClockP_getSystemTicks() *
+            ClockP_getSystemTickPeriod()) / 1000));
+}
+
+/*
+ *  ======== NetSched_start ========
+ */
+int NetSched_start(NetSched_Task *task, NetSched_TaskFxn fxn, void *arg)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    if (task->active) {
+        HwiP_restore(key);
+        return (-1);
+    }
+    PT_INIT(&task->pt);
+    task->fxn = fxn;
+    task->arg = arg;
+    task->events = 0;
+    task->timed = false;
+    task->polling = false;
+    task->active = true;
+    task->next = incomingList;
+    incomingList = task;
+    HwiP_restore(key);
+
+    sem_post(&wakeSem);
+
+    return (0);
+}
+
+/*
+ *  ======== NetSched_signal ========
+ */
+void NetSched_signal(uint32_t events)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    pendingEvents |= events;
+    HwiP_restore(key);
+
+    sem_post(&wakeSem);
+}
+
+/*
+ *  ======== NetSched_clearEvents ========
+ */
+void NetSched_clearEvents(NetSched_Task *task, uint32_t mask)
+{
+    task->events &= ~mask;
+}
+
+/*
+ *  ======== NetSched_setTimeout ========
+ */
+void NetSched_setTimeout(NetSched_Task *task, uint32_t ms)
+{
+    task->wakeTime = NetSched_nowMs() + ms;
+    task->timed = true;
+}
+
+/*
+ *  ======== NetSched_timedOut ========
+ *  Wrap-safe comparison against the free running ms counter.
+ */
+bool NetSched_timedOut(NetSched_Task *task)
+{
+    return ((int32_t)(NetSched_nowMs() - task->wakeTime) >= 0);
+}
+
+/*
+ *  ======== NetSched_setNonBlocking ========
+ */
+int32_t NetSched_setNonBlocking(int16_t sd)
+{
+    SlNetSock_Nonblocking_t enableOption;
+
+    enableOption.nonBlockingEnabled = 1;
+
+    return (SlNetSock_setOpt(sd, SLNETSOCK_LVL_SOCKET,
+            SLNETSOCK_OPT_NONBLOCKING, &enableOption, sizeof(enableOption)));
+}
+
+/*
+ *  ======== takeIncoming ========
+ *  Move newly started tasks onto the run list and collect posted events.
+ */
+static uint32_t takeIncoming(void)
+{
+    NetSched_Task *task;
+    NetSched_Task *next;
+    uint32_t       events;
+    uintptr_t      key;
+
+    key = HwiP_disable();
+    task = incomingList;
+    incomingList = NULL;
+    events = pendingEvents;
+    pendingEvents = 0;
+    HwiP_restore(key);
+
+    while (task != NULL) {
+        next = task->next;
+        task->next = taskList;
+        taskList = task;
+        task = next;
+    }
+
+    return (events);
+}
+
+/*
+ *  ======== waitForWork ========
+ *  Sleep until an event is posted or the next task deadline expires.
+ */
+static void waitForWork(uint32_t sleepMs)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += sleepMs / 1000;
+    ts.tv_nsec += (long)(sleepMs % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    sem_timedwait(&wakeSem, &ts);
+}
+
+/*
+ *  ======== netSchedThread ========
+ *  Run every task once per pass. A pass is triggered by an event, by a
+ *  task deadline, or by the poll period while any task waits on a socket.
+ */
+void *netSchedThread(void *arg0)
+{
+    NetSched_Task **link;
+    NetSched_Task  *task;
+    uint32_t        events;
+    uint32_t        now;
+    uint32_t        sleepMs;
+    int32_t         remaining;
+    char            state;
+    uintptr_t       key;
+    Supervisor_Id   watchdogId;
+
+    watchdogId = Supervisor_register("netsched", NETSCHED_DEADLINE_MS);
+
+    while (1) {
+        Supervisor_checkin(watchdogId, 0);
+        events = takeIncoming();
+        sleepMs = NETSCHED_IDLE_PERIOD_MS;
+
+        link = &taskList;
+        while ((task = *link) != NULL) {
+            task->events |= events;
+            state = task->fxn(task);
+
+            if (state >= PT_EXITED) {
+                /*
+                 *  Unlinked before it is marked free: NetSched_start()
+                 *  may reuse the task, and its next, the moment active
+                 *  reads false.
+                 */
+                *link = task->next;
+                key = HwiP_disable();
+                task->active = false;
+                HwiP_restore(key);
+                continue;
+            }
+
+            if (state == PT_YIELDED) {
+                sleepMs = 0;
+            }
+            else if (task->polling && (sleepMs > NETSCHED_POLL_PERIOD_MS)) {
+                sleepMs = NETSCHED_POLL_PERIOD_MS;
+            }
+            if (task->timed) {
+                now = NetSched_nowMs();
+                remaining = (int32_t)(task->wakeTime - now);
+                if (remaining <= 0) {
+                    sleepMs = 0;
+                }
+                else if ((uint32_t)remaining < sleepMs) {
+                    sleepMs = (uint32_t)remaining;
+                }
+            }
+            link = &task->next;
+        }
+
+        if (sleepMs > 0) {
+            waitForWork(sleepMs);
+        }
+    }
+}
@@ -0,0 +1,184 @@
+/*
+ *  ======== netsched.h ========
+ *  Cooperative scheduler for network state machines.
+ *
+ *  Network operations are written as protothreads (see pt.h) and all of
+ *  them run on the single netSchedThread. A task costs one NetSched_Task
+ *  (a few dozen bytes) instead of a dedicated pthread and stack, so many
+ *  transfers can be in flight at once.
+ *
+ *  Tasks wait on one of three things:
+ *   - SimpleLink async events, posted from the event handlers in
+ *     platform.c with NetSched_signal()
+ *   - non-blocking SlNetSock operations, retried every poll period until
+ *     they stop returning EAGAIN/EALREADY
+ *   - a timeout
+ */
+#ifndef __NETSCHED_H
+#define __NETSCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ti/net/slnetsock.h>
+#include <ti/net/slneterr.h>
+
+#include "pt.h"
+
+/* Scheduler thread stack, shared by every task */
+#define NETSCHED_STACK_SIZE                 (2048)
+
+/* How often tasks blocked on a socket are re-polled */
+#define NETSCHED_POLL_PERIOD_MS             (10)
+
+/* Longest the scheduler sleeps when nothing is pending */
+#define NETSCHED_IDLE_PERIOD_MS             (1000)
+
+/* A pass taking longer than this is a hung task; see supervisor.h */
+#define NETSCHED_DEADLINE_MS                (10000)
+
+/* Events posted by the SimpleLink event handlers */
+#define NETSCHED_EVENT_WLAN_CONNECTED       (1 << 0)
+#define NETSCHED_EVENT_WLAN_DISCONNECTED    (1 << 1)
+#define NETSCHED_EVENT_IP_ACQUIRED          (1 << 2)
+#define NETSCHED_EVENT_IP_LOST              (1 << 3)
+#define NETSCHED_EVENT_SCAN_DONE            (1 << 4)
+#define NETSCHED_EVENT_NWP_READY            (1 << 5)
+
+/* Requests between application modules */
+#define NETSCHED_EVENT_SCAN_REQUEST         (1 << 8)
+#define NETSCHED_EVENT_CONFIG_SAVE          (1 << 9)
+#define NETSCHED_EVENT_HIBERNATE            (1 << 10)
+#define NETSCHED_EVENT_CHECKPOINT           (1 << 11)
+
+typedef struct NetSched_Task NetSched_Task;
+
+/*!
+ *  @brief  Task body, a protothread returning PT_WAITING .. PT_ENDED
+ */
+typedef char (*NetSched_TaskFxn)(NetSched_Task *task);
+
+/*!
+ *  @brief  Task control block, owned (statically allocated) by the caller
+ */
+struct NetSched_Task {
+    Pt                  pt;
+    NetSched_TaskFxn    fxn;
+    void               *arg;
+    uint32_t            events;     /* latched events, cleared on wait */
+    uint32_t            wakeTime;   /* absolute ms, valid while timed */
+    bool                timed;
+    bool                polling;    /* blocked on a socket */
+    bool                active;
+    NetSched_Task      *next;
+};
+
+/*!
+ *  @brief  True when a non-blocking SlNetSock call has to be retried
+ */
+#define NetSched_wouldBlock(ret)                                            \
+    (((ret) == SLNETERR_BSD_EAGAIN) || ((ret) == SLNETERR_BSD_EALREADY))
+
+/*
+ *  The wait macros below may only be used inside a task body. Each one
+ *  expands to a single PT_WAIT_UNTIL(), so keep them on their own line.
+ */
+
+/* Sleep for ms milliseconds */
+#define NETSCHED_SLEEP(task, ms)                                            \
+    do {                                                                    \
+        NetSched_setTimeout((task), (ms));                                  \
+        PT_WAIT_UNTIL(&(task)->pt, NetSched_timedOut(task));                \
+        (task)->timed = false;                                              \
+    } while (0)
+
+/* Wait for any event in mask, consuming the events that woke us */
+#define NETSCHED_WAIT_EVENT(task, mask)                                     \
+    do {                                                                    \
+        PT_WAIT_UNTIL(&(task)->pt, ((task)->events & (mask)) != 0);         \
+        (task)->events &= ~(mask);                                          \
+    } while (0)
+
+/*
+ *  Wait for any event in mask or for a timeout. On return the events
+ *  that woke the task are left in (task)->events so the caller can tell
+ *  the two cases apart (use NetSched_clearEvents() afterwards).
+ */
+#define NETSCHED_WAIT_EVENT_TIMEOUT(task, mask, ms)                         \
+    do {                                                                    \
+        NetSched_setTimeout((task), (ms));                                  \
+        PT_WAIT_UNTIL(&(task)->pt, (((task)->events & (mask)) != 0) ||      \
+                                   NetSched_timedOut(task));                \
+        (task)->timed = false;                                              \
+    } while (0)
+
+/*
+ *  Issue a non-blocking SlNetSock call (connect, send, recv, ...) and
+ *  re-issue it every poll period until it no longer reports EAGAIN or
+ *  EALREADY. The final return value is left in ret. op is issued once
+ *  per poll: NetSched_wouldBlock() reads its argument twice.
+ */
+#define NETSCHED_WAIT_IO(task, ret, op)                                     \
+    do {                                                                    \
+        (task)->polling = true;                                             \
+        PT_WAIT_UNTIL(&(task)->pt,                                          \
+                ((ret) = (op), !NetSched_wouldBlock(ret)));                 \
+        (task)->polling = false;                                            \
+    } while (0)
+
+/*!
+ *  @brief  Initialize the scheduler; call before any other NetSched API
+ */
+extern int NetSched_init(void);
+
+/*!
+ *  @brief  Start running fxn as a task. Safe to call from any thread
+ *          and from inside another task.
+ *
+ *  @return 0 on success, -1 if the task is already active
+ */
+extern int NetSched_start(NetSched_Task *task, NetSched_TaskFxn fxn,
+                          void *arg);
+
+/*!
+ *  @brief  Post events to every task and wake the scheduler.
+ *          Safe to call from the SimpleLink event handlers.
+ */
+extern void NetSched_signal(uint32_t events);
+
+/*!
+ *  @brief  Drop latched events the task is not interested in any more
+ */
+extern void NetSched_clearEvents(NetSched_Task *task, uint32_t mask);
+
+/*!
+ *  @brief  Milliseconds since boot on the system clock; wraps every 49
+ *          days. The one millisecond clock for timeouts, periods and
+ *          statistics in every module. Callable from any context, also
+ *          before NetSched_init(). Readings are stamped with
+ *          Timebase_monoMs() instead.
+ */
+extern uint32_t NetSched_nowMs(void);
+
+extern void NetSched_setTimeout(NetSched_Task *task, uint32_t ms);
+extern bool NetSched_timedOut(NetSched_Task *task);
+
+/*!
+ *  @brief  Put an SlNetSock socket in non-blocking mode
+ */
+extern int32_t NetSched_setNonBlocking(int16_t sd);
+
+/*!
+ *  @brief  Scheduler thread entry; all tasks run in this context
+ */
+extern void *netSchedThread(void *arg0);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NETSCHED_H */
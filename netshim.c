@@ -0,0 +1,312 @@
+/*
+ *  ======== netshim.c ========
+ *  Scripted network conditions for upload tests
+ */
+#include "netshim.h"
+
+#if NET_SHIM
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "console.h"
+#include "netsched.h"
+#if NETSHIM_HOST
+#include "host.h"
+#endif
+
+typedef struct NetShim_Scenario {
+    const char         *name;
+    const NetShim_Step *steps;
+} NetShim_Scenario;
+
+/* Busy 2.4 GHz band: slow, jittery, some loss */
+static const NetShim_Step lossySteps[] = {
+    {30 * 60 * 1000, 80, 120, 10, 0, false, 0},
+    {0}
+};
+
+/* Weak signal at the edge of coverage */
+static const NetShim_Step slowSteps[] = {
+    {30 * 60 * 1000, 300, 200, 2, 64, false, 0},
+    {0}
+};
+
+/* Normal, then the AP drops and comes back lossy after a slow DHCP */
+static const NetShim_Step flakySteps[] = {
+    {5 * 60 * 1000, 30, 20, 0, 0, false, 0},
+    {2 * 60 * 1000, 0, 0, 100, 0, true, 6000},
+    {10 * 60 * 1000, 50, 50, 5, 0, false, 0},
+    {0}
+};
+
+/* Roaming between APs: short drops, each with a new DHCP lease */
+static const NetShim_Step roamSteps[] = {
+    {8 * 60 * 1000, 30, 20, 0, 0, false, 0},
+    {5 * 1000, 0, 0, 100, 0, true, 2000},
+    {8 * 60 * 1000, 30, 20, 0, 0, false, 0},
+    {5 * 1000, 0, 0, 100, 0, true, 8000},
+    {8 * 60 * 1000, 30, 20, 0, 0, false, 0},
+    {0}
+};
+
+/* Backend or uplink down for half an hour */
+static const NetShim_Step outageSteps[] = {
+    {30 * 60 * 1000, 0, 0, 100, 0, false, 0},
+    {0}
+};
+
+static const NetShim_Scenario scenarios[] = {
+    {"lossy", lossySteps},
+    {"slow", slowSteps},
+    {"flaky", flakySteps},
+    {"roam", roamSteps},
+    {"outage", outageSteps},
+};
+
+#define NETSHIM_SCENARIO_COUNT  (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static const NetShim_Step *steps = NULL;     /* running scenario */
+static uint32_t            stepIndex;
+static uint32_t            stepStartMs;
+static bool                stepEntered;
+static uint32_t            dhcpOwedMs;      /* until the next connect */
+static uint32_t            randomState;
+static NetShim_Stats       stats = {.step = 0xFF};
+
+/*
+ *  ======== nextRandom ========
+ */
+static uint32_t nextRandom(void)
+{
+    uint32_t x = randomState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomState = x;
+
+    return (x);
+}
+
+/*
+ *  ======== currentStep ========
+ *  Advances through the scenario by time; NULL when none is running.
+ */
+static const NetShim_Step *currentStep(void)
+{
+    if (steps == NULL) {
+        return (NULL);
+    }
+    while ((NetSched_nowMs() - stepStartMs) >= steps[stepIndex].durationMs) {
+        if (!stepEntered && steps[stepIndex].disconnect) {
+            /* A drop passed while idle still costs the new lease */
+            stats.disconnects++;
+            dhcpOwedMs = steps[stepIndex].dhcpMs;
+        }
+        stepStartMs += steps[stepIndex].durationMs;
+        stepIndex++;
+        stepEntered = false;
+        if (steps[stepIndex].durationMs == 0) {
+            steps = NULL;
+            stats.step = 0xFF;
+            return (NULL);
+        }
+    }
+    stats.step = (uint8_t)stepIndex;
+
+    if (!stepEntered) {
+        stepEntered = true;
+        if (steps[stepIndex].disconnect) {
+            /* The NWP reconnects through its connection policy */
+            sl_WlanDisconnect();
+            stats.disconnects++;
+            dhcpOwedMs = steps[stepIndex].dhcpMs;
+        }
+    }
+
+    return (&steps[stepIndex]);
+}
+
+/*
+ *  ======== hold ========
+ */
+static void hold(uint32_t ms)
+{
+#if NETSHIM_HOST
+    Host_advanceUs((uint64_t)ms * 1000);
+#else
+    usleep(ms * 1000);
+#endif
+}
+
+/*
+ *  ======== inject ========
+ *  The address is waited for on the first connect after a drop, once
+ *  the AP is back.
+ */
+static bool inject(size_t len, bool connect)
+{
+    const NetShim_Step *step = currentStep();
+    uint32_t            rxMs;
+    uint32_t            txMs = 0;
+    uint32_t            dhcpMs = 0;
+
+    if (step == NULL) {
+        return (true);
+    }
+    stats.operations++;
+
+    rxMs = step->latencyMs;
+    if (step->jitterMs != 0) {
+        rxMs += nextRandom() % (step->jitterMs + 1);
+    }
+    if (connect && !step->disconnect) {
+        dhcpMs = dhcpOwedMs;
+        dhcpOwedMs = 0;
+        rxMs += dhcpMs;
+    }
+    if (step->kbps != 0) {
+        txMs = (uint32_t)(len * 8 / step->kbps);
+    }
+    if (rxMs + txMs != 0) {
+        hold(rxMs + txMs);
+        stats.delayMs += rxMs + txMs;
+        stats.dhcpMs += dhcpMs;
+        stats.txMs += txMs;
+        stats.energyUj += (rxMs * NETSHIM_RX_MA + txMs * NETSHIM_TX_MA) *
+                (NETSHIM_SUPPLY_MV / 100) / 10;
+    }
+
+    if ((nextRandom() % 100) < step->lossPct) {
+        stats.dropped++;
+        return (false);
+    }
+
+    return (true);
+}
+
+/*
+ *  ======== NetShim_connect ========
+ */
+bool NetShim_connect(void)
+{
+    return (inject(0, true));
+}
+
+/*
+ *  ======== NetShim_request ========
+ */
+bool NetShim_request(size_t len)
+{
+    return (inject(len, false));
+}
+
+/*
+ *  ======== NetShim_start ========
+ */
+bool NetShim_start(const char *name)
+{
+    unsigned int i;
+
+    if (name == NULL) {
+        steps = NULL;
+        stats.step = 0xFF;
+        return (true);
+    }
+
+    for (i = 0; i < NETSHIM_SCENARIO_COUNT; i++) {
+        if (strcmp(scenarios[i].name, name) == 0) {
+            memset(&stats, 0, sizeof(stats));
+            randomState = NETSHIM_SEED;
+            stepIndex = 0;
+            stepStartMs = NetSched_nowMs();
+            stepEntered = false;
+            dhcpOwedMs = 0;
+            steps = scenarios[i].steps;
+            return (true);
+        }
+    }
+
+    return (false);
+}
+
+/*
+ *  ======== NetShim_scenario ========
+ */
+const char *NetShim_scenario(unsigned int index)
+{
+    return ((index < NETSHIM_SCENARIO_COUNT) ? scenarios[index].name : NULL);
+}
+
+/*
+ *  ======== NetShim_getStats ========
+ */
+void NetShim_getStats(NetShim_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdShim ========
+ */
+static void cmdShim(Console_Session *session, const Console_Args *args)
+{
+    char          printString[CONSOLE_PRINT_SIZE];
+    NetShim_Stats s;
+    unsigned int  i;
+    int           len;
+
+    if (args->argc > 0) {
+        if (strcmp(args->str[0], "off") == 0) {
+            NetShim_start(NULL);
+        }
+        else if (!NetShim_start(args->str[0])) {
+            len = snprintf(printString, sizeof(printString),
+                    "Scenarios:");
+            for (i = 0; i < NETSHIM_SCENARIO_COUNT; i++) {
+                len += snprintf(printString + len, sizeof(printString) - len,
+                        " %s", scenarios[i].name);
+            }
+            Console_print(session, printString);
+        }
+        return;
+    }
+
+    NetShim_getStats(&s);
+    if (s.step == 0xFF) {
+        snprintf(printString, sizeof(printString), "idle, ");
+    }
+    else {
+        snprintf(printString, sizeof(printString), "step %u, ", s.step);
+    }
+    len = strlen(printString);
+    snprintf(printString + len, sizeof(printString) - len,
+            "%lu operations, %lu dropped, %lu disconnects, %lu ms delay",
+            (unsigned long)s.operations, (unsigned long)s.dropped,
+            (unsigned long)s.disconnects, (unsigned long)s.delayMs);
+    Console_print(session, printString);
+
+    snprintf(printString, sizeof(printString),
+            "of which %lu ms DHCP, %lu ms sending; radio %lu.%03lu J",
+            (unsigned long)s.dhcpMs, (unsigned long)s.txMs,
+            (unsigned long)(s.energyUj / 1000000),
+            (unsigned long)((s.energyUj / 1000) % 1000));
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(netshim, "shim", cmdShim, "s", "[scenario|off]",
+                "injected network conditions, or start a scenario");
+
+#endif /* NET_SHIM */
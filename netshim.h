@@ -0,0 +1,114 @@
+/*
+ *  ======== netshim.h ========
+ *  Network condition injection for upload tests, built in with
+ *  NET_SHIM=1 only.
+ *
+ *  The shim sits in httpreq.c in front of every connect and request of
+ *  the upload session. It adds latency with jitter, a bandwidth cap on
+ *  the request body, random loss (the operation fails as a dropped
+ *  connection would), AP disconnects, and the time DHCP takes to hand
+ *  out an address again after one. Conditions come from scripted
+ *  scenarios: a list of steps, each holding for a while. A scenario is
+ *  started from the console (``shim <name>``), so the same run can be
+ *  repeated against different upload settings and compared on the
+ *  ``up`` and ``shim`` counters.
+ *
+ *  The shim also counts the radio time and energy the injected
+ *  conditions cost, from the typical CC3220 receive and transmit
+ *  currents below: waiting out latency and DHCP is receive time, the
+ *  capped body is transmit time.
+ *
+ *  Random choices use a fixed seed per scenario start, so a run is
+ *  repeatable. With NETSHIM_HOST=1 the shim builds for the host tools
+ *  (tools/uploadsim.c): delays then move the simulated clock of
+ *  tools/host/host.c on instead of sleeping.
+ */
+#ifndef __NETSHIM_H
+#define __NETSHIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef NET_SHIM
+#define NET_SHIM                    0
+#endif
+
+/* 1: built for the host tools, on a simulated clock */
+#ifndef NETSHIM_HOST
+#define NETSHIM_HOST                0
+#endif
+
+#define NETSHIM_SEED                (0x2545F491)
+
+/* Energy model: supply and typical radio currents */
+#define NETSHIM_SUPPLY_MV           (3300)
+#define NETSHIM_RX_MA               (53)
+#define NETSHIM_TX_MA               (248)
+
+/*!
+ *  @brief  Conditions of one scenario step
+ */
+typedef struct NetShim_Step {
+    uint32_t    durationMs;         /* 0 ends the scenario */
+    uint16_t    latencyMs;          /* per connect or request */
+    uint16_t    jitterMs;           /* uniform, added to latency */
+    uint16_t    lossPct;            /* operations that fail */
+    uint16_t    kbps;               /* request body rate, 0 unlimited */
+    bool        disconnect;         /* drop the AP when the step starts */
+    uint16_t    dhcpMs;             /* after the drop, first connect waits */
+} NetShim_Step;
+
+typedef struct NetShim_Stats {
+    uint32_t    operations;
+    uint32_t    dropped;
+    uint32_t    disconnects;
+    uint32_t    delayMs;            /* injected in total */
+    uint32_t    dhcpMs;             /* of which waiting for an address */
+    uint32_t    txMs;               /* of which sending a capped body */
+    uint32_t    energyUj;           /* radio energy of the delays */
+    uint8_t     step;               /* current step, 0xFF when idle */
+} NetShim_Stats;
+
+#if NET_SHIM
+
+/*!
+ *  @brief  Before a connect. Sleeps for the injected delay.
+ *
+ *  @return false if the connect is to fail
+ */
+extern bool NetShim_connect(void);
+
+/*!
+ *  @brief  Before a request with a body of len bytes. Sleeps for the
+ *          injected delay.
+ *
+ *  @return false if the request is to fail
+ */
+extern bool NetShim_request(size_t len);
+
+/*!
+ *  @brief  Start a scenario by name, or stop with NULL
+ *
+ *  @return false if there is no such scenario
+ */
+extern bool NetShim_start(const char *name);
+
+extern void NetShim_getStats(NetShim_Stats *stats);
+
+/*!
+ *  @brief  Scenario names, index from 0 until NULL
+ */
+extern const char *NetShim_scenario(unsigned int index);
+
+#endif /* NET_SHIM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NETSHIM_H */
@@ -0,0 +1,59 @@
+/*
+ *  ======== packbits.c ========
+ *  PackBits run-length encoding
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "packbits.h"
+
+/*
+ *  ======== PackBits_encode ========
+ */
+size_t PackBits_encode(const uint8_t *src, size_t srcLen, uint8_t *dst,
+                       size_t dstSize)
+{
+    size_t in = 0;
+    size_t out = 0;
+    size_t run;
+    size_t lit;
+
+    while (in < srcLen) {
+        /* Repeat run of at least 3 bytes */
+        run = 1;
+        while ((in + run < srcLen) && (run < 128) &&
+                (src[in + run] == src[in])) {
+            run++;
+        }
+        if (run >= 3) {
+            if (out + 2 > dstSize) {
+                return (0);
+            }
+            dst[out++] = (uint8_t)(int8_t)(1 - (int)run);
+            dst[out++] = src[in];
+            in += run;
+            continue;
+        }
+
+        /* Literals up to the next repeat run */
+        lit = 0;
+        while ((in + lit < srcLen) && (lit < 128)) {
+            if ((in + lit + 2 < srcLen) &&
+                    (src[in + lit] == src[in + lit + 1]) &&
+                    (src[in + lit] == src[in + lit + 2])) {
+                break;
+            }
+            lit++;
+        }
+        if (out + 1 + lit > dstSize) {
+            return (0);
+        }
+        dst[out++] = (uint8_t)(lit - 1);
+        memcpy(&dst[out], &src[in], lit);
+        out += lit;
+        in += lit;
+    }
+
+    return (out);
+}
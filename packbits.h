@@ -0,0 +1,35 @@
+/*
+ *  ======== packbits.h ========
+ *  PackBits run-length encoding, as in Apple's and TIFF's
+ *
+ *  A control byte n in 0..127 is followed by n + 1 literal bytes, n in
+ *  -127..-1 by one byte repeated 1 - n times. Runs shorter than 3 bytes
+ *  are kept as literals, so encoding never grows the data by more than
+ *  one byte in 128 (PACKBITS_MAX_SIZE).
+ */
+#ifndef __PACKBITS_H
+#define __PACKBITS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*! @brief  Worst case encoded size of len bytes */
+#define PACKBITS_MAX_SIZE(len)      ((len) + (len) / 128 + 1)
+
+/*!
+ *  @brief  Encode src into dst
+ *
+ *  @return encoded length, or 0 if dst is too small
+ */
+extern size_t PackBits_encode(const uint8_t *src, size_t srcLen,
+                              uint8_t *dst, size_t dstSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PACKBITS_H */
@@ -0,0 +1,377 @@
+/*
+ *  ======== payloadsec.c ========
+ *  Payload encryption and signing, on the CryptoCC32XX engine or in
+ *  software
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "Board.h"
+#include "console.h"
+#include "payloadsec.h"
+#include "timebase.h"
+
+#if PAYLOADSEC_SOFTWARE
+static SwCrypto_Aes     aes;
+#else
+static CryptoCC32XX_Handle crypto = NULL;
+#endif
+static bool             keyLoaded = false;
+static uint32_t         sequence;
+static PayloadSec_Stats stats;
+
+static uint32_t aesKey[PAYLOADSEC_AES_KEY_SIZE / 4];
+
+/* The engine takes a block sized key; HMAC zero pads a shorter one */
+static uint32_t hmacKey[PAYLOADSEC_HMAC_BLOCK_SIZE / 4];
+
+/*
+ *  ======== PayloadSec_init ========
+ */
+int PayloadSec_init(void)
+{
+#if PAYLOADSEC_SOFTWARE
+    return (0);
+#else
+    CryptoCC32XX_init();
+
+    crypto = CryptoCC32XX_open(Board_CRYPTO0,
+            CryptoCC32XX_AES | CryptoCC32XX_HMAC);
+
+    return ((crypto == NULL) ? -1 : 0);
+#endif
+}
+
+/*
+ *  ======== PayloadSec_loadKey ========
+ */
+bool PayloadSec_loadKey(void)
+{
+    uint8_t key[PAYLOADSEC_AES_KEY_SIZE + PAYLOADSEC_HMAC_KEY_SIZE];
+    _u32    token = 0;
+    _u16    len = sizeof(sequence);
+    _i32    fd;
+    _i32    ret;
+
+    fd = sl_FsOpen((const _u8 *)PAYLOADSEC_KEY_FILE, SL_FS_READ, &token);
+    if (fd < 0) {
+        return (false);
+    }
+    ret = sl_FsRead(fd, 0, key, sizeof(key));
+    sl_FsClose(fd, NULL, NULL, 0);
+    if (ret != sizeof(key)) {
+        return (false);
+    }
+
+    memcpy(aesKey, key, PAYLOADSEC_AES_KEY_SIZE);
+    memset(hmacKey, 0, sizeof(hmacKey));
+    memcpy(hmacKey, key + PAYLOADSEC_AES_KEY_SIZE, PAYLOADSEC_HMAC_KEY_SIZE);
+    memset(key, 0, sizeof(key));
+
+    /* A random start, so sequence numbers do not repeat across resets */
+    sl_NetUtilCmd(SL_NETUTIL_TRUE_RANDOM, NULL, 0, (_u8 *)&sequence, &len);
+
+#if PAYLOADSEC_SOFTWARE
+    SwCrypto_aesSetKey(&aes, (const uint8_t *)aesKey);
+    keyLoaded = true;
+#else
+    keyLoaded = (crypto != NULL);
+#endif
+
+    return (keyLoaded);
+}
+
+/*
+ *  ======== PayloadSec_ready ========
+ */
+bool PayloadSec_ready(void)
+{
+    return (keyLoaded);
+}
+
+/*
+ *  ======== sign ========
+ *  One step of the HMAC; the tag comes out on the last one.
+ *
+ *  @return 0 on success
+ */
+static int32_t sign(PayloadSec_Context *ctx, const void *data, size_t len,
+        bool more, uint8_t *tag)
+{
+#if PAYLOADSEC_SOFTWARE
+    SwCrypto_hmacUpdate(&ctx->hmac, data, len);
+    if (!more) {
+        SwCrypto_hmacFinal(&ctx->hmac, tag);
+    }
+
+    return (0);
+#else
+    uint8_t discard[PAYLOADSEC_TAG_SIZE];
+
+    ctx->hmac.moreData = more ? 1 : 0;
+
+    return ((CryptoCC32XX_sign(crypto, CryptoCC32XX_HMAC_SHA256,
+            (void *)data, len, (tag != NULL) ? tag : discard, &ctx->hmac) ==
+            CryptoCC32XX_STATUS_SUCCESS) ? 0 : -1);
+#endif
+}
+
+/*
+ *  ======== feed ========
+ *  Sends data through the HMAC in whole blocks. At least one byte is
+ *  always held back, so the final call has data.
+ */
+static int32_t feed(PayloadSec_Context *ctx, const uint8_t *data,
+        size_t len)
+{
+    uint8_t *pending = (uint8_t *)ctx->pending;
+    size_t   n;
+    int32_t  ret;
+
+    while (len > 0) {
+        if (ctx->pendingLen == PAYLOADSEC_HMAC_BLOCK_SIZE) {
+            ret = sign(ctx, pending, PAYLOADSEC_HMAC_BLOCK_SIZE, true, NULL);
+            if (ret != 0) {
+                return (-1);
+            }
+            ctx->pendingLen = 0;
+        }
+        if ((ctx->pendingLen == 0) && (len > PAYLOADSEC_HMAC_BLOCK_SIZE)) {
+            /* Straight from the caller's buffer */
+            n = ((len - 1) / PAYLOADSEC_HMAC_BLOCK_SIZE) *
+                    PAYLOADSEC_HMAC_BLOCK_SIZE;
+            ret = sign(ctx, data, n, true, NULL);
+            if (ret != 0) {
+                return (-1);
+            }
+            data += n;
+            len -= n;
+            continue;
+        }
+        n = PAYLOADSEC_HMAC_BLOCK_SIZE - ctx->pendingLen;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(pending + ctx->pendingLen, data, n);
+        ctx->pendingLen += n;
+        data += n;
+        len -= n;
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== encrypt ========
+ */
+static int32_t encrypt(PayloadSec_Context *ctx, const uint8_t *in,
+        size_t len, uint8_t *out)
+{
+#if PAYLOADSEC_SOFTWARE
+    /* Leaves the last ciphertext block in iv for the next chunk */
+    SwCrypto_cbcEncrypt(&aes, (uint8_t *)ctx->iv, in, len, out);
+#else
+    CryptoCC32XX_EncryptParams params;
+    size_t                     outLen = len;
+
+    params.aes.keySize = CryptoCC32XX_AES_KEY_SIZE_128BIT;
+    params.aes.pKey = (uint8_t *)aesKey;
+    params.aes.pIV = ctx->iv;
+
+    if (CryptoCC32XX_encrypt(crypto, CryptoCC32XX_AES_CBC, (void *)in, len,
+            out, &outLen, &params) != CryptoCC32XX_STATUS_SUCCESS) {
+        return (-1);
+    }
+
+    /* CBC chains on the last ciphertext block into the next chunk */
+    memcpy(ctx->iv, out + len - PAYLOADSEC_BLOCK_SIZE,
+            PAYLOADSEC_BLOCK_SIZE);
+#endif
+
+    return (feed(ctx, out, len));
+}
+
+/*
+ *  ======== PayloadSec_begin ========
+ */
+int32_t PayloadSec_begin(PayloadSec_Context *ctx, size_t length,
+        uint8_t *out)
+{
+    uint32_t header[PAYLOADSEC_HEADER_SIZE / 4];
+    _u16     len = PAYLOADSEC_BLOCK_SIZE;
+
+    if (!keyLoaded) {
+        return (-1);
+    }
+
+    memset(ctx, 0, sizeof(*ctx));
+#if PAYLOADSEC_SOFTWARE
+    SwCrypto_hmacInit(&ctx->hmac, (const uint8_t *)hmacKey,
+            PAYLOADSEC_HMAC_KEY_SIZE);
+#else
+    CryptoCC32XX_HmacParams_init(&ctx->hmac);
+    ctx->hmac.pKey = (uint8_t *)hmacKey;
+#endif
+    ctx->length = length;
+
+    if (sl_NetUtilCmd(SL_NETUTIL_TRUE_RANDOM, NULL, 0, (_u8 *)ctx->iv,
+            &len) < 0) {
+        return (-1);
+    }
+
+    header[0] = PAYLOADSEC_MAGIC;
+    header[1] = sequence++;
+    header[2] = (uint32_t)length;
+    header[3] = 0;
+    memcpy(out, header, PAYLOADSEC_HEADER_SIZE);
+    memcpy(out + PAYLOADSEC_HEADER_SIZE, ctx->iv, PAYLOADSEC_BLOCK_SIZE);
+
+    if (feed(ctx, out, PAYLOADSEC_HEADER_SIZE + PAYLOADSEC_BLOCK_SIZE) < 0) {
+        return (-1);
+    }
+
+    return (PAYLOADSEC_HEADER_SIZE + PAYLOADSEC_BLOCK_SIZE);
+}
+
+/*
+ *  ======== PayloadSec_update ========
+ */
+int32_t PayloadSec_update(PayloadSec_Context *ctx, const uint8_t *in,
+        size_t len, uint8_t *out)
+{
+    if (((len % PAYLOADSEC_BLOCK_SIZE) != 0) || (len >= ctx->length + 1)) {
+        /* The last, padded block must go through PayloadSec_finish() */
+        return (-1);
+    }
+    if (len == 0) {
+        return (0);
+    }
+    if (encrypt(ctx, in, len, out) < 0) {
+        return (-1);
+    }
+    ctx->length -= len;
+
+    return ((int32_t)len);
+}
+
+/*
+ *  ======== PayloadSec_finish ========
+ */
+int32_t PayloadSec_finish(PayloadSec_Context *ctx, const uint8_t *in,
+        size_t len, uint8_t *out)
+{
+    uint32_t last[PAYLOADSEC_BLOCK_SIZE / 4];
+    size_t   whole = len - (len % PAYLOADSEC_BLOCK_SIZE);
+    size_t   pad = PAYLOADSEC_BLOCK_SIZE - (len % PAYLOADSEC_BLOCK_SIZE);
+
+    if (len != ctx->length) {
+        return (-1);
+    }
+
+    if ((whole > 0) && (encrypt(ctx, in, whole, out) < 0)) {
+        return (-1);
+    }
+
+    /* PKCS#7: always at least one byte of padding */
+    memcpy(last, in + whole, len - whole);
+    memset((uint8_t *)last + (len - whole), (int)pad, pad);
+    if (encrypt(ctx, (uint8_t *)last, PAYLOADSEC_BLOCK_SIZE,
+            out + whole) < 0) {
+        return (-1);
+    }
+
+    if (sign(ctx, ctx->pending, ctx->pendingLen, false,
+            out + whole + PAYLOADSEC_BLOCK_SIZE) != 0) {
+        return (-1);
+    }
+    ctx->length = 0;
+
+    return ((int32_t)(whole + PAYLOADSEC_BLOCK_SIZE + PAYLOADSEC_TAG_SIZE));
+}
+
+/*
+ *  ======== PayloadSec_seal ========
+ */
+int32_t PayloadSec_seal(const uint8_t *in, size_t len, uint8_t *out,
+        size_t size)
+{
+    PayloadSec_Context ctx;
+    uint64_t           start = Timebase_monoUs();
+    uint32_t           us;
+    int32_t            pos;
+    int32_t            ret;
+    uintptr_t          key;
+
+    if (size < len + PAYLOADSEC_OVERHEAD) {
+        return (-1);
+    }
+
+    pos = PayloadSec_begin(&ctx, len, out);
+    while ((pos >= 0) && (ctx.length > PAYLOADSEC_CHUNK_SIZE)) {
+        ret = PayloadSec_update(&ctx, in, PAYLOADSEC_CHUNK_SIZE, out + pos);
+        in += PAYLOADSEC_CHUNK_SIZE;
+        pos = (ret < 0) ? ret : pos + ret;
+    }
+    if (pos >= 0) {
+        ret = PayloadSec_finish(&ctx, in, ctx.length, out + pos);
+        pos = (ret < 0) ? ret : pos + ret;
+    }
+    us = (uint32_t)(Timebase_monoUs() - start);
+
+    key = HwiP_disable();
+    if (pos < 0) {
+        stats.failures++;
+    }
+    else {
+        stats.sealed++;
+        stats.bytes += len;
+        stats.lastUs = us;
+        if (us > stats.maxUs) {
+            stats.maxUs = us;
+        }
+    }
+    HwiP_restore(key);
+
+    return (pos);
+}
+
+/*
+ *  ======== PayloadSec_getStats ========
+ */
+void PayloadSec_getStats(PayloadSec_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdPayloadSec ========
+ */
+static void cmdPayloadSec(Console_Session *session, const Console_Args *args)
+{
+    char             printString[CONSOLE_PRINT_SIZE];
+    PayloadSec_Stats s;
+
+    PayloadSec_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "%s%s, %lu sealed (%lu bytes), %lu failed, "
+            "last %lu us, max %lu us",
+            keyLoaded ? "keys loaded" : "no keys, sending in clear",
+            PAYLOADSEC_SOFTWARE ? " (software)" : "",
+            (unsigned long)s.sealed, (unsigned long)s.bytes,
+            (unsigned long)s.failures, (unsigned long)s.lastUs,
+            (unsigned long)s.maxUs);
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(payloadsec, "psec", cmdPayloadSec, "", "",
+                "payload sealing state and cost");
@@ -0,0 +1,144 @@
+/*
+ *  ======== payloadsec.h ========
+ *  End-to-end protection of telemetry payloads, independent of TLS.
+ *
+ *  A sealed payload is encrypted with AES-128-CBC and then authenticated
+ *  with HMAC-SHA256 over everything before the tag, both on the
+ *  CryptoCC32XX engine, or in software (swcrypto.c) with
+ *  PAYLOADSEC_SOFTWARE set. The output is the same either way:
+ *
+ *      header (16) | IV (16) | ciphertext, PKCS#7 padded | tag (32)
+ *
+ *  The header holds PAYLOADSEC_MAGIC, a sequence number, the plaintext
+ *  length and zero. All fields are little endian.
+ *
+ *  Payloads are processed in chunks: PayloadSec_begin(), any number of
+ *  PayloadSec_update() calls with whole AES blocks, then
+ *  PayloadSec_finish() with the rest. Ciphertext goes through the HMAC
+ *  as it is produced, so nothing is held beyond one 64-byte HMAC block.
+ *  Buffers should be word aligned so the engine's DMA can take them
+ *  directly.
+ *
+ *  The keys are read from PAYLOADSEC_KEY_FILE in the NWP file system
+ *  (16 bytes AES key, then 32 bytes HMAC key). Without the file,
+ *  payloads are sent in clear as before.
+ */
+#ifndef __PAYLOADSEC_H
+#define __PAYLOADSEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* 1: seal with swcrypto.c instead of the crypto engine */
+#ifndef PAYLOADSEC_SOFTWARE
+#define PAYLOADSEC_SOFTWARE         0
+#endif
+
+#if PAYLOADSEC_SOFTWARE
+#include "swcrypto.h"
+#else
+#include <ti/drivers/crypto/CryptoCC32XX.h>
+#endif
+
+#define PAYLOADSEC_KEY_FILE         "/flowness/payload.key"
+#define PAYLOADSEC_MAGIC            (0x31435350)    /* "PSC1" */
+
+#define PAYLOADSEC_AES_KEY_SIZE     (16)
+#define PAYLOADSEC_HMAC_KEY_SIZE    (32)
+#define PAYLOADSEC_BLOCK_SIZE       (16)
+#define PAYLOADSEC_HMAC_BLOCK_SIZE  (64)
+#define PAYLOADSEC_HEADER_SIZE      (16)
+#define PAYLOADSEC_TAG_SIZE         (32)
+
+/* Chunk size of PayloadSec_seal(), a multiple of the HMAC block */
+#define PAYLOADSEC_CHUNK_SIZE       (256)
+
+/* Most a sealed payload adds to the plaintext */
+#define PAYLOADSEC_OVERHEAD         (PAYLOADSEC_HEADER_SIZE + \
+        PAYLOADSEC_BLOCK_SIZE + PAYLOADSEC_BLOCK_SIZE + PAYLOADSEC_TAG_SIZE)
+
+/*!
+ *  @brief  State of one payload being sealed
+ */
+typedef struct PayloadSec_Context {
+    uint32_t    iv[PAYLOADSEC_BLOCK_SIZE / 4];  /* CBC chaining value */
+    uint32_t    pending[PAYLOADSEC_HMAC_BLOCK_SIZE / 4];
+    uint32_t    pendingLen;         /* bytes not yet through the HMAC */
+    uint32_t    length;             /* plaintext still expected */
+#if PAYLOADSEC_SOFTWARE
+    SwCrypto_Hmac hmac;
+#else
+    CryptoCC32XX_HmacParams hmac;
+#endif
+} PayloadSec_Context;
+
+typedef struct PayloadSec_Stats {
+    uint32_t    sealed;
+    uint32_t    bytes;              /* plaintext */
+    uint32_t    failures;
+    uint32_t    lastUs;             /* whole payload */
+    uint32_t    maxUs;
+} PayloadSec_Stats;
+
+/*!
+ *  @brief  Open the crypto engine; nothing to do in software
+ *
+ *  @return 0 on success
+ */
+extern int PayloadSec_init(void);
+
+/*!
+ *  @brief  Read the keys. Needs the NWP.
+ *
+ *  @return true if payloads will be sealed
+ */
+extern bool PayloadSec_loadKey(void);
+
+extern bool PayloadSec_ready(void);
+
+/*!
+ *  @brief  Start a payload of length bytes; writes the header and IV
+ *
+ *  @return bytes written to out, negative on error
+ */
+extern int32_t PayloadSec_begin(PayloadSec_Context *ctx, size_t length,
+        uint8_t *out);
+
+/*!
+ *  @brief  Encrypt len bytes, a multiple of PAYLOADSEC_BLOCK_SIZE,
+ *          into out
+ *
+ *  @return bytes written to out, negative on error
+ */
+extern int32_t PayloadSec_update(PayloadSec_Context *ctx, const uint8_t *in,
+        size_t len, uint8_t *out);
+
+/*!
+ *  @brief  Encrypt the last len bytes, pad, and append the tag
+ *
+ *  @return bytes written to out, negative on error
+ */
+extern int32_t PayloadSec_finish(PayloadSec_Context *ctx, const uint8_t *in,
+        size_t len, uint8_t *out);
+
+/*!
+ *  @brief  Seal a whole payload chunk by chunk. out needs
+ *          len + PAYLOADSEC_OVERHEAD bytes.
+ *
+ *  @return sealed length, negative on error
+ */
+extern int32_t PayloadSec_seal(const uint8_t *in, size_t len, uint8_t *out,
+        size_t size);
+
+extern void PayloadSec_getStats(PayloadSec_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PAYLOADSEC_H */
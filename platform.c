@@ -39,10 +39,33 @@
 #include <ti/drivers/UART.h>
 #include <ti/drivers/uart/UARTCC32XX.h>
 #include <ti/drivers/SPI.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/Capture.h>
+#include <ti/drivers/Timer.h>
+#include <ti/drivers/GPIO.h>
 
 #include "Board.h"
 #include "pthread.h"
 #include "semaphore.h"
+#include "netsched.h"
+#include "wifiscan.h"
+#include "consoletcp.h"
+#include "appconfig.h"
+#include "restserver.h"
+#include "supervisor.h"
+#include "crashdump.h"
+#include "boot.h"
+#include "hibernate.h"
+#include "dnscache.h"
+#include "timebase.h"
+#include "uartio.h"
+#include "sensorspi.h"
+#include "acoustic.h"
+#include "i2cbus.h"
+#include "totalizer.h"
+#include "alarms.h"
+#include "uploader.h"
+#include "payloadsec.h"
 
 
 #define SPAWN_TASK_PRIORITY                   (9)
@@ -50,6 +73,9 @@
 #define TASK_STACK_SIZE                       (2048)
 #define SLNET_IF_WIFI_PRIO                    (5)
 #define SLNET_IF_WIFI_NAME                    "CC3220"
+#define NETSCHED_TASK_PRIORITY                (2)
+#define WLAN_RECONNECT_DELAY_MS               (5000)
+#define WLAN_RECONNECT_MAX_DELAY_MS           (300000)
 
 /*
 #define SSID_NAME                             "Paradox NVR"                     // AP SSID
@@ -81,15 +107,20 @@ UART_Handle handle;
 pthread_t httpThread = (pthread_t)NULL;
 pthread_t spawn_thread = (pthread_t)NULL;
 pthread_t console_Thread = (pthread_t)NULL;
+pthread_t netSched_Thread = (pthread_t)NULL;
+
+static NetSched_Task wlanReconnectTask;
+static NetSched_Task bootTask;
+static uint32_t      reconnectDelayMs = WLAN_RECONNECT_DELAY_MS;
+static volatile int32_t nwpRole;
 
 
 //Display_Handle display;
 
 extern void* httpTask(void* pvParameters);
 extern void* consoleThread(void *arg0);
-extern UART_Handle uart;
-extern const char helpPrompt;
-extern const char userPrompt;
+extern const char consoleDisplay[];
+extern const char userPrompt[];
 
 static void DisplayBanner()
 {
@@ -137,6 +168,12 @@ void SimpleLinkNetAppEventHandler(SlNetAppEvent_t *pNetAppEvent)
             SlNetSock_init(0);
             SlNetUtil_init(0);
             sem_post(&ipEventSyncObj);
+            Boot_mark(Boot_Phase_IP_ACQUIRED);
+            NetSched_signal(NETSCHED_EVENT_IP_ACQUIRED);
+            break;
+        case SL_NETAPP_EVENT_IPV4_LOST:
+        case SL_NETAPP_EVENT_IPV6_LOST:
+            NetSched_signal(NETSCHED_EVENT_IP_LOST);
             break;
         default:
             break;
@@ -182,7 +219,7 @@ void SimpleLinkFatalErrorEventHandler(SlDeviceFatal_t *slFatalErrorEvent)
 */
 void SimpleLinkNetAppRequestMemFreeEventHandler(uint8_t *buffer)
 {
-    /* Unused in this application */
+    RestServer_freeBuffer(buffer);
 }
 
 /*!
@@ -205,7 +242,12 @@ void SimpleLinkNetAppRequestMemFreeEventHandler(uint8_t *buffer)
 */
 void SimpleLinkNetAppRequestEventHandler(SlNetAppRequest_t *pNetAppRequest, SlNetAppResponse_t *pNetAppResponse)
 {
-    /* Unused in this application */
+    if((pNetAppRequest == NULL) || (pNetAppResponse == NULL))
+    {
+        return;
+    }
+
+    RestServer_handleRequest(pNetAppRequest, pNetAppResponse);
 }
 
 /*!
@@ -258,7 +300,24 @@ void SimpleLinkHttpServerEventHandler(SlNetAppHttpServerEvent_t *pHttpEvent,
 */
 void SimpleLinkWlanEventHandler(SlWlanEvent_t *pWlanEvent)
 {
-    /* Unused in this application */
+    if(pWlanEvent == NULL)
+    {
+        return;
+    }
+
+    switch(pWlanEvent->Id)
+    {
+        case SL_WLAN_EVENT_CONNECT:
+            Boot_mark(Boot_Phase_WLAN_CONNECTED);
+            Hibernate_noteAp(pWlanEvent->Data.Connect.Bssid);
+            NetSched_signal(NETSCHED_EVENT_WLAN_CONNECTED);
+            break;
+        case SL_WLAN_EVENT_DISCONNECT:
+            NetSched_signal(NETSCHED_EVENT_WLAN_DISCONNECTED);
+            break;
+        default:
+            break;
+    }
 }
 /*!
     \brief          SimpleLinkGeneralEventHandler
@@ -308,37 +367,196 @@ void printError(char *errString, int code)
 {
     char errorBuff[256]={0};
     sprintf(errorBuff,"Error! code = %d, desc = %s\r\n", code, errString);
-    UART_write(uart, errorBuff,sizeof(errorBuff));
-    while(1);
+    UartIo_write(errorBuff, strlen(errorBuff));
+    UartIo_flush(100);
+    Supervisor_fatal(errString, code);
 }
 
 void print(const char *String)
 {
     //char errorBuff[256]={0};
     //sprintf(errorBuff,"Error! code = %d, desc = %s\r\n", code, errString);
-    UART_write(uart, String,strlen(String));
-    UART_write(uart, "\r\n",sizeof("\r\n"));
+    UartIo_write(String, strlen(String));
+    UartIo_write("\r\n", 2);
+    CrashDump_log(String);
 
 }
 
+/*
+ *  ======== Connect ========
+ *  Issues the connection request. A failure is returned, not fatal: the
+ *  reconnect task retries.
+ */
 int16_t Connect(void)
 {
     SlWlanSecParams_t   secParams = {0};
+    WifiScan_Entry      ap;
+    _u8                *pMacAddr = NULL;
     int16_t ret = 0;
     secParams.Key = (signed char*)SECURITY_KEY;
     secParams.KeyLen = strlen(SECURITY_KEY);
     secParams.Type = SECURITY_TYPE;
+
+    /* A fresh scan result lets the NWP go straight to the strongest AP */
+    if (WifiScan_findBest(SSID_NAME, &ap))
+    {
+        pMacAddr = ap.bssid;
+    }
+    /* After hibernate there is no scan yet; reuse the AP from before */
+    else if (Hibernate_lastAp(ap.bssid))
+    {
+        pMacAddr = ap.bssid;
+    }
     //UART_write( "Connecting to : %s.\r\n",SSID_NAME);
-    ret = sl_WlanConnect((signed char*)SSID_NAME, strlen(SSID_NAME), 0, &secParams, 0);
+    ret = sl_WlanConnect((signed char*)SSID_NAME, strlen(SSID_NAME), pMacAddr, &secParams, 0);
     //UART_write( "sl_WlanConnect finished with return: 0x%x.\r\n",ret);
     if (ret)
     {
-        printError("Connection failed , error code : %d \r\n", ret);
+        char printString[64];
+
+        sprintf(printString, "Connection failed, error code : %d", ret);
+        print(printString);
     }
 
     return ret;
 }
 
+/*
+ *  ======== wlanReconnectFxn ========
+ *  Runs on the network scheduler: re-issues the connection request once
+ *  the AP drops us, after a rescan, without parking a thread on it. A
+ *  request the NWP refuses is retried with a doubling delay.
+ */
+static PT_THREAD(wlanReconnectFxn(NetSched_Task *task))
+{
+    PT_BEGIN(&task->pt);
+
+    while (1)
+    {
+        NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_WLAN_DISCONNECTED);
+        reconnectDelayMs = WLAN_RECONNECT_DELAY_MS;
+
+        do
+        {
+            /* Refresh the scan cache so Connect() can pick the best AP */
+            NetSched_clearEvents(task, NETSCHED_EVENT_SCAN_DONE);
+            WifiScan_request();
+            NETSCHED_WAIT_EVENT_TIMEOUT(task, NETSCHED_EVENT_SCAN_DONE, WLAN_RECONNECT_DELAY_MS);
+            NetSched_clearEvents(task, NETSCHED_EVENT_WLAN_DISCONNECTED | NETSCHED_EVENT_SCAN_DONE);
+            if (Connect() == 0)
+            {
+                break;
+            }
+            NETSCHED_SLEEP(task, reconnectDelayMs);
+            reconnectDelayMs *= 2;
+            if (reconnectDelayMs > WLAN_RECONNECT_MAX_DELAY_MS)
+            {
+                reconnectDelayMs = WLAN_RECONNECT_MAX_DELAY_MS;
+            }
+        } while (1);
+    }
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== nwpInitCallback ========
+ *  Completion of sl_Start(), in sl_Task context: status is the role the
+ *  NWP came up in, or a negative error.
+ */
+static void nwpInitCallback(uint32_t status, SlDeviceInitInfo_t *pDeviceInitInfo)
+{
+    nwpRole = (int32_t)status;
+    Boot_mark(Boot_Phase_NWP_READY);
+    NetSched_signal(NETSCHED_EVENT_NWP_READY);
+}
+
+/*
+ *  ======== bootFxn ========
+ *  Network half of the boot sequence. mainThread only issues sl_Start()
+ *  and carries on with the local bring-up; this takes over once the NWP
+ *  is ready. The role is persistent in the NWP, so the restart into STA
+ *  only happens on the first boot after it was changed.
+ */
+static PT_THREAD(bootFxn(NetSched_Task *task))
+{
+    char printString[64];
+    int32_t ret;
+
+    PT_BEGIN(&task->pt);
+
+    NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_NWP_READY);
+    if (nwpRole < 0)
+    {
+        printError("Sl_start failed, error code : %d \r\n", nwpRole);
+    }
+
+    if (nwpRole != ROLE_STA)
+    {
+        ret = sl_WlanSetMode(ROLE_STA);
+        if (ret < 0)
+        {
+            printError("sl_WlanSetMode failed, error code : %d \r\n", ret);
+        }
+        ret = sl_Stop(200);
+        if (ret < 0)
+        {
+            printError("sl_Stop failed, error code : %d \r\n", ret);
+        }
+        ret = sl_Start(0, 0, nwpInitCallback);
+        if (ret < 0)
+        {
+            printError("sl_Start failed in STA role, error code : %d \r\n", ret);
+        }
+        NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_NWP_READY);
+        if (nwpRole != ROLE_STA)
+        {
+            printError("sl_Start failed in STA role, error code : %d \r\n", nwpRole);
+        }
+        Boot_mark(Boot_Phase_ROLE_SWITCH);
+        print("Device started as STATION");
+    }
+    print("sl_Start...");
+
+    if (Hibernate_restore())
+    {
+        print("Restored state from hibernate");
+        DnsCache_restore();
+        Timebase_restore();
+        Alarms_restore();
+        Uploader_restore();
+    }
+
+    /* The configuration lives in the NWP file system */
+    AppConfig_init();
+    Boot_mark(Boot_Phase_CONFIG);
+    if (!Totalizer_restore())
+    {
+        print("No volume checkpoint, totalizer starts at zero");
+    }
+
+    if(0==Connect())
+    {
+        sprintf(printString, "Wifi Connected to %s",SSID_NAME);
+        print(printString);
+
+/*
+        status = pthread_create(&httpThread, &pAttrs, httpTask, NULL);
+        if(status)
+        {
+            printError("Task create failed, error code : %d \r\n", status);
+        }
+        */
+    }
+    else
+    {
+        /* Not connected; the reconnect task takes it from here */
+        NetSched_signal(NETSCHED_EVENT_WLAN_DISCONNECTED);
+    }
+
+    PT_END(&task->pt);
+}
+
 /*
 // Callback function
 static void readCallback(UART_Handle handle, void *rxBuf, size_t size)
@@ -369,12 +587,17 @@ void mainThread(void *pvParameters)
     pthread_attr_t      pAttrs_spawn;
     pthread_attr_t      pAttrs;
     struct sched_param  priParam;
-    int32_t             mode;
     int16_t             ret;
-    UART_Params uartParams;
+    Supervisor_CrashRecord crashRecord;
+    char                crashString[128];
+    Hibernate_Wake      wake;
 
 
+    GPIO_init();
     SPI_init();
+    I2C_init();
+    Capture_init();
+    Timer_init();
     /*Display_init();
     display = Display_open(Display_Type_UART, NULL);
     if (display == NULL) {
@@ -382,32 +605,24 @@ void mainThread(void *pvParameters)
         while(1);
     }*/
 
-    UART_init();
-
-    /*
-     *  Initialize the UART parameters outside the loop. Let's keep
-     *  most of the defaults (e.g. baudrate = 115200) and only change the
-     *  following.
-     */
-    UART_Params_init(&uartParams);
-    uartParams.writeDataMode  = UART_DATA_BINARY;
-    uartParams.readDataMode   = UART_DATA_BINARY;
-    uartParams.readReturnMode = UART_RETURN_FULL;
-    uart = UART_open(Board_UART0, &uartParams);
-
-    pthread_attr_init(&pAttrs);
-    priParam.sched_priority = 1;
-    status = pthread_attr_setschedparam(&pAttrs, &priParam);
-    status |= pthread_attr_setstacksize(&pAttrs, TASK_STACK_SIZE);
-
-    ret = pthread_create(&console_Thread, &pAttrs, consoleThread, NULL);
-    if (ret != 0) {
-        /* pthread_create() failed */
-        while (1);
+    /* Console and log output, buffered and sent by DMA */
+    UartIo_init();
+    if (Timebase_init() != 0)
+    {
+        print("Timebase init failed, timestamps use the kernel clock");
     }
+    Boot_mark(Boot_Phase_DRIVERS);
+    wake = Hibernate_init();
 
-
-    print("UART Display initilized...");
+    /* From here on a stalled thread or fatal error resets the device */
+    Supervisor_init();
+    if (Supervisor_lastCrash(&crashRecord))
+    {
+        sprintf(crashString, "Recovered from reset #%u: %s in %s, code %d",
+                (unsigned)crashRecord.resetCount, crashRecord.reason,
+                crashRecord.name, (int)crashRecord.code);
+        print(crashString);
+    }
 
     ret = sem_init(&ipEventSyncObj,0,0);
     if(ret != 0)
@@ -415,6 +630,36 @@ void mainThread(void *pvParameters)
         printError("Semaphore init failed, error code : %d \r\n", ret);
         return;
     }
+
+    /* Start the network scheduler before the NWP so no event is missed */
+    ret = NetSched_init();
+    if(ret != 0)
+    {
+        printError("NetSched init failed, error code : %d \r\n", ret);
+        return;
+    }
+    pthread_attr_init(&pAttrs);
+    priParam.sched_priority = NETSCHED_TASK_PRIORITY;
+    status = pthread_attr_setschedparam(&pAttrs, &priParam);
+    status |= pthread_attr_setstacksize(&pAttrs, NETSCHED_STACK_SIZE);
+
+    status = pthread_create(&netSched_Thread, &pAttrs, netSchedThread, NULL);
+    if(status)
+    {
+        printError("Task create failed, error code : %d \r\n", status);
+    }
+    NetSched_start(&bootTask, bootFxn, NULL);
+    NetSched_start(&wlanReconnectTask, wlanReconnectFxn, NULL);
+    Hibernate_start();
+    WifiScan_init();
+    ConsoleTcp_init();
+    RestServer_init();
+    Uploader_init();
+    if (CrashDump_init())
+    {
+        print("Crash dump pending, uploading once connected");
+    }
+
     /* Start the SimpleLink Host */
     pthread_attr_init(&pAttrs_spawn);
     priParam.sched_priority = SPAWN_TASK_PRIORITY;
@@ -428,56 +673,65 @@ void mainThread(void *pvParameters)
     }
     print("sl_Task thread started...");
 
-    /* initialize the device */
-    mode = sl_Start(0, 0, 0);
-    if (mode < 0)
+    /*
+     *  Start the NWP without waiting for it; the rest of the bring-up
+     *  continues in bootFxn once nwpInitCallback reports it ready.
+     */
+    ret = sl_Start(0, 0, nwpInitCallback);
+    if (ret < 0)
     {
-        printError("Sl_start failed, error code : %d \r\n", status);
+        printError("Sl_start failed, error code : %d \r\n", ret);
     }
+    Boot_mark(Boot_Phase_NWP_START);
 
-    if(mode != ROLE_STA)
+    /* Measurement does not depend on the network */
+    if (SensorSpi_init() != 0)
     {
-        mode = sl_WlanSetMode(ROLE_STA);
-        //ASSERT_ON_ERROR(mode);
-        if (mode < 0)
-        {
-            printError("sl_WlanSetMode failed, error code : %d \r\n", status);
-        }
-        mode = sl_Stop(200);
-        //ASSERT_ON_ERROR(mode);
-        if (mode < 0)
-        {
-            printError("sl_Stop failed, error code : %d \r\n", status);
-        }
-        mode = sl_Start(0, 0, 0);
-        if (mode < 0 || (mode != ROLE_STA))
-        {
-            //ASSERT_ON_ERROR(mode);
-            printError("sl_Start failed in STA role, error code : %d \r\n", status);
-
-        }
-        UART_write(uart, "Device started as STATION \n\r",sizeof("Device started as STATION \n\r"));
+        print("Front-end SPI open failed");
+    }
+    if (Acoustic_init() != 0)
+    {
+        print("Acoustic I2S open failed");
+    }
+    if (I2cBus_init() != 0)
+    {
+        print("Sensor I2C open failed");
+    }
+    if (Totalizer_init() != 0)
+    {
+        print("Totalizer start failed");
+    }
+    if (PayloadSec_init() != 0)
+    {
+        print("Crypto engine open failed");
     }
-    print("sl_Start...");
 
-    if(0==Connect())
+    /*
+     *  A timer wake-up from hibernate only takes a reading and reports;
+     *  nobody is watching the UART console.
+     */
+    if (wake == Hibernate_Wake_TIMER)
     {
-        char printString[256]={0};
-        sprintf(printString, "Wifi Connected to %s",SSID_NAME);
-        print(printString);
+        return;
+    }
 
-/*
-        status = pthread_create(&httpThread, &pAttrs, httpTask, NULL);
-        if(status)
-        {
-            printError("Task create failed, error code : %d \r\n", status);
-        }
-        */
+    /* Local bring-up runs while the NWP boots */
+    pthread_attr_init(&pAttrs);
+    priParam.sched_priority = 1;
+    status = pthread_attr_setschedparam(&pAttrs, &priParam);
+    status |= pthread_attr_setstacksize(&pAttrs, TASK_STACK_SIZE);
+
+    ret = pthread_create(&console_Thread, &pAttrs, consoleThread, NULL);
+    if (ret != 0) {
+        /* pthread_create() failed */
+        Supervisor_fatal("console thread create failed", ret);
     }
+    Boot_mark(Boot_Phase_CONSOLE);
 
-    DisplayBanner();
-    print(&helpPrompt);
-    print(&userPrompt);
+    print("UART Display initilized...");
 
+    DisplayBanner();
+    print(consoleDisplay);
+    UartIo_write(userPrompt, strlen(userPrompt));
 }
 
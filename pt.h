@@ -0,0 +1,93 @@
+/*
+ *  ======== pt.h ========
+ *  Stackless cooperative coroutines (protothreads).
+ *
+ *  A protothread is an ordinary C function whose local continuation is
+ *  kept in a Pt structure instead of on a stack. The function can block
+ *  on a condition with PT_WAIT_UNTIL() and is resumed at the same point
+ *  the next time it is called. Only the Pt (two bytes) and whatever state
+ *  the caller keeps in its own context structure survive a wait; ordinary
+ *  local variables do NOT, so keep anything that must persist across a
+ *  wait in the context.
+ *
+ *  The continuation is implemented with a switch on __LINE__, so a
+ *  protothread body must not contain its own switch statement spanning a
+ *  wait point, and only one PT_* wait macro may appear per source line.
+ */
+#ifndef __PT_H
+#define __PT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*!
+ *  @brief  Protothread return codes
+ */
+#define PT_WAITING  (0)
+#define PT_YIELDED  (1)
+#define PT_EXITED   (2)
+#define PT_ENDED    (3)
+
+/*!
+ *  @brief  Protothread control block (local continuation)
+ */
+typedef struct Pt {
+    uint16_t lc;
+} Pt;
+
+#define PT_THREAD(name_args)        char name_args
+
+#define PT_INIT(pt)                 ((pt)->lc = 0)
+
+#define PT_BEGIN(pt)                { char ptYieldFlag = 1; (void)ptYieldFlag; \
+                                      switch ((pt)->lc) { case 0:
+
+#define PT_END(pt)                  } ptYieldFlag = 0; PT_INIT(pt); \
+                                      return (PT_ENDED); }
+
+#define PT_WAIT_UNTIL(pt, cond)     do {                                    \
+                                        (pt)->lc = __LINE__; case __LINE__: \
+                                        if (!(cond)) {                      \
+                                            return (PT_WAITING);            \
+                                        }                                   \
+                                    } while (0)
+
+#define PT_WAIT_WHILE(pt, cond)     PT_WAIT_UNTIL((pt), !(cond))
+
+/* Block until the child protothread has run to completion */
+#define PT_WAIT_THREAD(pt, thread)  PT_WAIT_WHILE((pt), ((thread) < PT_EXITED))
+
+#define PT_SPAWN(pt, child, thread) do {                                    \
+                                        PT_INIT((child));                   \
+                                        PT_WAIT_THREAD((pt), (thread));     \
+                                    } while (0)
+
+#define PT_RESTART(pt)              do {                                    \
+                                        PT_INIT(pt);                        \
+                                        return (PT_WAITING);                \
+                                    } while (0)
+
+#define PT_EXIT(pt)                 do {                                    \
+                                        PT_INIT(pt);                        \
+                                        return (PT_EXITED);                 \
+                                    } while (0)
+
+/* Give the other protothreads one pass before continuing */
+#define PT_YIELD(pt)                do {                                    \
+                                        ptYieldFlag = 0;                    \
+                                        (pt)->lc = __LINE__; case __LINE__: \
+                                        if (ptYieldFlag == 0) {             \
+                                            return (PT_YIELDED);            \
+                                        }                                   \
+                                    } while (0)
+
+#define PT_SCHEDULE(f)              ((f) < PT_EXITED)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PT_H */
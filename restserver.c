@@ -0,0 +1,469 @@
+/*
+ *  ======== restserver.c ========
+ *  REST interface served through the NWP's HTTP server
+ *
+ *  Everything here runs in the sl_Task context of the NetApp request
+ *  event, where calling back into the SimpleLink driver would deadlock.
+ *  Handlers therefore only read cached state; anything that needs the
+ *  NWP (saving the configuration to flash) is deferred to the network
+ *  scheduler.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "appconfig.h"
+#include "consoletcp.h"
+#include "i2cbus.h"
+#include "netsched.h"
+#include "restserver.h"
+#include "rollup.h"
+#include "totalizer.h"
+#include "wifiscan.h"
+
+/* Form field holding the admin key of a PUT, see appconfig.h */
+#define RESTSERVER_AUTH_KEY         "auth"
+
+/* Longest PUT body accepted, it has to arrive in the first fragment */
+#define RESTSERVER_MAX_BODY         (256)
+
+/* TLV header: type (1 byte) + length (2 bytes) */
+#define RESTSERVER_TLV_HDR_SIZE     (3)
+
+typedef uint16_t (*RestServer_GetFxn)(char *out, size_t size, int *outLen);
+typedef uint16_t (*RestServer_PutFxn)(char *body, char *out, size_t size,
+                                      int *outLen);
+
+typedef struct RestServer_Resource {
+    const char         *uri;
+    RestServer_GetFxn   getFxn;
+    RestServer_PutFxn   putFxn;
+} RestServer_Resource;
+
+typedef struct RestServer_Buffer {
+    uint8_t     refs;           /* pointers still held by the NWP */
+    uint8_t     metadata[RESTSERVER_METADATA_SIZE];
+    char        payload[RESTSERVER_PAYLOAD_SIZE];
+} RestServer_Buffer;
+
+static uint16_t getDiag(char *out, size_t size, int *outLen);
+static uint16_t getConfig(char *out, size_t size, int *outLen);
+static uint16_t getReadings(char *out, size_t size, int *outLen);
+static uint16_t putConfig(char *body, char *out, size_t size, int *outLen);
+
+static const RestServer_Resource resources[] = {
+    { "/api/diag",      getDiag,    NULL },
+    { "/api/config",    getConfig,  putConfig },
+    { "/api/readings",  getReadings, NULL },
+};
+
+#define RESTSERVER_NUM_RESOURCES \
+    (sizeof(resources) / sizeof(resources[0]))
+
+static RestServer_Buffer buffers[RESTSERVER_NUM_BUFFERS];
+static RestServer_Stats  stats;
+static NetSched_Task     saveTask;
+
+/*
+ *  ======== saveFxn ========
+ *  Writes the configuration on the network scheduler, where the NWP may
+ *  be called.
+ */
+static PT_THREAD(saveFxn(NetSched_Task *task))
+{
+    PT_BEGIN(&task->pt);
+
+    while (1) {
+        NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_CONFIG_SAVE);
+        AppConfig_save();
+    }
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== getDiag ========
+ */
+static uint16_t getDiag(char *out, size_t size, int *outLen)
+{
+    AppConfig config;
+
+    AppConfig_copy(&config);
+    *outLen = snprintf(out, size,
+            "{\"name\":\"%s\",\"uptimeMs\":%lu,\"scanEntries\":%d,"
+            "\"consoleDropped\":%lu,\"restRequests\":%lu,"
+            "\"restErrors\":%lu,\"restBusy\":%lu,\"restDenied\":%lu,"
+            "\"restMaxMs\":%lu}",
+            config.deviceName, (unsigned long)NetSched_nowMs(),
+            WifiScan_count(NULL),
+            (unsigned long)ConsoleTcp_droppedBytes(),
+            (unsigned long)stats.requests, (unsigned long)stats.errors,
+            (unsigned long)stats.busy, (unsigned long)stats.denied,
+            (unsigned long)stats.maxHandlingMs);
+
+    return (SL_NETAPP_HTTP_RESPONSE_200_OK);
+}
+
+/*
+ *  ======== getReadings ========
+ */
+static uint16_t getReadings(char *out, size_t size, int *outLen)
+{
+    Totalizer_Reading r;
+    Rollup_Summary    minute;
+    I2cBus_Reading    pressure;
+    int               len;
+
+    Totalizer_getReading(&r);
+    len = snprintf(out, size,
+            "{\"totalNl\":%llu,\"pulses\":%llu,\"rateNlPerS\":%lu,"
+            "\"tempMilliC\":%ld",
+            (unsigned long long)r.totalNl, (unsigned long long)r.pulses,
+            (unsigned long)r.rateNlPerS, (long)r.tempMilliC);
+    if (I2cBus_read(I2cBus_Value_PRESSURE, &pressure)) {
+        len += snprintf(out + len, size - len, ",\"pressurePa\":%ld",
+                (long)pressure.value);
+    }
+    if (Rollup_get(Rollup_Period_MINUTE, &minute)) {
+        len += snprintf(out + len, size - len,
+                ",\"minute\":{\"durationMs\":%lu,\"minNlPerS\":%lu,"
+                "\"meanNlPerS\":%lu,\"maxNlPerS\":%lu,\"sdNlPerS\":%lu,"
+                "\"volumeNl\":%llu}",
+                (unsigned long)minute.durationMs, (unsigned long)minute.min,
+                (unsigned long)minute.mean, (unsigned long)minute.max,
+                (unsigned long)minute.stddev,
+                (unsigned long long)minute.volumeNl);
+    }
+    len += snprintf(out + len, size - len, "}");
+    if (len >= (int)size) {
+        return (SL_NETAPP_HTTP_RESPONSE_500_INTERNAL_SERVER_ERROR);
+    }
+    *outLen = len;
+
+    return (SL_NETAPP_HTTP_RESPONSE_200_OK);
+}
+
+/*
+ *  ======== getConfig ========
+ */
+static uint16_t getConfig(char *out, size_t size, int *outLen)
+{
+    char        value[sizeof(((AppConfig *)0)->serverHost)];
+    const char *key;
+    int         len = 0;
+    int         i;
+
+    out[len++] = '{';
+    for (i = 0; (key = AppConfig_keyName(i)) != NULL; i++) {
+        AppConfig_get(key, value, sizeof(value));
+        len += snprintf(out + len, size - len, "%s\"%s\":\"%s\"",
+                (i > 0) ? "," : "", key, value);
+        if (len >= (int)size - 1) {
+            return (SL_NETAPP_HTTP_RESPONSE_500_INTERNAL_SERVER_ERROR);
+        }
+    }
+    out[len++] = '}';
+    *outLen = len;
+
+    return (SL_NETAPP_HTTP_RESPONSE_200_OK);
+}
+
+/*
+ *  ======== urlDecode ========
+ *  In place; '+' is a space and %XX an escaped byte.
+ */
+static void urlDecode(char *s)
+{
+    char *dst = s;
+    int   hi;
+    int   lo;
+
+    for (; *s != '\0'; s++) {
+        if (*s == '+') {
+            *dst++ = ' ';
+        }
+        else if ((*s == '%') && (s[1] != '\0') && (s[2] != '\0')) {
+            hi = (s[1] <= '9') ? s[1] - '0' : (s[1] | 0x20) - 'a' + 10;
+            lo = (s[2] <= '9') ? s[2] - '0' : (s[2] | 0x20) - 'a' + 10;
+            *dst++ = (char)((hi << 4) | lo);
+            s += 2;
+        }
+        else {
+            *dst++ = *s;
+        }
+    }
+    *dst = '\0';
+}
+
+/*
+ *  ======== putConfig ========
+ *  Body is key=value&key=value and must include auth=<admin key>. The
+ *  pairs are applied to a copy, which is only published when every pair
+ *  is valid.
+ */
+static uint16_t putConfig(char *body, char *out, size_t size, int *outLen)
+{
+    AppConfig  config;
+    bool       authorized = false;
+    char      *pair;
+    char      *next;
+    char      *value;
+
+    AppConfig_copy(&config);
+
+    for (pair = body; (pair != NULL) && (*pair != '\0'); pair = next) {
+        next = strchr(pair, '&');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        value = strchr(pair, '=');
+        if (value == NULL) {
+            return (SL_NETAPP_HTTP_RESPONSE_400_BAD_REQUEST);
+        }
+        *value++ = '\0';
+        urlDecode(pair);
+        urlDecode(value);
+        if (strcmp(pair, RESTSERVER_AUTH_KEY) == 0) {
+            authorized = AppConfig_authorize(value);
+            memset(value, 0, strlen(value));
+        }
+        else if (!AppConfig_set(&config, pair, value)) {
+            *outLen = snprintf(out, size, "{\"error\":\"bad key or value\","
+                    "\"key\":\"%s\"}", pair);
+            return (SL_NETAPP_HTTP_RESPONSE_400_BAD_REQUEST);
+        }
+    }
+
+    /* Checked last, so a bad key cannot tell a prober anything */
+    if (!authorized) {
+        stats.denied++;
+        return (SL_NETAPP_HTTP_RESPONSE_403_FORBIDDEN);
+    }
+
+    AppConfig_publish(&config);
+    NetSched_signal(NETSCHED_EVENT_CONFIG_SAVE);
+
+    return (getConfig(out, size, outLen));
+}
+
+/*
+ *  ======== findMetadata ========
+ *  Walk the request metadata TLVs for type.
+ */
+static const uint8_t *findMetadata(const SlNetAppRequestData_t *data,
+                                   uint8_t type, uint16_t *len)
+{
+    const uint8_t *p = data->pMetadata;
+    const uint8_t *end = p + data->MetadataLen;
+    uint16_t       tlvLen;
+
+    while (p + RESTSERVER_TLV_HDR_SIZE <= end) {
+        tlvLen = p[1] | ((uint16_t)p[2] << 8);
+        if (p + RESTSERVER_TLV_HDR_SIZE + tlvLen > end) {
+            break;
+        }
+        if (p[0] == type) {
+            *len = tlvLen;
+            return (p + RESTSERVER_TLV_HDR_SIZE);
+        }
+        p += RESTSERVER_TLV_HDR_SIZE + tlvLen;
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== putTlv ========
+ */
+static uint8_t *putTlv(uint8_t *p, uint8_t type, const void *value,
+                       uint16_t len)
+{
+    *p++ = type;
+    *p++ = (uint8_t)(len & 0xFF);
+    *p++ = (uint8_t)(len >> 8);
+    memcpy(p, value, len);
+
+    return (p + len);
+}
+
+/*
+ *  ======== allocBuffer ========
+ */
+static RestServer_Buffer *allocBuffer(void)
+{
+    int i;
+
+    for (i = 0; i < RESTSERVER_NUM_BUFFERS; i++) {
+        if (buffers[i].refs == 0) {
+            return (&buffers[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== dispatch ========
+ */
+static uint16_t dispatch(SlNetAppRequest_t *request, RestServer_Buffer *buf,
+                         int *payloadLen)
+{
+    const RestServer_Resource *resource = NULL;
+    const uint8_t             *uri;
+    uint16_t                   uriLen = 0;
+    char                       body[RESTSERVER_MAX_BODY];
+    unsigned int               i;
+
+    uri = findMetadata(&request->requestData,
+            SL_NETAPP_REQUEST_METADATA_TYPE_HTTP_REQUEST_URI, &uriLen);
+    if (uri == NULL) {
+        return (SL_NETAPP_HTTP_RESPONSE_400_BAD_REQUEST);
+    }
+
+    for (i = 0; i < RESTSERVER_NUM_RESOURCES; i++) {
+        if ((strlen(resources[i].uri) == uriLen) &&
+                (memcmp(resources[i].uri, uri, uriLen) == 0)) {
+            resource = &resources[i];
+            break;
+        }
+    }
+    if (resource == NULL) {
+        return (SL_NETAPP_HTTP_RESPONSE_404_NOT_FOUND);
+    }
+
+    switch (request->Type) {
+        case SL_NETAPP_REQUEST_HTTP_GET:
+            if (resource->getFxn != NULL) {
+                return (resource->getFxn(buf->payload,
+                        RESTSERVER_PAYLOAD_SIZE, payloadLen));
+            }
+            break;
+
+        case SL_NETAPP_REQUEST_HTTP_PUT:
+            if (resource->putFxn != NULL) {
+                if ((request->requestData.Flags &
+                        SL_NETAPP_REQUEST_RESPONSE_FLAGS_CONTINUATION) ||
+                        (request->requestData.PayloadLen >= sizeof(body))) {
+                    return (SL_NETAPP_HTTP_RESPONSE_400_BAD_REQUEST);
+                }
+                memcpy(body, request->requestData.pPayload,
+                        request->requestData.PayloadLen);
+                body[request->requestData.PayloadLen] = '\0';
+                return (resource->putFxn(body, buf->payload,
+                        RESTSERVER_PAYLOAD_SIZE, payloadLen));
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return (SL_NETAPP_HTTP_RESPONSE_405_METHOD_NOT_ALLOWED);
+}
+
+/*
+ *  ======== RestServer_handleRequest ========
+ */
+void RestServer_handleRequest(SlNetAppRequest_t *pNetAppRequest,
+                              SlNetAppResponse_t *pNetAppResponse)
+{
+    static const char  contentType[] = "application/json";
+    RestServer_Buffer *buf;
+    uint8_t           *meta;
+    uint32_t           start = NetSched_nowMs();
+    uint32_t           elapsed;
+    uint32_t           contentLen;
+    uint16_t           status;
+    int                payloadLen = 0;
+
+    pNetAppResponse->ResponseData.pMetadata = NULL;
+    pNetAppResponse->ResponseData.MetadataLen = 0;
+    pNetAppResponse->ResponseData.pPayload = NULL;
+    pNetAppResponse->ResponseData.PayloadLen = 0;
+    pNetAppResponse->ResponseData.Flags = 0;
+
+    if (pNetAppRequest->AppId != SL_NETAPP_HTTP_SERVER_ID) {
+        pNetAppResponse->Status = SL_NETAPP_RESPONSE_NONE;
+        return;
+    }
+    stats.requests++;
+
+    /* Until the NWP frees a buffer the response has to be refused */
+    buf = allocBuffer();
+    if (buf == NULL) {
+        stats.busy++;
+        pNetAppResponse->Status = SL_NETAPP_HTTP_RESPONSE_503_SERVICE_UNAVAILABLE;
+        return;
+    }
+
+    status = dispatch(pNetAppRequest, buf, &payloadLen);
+    if ((payloadLen < 0) || (payloadLen >= RESTSERVER_PAYLOAD_SIZE)) {
+        status = SL_NETAPP_HTTP_RESPONSE_500_INTERNAL_SERVER_ERROR;
+        payloadLen = 0;
+    }
+    if (status != SL_NETAPP_HTTP_RESPONSE_200_OK) {
+        stats.errors++;
+    }
+
+    contentLen = payloadLen;
+    meta = buf->metadata;
+    meta = putTlv(meta, SL_NETAPP_REQUEST_METADATA_TYPE_STATUS, &status,
+            sizeof(status));
+    if (payloadLen > 0) {
+        meta = putTlv(meta, SL_NETAPP_REQUEST_METADATA_TYPE_HTTP_CONTENT_TYPE,
+                contentType, sizeof(contentType) - 1);
+    }
+    meta = putTlv(meta, SL_NETAPP_REQUEST_METADATA_TYPE_HTTP_CONTENT_LEN,
+            &contentLen, sizeof(contentLen));
+
+    pNetAppResponse->Status = status;
+    pNetAppResponse->ResponseData.pMetadata = buf->metadata;
+    pNetAppResponse->ResponseData.MetadataLen = meta - buf->metadata;
+    buf->refs = 1;
+    if (payloadLen > 0) {
+        pNetAppResponse->ResponseData.pPayload = (uint8_t *)buf->payload;
+        pNetAppResponse->ResponseData.PayloadLen = payloadLen;
+        buf->refs++;
+    }
+
+    elapsed = NetSched_nowMs() - start;
+    if (elapsed > stats.maxHandlingMs) {
+        stats.maxHandlingMs = elapsed;
+    }
+}
+
+/*
+ *  ======== RestServer_freeBuffer ========
+ */
+void RestServer_freeBuffer(uint8_t *buffer)
+{
+    int i;
+
+    for (i = 0; i < RESTSERVER_NUM_BUFFERS; i++) {
+        if (((buffer == buffers[i].metadata) ||
+                (buffer == (uint8_t *)buffers[i].payload)) &&
+                (buffers[i].refs > 0)) {
+            buffers[i].refs--;
+            return;
+        }
+    }
+}
+
+/*
+ *  ======== RestServer_init ========
+ */
+void RestServer_init(void)
+{
+    NetSched_start(&saveTask, saveFxn, NULL);
+}
+
+/*
+ *  ======== RestServer_getStats ========
+ */
+void RestServer_getStats(RestServer_Stats *statsOut)
+{
+    *statsOut = stats;
+}
@@ -0,0 +1,66 @@
+/*
+ *  ======== restserver.h ========
+ *  REST interface served through the NWP's HTTP server.
+ *
+ *  The NWP forwards requests for /api/... to the host as NetApp request
+ *  events. Each response is formatted straight into one of a few static
+ *  response buffers that are handed to the NWP as-is; a buffer is only
+ *  reused after SimpleLinkNetAppRequestMemFreeEventHandler() returns it.
+ *
+ *      GET /api/diag       device diagnostics
+ *      GET /api/config     configuration (see appconfig.h)
+ *      PUT /api/config     key=value&key=value form body, with
+ *                          auth=<admin key> (see appconfig.h)
+ */
+#ifndef __RESTSERVER_H
+#define __RESTSERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include <ti/drivers/net/wifi/simplelink.h>
+
+/* Response buffers that can be in flight with the NWP at once */
+#define RESTSERVER_NUM_BUFFERS      (2)
+
+#define RESTSERVER_METADATA_SIZE    (64)
+#define RESTSERVER_PAYLOAD_SIZE     (512)
+
+/*!
+ *  @brief  Request counters
+ */
+typedef struct RestServer_Stats {
+    uint32_t    requests;
+    uint32_t    errors;
+    uint32_t    busy;               /* no response buffer free */
+    uint32_t    denied;             /* PUT without a valid admin key */
+    uint32_t    maxHandlingMs;      /* slowest request, event to response */
+} RestServer_Stats;
+
+/*!
+ *  @brief  Start the deferred configuration writer on the network
+ *          scheduler
+ */
+extern void RestServer_init(void);
+
+/*!
+ *  @brief  Body of SimpleLinkNetAppRequestEventHandler()
+ */
+extern void RestServer_handleRequest(SlNetAppRequest_t *pNetAppRequest,
+                                     SlNetAppResponse_t *pNetAppResponse);
+
+/*!
+ *  @brief  Body of SimpleLinkNetAppRequestMemFreeEventHandler()
+ */
+extern void RestServer_freeBuffer(uint8_t *buffer);
+
+extern void RestServer_getStats(RestServer_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RESTSERVER_H */
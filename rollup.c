@@ -0,0 +1,207 @@
+/*
+ *  ======== rollup.c ========
+ *  Per-interval flow rate summaries
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "console.h"
+#include "fixmath.h"
+#include "rollup.h"
+
+/* Running state of one period */
+typedef struct Accumulator {
+    Rollup_Summary  s;
+    uint64_t        sum;
+    uint64_t        sumSq;          /* of rate >> ROLLUP_VAR_SHIFT */
+} Accumulator;
+
+static const uint32_t periodMs[Rollup_Period_COUNT] = {
+    60 * 1000, 15 * 60 * 1000, 60 * 60 * 1000
+};
+
+/* Decades from 1 uL/s; a dripping tap is around 10 uL/s */
+static const uint32_t bucketLimit[ROLLUP_HIST_BUCKETS - 1] = {
+    1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/* Owned by the totalizer thread */
+static Accumulator      acc[Rollup_Period_COUNT];
+
+/* Guarded by HwiP */
+static Rollup_Summary   last[Rollup_Period_COUNT];
+static bool             lastValid[Rollup_Period_COUNT];
+static uint32_t         raw[ROLLUP_RAW_SIZE];
+static uint32_t         rawCount = 0;       /* total ever added */
+
+/*
+ *  ======== closePeriod ========
+ *  Finish the summary of period p. Runs once per interval, so the
+ *  divisions and the square root stay off the per-sample path.
+ */
+static void closePeriod(int p, uint32_t timeMs)
+{
+    Accumulator *a = &acc[p];
+    uint64_t     meanScaled;
+    uint64_t     var;
+    uintptr_t    key;
+
+    a->s.durationMs = timeMs - a->s.startMs;
+    a->s.mean = (uint32_t)(a->sum / a->s.count);
+    meanScaled = a->sum / a->s.count >> ROLLUP_VAR_SHIFT;
+    var = a->sumSq / a->s.count;
+    var = (var > meanScaled * meanScaled) ? var - meanScaled * meanScaled : 0;
+    a->s.stddev = FixMath_isqrt(var) << ROLLUP_VAR_SHIFT;
+
+    key = HwiP_disable();
+    last[p] = a->s;
+    lastValid[p] = true;
+    HwiP_restore(key);
+
+    a->s.count = 0;
+}
+
+/*
+ *  ======== Rollup_add ========
+ */
+void Rollup_add(uint32_t rateNlPerS, uint32_t volumeNl, uint32_t timeMs)
+{
+    Accumulator *a;
+    uint32_t     scaled = rateNlPerS >> ROLLUP_VAR_SHIFT;
+    uintptr_t    key;
+    int          bucket = 0;
+    int          p;
+
+    while ((bucket < ROLLUP_HIST_BUCKETS - 1) &&
+            (rateNlPerS >= bucketLimit[bucket])) {
+        bucket++;
+    }
+
+    for (p = 0; p < Rollup_Period_COUNT; p++) {
+        a = &acc[p];
+        if ((a->s.count != 0) &&
+                ((timeMs - a->s.startMs) >= periodMs[p])) {
+            closePeriod(p, timeMs);
+        }
+        if (a->s.count == 0) {
+            memset(a, 0, sizeof(*a));
+            a->s.startMs = timeMs;
+            a->s.min = rateNlPerS;
+            a->s.max = rateNlPerS;
+        }
+        if (rateNlPerS < a->s.min) {
+            a->s.min = rateNlPerS;
+        }
+        if (rateNlPerS > a->s.max) {
+            a->s.max = rateNlPerS;
+        }
+        a->s.count++;
+        a->s.volumeNl += volumeNl;
+        if (a->s.hist[bucket] != UINT16_MAX) {
+            a->s.hist[bucket]++;
+        }
+        a->sum += rateNlPerS;
+        a->sumSq += (uint64_t)scaled * scaled;
+    }
+
+    key = HwiP_disable();
+    raw[rawCount % ROLLUP_RAW_SIZE] = rateNlPerS;
+    rawCount++;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== Rollup_get ========
+ */
+bool Rollup_get(Rollup_Period period, Rollup_Summary *summary)
+{
+    uintptr_t key;
+    bool      valid;
+
+    if ((unsigned int)period >= Rollup_Period_COUNT) {
+        return (false);
+    }
+
+    key = HwiP_disable();
+    *summary = last[period];
+    valid = lastValid[period];
+    HwiP_restore(key);
+
+    return (valid);
+}
+
+/*
+ *  ======== Rollup_raw ========
+ */
+int Rollup_raw(uint32_t *rates, int max)
+{
+    uint32_t  first;
+    uint32_t  n;
+    uintptr_t key;
+    int       i;
+
+    key = HwiP_disable();
+    n = (rawCount < ROLLUP_RAW_SIZE) ? rawCount : ROLLUP_RAW_SIZE;
+    if (n > (uint32_t)max) {
+        n = (uint32_t)max;
+    }
+    first = rawCount - n;
+    for (i = 0; i < (int)n; i++) {
+        rates[i] = raw[(first + i) % ROLLUP_RAW_SIZE];
+    }
+    HwiP_restore(key);
+
+    return ((int)n);
+}
+
+/*
+ *  ======== Rollup_bucketLimit ========
+ */
+uint32_t Rollup_bucketLimit(int i)
+{
+    return ((i < ROLLUP_HIST_BUCKETS - 1) ? bucketLimit[i] : UINT32_MAX);
+}
+
+/*
+ *  ======== cmdRollup ========
+ */
+static void cmdRollup(Console_Session *session, const Console_Args *args)
+{
+    static const char *const names[Rollup_Period_COUNT] = {
+        "1 min", "15 min", "1 h"
+    };
+    char           printString[CONSOLE_PRINT_SIZE];
+    Rollup_Summary s;
+    int            len;
+    int            p;
+    int            i;
+
+    for (p = 0; p < Rollup_Period_COUNT; p++) {
+        if (!Rollup_get((Rollup_Period)p, &s)) {
+            snprintf(printString, sizeof(printString), "%-6s --", names[p]);
+            Console_print(session, printString);
+            continue;
+        }
+        len = snprintf(printString, sizeof(printString),
+                "%-6s n %lu min %lu mean %lu max %lu sd %lu nL/s, "
+                "%lu mL, hist",
+                names[p], (unsigned long)s.count, (unsigned long)s.min,
+                (unsigned long)s.mean, (unsigned long)s.max,
+                (unsigned long)s.stddev,
+                (unsigned long)(s.volumeNl / 1000000));
+        for (i = 0; (i < ROLLUP_HIST_BUCKETS) &&
+                (len < (int)sizeof(printString)); i++) {
+            len += snprintf(printString + len, sizeof(printString) - len,
+                    " %u", s.hist[i]);
+        }
+        Console_print(session, printString);
+    }
+}
+
+CONSOLE_COMMAND(rollup, "roll", cmdRollup, "", "",
+                "flow rate summaries per minute, quarter and hour");
@@ -0,0 +1,86 @@
+/*
+ *  ======== rollup.h ========
+ *  Interval summaries of the flow rate.
+ *
+ *  Every flow rate from the totalizer is added to three running
+ *  summaries, one minute, 15 minutes and one hour long: count, min, max,
+ *  mean, standard deviation, volume and a histogram over fixed decade
+ *  buckets. Adding a sample is a handful of integer operations on
+ *  preallocated state. When an interval ends its summary replaces the
+ *  previous one for that period.
+ *
+ *  Reports carry the summaries; the last ROLLUP_RAW_SIZE raw rates are
+ *  only sent when asked for (Uploader_requestRaw()).
+ */
+#ifndef __ROLLUP_H
+#define __ROLLUP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ROLLUP_HIST_BUCKETS         (8)
+
+/* Raw rates kept for on-demand upload */
+#define ROLLUP_RAW_SIZE             (32)
+
+/* The variance is accumulated in units of 2^ROLLUP_VAR_SHIFT nL/s */
+#define ROLLUP_VAR_SHIFT            (8)
+
+typedef enum Rollup_Period {
+    Rollup_Period_MINUTE = 0,
+    Rollup_Period_QUARTER,          /* 15 minutes */
+    Rollup_Period_HOUR,
+    Rollup_Period_COUNT
+} Rollup_Period;
+
+/*!
+ *  @brief  Summary of one interval. Rates in nL/s.
+ */
+typedef struct Rollup_Summary {
+    uint32_t    startMs;
+    uint32_t    durationMs;
+    uint32_t    count;
+    uint32_t    min;
+    uint32_t    max;
+    uint32_t    mean;
+    uint32_t    stddev;
+    uint64_t    volumeNl;
+    uint16_t    hist[ROLLUP_HIST_BUCKETS];  /* see Rollup_bucketLimit() */
+} Rollup_Summary;
+
+/*!
+ *  @brief  Add one flow rate and the volume it stands for, measured at
+ *          timeMs (Timebase_monoMs())
+ */
+extern void Rollup_add(uint32_t rateNlPerS, uint32_t volumeNl,
+                       uint32_t timeMs);
+
+/*!
+ *  @brief  Last completed summary of period
+ *
+ *  @return false if none has completed yet
+ */
+extern bool Rollup_get(Rollup_Period period, Rollup_Summary *summary);
+
+/*!
+ *  @brief  Most recent raw rates, oldest first
+ *
+ *  @return number copied
+ */
+extern int Rollup_raw(uint32_t *rates, int max);
+
+/*!
+ *  @brief  Upper limit (exclusive, nL/s) of histogram bucket i; the last
+ *          bucket has none
+ */
+extern uint32_t Rollup_bucketLimit(int i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ROLLUP_H */
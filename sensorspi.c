@@ -0,0 +1,206 @@
+/*
+ *  ======== sensorspi.c ========
+ *  Continuous acquisition from the flow front-end on GSPI
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+
+/* POSIX Header files */
+#include <semaphore.h>
+
+#include <ti/drivers/GPIO.h>
+#include <ti/drivers/SPI.h>
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "Board.h"
+#include "boot.h"
+#include "console.h"
+#include "sensorspi.h"
+
+static SPI_Handle       spiHandle = NULL;
+static SPI_Transaction  transaction;
+
+/* Ping-pong halves, plus a sink that drains the FIFO on an overrun */
+static int16_t          blocks[2][SENSORSPI_BLOCK_SAMPLES];
+static int16_t          discard[SENSORSPI_BLOCK_SAMPLES];
+static volatile bool    full[2] = {false, false};
+static volatile int     fillIndex = 0;          /* next half to fill */
+static int              readIndex = 0;          /* owned by the consumer */
+static volatile bool    transferActive = false;
+static sem_t            blockSem;
+
+static SensorSpi_Stats  stats;
+
+/*
+ *  ======== startTransfer ========
+ *  Called from the data-ready interrupt and from the transfer callback.
+ */
+static void startTransfer(void)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    if (transferActive) {
+        HwiP_restore(key);
+        return;
+    }
+    transferActive = true;
+    HwiP_restore(key);
+
+    transaction.count = SENSORSPI_BLOCK_SAMPLES;
+    transaction.txBuf = NULL;
+    if (full[fillIndex]) {
+        /* The consumer still holds this half; drain the FIFO anyway */
+        stats.overruns++;
+        transaction.rxBuf = discard;
+    }
+    else {
+        transaction.rxBuf = blocks[fillIndex];
+    }
+
+    if (!SPI_transfer(spiHandle, &transaction)) {
+        stats.errors++;
+        transferActive = false;
+    }
+}
+
+/*
+ *  ======== transferCallback ========
+ */
+static void transferCallback(SPI_Handle handle, SPI_Transaction *t)
+{
+    bool completed = false;
+
+    if (t->status != SPI_TRANSFER_COMPLETED) {
+        stats.errors++;
+    }
+    else if (t->rxBuf != discard) {
+        full[fillIndex] = true;
+        fillIndex ^= 1;
+        stats.blocks++;
+        completed = true;
+    }
+
+    /*
+     *  Only now may the data-ready edge start a transfer: it must see
+     *  the half just filled as full and the next one as the target.
+     */
+    transferActive = false;
+
+    if (completed) {
+        Boot_mark(Boot_Phase_FIRST_READING);
+        sem_post(&blockSem);
+    }
+
+    /* The next block is already waiting: no need for another edge */
+    if (GPIO_read(Board_SPI_SLAVE_READY) == 0) {
+        stats.chained++;
+        startTransfer();
+    }
+}
+
+/*
+ *  ======== dataReadyFxn ========
+ */
+static void dataReadyFxn(uint_least8_t index)
+{
+    startTransfer();
+}
+
+/*
+ *  ======== SensorSpi_init ========
+ */
+int SensorSpi_init(void)
+{
+    SPI_Params spiParams;
+
+    sem_init(&blockSem, 0, 0);
+
+    SPI_Params_init(&spiParams);
+    spiParams.mode = SPI_MASTER;
+    spiParams.frameFormat = SPI_POL0_PHA0;
+    spiParams.dataSize = 16;
+    spiParams.bitRate = SENSORSPI_BITRATE;
+    spiParams.transferMode = SPI_MODE_CALLBACK;
+    spiParams.transferCallbackFxn = transferCallback;
+    spiHandle = SPI_open(Board_SPI_MASTER, &spiParams);
+    if (spiHandle == NULL) {
+        return (-1);
+    }
+
+    GPIO_setConfig(Board_SPI_SLAVE_READY,
+            GPIO_CFG_INPUT | GPIO_CFG_IN_PU | GPIO_CFG_IN_INT_FALLING);
+    GPIO_setCallback(Board_SPI_SLAVE_READY, dataReadyFxn);
+    GPIO_enableInt(Board_SPI_SLAVE_READY);
+
+    /* The front-end may have been ready before the edge was armed */
+    if (GPIO_read(Board_SPI_SLAVE_READY) == 0) {
+        startTransfer();
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== SensorSpi_acquire ========
+ */
+const int16_t *SensorSpi_acquire(uint32_t timeoutMs)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeoutMs / 1000;
+    ts.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    if (sem_timedwait(&blockSem, &ts) != 0) {
+        return (NULL);
+    }
+
+    return (blocks[readIndex]);
+}
+
+/*
+ *  ======== SensorSpi_release ========
+ */
+void SensorSpi_release(void)
+{
+    full[readIndex] = false;
+    readIndex ^= 1;
+}
+
+/*
+ *  ======== SensorSpi_getStats ========
+ */
+void SensorSpi_getStats(SensorSpi_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdSensorSpi ========
+ */
+static void cmdSensorSpi(Console_Session *session, const Console_Args *args)
+{
+    char            printString[CONSOLE_PRINT_SIZE];
+    SensorSpi_Stats s;
+
+    SensorSpi_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "blocks %lu (chained %lu), overruns %lu, errors %lu",
+            (unsigned long)s.blocks, (unsigned long)s.chained,
+            (unsigned long)s.overruns, (unsigned long)s.errors);
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(sensorspi, "spi", cmdSensorSpi, "", "",
+                "front-end acquisition counters");
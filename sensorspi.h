@@ -0,0 +1,69 @@
+/*
+ *  ======== sensorspi.h ========
+ *  Continuous acquisition from the flow front-end on GSPI.
+ *
+ *  The front-end collects SENSORSPI_BLOCK_SAMPLES samples in its FIFO and
+ *  pulls its data-ready line (Board_SPI_SLAVE_READY) low. That edge
+ *  starts a DMA transfer of the whole block into one half of a ping-pong
+ *  buffer; the transfer callback hands the half to the consumer and, if
+ *  data-ready is still low, starts the next block right away. The CPU
+ *  only sees one interrupt per block.
+ *
+ *  Blocks the consumer is too slow for are dropped and counted as
+ *  overruns; acquisition itself never waits for the consumer.
+ *
+ *  Build with BOARD_GSPI_TURBO=1 for front-ends that accept words back
+ *  to back (see CC3220SF_LAUNCHXL.c).
+ */
+#ifndef __SENSORSPI_H
+#define __SENSORSPI_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Samples (16 bit frames) per data-ready */
+#define SENSORSPI_BLOCK_SAMPLES     (128)
+
+#define SENSORSPI_BITRATE           (10000000)
+
+/*!
+ *  @brief  Acquisition counters
+ */
+typedef struct SensorSpi_Stats {
+    uint32_t    blocks;             /* delivered to the consumer */
+    uint32_t    overruns;           /* dropped, both halves were full */
+    uint32_t    chained;            /* started straight from the previous */
+    uint32_t    errors;             /* failed transfers */
+} SensorSpi_Stats;
+
+/*!
+ *  @brief  Open GSPI and arm the data-ready interrupt
+ *
+ *  @return 0 on success
+ */
+extern int SensorSpi_init(void);
+
+/*!
+ *  @brief  Wait up to timeoutMs for a full block
+ *
+ *  @return the block, or NULL on timeout. Valid until
+ *          SensorSpi_release().
+ */
+extern const int16_t *SensorSpi_acquire(uint32_t timeoutMs);
+
+/*!
+ *  @brief  Return the block from SensorSpi_acquire() for reuse
+ */
+extern void SensorSpi_release(void);
+
+extern void SensorSpi_getStats(SensorSpi_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSORSPI_H */
@@ -0,0 +1,228 @@
+/*
+ *  ======== supervisor.c ========
+ *  Software watchdog supervisor
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/driverlib/rom.h>
+#include <ti/devices/cc32xx/driverlib/rom_map.h>
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+
+#include <ti/drivers/Watchdog.h>
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "Board.h"
+#include "console.h"
+#include "crashdump.h"
+#include "netsched.h"
+#include "supervisor.h"
+
+typedef struct Supervisor_Client {
+    const char         *name;
+    uint32_t            deadlineMs;
+    volatile uint32_t   lastCheckinMs;
+    volatile int32_t    activity;
+} Supervisor_Client;
+
+/*
+ *  Survives MCU resets (not hibernate): the .retained section is not
+ *  initialized by the C runtime, see CC3220SF_LAUNCHXL_TIRTOS.cmd.
+ */
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_SECTION(supervisorRecord, ".retained")
+#elif defined(__IAR_SYSTEMS_ICC__)
+#pragma location=".retained"
+__no_init
+#elif defined(__GNUC__)
+__attribute__ ((section (".retained")))
+#endif
+static Supervisor_CrashRecord supervisorRecord;
+
+static Supervisor_CrashRecord lastRecord;
+static bool                   lastRecordValid = false;
+
+static Supervisor_Client      clients[SUPERVISOR_MAX_CLIENTS];
+static volatile int           clientCount = 0;
+static Watchdog_Handle        watchdogHandle = NULL;
+
+/*
+ *  ======== validateRecord ========
+ *  Anything but our magic is power-up garbage.
+ */
+static void validateRecord(void)
+{
+    if (supervisorRecord.magic != SUPERVISOR_RECORD_MAGIC) {
+        memset(&supervisorRecord, 0, sizeof(supervisorRecord));
+        supervisorRecord.magic = SUPERVISOR_RECORD_MAGIC;
+    }
+}
+
+/*
+ *  ======== record ========
+ */
+static void record(Supervisor_Cause cause, const char *name,
+                   const char *reason, int32_t code, uint32_t sinceCheckinMs)
+{
+    validateRecord();
+    supervisorRecord.resetCount++;
+    supervisorRecord.cause = cause;
+    supervisorRecord.uptimeMs = NetSched_nowMs();
+    supervisorRecord.code = code;
+    supervisorRecord.sinceCheckinMs = sinceCheckinMs;
+    strncpy(supervisorRecord.name, name, sizeof(supervisorRecord.name) - 1);
+    supervisorRecord.name[sizeof(supervisorRecord.name) - 1] = '\0';
+    strncpy(supervisorRecord.reason, reason,
+            sizeof(supervisorRecord.reason) - 1);
+    supervisorRecord.reason[sizeof(supervisorRecord.reason) - 1] = '\0';
+}
+
+/*
+ *  ======== watchdogCallback ========
+ *  Runs from the watchdog interrupt once per period. Clearing the
+ *  watchdog here is the only thing that keeps the device running, so
+ *  it only happens while every client is on time. A stalled client is
+ *  recorded once and the second timeout resets the device.
+ */
+static void watchdogCallback(uintptr_t handle)
+{
+    uint32_t now = NetSched_nowMs();
+    uint32_t since;
+    int      i;
+
+    for (i = 0; i < clientCount; i++) {
+        since = now - clients[i].lastCheckinMs;
+        if (since > clients[i].deadlineMs) {
+            if (supervisorRecord.cause == Supervisor_Cause_NONE) {
+                record(Supervisor_Cause_STALL, clients[i].name,
+                        "missed deadline", clients[i].activity, since);
+                CrashDump_capture(CrashDump_Cause_STALL, clients[i].name,
+                        clients[i].activity);
+            }
+            return;
+        }
+    }
+
+    Watchdog_clear(watchdogHandle);
+}
+
+/*
+ *  ======== Supervisor_init ========
+ */
+void Supervisor_init(void)
+{
+    Watchdog_Params params;
+
+    validateRecord();
+    if (supervisorRecord.cause != Supervisor_Cause_NONE) {
+        lastRecord = supervisorRecord;
+        lastRecordValid = true;
+        supervisorRecord.cause = Supervisor_Cause_NONE;
+    }
+
+    Watchdog_init();
+    Watchdog_Params_init(&params);
+    params.callbackFxn = (Watchdog_Callback)watchdogCallback;
+    params.resetMode = Watchdog_RESET_ON;
+    params.debugStallMode = Watchdog_DEBUG_STALL_ON;
+
+    watchdogHandle = Watchdog_open(Board_WATCHDOG0, &params);
+    if (watchdogHandle == NULL) {
+        Supervisor_fatal("Watchdog_open failed", 0);
+    }
+}
+
+/*
+ *  ======== Supervisor_register ========
+ */
+Supervisor_Id Supervisor_register(const char *name, uint32_t deadlineMs)
+{
+    uintptr_t     key;
+    Supervisor_Id id = -1;
+
+    key = HwiP_disable();
+    if (clientCount < SUPERVISOR_MAX_CLIENTS) {
+        id = clientCount;
+        clients[id].name = name;
+        clients[id].deadlineMs = deadlineMs;
+        clients[id].lastCheckinMs = NetSched_nowMs();
+        clients[id].activity = 0;
+        clientCount++;
+    }
+    HwiP_restore(key);
+
+    return (id);
+}
+
+/*
+ *  ======== Supervisor_checkin ========
+ */
+void Supervisor_checkin(Supervisor_Id id, int32_t activity)
+{
+    if ((id >= 0) && (id < clientCount)) {
+        clients[id].activity = activity;
+        clients[id].lastCheckinMs = NetSched_nowMs();
+    }
+}
+
+/*
+ *  ======== Supervisor_fatal ========
+ */
+void Supervisor_fatal(const char *reason, int32_t code)
+{
+    HwiP_disable();
+    record(Supervisor_Cause_FATAL, "fatal", reason, code, 0);
+    CrashDump_capture(CrashDump_Cause_FATAL, reason, code);
+
+    MAP_PRCMMCUReset(true);
+
+    /* Not reached; the watchdog is the backstop if the reset fails */
+    while (1);
+}
+
+/*
+ *  ======== Supervisor_lastCrash ========
+ */
+bool Supervisor_lastCrash(Supervisor_CrashRecord *crashRecord)
+{
+    if (lastRecordValid) {
+        *crashRecord = lastRecord;
+    }
+
+    return (lastRecordValid);
+}
+
+/*
+ *  ======== cmdWatchdog ========
+ */
+static void cmdWatchdog(Console_Session *session, const Console_Args *args)
+{
+    char                   printString[CONSOLE_PRINT_SIZE];
+    Supervisor_CrashRecord crash;
+    uint32_t               now = NetSched_nowMs();
+    int                    i;
+
+    for (i = 0; i < clientCount; i++) {
+        snprintf(printString, sizeof(printString),
+                "%-12s deadline %lu ms, last check-in %lu ms ago, activity %ld",
+                clients[i].name, (unsigned long)clients[i].deadlineMs,
+                (unsigned long)(now - clients[i].lastCheckinMs),
+                (long)clients[i].activity);
+        Console_print(session, printString);
+    }
+
+    if (Supervisor_lastCrash(&crash)) {
+        snprintf(printString, sizeof(printString),
+                "Last reset #%lu: %s in %s, code %ld, after %lu ms uptime",
+                (unsigned long)crash.resetCount, crash.reason, crash.name,
+                (long)crash.code, (unsigned long)crash.uptimeMs);
+        Console_print(session, printString);
+    }
+}
+
+CONSOLE_COMMAND(watchdog, "wdt", cmdWatchdog, "", "",
+                "supervised threads and last reset");
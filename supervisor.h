@@ -0,0 +1,86 @@
+/*
+ *  ======== supervisor.h ========
+ *  Software watchdog supervisor.
+ *
+ *  Threads that loop register with a deadline and check in on every
+ *  pass. The hardware watchdog (Board_WATCHDOG0, 1 second period) is
+ *  only cleared when every registered thread has checked in within its
+ *  deadline; otherwise the stalled thread is recorded in a crash record
+ *  kept in retained RAM and the watchdog resets the device.
+ *
+ *  Fatal errors go through Supervisor_fatal(), which records the reason
+ *  and resets right away instead of spinning. Both paths also capture a
+ *  full crash dump, see crashdump.h.
+ */
+#ifndef __SUPERVISOR_H
+#define __SUPERVISOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SUPERVISOR_MAX_CLIENTS      (8)
+
+#define SUPERVISOR_RECORD_MAGIC     (0x57444F47)    /* "WDOG" */
+
+typedef int Supervisor_Id;
+
+/*!
+ *  @brief  Why the last reset happened, kept across MCU resets
+ */
+typedef enum Supervisor_Cause {
+    Supervisor_Cause_NONE = 0,
+    Supervisor_Cause_STALL,         /* a thread missed its deadline */
+    Supervisor_Cause_FATAL          /* Supervisor_fatal() */
+} Supervisor_Cause;
+
+typedef struct Supervisor_CrashRecord {
+    uint32_t    magic;
+    uint32_t    resetCount;         /* supervisor resets since power-up */
+    uint32_t    cause;              /* Supervisor_Cause */
+    uint32_t    uptimeMs;
+    int32_t     code;               /* error code or last activity */
+    uint32_t    sinceCheckinMs;     /* stall length at reset */
+    char        name[16];           /* stalled thread */
+    char        reason[48];
+} Supervisor_CrashRecord;
+
+/*!
+ *  @brief  Open the watchdog and start supervising
+ */
+extern void Supervisor_init(void);
+
+/*!
+ *  @brief  Register the calling thread
+ *
+ *  @return id for Supervisor_checkin(), or -1 if the table is full
+ */
+extern Supervisor_Id Supervisor_register(const char *name,
+                                         uint32_t deadlineMs);
+
+/*!
+ *  @brief  Report progress. activity is free form (e.g. a state number)
+ *          and ends up in the crash record if the thread stalls.
+ */
+extern void Supervisor_checkin(Supervisor_Id id, int32_t activity);
+
+/*!
+ *  @brief  Record the reason and reset. Does not return.
+ */
+extern void Supervisor_fatal(const char *reason, int32_t code);
+
+/*!
+ *  @brief  Crash record from before the last reset
+ *
+ *  @return true if the last reset was caused by the supervisor
+ */
+extern bool Supervisor_lastCrash(Supervisor_CrashRecord *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SUPERVISOR_H */
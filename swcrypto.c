@@ -0,0 +1,375 @@
+/*
+ *  ======== swcrypto.c ========
+ *  Portable AES-128 and HMAC-SHA256
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "swcrypto.h"
+
+static const uint8_t sbox[256] = {
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5,
+    0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0,
+    0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC,
+    0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A,
+    0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0,
+    0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B,
+    0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85,
+    0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5,
+    0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17,
+    0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88,
+    0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C,
+    0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9,
+    0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6,
+    0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E,
+    0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94,
+    0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68,
+    0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+static const uint32_t sha256K[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+    0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+    0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+    0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+    0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+    0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+#define ROTR(x, n)      (((x) >> (n)) | ((x) << (32 - (n))))
+
+/*
+ *  ======== load32 ========
+ */
+static uint32_t load32(const uint8_t *p)
+{
+    return (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+            ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+}
+
+/*
+ *  ======== store32 ========
+ */
+static void store32(uint8_t *p, uint32_t x)
+{
+    p[0] = (uint8_t)(x >> 24);
+    p[1] = (uint8_t)(x >> 16);
+    p[2] = (uint8_t)(x >> 8);
+    p[3] = (uint8_t)x;
+}
+
+/*
+ *  ======== xtime ========
+ *  Multiply by x in GF(2^8).
+ */
+static uint8_t xtime(uint8_t x)
+{
+    return ((uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1B : 0x00)));
+}
+
+/*
+ *  ======== subWord ========
+ */
+static uint32_t subWord(uint32_t x)
+{
+    return (((uint32_t)sbox[x >> 24] << 24) |
+            ((uint32_t)sbox[(x >> 16) & 0xFF] << 16) |
+            ((uint32_t)sbox[(x >> 8) & 0xFF] << 8) |
+            (uint32_t)sbox[x & 0xFF]);
+}
+
+/*
+ *  ======== SwCrypto_aesSetKey ========
+ */
+void SwCrypto_aesSetKey(SwCrypto_Aes *aes, const uint8_t *key)
+{
+    uint32_t *w = aes->roundKey;
+    uint32_t  rcon = 0x01;
+    uint32_t  t;
+    int       i;
+
+    for (i = 0; i < 4; i++) {
+        w[i] = load32(key + 4 * i);
+    }
+    for (i = 4; i < 44; i++) {
+        t = w[i - 1];
+        if ((i % 4) == 0) {
+            t = subWord((t << 8) | (t >> 24)) ^ (rcon << 24);
+            rcon = xtime((uint8_t)rcon);
+        }
+        w[i] = w[i - 4] ^ t;
+    }
+}
+
+/*
+ *  ======== addRoundKey ========
+ */
+static void addRoundKey(uint8_t *s, const uint32_t *rk)
+{
+    int c;
+
+    for (c = 0; c < 4; c++) {
+        s[4 * c] ^= (uint8_t)(rk[c] >> 24);
+        s[4 * c + 1] ^= (uint8_t)(rk[c] >> 16);
+        s[4 * c + 2] ^= (uint8_t)(rk[c] >> 8);
+        s[4 * c + 3] ^= (uint8_t)rk[c];
+    }
+}
+
+/*
+ *  ======== SwCrypto_aesEncrypt ========
+ *  The state is column major, s[row + 4 * column], as in FIPS-197.
+ */
+void SwCrypto_aesEncrypt(const SwCrypto_Aes *aes, const uint8_t *in,
+        uint8_t *out)
+{
+    uint8_t s[16];
+    uint8_t t[16];
+    uint8_t all;
+    int     round;
+    int     c;
+
+    memcpy(s, in, sizeof(s));
+    addRoundKey(s, aes->roundKey);
+
+    for (round = 1; round <= 10; round++) {
+        /* SubBytes and ShiftRows: row r moves left by r columns */
+        t[0] = sbox[s[0]];   t[4] = sbox[s[4]];
+        t[8] = sbox[s[8]];   t[12] = sbox[s[12]];
+        t[1] = sbox[s[5]];   t[5] = sbox[s[9]];
+        t[9] = sbox[s[13]];  t[13] = sbox[s[1]];
+        t[2] = sbox[s[10]];  t[6] = sbox[s[14]];
+        t[10] = sbox[s[2]];  t[14] = sbox[s[6]];
+        t[3] = sbox[s[15]];  t[7] = sbox[s[3]];
+        t[11] = sbox[s[7]];  t[15] = sbox[s[11]];
+
+        if (round == 10) {
+            /* No MixColumns in the last round */
+            memcpy(s, t, sizeof(s));
+        }
+        else {
+            for (c = 0; c < 16; c += 4) {
+                all = t[c] ^ t[c + 1] ^ t[c + 2] ^ t[c + 3];
+                s[c] = t[c] ^ all ^ xtime(t[c] ^ t[c + 1]);
+                s[c + 1] = t[c + 1] ^ all ^ xtime(t[c + 1] ^ t[c + 2]);
+                s[c + 2] = t[c + 2] ^ all ^ xtime(t[c + 2] ^ t[c + 3]);
+                s[c + 3] = t[c + 3] ^ all ^ xtime(t[c + 3] ^ t[c]);
+            }
+        }
+        addRoundKey(s, aes->roundKey + 4 * round);
+    }
+
+    memcpy(out, s, sizeof(s));
+}
+
+/*
+ *  ======== SwCrypto_cbcEncrypt ========
+ */
+void SwCrypto_cbcEncrypt(const SwCrypto_Aes *aes, uint8_t *iv,
+        const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t i;
+
+    while (len >= SWCRYPTO_AES_BLOCK_SIZE) {
+        for (i = 0; i < SWCRYPTO_AES_BLOCK_SIZE; i++) {
+            iv[i] ^= in[i];
+        }
+        SwCrypto_aesEncrypt(aes, iv, iv);
+        memcpy(out, iv, SWCRYPTO_AES_BLOCK_SIZE);
+        in += SWCRYPTO_AES_BLOCK_SIZE;
+        out += SWCRYPTO_AES_BLOCK_SIZE;
+        len -= SWCRYPTO_AES_BLOCK_SIZE;
+    }
+}
+
+/*
+ *  ======== sha256Block ========
+ */
+static void sha256Block(uint32_t *state, const uint8_t *block)
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t t1;
+    uint32_t t2;
+    int      i;
+
+    for (i = 0; i < 16; i++) {
+        w[i] = load32(block + 4 * i);
+    }
+    for (i = 16; i < 64; i++) {
+        w[i] = w[i - 16] + w[i - 7] +
+                (ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^
+                 (w[i - 15] >> 3)) +
+                (ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    }
+
+    a = state[0]; b = state[1]; c = state[2]; d = state[3];
+    e = state[4]; f = state[5]; g = state[6]; h = state[7];
+
+    for (i = 0; i < 64; i++) {
+        t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) +
+                ((e & f) ^ (~e & g)) + sha256K[i] + w[i];
+        t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) +
+                ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+/*
+ *  ======== SwCrypto_sha256Init ========
+ */
+void SwCrypto_sha256Init(SwCrypto_Sha256 *sha)
+{
+    sha->state[0] = 0x6A09E667;
+    sha->state[1] = 0xBB67AE85;
+    sha->state[2] = 0x3C6EF372;
+    sha->state[3] = 0xA54FF53A;
+    sha->state[4] = 0x510E527F;
+    sha->state[5] = 0x9B05688C;
+    sha->state[6] = 0x1F83D9AB;
+    sha->state[7] = 0x5BE0CD19;
+    sha->length = 0;
+}
+
+/*
+ *  ======== SwCrypto_sha256Update ========
+ *  Whole blocks are hashed straight from data.
+ */
+void SwCrypto_sha256Update(SwCrypto_Sha256 *sha, const void *data,
+        size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    size_t         used = (size_t)(sha->length % SWCRYPTO_SHA256_BLOCK_SIZE);
+    size_t         n;
+
+    sha->length += len;
+
+    if (used != 0) {
+        n = SWCRYPTO_SHA256_BLOCK_SIZE - used;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(sha->block + used, p, n);
+        p += n;
+        len -= n;
+        if (used + n < SWCRYPTO_SHA256_BLOCK_SIZE) {
+            return;
+        }
+        sha256Block(sha->state, sha->block);
+    }
+    while (len >= SWCRYPTO_SHA256_BLOCK_SIZE) {
+        sha256Block(sha->state, p);
+        p += SWCRYPTO_SHA256_BLOCK_SIZE;
+        len -= SWCRYPTO_SHA256_BLOCK_SIZE;
+    }
+    memcpy(sha->block, p, len);
+}
+
+/*
+ *  ======== SwCrypto_sha256Final ========
+ */
+void SwCrypto_sha256Final(SwCrypto_Sha256 *sha, uint8_t *digest)
+{
+    uint64_t bits = sha->length * 8;
+    size_t   used = (size_t)(sha->length % SWCRYPTO_SHA256_BLOCK_SIZE);
+    int      i;
+
+    sha->block[used++] = 0x80;
+    if (used > SWCRYPTO_SHA256_BLOCK_SIZE - 8) {
+        memset(sha->block + used, 0, SWCRYPTO_SHA256_BLOCK_SIZE - used);
+        sha256Block(sha->state, sha->block);
+        used = 0;
+    }
+    memset(sha->block + used, 0, SWCRYPTO_SHA256_BLOCK_SIZE - 8 - used);
+    store32(sha->block + SWCRYPTO_SHA256_BLOCK_SIZE - 8,
+            (uint32_t)(bits >> 32));
+    store32(sha->block + SWCRYPTO_SHA256_BLOCK_SIZE - 4, (uint32_t)bits);
+    sha256Block(sha->state, sha->block);
+
+    for (i = 0; i < 8; i++) {
+        store32(digest + 4 * i, sha->state[i]);
+    }
+}
+
+/*
+ *  ======== SwCrypto_hmacInit ========
+ */
+void SwCrypto_hmacInit(SwCrypto_Hmac *hmac, const uint8_t *key, size_t len)
+{
+    uint8_t pad[SWCRYPTO_SHA256_BLOCK_SIZE];
+    size_t  i;
+
+    memset(pad, 0, sizeof(pad));
+    if (len > SWCRYPTO_SHA256_BLOCK_SIZE) {
+        SwCrypto_sha256Init(&hmac->inner);
+        SwCrypto_sha256Update(&hmac->inner, key, len);
+        SwCrypto_sha256Final(&hmac->inner, pad);
+    }
+    else {
+        memcpy(pad, key, len);
+    }
+
+    for (i = 0; i < sizeof(pad); i++) {
+        pad[i] ^= 0x36;
+    }
+    SwCrypto_sha256Init(&hmac->inner);
+    SwCrypto_sha256Update(&hmac->inner, pad, sizeof(pad));
+
+    for (i = 0; i < sizeof(pad); i++) {
+        pad[i] ^= 0x36 ^ 0x5C;
+    }
+    SwCrypto_sha256Init(&hmac->outer);
+    SwCrypto_sha256Update(&hmac->outer, pad, sizeof(pad));
+
+    memset(pad, 0, sizeof(pad));
+}
+
+/*
+ *  ======== SwCrypto_hmacUpdate ========
+ */
+void SwCrypto_hmacUpdate(SwCrypto_Hmac *hmac, const void *data, size_t len)
+{
+    SwCrypto_sha256Update(&hmac->inner, data, len);
+}
+
+/*
+ *  ======== SwCrypto_hmacFinal ========
+ */
+void SwCrypto_hmacFinal(SwCrypto_Hmac *hmac, uint8_t *tag)
+{
+    uint8_t digest[SWCRYPTO_SHA256_SIZE];
+
+    SwCrypto_sha256Final(&hmac->inner, digest);
+    SwCrypto_sha256Update(&hmac->outer, digest, sizeof(digest));
+    SwCrypto_sha256Final(&hmac->outer, tag);
+}
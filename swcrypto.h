@@ -0,0 +1,83 @@
+/*
+ *  ======== swcrypto.h ========
+ *  AES-128 encryption and HMAC-SHA256 in portable C.
+ *
+ *  The software counterpart of the CryptoCC32XX engine for payloadsec.c
+ *  (see PAYLOADSEC_SOFTWARE), and what the host tools seal with. Only
+ *  the directions payloadsec needs are here: AES encrypt, CBC encrypt,
+ *  SHA-256 and HMAC-SHA256.
+ *
+ *  The AES is byte oriented with a 256 byte S-box and no larger tables,
+ *  so it fits the flash budget but is not constant time against cache
+ *  timing; the CC3220 has no data cache, so that does not apply on the
+ *  device.
+ */
+#ifndef __SWCRYPTO_H
+#define __SWCRYPTO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SWCRYPTO_AES_KEY_SIZE       (16)
+#define SWCRYPTO_AES_BLOCK_SIZE     (16)
+#define SWCRYPTO_SHA256_SIZE        (32)
+#define SWCRYPTO_SHA256_BLOCK_SIZE  (64)
+
+/*!
+ *  @brief  Expanded AES-128 key
+ */
+typedef struct SwCrypto_Aes {
+    uint32_t    roundKey[44];
+} SwCrypto_Aes;
+
+typedef struct SwCrypto_Sha256 {
+    uint32_t    state[8];
+    uint64_t    length;             /* bytes hashed so far */
+    uint8_t     block[SWCRYPTO_SHA256_BLOCK_SIZE];
+} SwCrypto_Sha256;
+
+typedef struct SwCrypto_Hmac {
+    SwCrypto_Sha256 inner;
+    SwCrypto_Sha256 outer;          /* already holds the outer key pad */
+} SwCrypto_Hmac;
+
+extern void SwCrypto_aesSetKey(SwCrypto_Aes *aes, const uint8_t *key);
+
+/*!
+ *  @brief  Encrypt one block; in and out may be the same
+ */
+extern void SwCrypto_aesEncrypt(const SwCrypto_Aes *aes, const uint8_t *in,
+        uint8_t *out);
+
+/*!
+ *  @brief  CBC encrypt len bytes, a multiple of the block size. iv is
+ *          updated to the last ciphertext block, so the next call
+ *          carries on the chain.
+ */
+extern void SwCrypto_cbcEncrypt(const SwCrypto_Aes *aes, uint8_t *iv,
+        const uint8_t *in, size_t len, uint8_t *out);
+
+extern void SwCrypto_sha256Init(SwCrypto_Sha256 *sha);
+extern void SwCrypto_sha256Update(SwCrypto_Sha256 *sha, const void *data,
+        size_t len);
+extern void SwCrypto_sha256Final(SwCrypto_Sha256 *sha, uint8_t *digest);
+
+/*!
+ *  @brief  Start a MAC; keys longer than a SHA-256 block are hashed
+ *          first, as RFC 2104 has it
+ */
+extern void SwCrypto_hmacInit(SwCrypto_Hmac *hmac, const uint8_t *key,
+        size_t len);
+extern void SwCrypto_hmacUpdate(SwCrypto_Hmac *hmac, const void *data,
+        size_t len);
+extern void SwCrypto_hmacFinal(SwCrypto_Hmac *hmac, uint8_t *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SWCRYPTO_H */
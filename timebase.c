@@ -0,0 +1,363 @@
+/*
+ *  ======== timebase.c ========
+ *  Monotonic timebase and SNTP disciplined wall clock
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/inc/hw_memmap.h>
+#include <ti/devices/cc32xx/inc/hw_timer.h>
+#include <ti/devices/cc32xx/driverlib/rom.h>
+#include <ti/devices/cc32xx/driverlib/rom_map.h>
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+
+#include <ti/drivers/Timer.h>
+#include <ti/drivers/dpl/ClockP.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/net/sntp/sntp.h>
+
+#include "Board.h"
+#include "console.h"
+#include "hibernate.h"
+#include "timebase.h"
+
+/* Seconds from the NTP epoch (1900) to the Unix epoch (1970) */
+#define TIMEBASE_NTP_TO_UNIX_S      (2208988800ULL)
+
+/* Shortest sync interval that is used to trim the rate */
+#define TIMEBASE_MIN_TRIM_US        (10LL * 60 * 1000000)
+
+static Timer_Handle     timer = NULL;
+static volatile uint32_t wraps = 0;
+static uint64_t         bootTicks;          /* TIMER0 count at the anchor */
+static uint64_t         bootMonoUs;         /* RTC time at the anchor */
+static Hibernate_Clock  discipline;         /* baseUtcUs 0: not synced */
+static uint64_t         lastAttemptUs;
+static bool             attempted = false;
+static Timebase_Stats   stats;
+
+/*
+ *  ======== wrapFxn ========
+ */
+static void wrapFxn(Timer_Handle handle)
+{
+    wraps++;
+}
+
+/*
+ *  ======== ticks64 ========
+ *  A wrap whose interrupt is still pending is counted here, so this is
+ *  right even with interrupts disabled.
+ */
+static uint64_t ticks64(void)
+{
+    uintptr_t key;
+    uint32_t  hi;
+    uint32_t  lo;
+
+    key = HwiP_disable();
+    hi = wraps;
+    lo = Timebase_ticks();
+    if ((HWREG(TIMERA0_BASE + TIMER_O_RIS) & TIMER_RIS_TATORIS) &&
+            (lo < 0x80000000)) {
+        hi++;
+    }
+    HwiP_restore(key);
+
+    return (((uint64_t)hi << 32) | lo);
+}
+
+/*
+ *  ======== utcAt ========
+ *  UTC at monotonic time mono under discipline c.
+ */
+static int64_t utcAt(const Hibernate_Clock *c, uint64_t mono)
+{
+    int64_t d = (int64_t)(mono - c->baseMonoUs);
+    int64_t slew = d * TIMEBASE_SLEW_PPM / 1000000;
+
+    if (c->slewUs >= 0) {
+        if (slew > c->slewUs) {
+            slew = c->slewUs;
+        }
+    }
+    else {
+        slew = -slew;
+        if (slew < c->slewUs) {
+            slew = c->slewUs;
+        }
+    }
+
+    return (c->baseUtcUs + d + d * c->freqPpb / 1000000000 + slew);
+}
+
+/*
+ *  ======== Timebase_init ========
+ */
+int Timebase_init(void)
+{
+    Timer_Params params;
+    uint64_t     rtc;
+    uintptr_t    key;
+
+    Timer_Params_init(&params);
+    params.periodUnits = Timer_PERIOD_COUNTS;
+    params.period = 0xFFFFFFFF;
+    params.timerMode = Timer_CONTINUOUS_CALLBACK;
+    params.timerCallback = wrapFxn;
+
+    timer = Timer_open(Board_TIMER0, &params);
+    if (timer == NULL) {
+        return (-1);
+    }
+    if (Timer_start(timer) != Timer_STATUS_SUCCESS) {
+        Timer_close(timer);
+        timer = NULL;
+        return (-1);
+    }
+
+    key = HwiP_disable();
+    rtc = MAP_PRCMSlowClkCtrGet();
+    bootTicks = ticks64();
+    HwiP_restore(key);
+
+    /* 1e6 / 32768 = 15625 / 512 */
+    bootMonoUs = rtc * 15625 / 512;
+
+    return (0);
+}
+
+/*
+ *  ======== Timebase_restore ========
+ */
+void Timebase_restore(void)
+{
+    Hibernate_Clock saved;
+
+    if (Hibernate_lastClock(&saved)) {
+        discipline = saved;
+        stats.freqPpb = saved.freqPpb;
+    }
+}
+
+/*
+ *  ======== Timebase_monoUs ========
+ */
+uint64_t Timebase_monoUs(void)
+{
+    if (timer == NULL) {
+        return ((uint64_t)ClockP_getSystemTicks() *
+                ClockP_getSystemTickPeriod());
+    }
+
+    return (bootMonoUs + (ticks64() - bootTicks) / TIMEBASE_TICKS_PER_US);
+}
+
+/*
+ *  ======== Timebase_monoMs ========
+ */
+uint32_t Timebase_monoMs(void)
+{
+    return ((uint32_t)(Timebase_monoUs() / 1000));
+}
+
+/*
+ *  ======== Timebase_utcUs ========
+ */
+bool Timebase_utcUs(int64_t *utcUs)
+{
+    Hibernate_Clock c;
+    uintptr_t       key;
+
+    key = HwiP_disable();
+    c = discipline;
+    HwiP_restore(key);
+
+    if (c.baseUtcUs == 0) {
+        return (false);
+    }
+    *utcUs = utcAt(&c, Timebase_monoUs());
+
+    return (true);
+}
+
+/*
+ *  ======== Timebase_syncDue ========
+ */
+bool Timebase_syncDue(void)
+{
+    uint64_t interval = (discipline.baseUtcUs != 0) ?
+            (uint64_t)TIMEBASE_SYNC_MS * 1000 :
+            (uint64_t)TIMEBASE_RESYNC_MS * 1000;
+
+    return (!attempted || ((Timebase_monoUs() - lastAttemptUs) >= interval));
+}
+
+/*
+ *  ======== Timebase_sync ========
+ */
+int32_t Timebase_sync(void)
+{
+    static const char *servers[] = {TIMEBASE_SNTP_SERVER};
+    struct timeval     timeout;
+    Hibernate_Clock    c;
+    uint64_t           ntp;
+    uint64_t           before;
+    uint64_t           after;
+    uint64_t           mono;
+    int64_t            server;
+    int64_t            local;
+    int64_t            error;
+    int64_t            interval;
+    int64_t            trim;
+    int32_t            ret;
+    uintptr_t          key;
+
+    timeout.tv_sec = TIMEBASE_SNTP_TIMEOUT_S;
+    timeout.tv_usec = 0;
+
+    before = Timebase_monoUs();
+    ret = SNTP_getTime(servers, 1, &timeout, &ntp);
+    after = Timebase_monoUs();
+    attempted = true;
+    lastAttemptUs = after;
+    if (ret < 0) {
+        stats.failures++;
+        return (ret);
+    }
+
+    /* The server's time is taken to be that of the round trip midpoint */
+    mono = before + (after - before) / 2;
+    server = (int64_t)((ntp >> 32) - TIMEBASE_NTP_TO_UNIX_S) * 1000000 +
+            (int64_t)(((ntp & 0xFFFFFFFF) * 1000000) >> 32);
+
+    c = discipline;
+    if (c.baseUtcUs == 0) {
+        error = TIMEBASE_STEP_US + 1;
+    }
+    else {
+        local = utcAt(&c, mono);
+        error = server - local;
+    }
+
+    if ((error > TIMEBASE_STEP_US) || (error < -TIMEBASE_STEP_US)) {
+        /* First sync, or too far off to slew in reasonable time */
+        c.baseUtcUs = server;
+        c.slewUs = 0;
+        stats.steps++;
+    }
+    else {
+        /*
+         *  Once the last offset has been slewed in, what is left is the
+         *  rate error over the interval; take half of it.
+         */
+        interval = (int64_t)(mono - c.baseMonoUs);
+        if ((interval >= TIMEBASE_MIN_TRIM_US) &&
+                (interval * TIMEBASE_SLEW_PPM / 1000000 >=
+                 ((c.slewUs < 0) ? -c.slewUs : c.slewUs))) {
+            trim = c.freqPpb + error * 1000000000 / interval / 2;
+            if (trim > TIMEBASE_MAX_FREQ_PPB) {
+                trim = TIMEBASE_MAX_FREQ_PPB;
+            }
+            else if (trim < -TIMEBASE_MAX_FREQ_PPB) {
+                trim = -TIMEBASE_MAX_FREQ_PPB;
+            }
+            c.freqPpb = (int32_t)trim;
+        }
+        c.baseUtcUs = local;
+        c.slewUs = (int32_t)error;
+    }
+    c.baseMonoUs = mono;
+
+    key = HwiP_disable();
+    discipline = c;
+    stats.syncs++;
+    stats.lastErrorUs = (error > INT32_MAX) ? INT32_MAX :
+            ((error < INT32_MIN) ? INT32_MIN : (int32_t)error);
+    stats.freqPpb = c.freqPpb;
+    stats.lastRttUs = (uint32_t)(after - before);
+    HwiP_restore(key);
+
+    Hibernate_noteClock(&c);
+
+    return (0);
+}
+
+/*
+ *  ======== Timebase_getStats ========
+ */
+void Timebase_getStats(Timebase_Stats *out)
+{
+    uintptr_t key;
+    int64_t   slew;
+    int64_t   applied;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+
+    /* What is left of the slew */
+    if (discipline.baseUtcUs != 0) {
+        applied = (int64_t)(Timebase_monoUs() - discipline.baseMonoUs) *
+                TIMEBASE_SLEW_PPM / 1000000;
+        slew = discipline.slewUs;
+        if (slew >= 0) {
+            slew = (applied >= slew) ? 0 : slew - applied;
+        }
+        else {
+            slew = (applied >= -slew) ? 0 : slew + applied;
+        }
+        out->slewUs = (int32_t)slew;
+    }
+}
+
+/*
+ *  ======== cmdTime ========
+ */
+static void cmdTime(Console_Session *session, const Console_Args *args)
+{
+    char           printString[CONSOLE_PRINT_SIZE];
+    Timebase_Stats s;
+    int64_t        utc;
+    uint64_t       mono = Timebase_monoUs();
+
+    if (args->argc > 0) {
+        if (strcmp(args->str[0], "sync") != 0) {
+            Console_print(session, "Unknown option");
+            return;
+        }
+        /* Blocks the console for up to TIMEBASE_SNTP_TIMEOUT_S */
+        if (Timebase_sync() < 0) {
+            Console_print(session, "SNTP request failed");
+            return;
+        }
+    }
+
+    if (Timebase_utcUs(&utc)) {
+        snprintf(printString, sizeof(printString), "UTC %lld.%06ld",
+                (long long)(utc / 1000000), (long)(utc % 1000000));
+    }
+    else {
+        snprintf(printString, sizeof(printString), "not synchronized");
+    }
+    Console_print(session, printString);
+
+    Timebase_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "up %llu.%06lu s, %lu syncs (%lu steps, %lu failed), "
+            "last error %ld us, rtt %lu us, rate %ld ppb, slewing %ld us",
+            (unsigned long long)(mono / 1000000),
+            (unsigned long)(mono % 1000000), (unsigned long)s.syncs,
+            (unsigned long)s.steps, (unsigned long)s.failures,
+            (long)s.lastErrorUs, (unsigned long)s.lastRttUs,
+            (long)s.freqPpb, (long)s.slewUs);
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(time, "time", cmdTime, "s", "[sync]",
+                "wall clock and time sync state, or sync now");
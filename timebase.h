@@ -0,0 +1,131 @@
+/*
+ *  ======== timebase.h ========
+ *  Monotonic timestamps and an SNTP disciplined wall clock.
+ *
+ *  Monotonic time is the RTC slow clock (32768 Hz), which keeps counting
+ *  through hibernate, read once at boot, plus TIMER0 running free at the
+ *  80 MHz system clock since then. It starts at power-up and never goes
+ *  back, including across hibernate. On the measurement path
+ *  Timebase_ticks() reads the timer register directly: one load, usable
+ *  from any context. Timebase_monoUs() extends it to 64 bits and is
+ *  also safe from a Hwi.
+ *
+ *  UTC is derived from monotonic time. Timebase_sync() asks an SNTP
+ *  server for the time. A small error is slewed in at
+ *  TIMEBASE_SLEW_PPM, so time never steps back; only the first sync or
+ *  an error beyond TIMEBASE_STEP_US steps the clock. Each sync also
+ *  trims a rate correction from the error over the interval, so the
+ *  clock holds between syncs. The discipline is kept in Hibernate_State
+ *  and survives hibernate.
+ *
+ *  TIMER0 is Board_TIMER0 (TIMERA0_BASE, 32-bit). While it runs the
+ *  Timer driver holds off LPDS; the power policy is disabled in this
+ *  application anyway.
+ */
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ti/devices/cc32xx/inc/hw_types.h>
+#include <ti/devices/cc32xx/inc/hw_memmap.h>
+#include <ti/devices/cc32xx/inc/hw_timer.h>
+
+#define TIMEBASE_TICKS_PER_US       (80)
+#define TIMEBASE_RTC_HZ             (32768)
+
+#define TIMEBASE_SNTP_SERVER        "pool.ntp.org"
+#define TIMEBASE_SNTP_TIMEOUT_S     (5)
+
+/* Sync interval once synchronized, and while not yet */
+#define TIMEBASE_SYNC_MS            (6 * 60 * 60 * 1000)
+#define TIMEBASE_RESYNC_MS          (5 * 60 * 1000)
+
+/* Errors up to this are slewed in, larger ones step the clock */
+#define TIMEBASE_STEP_US            (1000000)
+#define TIMEBASE_SLEW_PPM           (500)
+
+/* Bound on the rate correction; the crystals are good to 20 ppm */
+#define TIMEBASE_MAX_FREQ_PPB       (100000)
+
+typedef struct Timebase_Stats {
+    uint32_t    syncs;
+    uint32_t    steps;
+    uint32_t    failures;
+    int32_t     lastErrorUs;        /* server minus local at last sync */
+    int32_t     freqPpb;
+    int32_t     slewUs;             /* still to be slewed in */
+    uint32_t    lastRttUs;          /* SNTP round trip */
+} Timebase_Stats;
+
+/*!
+ *  @brief  Free running 80 MHz count; wraps every 53 s. Only valid
+ *          after Timebase_init() succeeded. Differences of two values
+ *          give elapsed time.
+ */
+static inline uint32_t Timebase_ticks(void)
+{
+    /* The timer counts down from 0xFFFFFFFF */
+    return (~HWREG(TIMERA0_BASE + TIMER_O_TAR));
+}
+
+/*!
+ *  @brief  Start TIMER0 and anchor it to the RTC. Call after
+ *          Timer_init().
+ *
+ *  @return 0 on success
+ */
+extern int Timebase_init(void);
+
+/*!
+ *  @brief  Take the clock discipline from before hibernate. Call after
+ *          Hibernate_restore().
+ */
+extern void Timebase_restore(void);
+
+/*!
+ *  @brief  Microseconds since power-up. Callable from any context.
+ */
+extern uint64_t Timebase_monoUs(void);
+
+/*!
+ *  @brief  Timebase_monoUs() in milliseconds, wrapping every 49 days.
+ *          The time stamp of measurements (totalizer, I2C readings,
+ *          acoustic features, rollups, alarms), so readings from all
+ *          modules and from before a hibernate share one clock.
+ */
+extern uint32_t Timebase_monoMs(void);
+
+/*!
+ *  @brief  UTC in microseconds since 1970
+ *
+ *  @return false if the clock was never synchronized; *utcUs is then
+ *          left alone
+ */
+extern bool Timebase_utcUs(int64_t *utcUs);
+
+/*!
+ *  @brief  True when Timebase_sync() should run
+ */
+extern bool Timebase_syncDue(void);
+
+/*!
+ *  @brief  Synchronize with the SNTP server. Blocks for up to
+ *          TIMEBASE_SNTP_TIMEOUT_S; call from a thread that may.
+ *
+ *  @return 0 on success, negative SNTP error otherwise
+ */
+extern int32_t Timebase_sync(void);
+
+extern void Timebase_getStats(Timebase_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMEBASE_H */
@@ -0,0 +1,41 @@
+/*
+ *  ======== check.h ========
+ *  Assertions for the host tests. A failed CHECK() reports and carries
+ *  on, so one run lists every failure; CHECK_DONE() gives the exit
+ *  status.
+ */
+#ifndef __CHECK_H
+#define __CHECK_H
+
+#include <stdio.h>
+
+static unsigned int checkCount = 0;
+static unsigned int checkFailures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        checkCount++;                                                       \
+        if (!(cond)) {                                                      \
+            checkFailures++;                                                \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,          \
+                    __LINE__, #cond);                                       \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                      \
+    do {                                                                    \
+        long long checkA = (long long)(a);                                  \
+        long long checkB = (long long)(b);                                  \
+        checkCount++;                                                       \
+        if (checkA != checkB) {                                             \
+            checkFailures++;                                                \
+            fprintf(stderr, "%s:%d: %s == %s failed: %lld != %lld\n",       \
+                    __FILE__, __LINE__, #a, #b, checkA, checkB);            \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_DONE(name)                                                    \
+    (printf("%s: %u checks, %u failed\n", (name), checkCount,               \
+            checkFailures), (checkFailures == 0) ? 0 : 1)
+
+#endif /* __CHECK_H */
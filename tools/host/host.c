@@ -0,0 +1,311 @@
+/*
+ *  ======== host.c ========
+ *  SDK and firmware calls for the host builds, see host.h
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "console.h"
+#include "host.h"
+#include "netsched.h"
+#include "timebase.h"
+
+typedef struct HostFile {
+    char        name[64];
+    uint32_t    len;
+    bool        used;
+    uint8_t     data[HOST_FILE_SIZE];
+} HostFile;
+
+static HostFile     files[HOST_FILES];
+static unsigned int fsFailures = 0;
+static uint32_t     random32 = 0x2545F491;
+static bool         simulated = false;
+static uint64_t     simUs = 0;
+
+/*
+ *  ======== findFile ========
+ */
+static HostFile *findFile(const char *name)
+{
+    int i;
+
+    for (i = 0; i < HOST_FILES; i++) {
+        if (files[i].used && (strcmp(files[i].name, name) == 0)) {
+            return (&files[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== newFile ========
+ */
+static HostFile *newFile(const char *name)
+{
+    int i;
+
+    if (strlen(name) >= sizeof(files[0].name)) {
+        return (NULL);
+    }
+    for (i = 0; i < HOST_FILES; i++) {
+        if (!files[i].used) {
+            memset(&files[i], 0, sizeof(files[i]));
+            strcpy(files[i].name, name);
+            files[i].used = true;
+            return (&files[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== takeFailure ========
+ */
+static bool takeFailure(void)
+{
+    if (fsFailures == 0) {
+        return (false);
+    }
+    fsFailures--;
+
+    return (true);
+}
+
+/*
+ *  ======== Host_setFile ========
+ */
+bool Host_setFile(const char *name, const void *data, size_t len)
+{
+    HostFile *file = findFile(name);
+
+    if (file == NULL) {
+        file = newFile(name);
+    }
+    if ((file == NULL) || (len > HOST_FILE_SIZE)) {
+        return (false);
+    }
+    memcpy(file->data, data, len);
+    file->len = (uint32_t)len;
+
+    return (true);
+}
+
+/*
+ *  ======== Host_clearFiles ========
+ */
+void Host_clearFiles(void)
+{
+    memset(files, 0, sizeof(files));
+    fsFailures = 0;
+}
+
+/*
+ *  ======== Host_failFs ========
+ */
+void Host_failFs(unsigned int count)
+{
+    fsFailures = count;
+}
+
+/*
+ *  ======== Host_seedRandom ========
+ */
+void Host_seedRandom(uint32_t seed)
+{
+    random32 = (seed != 0) ? seed : 0x2545F491;
+}
+
+/*
+ *  ======== Host_setClockUs ========
+ */
+void Host_setClockUs(uint64_t us)
+{
+    simulated = true;
+    simUs = us;
+}
+
+/*
+ *  ======== Host_advanceUs ========
+ */
+void Host_advanceUs(uint64_t us)
+{
+    simUs += us;
+}
+
+/*
+ *  ======== sl_FsOpen ========
+ *  The handle is the slot index.
+ */
+_i32 sl_FsOpen(const _u8 *name, const _u32 mode, _u32 *token)
+{
+    HostFile *file;
+
+    (void)token;
+    if (takeFailure()) {
+        return (SL_ERROR_FS_NO_FREE_SPACE);
+    }
+    file = findFile((const char *)name);
+    if (mode & SL_FS_CREATE) {
+        if (file == NULL) {
+            file = newFile((const char *)name);
+        }
+        if (file == NULL) {
+            return (SL_ERROR_FS_NO_FREE_SPACE);
+        }
+        if (mode & SL_FS_OVERWRITE) {
+            file->len = 0;
+        }
+    }
+    if (file == NULL) {
+        return (SL_ERROR_FS_FILE_NOT_EXISTS);
+    }
+
+    return ((_i32)(file - files));
+}
+
+/*
+ *  ======== sl_FsRead ========
+ */
+_i32 sl_FsRead(const _i32 fd, _u32 offset, _u8 *data, _u32 len)
+{
+    HostFile *file = &files[fd];
+
+    if (offset >= file->len) {
+        return (0);
+    }
+    if (len > file->len - offset) {
+        len = file->len - offset;
+    }
+    memcpy(data, file->data + offset, len);
+
+    return ((_i32)len);
+}
+
+/*
+ *  ======== sl_FsWrite ========
+ */
+_i32 sl_FsWrite(const _i32 fd, _u32 offset, _u8 *data, _u32 len)
+{
+    HostFile *file = &files[fd];
+
+    if (takeFailure() || (offset + len > HOST_FILE_SIZE)) {
+        return (SL_ERROR_FS_NO_FREE_SPACE);
+    }
+    memcpy(file->data + offset, data, len);
+    if (offset + len > file->len) {
+        file->len = offset + len;
+    }
+
+    return ((_i32)len);
+}
+
+/*
+ *  ======== sl_FsClose ========
+ */
+_i16 sl_FsClose(const _i32 fd, const _u8 *cert, const _u8 *signature,
+        const _u32 signatureLen)
+{
+    (void)fd;
+    (void)cert;
+    (void)signature;
+    (void)signatureLen;
+
+    return (0);
+}
+
+/*
+ *  ======== sl_FsDel ========
+ */
+_i32 sl_FsDel(const _u8 *name, const _u32 token)
+{
+    HostFile *file = findFile((const char *)name);
+
+    (void)token;
+    if (file == NULL) {
+        return (SL_ERROR_FS_FILE_NOT_EXISTS);
+    }
+    file->used = false;
+
+    return (0);
+}
+
+/*
+ *  ======== sl_NetUtilCmd ========
+ *  Only SL_NETUTIL_TRUE_RANDOM.
+ */
+_i16 sl_NetUtilCmd(const _u16 cmd, const _u8 *attrib, const _u16 attribLen,
+        _u8 *out, _u16 *outLen)
+{
+    _u16 i;
+
+    (void)attrib;
+    (void)attribLen;
+    if (cmd != SL_NETUTIL_TRUE_RANDOM) {
+        return (-1);
+    }
+    for (i = 0; i < *outLen; i++) {
+        random32 ^= random32 << 13;
+        random32 ^= random32 >> 17;
+        random32 ^= random32 << 5;
+        out[i] = (_u8)random32;
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== Timebase_monoUs ========
+ */
+uint64_t Timebase_monoUs(void)
+{
+    struct timespec ts;
+
+    if (simulated) {
+        return (simUs);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000);
+}
+
+/*
+ *  ======== Timebase_monoMs ========
+ */
+uint32_t Timebase_monoMs(void)
+{
+    return ((uint32_t)(Timebase_monoUs() / 1000));
+}
+
+/*
+ *  ======== NetSched_nowMs ========
+ */
+uint32_t NetSched_nowMs(void)
+{
+    return ((uint32_t)(Timebase_monoUs() / 1000));
+}
+
+/*
+ *  ======== sl_WlanDisconnect ========
+ */
+_i16 sl_WlanDisconnect(void)
+{
+    return (0);
+}
+
+/*
+ *  ======== Console_print ========
+ */
+void Console_print(Console_Session *session, const char *string)
+{
+    (void)session;
+    printf("%s\n", string);
+}
@@ -0,0 +1,78 @@
+/*
+ *  ======== host.h ========
+ *  Host side of the stand-in SDK headers under tools/host.
+ *
+ *  Firmware modules that do not touch hardware build for the host
+ *  against these headers and link with host.c, which supplies the few
+ *  SDK and firmware calls they make:
+ *   - the NWP file system, kept in memory
+ *   - the NWP random number generator, a seeded xorshift so runs repeat
+ *   - Timebase_monoUs()/Timebase_monoMs() and NetSched_nowMs(), on the
+ *     host's monotonic clock or on a simulated one
+ *   - Console_print(), to stdout
+ *
+ *  hosthib.c stands in for hibernate.c, and hostnet.c for the network
+ *  (see hostnet.h).
+ */
+#ifndef __HOST_H
+#define __HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hibernate.h"
+
+#define HOST_FILES                  (8)
+#define HOST_FILE_SIZE              (4096)
+
+/*!
+ *  @brief  Create or replace a file in the stand-in NWP file system
+ *
+ *  @return false if there is no room
+ */
+extern bool Host_setFile(const char *name, const void *data, size_t len);
+
+/*!
+ *  @brief  Remove every file
+ */
+extern void Host_clearFiles(void);
+
+/*!
+ *  @brief  Make the next count file opens or writes fail
+ */
+extern void Host_failFs(unsigned int count);
+
+extern void Host_seedRandom(uint32_t seed);
+
+/*!
+ *  @brief  Switch Timebase_monoUs() to a simulated clock at us
+ */
+extern void Host_setClockUs(uint64_t us);
+
+/*!
+ *  @brief  Move the simulated clock on
+ */
+extern void Host_advanceUs(uint64_t us);
+
+/*!
+ *  @brief  Start over as after a boot of the given kind. A cold boot
+ *          clears the hibernate record, a wake-up keeps it.
+ */
+extern void Host_wake(Hibernate_Wake how);
+
+/*!
+ *  @brief  Sleep asked for with Hibernate_request() since the last
+ *          Host_wake(), 0 if none
+ */
+extern uint32_t Host_hibernateRequested(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HOST_H */
@@ -0,0 +1,122 @@
+/*
+ *  ======== hosthib.c ========
+ *  Host stand-in for hibernate.c: the state record stays in memory and
+ *  Host_wake() plays the part of a reboot, see host.h
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hibernate.h"
+#include "host.h"
+
+Hibernate_State hibernateState;
+
+static Hibernate_Wake   wake = Hibernate_Wake_COLD;
+static uint32_t         requestedMs = 0;
+
+/*
+ *  ======== Host_wake ========
+ */
+void Host_wake(Hibernate_Wake how)
+{
+    wake = how;
+    requestedMs = 0;
+    if (how == Hibernate_Wake_COLD) {
+        memset(&hibernateState, 0, sizeof(hibernateState));
+    }
+    else {
+        hibernateState.wakeCount++;
+    }
+}
+
+/*
+ *  ======== Host_hibernateRequested ========
+ */
+uint32_t Host_hibernateRequested(void)
+{
+    return (requestedMs);
+}
+
+/*
+ *  ======== Hibernate_wake ========
+ */
+Hibernate_Wake Hibernate_wake(void)
+{
+    return (wake);
+}
+
+/*
+ *  ======== Hibernate_request ========
+ */
+void Hibernate_request(uint32_t sleepMs)
+{
+    requestedMs = (sleepMs != 0) ? sleepMs : 1;
+    hibernateState.sleepMs = sleepMs;
+}
+
+/*
+ *  ======== Hibernate_noteServer ========
+ */
+void Hibernate_noteServer(uint32_t hostHash, uint32_t addr)
+{
+    hibernateState.serverHash = hostHash;
+    hibernateState.serverAddr = addr;
+}
+
+/*
+ *  ======== Hibernate_lastServer ========
+ */
+bool Hibernate_lastServer(uint32_t *hostHash, uint32_t *addr)
+{
+    if ((wake == Hibernate_Wake_COLD) || (hibernateState.serverAddr == 0)) {
+        return (false);
+    }
+    *hostHash = hibernateState.serverHash;
+    *addr = hibernateState.serverAddr;
+
+    return (true);
+}
+
+/*
+ *  ======== Hibernate_noteAlarms ========
+ */
+void Hibernate_noteAlarms(const Hibernate_Alarms *alarms)
+{
+    hibernateState.alarms = *alarms;
+}
+
+/*
+ *  ======== Hibernate_lastAlarms ========
+ */
+bool Hibernate_lastAlarms(Hibernate_Alarms *alarms)
+{
+    if (wake == Hibernate_Wake_COLD) {
+        return (false);
+    }
+    *alarms = hibernateState.alarms;
+
+    return (true);
+}
+
+/*
+ *  ======== Hibernate_noteSchedule ========
+ */
+void Hibernate_noteSchedule(const Hibernate_Schedule *schedule)
+{
+    hibernateState.schedule = *schedule;
+}
+
+/*
+ *  ======== Hibernate_lastSchedule ========
+ */
+bool Hibernate_lastSchedule(Hibernate_Schedule *schedule)
+{
+    if ((wake == Hibernate_Wake_COLD) ||
+            (hibernateState.schedule.monoMs == 0)) {
+        return (false);
+    }
+    *schedule = hibernateState.schedule;
+
+    return (true);
+}
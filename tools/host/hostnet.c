@@ -0,0 +1,465 @@
+/*
+ *  ======== hostnet.c ========
+ *  SlNetUtil and HTTPClient stand-ins on the simulated clock, see
+ *  hostnet.h
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ti/net/http/httpclient.h>
+#include <ti/net/slnetutils.h>
+
+#include "host.h"
+#include "hostnet.h"
+#include "netshim.h"
+
+typedef struct HostName {
+    char        name[64];
+    uint32_t    addr;               /* host order */
+} HostName;
+
+typedef struct Client {
+    bool        connected;
+    int16_t     status;             /* of the last request */
+    const char *body;               /* response left to read */
+    size_t      left;
+} Client;
+
+typedef struct AddrInfo {
+    SlNetUtil_addrInfo_t    info;
+    SlNetSock_AddrIn_t      addr;
+} AddrInfo;
+
+static HostNet_Server   server = {
+    .connectMs = 5,
+    .tlsMs = 0,
+    .requestMs = 20,
+    .lookupMs = 10,
+    .phyKbps = 0,
+    .status = 200,
+    .retryAfterS = 0,
+    .body = NULL
+};
+static HostName         hosts[HOSTNET_HOSTS];
+static unsigned int     lookupFailures = 0;
+static HostNet_Stats    stats;
+
+/*
+ *  ======== spend ========
+ *  Radio time: rxMs waiting for the other end, txMs sending.
+ */
+static void spend(uint32_t rxMs, uint32_t txMs)
+{
+    Host_advanceUs((uint64_t)(rxMs + txMs) * 1000);
+    stats.radioMs += rxMs + txMs;
+    stats.energyUj += (rxMs * NETSHIM_RX_MA + txMs * NETSHIM_TX_MA) *
+            (NETSHIM_SUPPLY_MV / 100) / 10;
+}
+
+/*
+ *  ======== findHost ========
+ */
+static HostName *findHost(const char *name)
+{
+    int i;
+
+    for (i = 0; i < HOSTNET_HOSTS; i++) {
+        if (hosts[i].name[0] && (strcmp(hosts[i].name, name) == 0)) {
+            return (&hosts[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== knownAddr ========
+ */
+static bool knownAddr(uint32_t addr)
+{
+    int i;
+
+    for (i = 0; i < HOSTNET_HOSTS; i++) {
+        if (hosts[i].name[0] && (hosts[i].addr == addr)) {
+            return (true);
+        }
+    }
+
+    return (false);
+}
+
+/*
+ *  ======== resolve ========
+ *  The responder: one round trip, answered from the table.
+ */
+static bool resolve(const char *name, uint32_t *addr)
+{
+    HostName *h;
+
+    stats.lookups++;
+    spend(server.lookupMs, 0);
+
+    h = findHost(name);
+    if ((h == NULL) || (lookupFailures > 0)) {
+        if (lookupFailures > 0) {
+            lookupFailures--;
+        }
+        stats.lookupFailures++;
+        return (false);
+    }
+    *addr = h->addr;
+
+    return (true);
+}
+
+/*
+ *  ======== HostNet_setServer ========
+ */
+void HostNet_setServer(const HostNet_Server *s)
+{
+    server = *s;
+}
+
+/*
+ *  ======== HostNet_addHost ========
+ */
+bool HostNet_addHost(const char *name, uint32_t addr)
+{
+    HostName *h = findHost(name);
+    int       i;
+
+    if (strlen(name) >= sizeof(hosts[0].name)) {
+        return (false);
+    }
+    for (i = 0; (h == NULL) && (i < HOSTNET_HOSTS); i++) {
+        if (hosts[i].name[0] == '\0') {
+            h = &hosts[i];
+            strcpy(h->name, name);
+        }
+    }
+    if (h == NULL) {
+        return (false);
+    }
+    h->addr = addr;
+
+    return (true);
+}
+
+/*
+ *  ======== HostNet_clearHosts ========
+ */
+void HostNet_clearHosts(void)
+{
+    memset(hosts, 0, sizeof(hosts));
+}
+
+/*
+ *  ======== HostNet_failLookups ========
+ */
+void HostNet_failLookups(unsigned int count)
+{
+    lookupFailures = count;
+}
+
+/*
+ *  ======== HostNet_getStats ========
+ */
+void HostNet_getStats(HostNet_Stats *out)
+{
+    *out = stats;
+}
+
+/*
+ *  ======== HostNet_resetStats ========
+ */
+void HostNet_resetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+/*
+ *  ======== SlNetUtil_htonl ========
+ */
+uint32_t SlNetUtil_htonl(uint32_t val)
+{
+    uint8_t  b[4] = {(uint8_t)(val >> 24), (uint8_t)(val >> 16),
+                     (uint8_t)(val >> 8), (uint8_t)val};
+    uint32_t out;
+
+    memcpy(&out, b, sizeof(out));
+
+    return (out);
+}
+
+/*
+ *  ======== SlNetUtil_ntohl ========
+ */
+uint32_t SlNetUtil_ntohl(uint32_t val)
+{
+    uint8_t b[4];
+
+    memcpy(b, &val, sizeof(b));
+
+    return (((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+            ((uint32_t)b[2] << 8) | b[3]);
+}
+
+/*
+ *  ======== SlNetUtil_htons ========
+ */
+uint16_t SlNetUtil_htons(uint16_t val)
+{
+    uint8_t  b[2] = {(uint8_t)(val >> 8), (uint8_t)val};
+    uint16_t out;
+
+    memcpy(&out, b, sizeof(out));
+
+    return (out);
+}
+
+/*
+ *  ======== SlNetUtil_ntohs ========
+ */
+uint16_t SlNetUtil_ntohs(uint16_t val)
+{
+    uint8_t b[2];
+
+    memcpy(b, &val, sizeof(b));
+
+    return ((uint16_t)((b[0] << 8) | b[1]));
+}
+
+/*
+ *  ======== SlNetUtil_getAddrInfo ========
+ */
+int32_t SlNetUtil_getAddrInfo(uint16_t ifID, const char *node,
+        const char *service, const SlNetUtil_addrInfo_t *hints,
+        SlNetUtil_addrInfo_t **res)
+{
+    AddrInfo *ai;
+    uint32_t  addr;
+
+    if (!resolve(node, &addr)) {
+        return (SLNETUTIL_EAI_FAIL);
+    }
+    ai = calloc(1, sizeof(*ai));
+    if (ai == NULL) {
+        return (SLNETUTIL_EAI_FAIL);
+    }
+    ai->addr.sin_family = SLNETSOCK_AF_INET;
+    ai->addr.sin_addr.s_addr = SlNetUtil_htonl(addr);
+    ai->info.ai_family = SLNETSOCK_AF_INET;
+    ai->info.ai_socktype = SLNETSOCK_SOCK_STREAM;
+    ai->info.ai_addrlen = sizeof(ai->addr);
+    ai->info.ai_addr = (SlNetSock_Addr_t *)&ai->addr;
+    *res = &ai->info;
+
+    return (0);
+}
+
+/*
+ *  ======== SlNetUtil_freeAddrInfo ========
+ */
+void SlNetUtil_freeAddrInfo(SlNetUtil_addrInfo_t *res)
+{
+    /* info is the first member of the AddrInfo allocated above */
+    free(res);
+}
+
+/*
+ *  ======== HTTPClient_create ========
+ */
+HTTPClient_Handle HTTPClient_create(int16_t *status, void *params)
+{
+    Client *client = calloc(1, sizeof(*client));
+
+    *status = (client != NULL) ? 0 : HTTPClient_ENOCONNECTION;
+
+    return (client);
+}
+
+/*
+ *  ======== HTTPClient_destroy ========
+ */
+int16_t HTTPClient_destroy(HTTPClient_Handle handle)
+{
+    free(handle);
+
+    return (0);
+}
+
+/*
+ *  ======== HTTPClient_connect ========
+ *  By name, as for https: the lookup is the client's own.
+ */
+int16_t HTTPClient_connect(HTTPClient_Handle handle, const char *hostName,
+        HTTPClient_extSecParams *exSecParams, uint32_t flags)
+{
+    Client     *client = handle;
+    char        name[64];
+    const char *p = hostName;
+    bool        secure = true;
+    uint32_t    addr;
+    size_t      n;
+
+    if (strncmp(p, "https://", 8) == 0) {
+        p += 8;
+    }
+    else if (strncmp(p, "http://", 7) == 0) {
+        p += 7;
+        secure = false;
+    }
+    n = strcspn(p, ":/");
+    if (n >= sizeof(name)) {
+        return (HTTPClient_EHOSTNAMERESOLVE);
+    }
+    memcpy(name, p, n);
+    name[n] = '\0';
+
+    if (!resolve(name, &addr)) {
+        return (HTTPClient_EHOSTNAMERESOLVE);
+    }
+    stats.connects++;
+    spend(server.connectMs, 0);
+    if (secure) {
+        stats.tlsConnects++;
+        spend(server.tlsMs, 0);
+    }
+    client->connected = true;
+
+    return (0);
+}
+
+/*
+ *  ======== HTTPClient_connect2 ========
+ *  By address; an address no name maps to any more refuses, as a
+ *  server that moved would.
+ */
+int16_t HTTPClient_connect2(HTTPClient_Handle handle,
+        const SlNetSock_Addr_t *addr, HTTPClient_extSecParams *exSecParams,
+        uint32_t flags)
+{
+    Client *client = handle;
+
+    stats.connects++;
+    spend(server.connectMs, 0);
+    if (!knownAddr(SlNetUtil_ntohl(
+            ((const SlNetSock_AddrIn_t *)addr)->sin_addr.s_addr))) {
+        return (HTTPClient_ECONNECTFAIL);
+    }
+    if (exSecParams != NULL) {
+        stats.tlsConnects++;
+        spend(server.tlsMs, 0);
+    }
+    client->connected = true;
+
+    return (0);
+}
+
+/*
+ *  ======== HTTPClient_disconnect ========
+ */
+int16_t HTTPClient_disconnect(HTTPClient_Handle handle)
+{
+    Client *client = handle;
+
+    client->connected = false;
+    client->left = 0;
+
+    return (0);
+}
+
+/*
+ *  ======== HTTPClient_sendRequest ========
+ */
+int16_t HTTPClient_sendRequest(HTTPClient_Handle handle, const char *method,
+        const char *requestURI, const char *body, uint32_t bodyLen,
+        uint32_t flags)
+{
+    Client  *client = handle;
+    uint32_t txMs = 0;
+
+    if (!client->connected) {
+        return (HTTPClient_ENOCONNECTION);
+    }
+    stats.requests++;
+    stats.bytesSent += bodyLen;
+    if (server.phyKbps != 0) {
+        txMs = bodyLen * 8 / server.phyKbps;
+    }
+    spend(server.requestMs, txMs);
+
+    client->status = server.status;
+    client->body = (server.body != NULL) ? server.body : "";
+    client->left = strlen(client->body);
+
+    return (client->status);
+}
+
+/*
+ *  ======== HTTPClient_readResponseBody ========
+ */
+int16_t HTTPClient_readResponseBody(HTTPClient_Handle handle, char *body,
+        uint32_t bodyLen, bool *moreDataFlag)
+{
+    Client *client = handle;
+    size_t  n = (client->left < bodyLen) ? client->left : bodyLen;
+
+    if (!client->connected) {
+        return (HTTPClient_ENOCONNECTION);
+    }
+    memcpy(body, client->body, n);
+    client->body += n;
+    client->left -= n;
+    *moreDataFlag = (client->left > 0);
+
+    return ((int16_t)n);
+}
+
+/*
+ *  ======== HTTPClient_setHeader ========
+ */
+int16_t HTTPClient_setHeader(HTTPClient_Handle handle, uint32_t option,
+        const void *value, uint32_t len, uint32_t flags)
+{
+    return (0);
+}
+
+/*
+ *  ======== HTTPClient_setHeaderByName ========
+ */
+int16_t HTTPClient_setHeaderByName(HTTPClient_Handle handle,
+        uint32_t option, const char *name, const void *value, uint32_t len,
+        uint32_t flags)
+{
+    return (0);
+}
+
+/*
+ *  ======== HTTPClient_getHeader ========
+ *  Only Retry-After, which comes with a 503.
+ */
+int16_t HTTPClient_getHeader(HTTPClient_Handle handle, uint32_t option,
+        void *value, uint32_t *len, uint32_t flags)
+{
+    Client *client = handle;
+    char    text[12];
+    int     n = 0;
+
+    if ((option == HTTPClient_HFIELD_RES_RETRY_AFTER) &&
+            (client->status == 503) && (server.retryAfterS != 0)) {
+        n = snprintf(text, sizeof(text), "%u",
+                (unsigned int)server.retryAfterS);
+    }
+    if ((uint32_t)n > *len) {
+        return (HTTPClient_EGETOPTBUFSMALL);
+    }
+    memcpy(value, text, n);
+    *len = n;
+
+    return (0);
+}
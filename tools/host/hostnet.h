@@ -0,0 +1,81 @@
+/*
+ *  ======== hostnet.h ========
+ *  Stand-in network for the host builds: a DNS responder behind
+ *  SlNetUtil_getAddrInfo() and a server behind the HTTPClient calls.
+ *
+ *  Nothing goes on the wire. Every lookup, connect and request moves
+ *  the simulated clock of host.c on by what it would take (see
+ *  HostNet_Server), and the radio time and energy are counted with the
+ *  currents of netshim.h, so runs are repeatable and can be compared.
+ *  The network conditions themselves (loss, drops, DHCP) are left to
+ *  netshim.c in front of the client, as on the device.
+ */
+#ifndef __HOSTNET_H
+#define __HOSTNET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOSTNET_HOSTS               (8)
+
+/*!
+ *  @brief  How the stand-in server behaves
+ */
+typedef struct HostNet_Server {
+    uint16_t    connectMs;          /* TCP handshake */
+    uint16_t    tlsMs;              /* more for an https connect */
+    uint16_t    requestMs;          /* request to response */
+    uint16_t    lookupMs;           /* DNS round trip */
+    uint16_t    phyKbps;            /* body rate, 0 unlimited */
+    int16_t     status;             /* answer to every request */
+    uint16_t    retryAfterS;        /* sent with a 503, 0 for none */
+    const char *body;               /* response body, NULL for none */
+} HostNet_Server;
+
+typedef struct HostNet_Stats {
+    uint32_t    lookups;
+    uint32_t    lookupFailures;
+    uint32_t    connects;
+    uint32_t    tlsConnects;        /* of which https */
+    uint32_t    requests;
+    uint32_t    bytesSent;          /* request bodies */
+    uint32_t    radioMs;
+    uint32_t    energyUj;
+} HostNet_Stats;
+
+/*!
+ *  @brief  Replace the server's behaviour; the defaults are a LAN
+ *          server answering 200 with an empty body
+ */
+extern void HostNet_setServer(const HostNet_Server *server);
+
+/*!
+ *  @brief  Answer lookups of name with addr (host order); a name
+ *          already known moves to the new address
+ *
+ *  @return false if the table is full
+ */
+extern bool HostNet_addHost(const char *name, uint32_t addr);
+
+/*!
+ *  @brief  Forget all names
+ */
+extern void HostNet_clearHosts(void);
+
+/*!
+ *  @brief  Make the next count lookups fail
+ */
+extern void HostNet_failLookups(unsigned int count);
+
+extern void HostNet_getStats(HostNet_Stats *stats);
+extern void HostNet_resetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HOSTNET_H */
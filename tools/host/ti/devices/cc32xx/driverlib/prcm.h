@@ -0,0 +1,35 @@
+/*
+ *  ======== prcm.h ========
+ *  Host stand-in for the PRCM calls hibernate.c makes: the reset and
+ *  wake-up cause and the on-chip retention registers. A test that
+ *  builds hibernate.c supplies them and so plays the hardware.
+ */
+#ifndef __PRCM_H__
+#define __PRCM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PRCM_POWER_ON                       (0x00000000)
+#define PRCM_LPDS_EXIT                      (0x00000001)
+#define PRCM_CORE_RESET                     (0x00000003)
+#define PRCM_MCU_RESET                      (0x00000004)
+#define PRCM_WDT_RESET                      (0x00000005)
+#define PRCM_SOC_RESET                      (0x00000006)
+#define PRCM_HIB_EXIT                       (0x00000007)
+
+#define PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK    (0x00000002)
+#define PRCM_HIB_WAKEUP_CAUSE_GPIO          (0x00000004)
+
+extern unsigned long PRCMSysResetCauseGet(void);
+extern unsigned long PRCMHibernateWakeupCauseGet(void);
+extern void PRCMOCRRegisterWrite(unsigned char index,
+        unsigned long regValue);
+extern unsigned long PRCMOCRRegisterRead(unsigned char index);
+
+#define MAP_PRCMSysResetCauseGet            PRCMSysResetCauseGet
+#define MAP_PRCMHibernateWakeupCauseGet     PRCMHibernateWakeupCauseGet
+#define MAP_PRCMOCRRegisterWrite            PRCMOCRRegisterWrite
+#define MAP_PRCMOCRRegisterRead             PRCMOCRRegisterRead
+
+#endif /* __PRCM_H__ */
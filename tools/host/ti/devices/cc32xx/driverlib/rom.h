@@ -0,0 +1,8 @@
+/*
+ *  ======== rom.h ========
+ *  Host stand-in: there is no ROM; rom_map.h maps to the plain calls.
+ */
+#ifndef __ROM_H__
+#define __ROM_H__
+
+#endif /* __ROM_H__ */
@@ -0,0 +1,9 @@
+/*
+ *  ======== rom_map.h ========
+ *  Host stand-in: the MAP_ names of the calls in the stand-in driverlib
+ *  headers are defined next to their declarations there.
+ */
+#ifndef __ROM_MAP_H__
+#define __ROM_MAP_H__
+
+#endif /* __ROM_MAP_H__ */
@@ -0,0 +1,10 @@
+/*
+ *  ======== hw_memmap.h ========
+ *  Host stand-in
+ */
+#ifndef __HW_MEMMAP_H__
+#define __HW_MEMMAP_H__
+
+#define TIMERA0_BASE    0x40030000
+
+#endif /* __HW_MEMMAP_H__ */
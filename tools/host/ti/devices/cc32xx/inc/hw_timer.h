@@ -0,0 +1,10 @@
+/*
+ *  ======== hw_timer.h ========
+ *  Host stand-in
+ */
+#ifndef __HW_TIMER_H__
+#define __HW_TIMER_H__
+
+#define TIMER_O_TAR     0x00000048
+
+#endif /* __HW_TIMER_H__ */
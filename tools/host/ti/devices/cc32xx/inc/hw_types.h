@@ -0,0 +1,12 @@
+/*
+ *  ======== hw_types.h ========
+ *  Host stand-in. Register access compiles but must never run.
+ */
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdint.h>
+
+#define HWREG(x)        (*((volatile uint32_t *)(uintptr_t)(x)))
+
+#endif /* __HW_TYPES_H__ */
@@ -0,0 +1,10 @@
+/*
+ *  ======== GPIO.h ========
+ *  Host stand-in: nothing the host tools call, only so console.c builds.
+ */
+#ifndef ti_drivers_GPIO__include
+#define ti_drivers_GPIO__include
+
+#include <stdint.h>
+
+#endif /* ti_drivers_GPIO__include */
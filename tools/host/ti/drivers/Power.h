@@ -0,0 +1,14 @@
+/*
+ *  ======== Power.h ========
+ *  Host stand-in: only the shutdown, which a test that builds
+ *  hibernate.c supplies.
+ */
+#ifndef ti_drivers_Power__include
+#define ti_drivers_Power__include
+
+#include <stdint.h>
+
+extern int_fast16_t Power_shutdown(uint_fast16_t shutdownState,
+        uint_fast32_t shutdownTime);
+
+#endif /* ti_drivers_Power__include */
@@ -0,0 +1,12 @@
+/*
+ *  ======== UART.h ========
+ *  Host stand-in: the UART is reached through uartio.h, which the host
+ *  tests supply themselves.
+ */
+#ifndef ti_drivers_UART__include
+#define ti_drivers_UART__include
+
+#include <stddef.h>
+#include <stdint.h>
+
+#endif /* ti_drivers_UART__include */
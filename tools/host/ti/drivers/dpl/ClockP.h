@@ -0,0 +1,26 @@
+/*
+ *  ======== ClockP.h ========
+ *  Host stand-in: a 1 ms system tick on the host's monotonic clock.
+ */
+#ifndef ti_dpl_ClockP__include
+#define ti_dpl_ClockP__include
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t ClockP_getSystemTicks(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint32_t)((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000));
+}
+
+/* In microseconds */
+static inline uint32_t ClockP_getSystemTickPeriod(void)
+{
+    return (1000);
+}
+
+#endif /* ti_dpl_ClockP__include */
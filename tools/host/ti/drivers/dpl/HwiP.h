@@ -0,0 +1,40 @@
+/*
+ *  ======== HwiP.h ========
+ *  Host stand-in: one global lock in place of disabling interrupts.
+ *  Most tools are single threaded and never contend for it; the
+ *  scheduler test runs netSchedThread next to the test's own thread,
+ *  as the firmware does. It nests, as HwiP_disable() does.
+ */
+#ifndef ti_dpl_HwiP__include
+#define ti_dpl_HwiP__include
+
+#include <pthread.h>
+#include <stdint.h>
+
+/* Weak, so every file including this shares the one lock */
+__attribute__ ((weak)) pthread_mutex_t hostHwiLock = PTHREAD_MUTEX_INITIALIZER;
+__attribute__ ((weak)) pthread_t       hostHwiOwner;
+__attribute__ ((weak)) unsigned int    hostHwiDepth;
+
+static inline uintptr_t HwiP_disable(void)
+{
+    if ((hostHwiDepth > 0) && pthread_equal(hostHwiOwner, pthread_self())) {
+        hostHwiDepth++;
+        return (1);
+    }
+    pthread_mutex_lock(&hostHwiLock);
+    hostHwiOwner = pthread_self();
+    hostHwiDepth = 1;
+
+    return (0);
+}
+
+static inline void HwiP_restore(uintptr_t key)
+{
+    (void)key;
+    if (--hostHwiDepth == 0) {
+        pthread_mutex_unlock(&hostHwiLock);
+    }
+}
+
+#endif /* ti_dpl_HwiP__include */
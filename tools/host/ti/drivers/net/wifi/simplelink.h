@@ -0,0 +1,107 @@
+/*
+ *  ======== simplelink.h ========
+ *  Host stand-in for the NWP calls the host tools need: the file system
+ *  (kept in memory, see host.h), the random number generator (seeded,
+ *  so runs repeat) and an AP disconnect, which only counts. The WLAN
+ *  and IP configuration types are here for console.c; a test that
+ *  runs its commands supplies sl_WlanConnect(), sl_WlanGet() and
+ *  sl_NetCfgGet(), and one that builds hibernate.c sl_Start() and
+ *  sl_Stop().
+ */
+#ifndef __SIMPLELINK_H__
+#define __SIMPLELINK_H__
+
+#include <stdint.h>
+
+typedef uint8_t     _u8;
+typedef int8_t      _i8;
+typedef uint16_t    _u16;
+typedef int16_t     _i16;
+typedef uint32_t    _u32;
+typedef int32_t     _i32;
+
+#define SL_FS_READ                  (0x00000000)
+#define SL_FS_WRITE                 (0x01000000)
+#define SL_FS_CREATE                (0x02000000)
+#define SL_FS_OVERWRITE             (0x04000000)
+#define SL_FS_CREATE_MAX_SIZE(x)    ((_u32)(x) & 0x00FFFFFF)
+
+#define SL_ERROR_FS_FILE_NOT_EXISTS (-11)
+#define SL_ERROR_FS_NO_FREE_SPACE   (-12)
+
+#define SL_NETUTIL_TRUE_RANDOM      (3)
+
+extern _i32 sl_FsOpen(const _u8 *name, const _u32 mode, _u32 *token);
+extern _i32 sl_FsRead(const _i32 fd, _u32 offset, _u8 *data, _u32 len);
+extern _i32 sl_FsWrite(const _i32 fd, _u32 offset, _u8 *data, _u32 len);
+extern _i16 sl_FsClose(const _i32 fd, const _u8 *cert, const _u8 *signature,
+        const _u32 signatureLen);
+extern _i32 sl_FsDel(const _u8 *name, const _u32 token);
+
+#define SL_WLAN_SEC_TYPE_OPEN       (0)
+#define SL_WLAN_SEC_TYPE_WPA_WPA2   (2)
+
+#define SL_WLAN_CONNECTION_INFO     (4)
+
+#define SL_NETCFG_IPV4_STA_ADDR_MODE (3)
+#define SL_NETCFG_ADDR_STATIC       (0)
+#define SL_NETCFG_ADDR_DHCP         (1)
+
+#define SL_IPV4_BYTE(val, index)    (((val) >> ((index) * 8)) & 0xFF)
+
+#define SL_WLAN_SCAN_RESULT_HIDDEN_SSID(x)              (((x) >> 15) & 0x1)
+#define SL_WLAN_SCAN_RESULT_GROUP_CIPHER(x)             (((x) >> 8) & 0x7)
+#define SL_WLAN_SCAN_RESULT_UNICAST_CIPHER_BITMAP(x)    (((x) >> 4) & 0x7)
+#define SL_WLAN_SCAN_RESULT_KEY_MGMT_SUITES_BITMAP(x)   ((x) & 0x3)
+#define SL_WLAN_SCAN_RESULT_SEC_TYPE_BITMAP(x)          (((x) >> 11) & 0xF)
+
+typedef struct {
+    _u8     Type;
+    _i8    *Key;
+    _u8     KeyLen;
+} SlWlanSecParams_t;
+
+typedef struct {
+    _u8     User[32];
+    _u8     UserLen;
+} SlWlanSecParamsExt_t;
+
+typedef struct {
+    _u8     SsidLen;
+    _u8     SsidName[32];
+    _u8     Bssid[6];
+} SlWlanConnectionInfo_t;
+
+typedef struct {
+    _u8     Mode;
+    _u8     SecType;
+    _u8     Reserved[2];
+    union {
+        SlWlanConnectionInfo_t  StaConnect;
+    } ConnectionInfo;
+} SlWlanConnStatusParam_t;
+
+typedef struct {
+    _u32    Ip;
+    _u32    IpMask;
+    _u32    IpGateway;
+    _u32    IpDnsServer;
+} SlNetCfgIpV4Args_t;
+
+extern _i16 sl_Start(const void *ifHdl, _i8 *devName,
+        const void *initCallBack);
+extern _i16 sl_Stop(const _u16 timeout);
+
+extern _i16 sl_WlanConnect(const _i8 *name, const _i16 nameLen,
+        const _u8 *macAddr, const SlWlanSecParams_t *secParams,
+        const SlWlanSecParamsExt_t *secExtParams);
+extern _i16 sl_WlanDisconnect(void);
+extern _i16 sl_WlanGet(const _u16 configId, _u16 *configOpt,
+        _u16 *configLen, _u8 *values);
+extern _i16 sl_NetCfgGet(const _u16 configId, _u16 *configOpt,
+        _u16 *configLen, _u8 *values);
+
+extern _i16 sl_NetUtilCmd(const _u16 cmd, const _u8 *attrib,
+        const _u16 attribLen, _u8 *out, _u16 *outLen);
+
+#endif /* __SIMPLELINK_H__ */
@@ -0,0 +1,11 @@
+/*
+ *  ======== slnetifwifi.h ========
+ *  Host stand-in: the SlNetIf glue is not used on the host, only the
+ *  simplelink.h it pulls in.
+ */
+#ifndef __SLNETIFWIFI_H__
+#define __SLNETIFWIFI_H__
+
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#endif /* __SLNETIFWIFI_H__ */
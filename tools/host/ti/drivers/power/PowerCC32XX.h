@@ -0,0 +1,10 @@
+/*
+ *  ======== PowerCC32XX.h ========
+ *  Host stand-in: see Power.h.
+ */
+#ifndef ti_drivers_power_PowerCC32XX__include
+#define ti_drivers_power_PowerCC32XX__include
+
+#include <ti/drivers/Power.h>
+
+#endif /* ti_drivers_power_PowerCC32XX__include */
@@ -0,0 +1,71 @@
+/*
+ *  ======== httpclient.h ========
+ *  Host stand-in for the subset of the HTTP client the firmware uses.
+ *  Requests are answered by the stand-in server in
+ *  tools/host/hostnet.c; header values are const here, which the real
+ *  prototypes only imply.
+ */
+#ifndef ti_net_http_HTTPClient__include
+#define ti_net_http_HTTPClient__include
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ti/net/slnetsock.h>
+
+#define HTTP_METHOD_GET                     "GET"
+#define HTTP_METHOD_POST                    "POST"
+#define HTTP_METHOD_PUT                     "PUT"
+
+#define HTTPClient_ENOCONNECTION            (-3001)
+#define HTTPClient_EHOSTNAMERESOLVE         (-3002)
+#define HTTPClient_ECONNECTFAIL             (-3003)
+#define HTTPClient_EGETOPTBUFSMALL          (-3009)
+
+#define HTTPClient_HFIELD_PERSISTENT        (0x01)
+#define HTTPClient_HFIELD_NOT_PERSISTENT    (0x00)
+
+#define HTTPClient_REQUEST_HEADER_MASK      (0x80000000)
+
+/* Response fields */
+#define HTTPClient_HFIELD_RES_RETRY_AFTER   (17)
+
+/* Request fields */
+#define HTTPClient_HFIELD_REQ_CONTENT_TYPE  (HTTPClient_REQUEST_HEADER_MASK | 11)
+#define HTTPClient_HFIELD_REQ_HOST          (HTTPClient_REQUEST_HEADER_MASK | 15)
+#define HTTPClient_HFIELD_REQ_USER_AGENT    (HTTPClient_REQUEST_HEADER_MASK | 27)
+
+typedef void *HTTPClient_Handle;
+
+typedef struct HTTPClient_extSecParams {
+    const char *privateKey;
+    const char *clientCert;
+    const char *rootCa;
+} HTTPClient_extSecParams;
+
+extern HTTPClient_Handle HTTPClient_create(int16_t *status, void *params);
+extern int16_t HTTPClient_destroy(HTTPClient_Handle client);
+
+extern int16_t HTTPClient_connect(HTTPClient_Handle client,
+        const char *hostName, HTTPClient_extSecParams *exSecParams,
+        uint32_t flags);
+extern int16_t HTTPClient_connect2(HTTPClient_Handle client,
+        const SlNetSock_Addr_t *addr, HTTPClient_extSecParams *exSecParams,
+        uint32_t flags);
+extern int16_t HTTPClient_disconnect(HTTPClient_Handle client);
+
+extern int16_t HTTPClient_sendRequest(HTTPClient_Handle client,
+        const char *method, const char *requestURI, const char *body,
+        uint32_t bodyLen, uint32_t flags);
+extern int16_t HTTPClient_readResponseBody(HTTPClient_Handle client,
+        char *body, uint32_t bodyLen, bool *moreDataFlag);
+
+extern int16_t HTTPClient_setHeader(HTTPClient_Handle client,
+        uint32_t option, const void *value, uint32_t len, uint32_t flags);
+extern int16_t HTTPClient_setHeaderByName(HTTPClient_Handle client,
+        uint32_t option, const char *name, const void *value, uint32_t len,
+        uint32_t flags);
+extern int16_t HTTPClient_getHeader(HTTPClient_Handle client,
+        uint32_t option, void *value, uint32_t *len, uint32_t flags);
+
+#endif /* ti_net_http_HTTPClient__include */
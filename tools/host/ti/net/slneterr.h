@@ -0,0 +1,14 @@
+/*
+ *  ======== slneterr.h ========
+ *  Host stand-in
+ */
+#ifndef __SL_NET_ERR_H__
+#define __SL_NET_ERR_H__
+
+#define SLNETERR_RET_CODE_OK                (0)
+#define SLNETERR_RET_CODE_INVALID_INPUT     (-2)
+#define SLNETERR_BSD_EAGAIN                 (-11)
+#define SLNETERR_BSD_EALREADY               (-114)
+#define SLNETUTIL_EAI_FAIL                  (-3004)
+
+#endif /* __SL_NET_ERR_H__ */
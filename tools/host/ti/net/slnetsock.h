@@ -0,0 +1,53 @@
+/*
+ *  ======== slnetsock.h ========
+ *  Host stand-in: the types and constants the firmware modules name,
+ *  and the socket calls. No host source defines those; a test that
+ *  drives sockets supplies its own peer (see test_netsched.c), the
+ *  others go through tools/host/hostnet.h.
+ */
+#ifndef __SL_NET_SOCK_H__
+#define __SL_NET_SOCK_H__
+
+#include <stdint.h>
+
+#define SLNETSOCK_AF_INET               (2)
+#define SLNETSOCK_SOCK_STREAM           (1)
+#define SLNETSOCK_PROTO_TCP             (6)
+#define SLNETSOCK_LVL_SOCKET            (1)
+#define SLNETSOCK_OPT_NONBLOCKING       (24)
+
+typedef uint32_t SlNetSocklen_t;
+
+typedef struct SlNetSock_InAddr_t {
+    uint32_t    s_addr;                 /* network order */
+} SlNetSock_InAddr_t;
+
+typedef struct SlNetSock_Addr_t {
+    uint16_t    sa_family;
+    uint8_t     sa_data[14];
+} SlNetSock_Addr_t;
+
+typedef struct SlNetSock_AddrIn_t {
+    uint16_t            sin_family;
+    uint16_t            sin_port;       /* network order */
+    SlNetSock_InAddr_t  sin_addr;
+    int8_t              sin_zero[8];
+} SlNetSock_AddrIn_t;
+
+typedef struct SlNetSock_Nonblocking_t {
+    uint8_t     nonBlockingEnabled;
+} SlNetSock_Nonblocking_t;
+
+extern int16_t SlNetSock_create(int16_t domain, int16_t type,
+        int16_t protocol, uint32_t ifBitmap, int16_t flags);
+extern int32_t SlNetSock_connect(int16_t sd, const SlNetSock_Addr_t *addr,
+        SlNetSocklen_t addrlen);
+extern int32_t SlNetSock_send(int16_t sd, const void *buf, uint32_t len,
+        uint32_t flags);
+extern int32_t SlNetSock_recv(int16_t sd, void *buf, uint32_t len,
+        uint32_t flags);
+extern int32_t SlNetSock_close(int16_t sd);
+extern int32_t SlNetSock_setOpt(int16_t sd, int16_t level, int16_t optname,
+        void *optval, SlNetSocklen_t optlen);
+
+#endif /* __SL_NET_SOCK_H__ */
@@ -0,0 +1,35 @@
+/*
+ *  ======== slnetutils.h ========
+ *  Host stand-in. Lookups are answered by the stand-in DNS responder
+ *  in tools/host/hostnet.c.
+ */
+#ifndef __SL_NET_UTILS_H__
+#define __SL_NET_UTILS_H__
+
+#include <stdint.h>
+
+#include <ti/net/slnetsock.h>
+#include <ti/net/slneterr.h>
+
+typedef struct SlNetUtil_addrInfo_t {
+    int                          ai_flags;
+    int                          ai_family;
+    int                          ai_socktype;
+    int                          ai_protocol;
+    uint32_t                     ai_addrlen;
+    SlNetSock_Addr_t            *ai_addr;
+    char                        *ai_canonname;
+    struct SlNetUtil_addrInfo_t *ai_next;
+} SlNetUtil_addrInfo_t;
+
+extern int32_t SlNetUtil_getAddrInfo(uint16_t ifID, const char *node,
+        const char *service, const SlNetUtil_addrInfo_t *hints,
+        SlNetUtil_addrInfo_t **res);
+extern void SlNetUtil_freeAddrInfo(SlNetUtil_addrInfo_t *res);
+
+extern uint32_t SlNetUtil_htonl(uint32_t val);
+extern uint32_t SlNetUtil_ntohl(uint32_t val);
+extern uint16_t SlNetUtil_htons(uint16_t val);
+extern uint16_t SlNetUtil_ntohs(uint16_t val);
+
+#endif /* __SL_NET_UTILS_H__ */
@@ -0,0 +1,441 @@
+/*
+ *  ======== test_alarms.c ========
+ *  Host test of alarms.c. Recorded-style traces (a burst, a slow leak,
+ *  a pressure loss, a frost, a hiss, a full scale step) are replayed
+ *  through Alarms_feed() and the events must come out in order, each
+ *  inside its expected window. Then the queue: overflow, sequence
+ *  numbers and acks across an overflow; and the hold time kept across
+ *  hibernate.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "alarms.h"
+#include "host/host.h"
+#include "uploader.h"
+
+#include "check.h"
+
+#define MAX_EVENTS      (8)
+
+/*!
+ *  @brief  Values from -> to, linearly, fed every stepMs for durationMs
+ */
+typedef struct Segment {
+    uint32_t    durationMs;
+    uint32_t    stepMs;
+    int32_t     from;
+    int32_t     to;
+} Segment;
+
+/*!
+ *  @brief  An event expected between loMs and hiMs into the trace
+ */
+typedef struct Expect {
+    const char *rule;
+    bool        raised;
+    uint32_t    loMs;
+    uint32_t    hiMs;
+} Expect;
+
+typedef struct Trace {
+    const char     *name;
+    Alarms_Source   source;
+    const Segment  *segments;
+    const Expect   *expects;
+} Trace;
+
+/* 0.8 L/s for 8 s */
+static const Segment burstSegments[] = {
+    {10000, 1000, 0, 0},
+    {8000, 1000, 800000000, 800000000},
+    {10000, 1000, 0, 0},
+    {0}
+};
+static const Expect burstExpects[] = {
+    {"burst", true, 15000, 15000},
+    {"burst", false, 18000, 18000},
+    {NULL}
+};
+
+/* High flow twice for less than the hold, with a dip between */
+static const Segment blipSegments[] = {
+    {4000, 1000, 800000000, 800000000},
+    {1000, 1000, 460000000, 460000000},
+    {4000, 1000, 800000000, 800000000},
+    {10000, 1000, 0, 0},
+    {0}
+};
+static const Expect blipExpects[] = {
+    {NULL}
+};
+
+/* Inside the hysteresis band an alarm stays raised */
+static const Segment bandSegments[] = {
+    {6000, 1000, 800000000, 800000000},
+    {5000, 1000, 470000000, 470000000},
+    {5000, 1000, 440000000, 440000000},
+    {2000, 1000, 0, 0},
+    {0}
+};
+static const Expect bandExpects[] = {
+    {"burst", true, 5000, 5000},
+    {"burst", false, 11000, 11000},
+    {NULL}
+};
+
+/* A dripping tap, one reading a minute, for over two hours */
+static const Segment leakSegments[] = {
+    {130 * 60000, 60000, 5000, 5000},
+    {5 * 60000, 60000, 0, 0},
+    {0}
+};
+static const Expect leakExpects[] = {
+    {"leak", true, 120 * 60000, 120 * 60000},
+    {"leak", false, 130 * 60000, 130 * 60000},
+    {NULL}
+};
+
+/* Mains pressure falls from 3 bar to 0.5 bar in 10 s and comes back */
+static const Segment pressureSegments[] = {
+    {10000, 1000, 300000, 300000},
+    {10000, 1000, 300000, 50000},
+    {20000, 1000, 50000, 50000},
+    {5000, 1000, 50000, 300000},
+    {20000, 1000, 300000, 300000},
+    {0}
+};
+static const Expect pressureExpects[] = {
+    {"pdrop", true, 11000, 11000},
+    {"pdrop", false, 20000, 30000},
+    {"plow", true, 29000, 29000},
+    {"plow", false, 42000, 42000},
+    {NULL}
+};
+
+/* Frost: 8 C down to -1 C over 10 minutes, then a thaw */
+static const Segment frostSegments[] = {
+    {600000, 10000, 8000, -1000},
+    {600000, 10000, -1000, -1000},
+    {300000, 10000, -1000, 5000},
+    {60000, 10000, 5000, 5000},
+    {0}
+};
+static const Expect frostExpects[] = {
+    {"freeze", true, 470000, 470000},
+    {"freeze", false, 1410000, 1410000},
+    {NULL}
+};
+
+/* Hiss interrupted once, which restarts the hold */
+static const Segment hissSegments[] = {
+    {20000, 1000, 5000, 5000},
+    {2000, 1000, 3500, 3500},
+    {40000, 1000, 5000, 5000},
+    {5000, 1000, 2000, 2000},
+    {0}
+};
+static const Expect hissExpects[] = {
+    {"hiss", true, 52000, 52000},
+    {"hiss", false, 62000, 62000},
+    {NULL}
+};
+
+/*
+ *  A full scale step 1 ms apart. The rate must saturate, not wrap to
+ *  the wrong sign.
+ */
+static const Segment stepSegments[] = {
+    {2000, 1000, 300000, 300000},
+    {1, 1, 2000000000, 2000000000},
+    {1, 1, -2000000000, -2000000000},
+    {15000, 1000, -2000000000, -2000000000},
+    {1, 1, 300000, 300000},
+    {20000, 1000, 300000, 300000},
+    {0}
+};
+static const Expect stepExpects[] = {
+    {"pdrop", true, 2001, 2001},
+    {"plow", true, 12002, 12002},
+    {"pdrop", false, 17002, 17002},
+    {"plow", false, 17002, 17002},
+    {NULL}
+};
+
+static const Trace traces[] = {
+    {"burst", Alarms_Source_FLOW, burstSegments, burstExpects},
+    {"blip", Alarms_Source_FLOW, blipSegments, blipExpects},
+    {"band", Alarms_Source_FLOW, bandSegments, bandExpects},
+    {"leak", Alarms_Source_FLOW, leakSegments, leakExpects},
+    {"pressure", Alarms_Source_PRESSURE, pressureSegments, pressureExpects},
+    {"frost", Alarms_Source_TEMPERATURE, frostSegments, frostExpects},
+    {"hiss", Alarms_Source_ACOUSTIC, hissSegments, hissExpects},
+    {"step", Alarms_Source_PRESSURE, stepSegments, stepExpects},
+};
+
+static uint32_t nowMs = 1000;
+static uint32_t urgentCount = 0;
+
+/*
+ *  ======== Uploader_urgent ========
+ *  Stands in for the uploader's wake-up.
+ */
+void Uploader_urgent(void)
+{
+    urgentCount++;
+}
+
+/*
+ *  ======== ruleIndex ========
+ */
+static int ruleIndex(const char *name)
+{
+    int i;
+
+    for (i = 0; Alarms_rule(i) != NULL; i++) {
+        if (strcmp(Alarms_rule(i)->name, name) == 0) {
+            return (i);
+        }
+    }
+
+    return (-1);
+}
+
+/*
+ *  ======== feed ========
+ */
+static void feed(Alarms_Source source, int32_t value)
+{
+    Host_setClockUs((uint64_t)nowMs * 1000);
+    Alarms_feed(source, value, nowMs);
+}
+
+/*
+ *  ======== replay ========
+ */
+static void replay(const Trace *trace)
+{
+    Alarms_Event   events[MAX_EVENTS];
+    const Segment *seg;
+    const Expect  *e;
+    uint32_t       startMs = nowMs;
+    uint32_t       t;
+    uint32_t       at;
+    int            count;
+    int            i;
+
+    for (seg = trace->segments; seg->durationMs != 0; seg++) {
+        for (t = 0; t < seg->durationMs; t += seg->stepMs) {
+            feed(trace->source, seg->from + (int32_t)(((int64_t)seg->to -
+                    seg->from) * t / seg->durationMs));
+            nowMs += seg->stepMs;
+        }
+    }
+
+    count = Alarms_peek(events, MAX_EVENTS);
+    for (e = trace->expects, i = 0; e->rule != NULL; e++, i++) {
+        if (i >= count) {
+            fprintf(stderr, "%s: missing %s %s\n", trace->name, e->rule,
+                    e->raised ? "raised" : "cleared");
+            CHECK(i < count);
+            continue;
+        }
+        at = events[i].timeMs - startMs;
+        CHECK_EQ(events[i].rule, ruleIndex(e->rule));
+        CHECK_EQ(events[i].raised, e->raised);
+        if ((at < e->loMs) || (at > e->hiMs)) {
+            fprintf(stderr, "%s: %s at %lu ms, expected %lu..%lu\n",
+                    trace->name, e->rule, (unsigned long)at,
+                    (unsigned long)e->loMs, (unsigned long)e->hiMs);
+        }
+        CHECK((at >= e->loMs) && (at <= e->hiMs));
+    }
+    CHECK_EQ(count, i);
+    if (count > 0) {
+        Alarms_ack(events[count - 1].seq);
+    }
+    CHECK_EQ(Alarms_peek(events, MAX_EVENTS), 0);
+    CHECK_EQ(Alarms_active(), 0);
+
+    /* Apart from the next trace */
+    nowMs += 60000;
+}
+
+/*
+ *  ======== toggleBurst ========
+ *  One raised and one cleared event.
+ */
+static void toggleBurst(void)
+{
+    int i;
+
+    for (i = 0; i <= 5; i++) {
+        feed(Alarms_Source_FLOW, 800000000);
+        nowMs += 1000;
+    }
+    feed(Alarms_Source_FLOW, 0);
+    nowMs += 1000;
+}
+
+/*
+ *  ======== testQueue ========
+ */
+static void testQueue(void)
+{
+    Alarms_Event events[ALARMS_QUEUE_SIZE + 2];
+    Alarms_Stats before;
+    Alarms_Stats after;
+    uint32_t     seq;
+    int          count;
+    int          i;
+
+    Alarms_getStats(&before);
+    for (i = 0; i < 10; i++) {
+        toggleBurst();
+    }
+    Alarms_getStats(&after);
+    CHECK_EQ(after.raised - before.raised, 10);
+    CHECK_EQ(after.cleared - before.cleared, 10);
+    CHECK_EQ(after.dropped - before.dropped, 20 - ALARMS_QUEUE_SIZE);
+    CHECK_EQ(urgentCount, after.raised + after.cleared);
+
+    /* The newest are kept, in order, with consecutive numbers */
+    count = Alarms_peek(events, ALARMS_QUEUE_SIZE + 2);
+    CHECK_EQ(count, ALARMS_QUEUE_SIZE);
+    for (i = 1; i < count; i++) {
+        CHECK_EQ(events[i].seq, events[i - 1].seq + 1);
+        CHECK_EQ(events[i].raised, !events[i - 1].raised);
+    }
+    CHECK_EQ(events[count - 1].raised, 0);
+    seq = events[count - 1].seq;
+
+    /* Two more arrive before the ack and push two peeked ones out */
+    toggleBurst();
+    Alarms_ack(seq);
+    count = Alarms_peek(events, ALARMS_QUEUE_SIZE);
+    CHECK_EQ(count, 2);
+    CHECK_EQ(events[0].seq, seq + 1);
+    CHECK_EQ(events[1].seq, seq + 2);
+
+    /* An old ack removes nothing newer */
+    Alarms_ack(seq - 5);
+    CHECK_EQ(Alarms_peek(events, ALARMS_QUEUE_SIZE), 2);
+    Alarms_ack(seq + 2);
+    CHECK_EQ(Alarms_peek(events, ALARMS_QUEUE_SIZE), 0);
+}
+
+/*
+ *  ======== holdHiss ========
+ *  The hiss condition for seconds, clock left at the last feed.
+ */
+static void holdHiss(int seconds)
+{
+    int i;
+
+    for (i = 0; i <= seconds; i++) {
+        feed(Alarms_Source_ACOUSTIC, 5000);
+        nowMs += 1000;
+    }
+    nowMs -= 1000;
+    Host_setClockUs((uint64_t)nowMs * 1000);
+}
+
+/*
+ *  ======== forget ========
+ *  What a reset does to the pending hold in RAM.
+ */
+static void forget(void)
+{
+    nowMs += 1000;
+    feed(Alarms_Source_ACOUSTIC, 0);
+    CHECK_EQ(Alarms_pending(), 0);
+}
+
+/*
+ *  ======== testHibernate ========
+ *  A hold part way through carries over; the time asleep does not
+ *  count towards it.
+ */
+static void testHibernate(void)
+{
+    Alarms_Event events[MAX_EVENTS];
+    int          hiss = ruleIndex("hiss");
+    uint32_t     wakeMs;
+    int          count;
+    int          i;
+
+    /* A cold boot brings nothing back */
+    holdHiss(20);
+    Alarms_persist();
+    forget();
+    Host_wake(Hibernate_Wake_COLD);
+    Alarms_restore();
+    CHECK_EQ(Alarms_pending(), 0);
+
+    /* An hour asleep, then awake with the hiss still there */
+    holdHiss(20);
+    Alarms_persist();
+    forget();
+    Host_wake(Hibernate_Wake_TIMER);
+    nowMs += 3600000;
+    wakeMs = nowMs;
+    Host_setClockUs((uint64_t)nowMs * 1000);
+    Alarms_restore();
+    CHECK_EQ(Alarms_pending(), 1U << hiss);
+
+    for (i = 0; i <= 12; i++) {
+        feed(Alarms_Source_ACOUSTIC, 5000);
+        nowMs += 1000;
+    }
+    count = Alarms_peek(events, MAX_EVENTS);
+    CHECK_EQ(count, 1);
+    if (count == 1) {
+        /* 20 s held before, 10 s after */
+        CHECK_EQ(events[0].timeMs - wakeMs, 10000);
+        CHECK_EQ(events[0].rule, hiss);
+        Alarms_ack(events[0].seq);
+    }
+    CHECK_EQ(Alarms_active(), 1U << hiss);
+
+    /* Raised before the sleep: raised after, without a new event */
+    Host_setClockUs((uint64_t)nowMs * 1000);
+    Alarms_persist();
+    Host_wake(Hibernate_Wake_TIMER);
+    nowMs += 3600000;
+    Host_setClockUs((uint64_t)nowMs * 1000);
+    Alarms_restore();
+    CHECK_EQ(Alarms_active(), 1U << hiss);
+    CHECK_EQ(Alarms_peek(events, MAX_EVENTS), 0);
+
+    feed(Alarms_Source_ACOUSTIC, 0);
+    count = Alarms_peek(events, MAX_EVENTS);
+    CHECK_EQ(count, 1);
+    if (count == 1) {
+        CHECK_EQ(events[0].raised, 0);
+        Alarms_ack(events[0].seq);
+    }
+    CHECK_EQ(Alarms_active(), 0);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    unsigned int i;
+
+    Host_wake(Hibernate_Wake_COLD);
+    CHECK(Alarms_rule(-1) == NULL);
+    CHECK(ruleIndex("burst") >= 0);
+
+    for (i = 0; i < sizeof(traces) / sizeof(traces[0]); i++) {
+        replay(&traces[i]);
+    }
+    testQueue();
+    testHibernate();
+
+    return (CHECK_DONE("alarms"));
+}
@@ -0,0 +1,501 @@
+/*
+ *  ======== test_console.c ========
+ *  Host test of the console core in console.c: argument parsing, line
+ *  editing, dispatch and the telnet commands dropped from the input.
+ *
+ *  A test command is registered with CONSOLE_COMMAND() like any other,
+ *  so the dispatcher finds it in the linker collected table next to the
+ *  built-in ones. The NWP calls of the Wi-Fi commands are answered here.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "console.h"
+#include "uartio.h"
+#include "wifiscan.h"
+
+#include "check.h"
+
+#define TELNET_SE               (240)
+#define TELNET_NOP              (241)
+#define TELNET_SB               (250)
+#define TELNET_WILL             (251)
+#define TELNET_DO               (253)
+#define TELNET_IAC              (255)
+
+static char     output[4096];
+static size_t   outputLen;
+
+static int      testCalls;
+static int      testArgc;
+static int32_t  testNum[3];
+static char     testStr[3][CONSOLE_LINE_SIZE];
+
+static int      lineCalls;
+static char     lineSeen[CONSOLE_LINE_SIZE];
+
+static char     connectSsid[33];
+static int      connectType;
+static char     connectKey[65];
+static int      scanRequests;
+
+/*
+ *  ======== cmdTest ========
+ */
+static void cmdTest(Console_Session *session, const Console_Args *args)
+{
+    int i;
+
+    testCalls++;
+    testArgc = args->argc;
+    for (i = 0; i < args->argc; i++) {
+        testNum[i] = args->num[i];
+        snprintf(testStr[i], sizeof(testStr[i]), "%s", args->str[i]);
+    }
+}
+
+CONSOLE_COMMAND(test, "t", cmdTest, "Isi", "<n> [s] [i]", "test command");
+
+/*
+ *  ======== capture ========
+ */
+static void capture(Console_Session *session, const char *buf, size_t len)
+{
+    if (outputLen + len < sizeof(output)) {
+        memcpy(output + outputLen, buf, len);
+        outputLen += len;
+        output[outputLen] = '\0';
+    }
+}
+
+/*
+ *  ======== lineTaken ========
+ */
+static void lineTaken(Console_Session *session, char *line)
+{
+    lineCalls++;
+    snprintf(lineSeen, sizeof(lineSeen), "%s", line);
+}
+
+/*
+ *  ======== reset ========
+ */
+static void reset(void)
+{
+    outputLen = 0;
+    output[0] = '\0';
+    testCalls = 0;
+    testArgc = -1;
+    memset(testNum, 0, sizeof(testNum));
+    memset(testStr, 0, sizeof(testStr));
+}
+
+/*
+ *  ======== type ========
+ */
+static void type(Console_Session *session, const char *s)
+{
+    while (*s != '\0') {
+        Console_input(session, *s++);
+    }
+}
+
+/*
+ *  ======== typeBytes ========
+ */
+static void typeBytes(Console_Session *session, const uint8_t *s, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        Console_input(session, (char)s[i]);
+    }
+}
+
+/*
+ *  ======== parse ========
+ */
+static int parse(const char *line, const char *schema, Console_Args *args)
+{
+    static char buf[CONSOLE_LINE_SIZE];
+
+    snprintf(buf, sizeof(buf), "%s", line);
+
+    return (Console_parseArgs(buf, schema, args));
+}
+
+/*
+ *  ======== testParse ========
+ */
+static void testParse(void)
+{
+    Console_Args args;
+
+    /* No arguments */
+    CHECK_EQ(parse("", "", &args), 0);
+    CHECK_EQ(args.argc, 0);
+    CHECK_EQ(parse("   ", "", &args), 0);
+    CHECK_EQ(parse("x", "", &args), 1);
+
+    /* Mixed, with extra spaces */
+    CHECK_EQ(parse("  12   abc  -5 ", "Isi", &args), 0);
+    CHECK_EQ(args.argc, 3);
+    CHECK_EQ(args.num[0], 12);
+    CHECK(strcmp(args.str[0], "12") == 0);
+    CHECK(strcmp(args.str[1], "abc") == 0);
+    CHECK_EQ(args.num[1], 0);
+    CHECK_EQ(args.num[2], -5);
+
+    /* Required and optional */
+    CHECK_EQ(parse("", "I", &args), 1);
+    CHECK_EQ(parse("", "S", &args), 1);
+    CHECK_EQ(parse("", "is", &args), 0);
+    CHECK_EQ(args.argc, 0);
+    CHECK_EQ(parse("3", "Is", &args), 0);
+    CHECK_EQ(args.argc, 1);
+    CHECK_EQ(parse("3", "IS", &args), 2);
+
+    /* Surplus */
+    CHECK_EQ(parse("1 2 3 4", "Iii", &args), 4);
+    CHECK_EQ(parse("a b", "s", &args), 2);
+
+    /* Integers */
+    CHECK_EQ(parse("0x1F", "I", &args), 0);
+    CHECK_EQ(args.num[0], 31);
+    CHECK_EQ(parse("0XfF", "I", &args), 0);
+    CHECK_EQ(args.num[0], 255);
+    CHECK_EQ(parse("-0x10", "I", &args), 0);
+    CHECK_EQ(args.num[0], -16);
+    CHECK_EQ(parse("2147483647", "I", &args), 0);
+    CHECK_EQ(args.num[0], 2147483647);
+    CHECK_EQ(parse("-2147483648", "I", &args), 0);
+    CHECK_EQ(args.num[0], -2147483647 - 1);
+    CHECK_EQ(parse("0", "I", &args), 0);
+    CHECK_EQ(args.num[0], 0);
+    CHECK_EQ(parse("12a", "I", &args), 1);
+    CHECK_EQ(parse("5 x", "Ii", &args), 2);
+    CHECK_EQ(parse("-", "I", &args), 1);
+    CHECK_EQ(parse("0x", "I", &args), 1);
+    CHECK_EQ(parse("0xg", "I", &args), 1);
+    CHECK_EQ(parse("--1", "I", &args), 1);
+    CHECK_EQ(parse("1.5", "i", &args), 1);
+
+    /* A string argument takes anything */
+    CHECK_EQ(parse("0x", "S", &args), 0);
+    CHECK(strcmp(args.str[0], "0x") == 0);
+
+    /* Quotes */
+    CHECK_EQ(parse("\"my net\" pass", "Ss", &args), 0);
+    CHECK_EQ(args.argc, 2);
+    CHECK(strcmp(args.str[0], "my net") == 0);
+    CHECK(strcmp(args.str[1], "pass") == 0);
+    CHECK_EQ(parse("\"\" x", "Ss", &args), 0);
+    CHECK(strcmp(args.str[0], "") == 0);
+    CHECK(strcmp(args.str[1], "x") == 0);
+    CHECK_EQ(parse("a \"b c", "Ss", &args), 0);
+    CHECK(strcmp(args.str[1], "b c") == 0);
+    CHECK_EQ(parse("\"12\"", "I", &args), 0);
+    CHECK_EQ(args.num[0], 12);
+
+    /* As many as there can be */
+    CHECK_EQ(parse("1 2 3 4 5 6", "IIIIII", &args), 0);
+    CHECK_EQ(args.argc, CONSOLE_MAX_ARGS);
+    CHECK_EQ(args.num[5], 6);
+}
+
+/*
+ *  ======== testDispatch ========
+ */
+static void testDispatch(void)
+{
+    Console_Session session;
+
+    reset();
+    Console_open(&session, capture, NULL, true);
+    CHECK(strstr(output, "> ") != NULL);
+    CHECK(Console_findCmd("t") != NULL);
+    CHECK(Console_findCmd("h") != NULL);
+    CHECK(Console_findCmd("nope") == NULL);
+    CHECK(!Console_isUart(&session));
+
+    /* Echoed, run, prompted */
+    reset();
+    type(&session, "t 7 hi 0x10\r");
+    CHECK_EQ(testCalls, 1);
+    CHECK_EQ(testArgc, 3);
+    CHECK_EQ(testNum[0], 7);
+    CHECK(strcmp(testStr[1], "hi") == 0);
+    CHECK_EQ(testNum[2], 16);
+    CHECK(strcmp(output, "t 7 hi 0x10\r\n> ") == 0);
+
+    /* Usage on a bad argument */
+    reset();
+    type(&session, "t\r");
+    CHECK_EQ(testCalls, 0);
+    CHECK(strstr(output, "Bad argument 1. Usage: t <n> [s] [i]") != NULL);
+    reset();
+    type(&session, "t 1 a b\r");
+    CHECK_EQ(testCalls, 0);
+    CHECK(strstr(output, "Bad argument 3.") != NULL);
+
+    /* Help for an unknown command lists the table, this one included */
+    reset();
+    type(&session, "zz\r");
+    CHECK(strstr(output, "Valid Commands") != NULL);
+    CHECK(strstr(output, "t <n> [s] [i]: test command") != NULL);
+    CHECK(strstr(output, "h : help") != NULL);
+
+    /* An empty line only prompts */
+    reset();
+    type(&session, "\r");
+    CHECK(strcmp(output, "\r\n> ") == 0);
+
+    /* CR, LF and CR LF each end one line */
+    reset();
+    type(&session, "t 1\r\nt 2\nt 3\r");
+    CHECK_EQ(testCalls, 3);
+    CHECK_EQ(testNum[0], 3);
+    reset();
+    type(&session, "\r\n\r\n");
+    CHECK(strcmp(output, "\r\n> \r\n> ") == 0);
+
+    /* Backspace and delete */
+    reset();
+    type(&session, "t 12\b3\r");
+    CHECK_EQ(testNum[0], 13);
+    CHECK(strstr(output, "\b \b") != NULL);
+    reset();
+    type(&session, "\b\x7F" "t 45\x7F\x7F" "6\r");
+    CHECK_EQ(testNum[0], 6);
+
+    /* Control characters are dropped, overlong lines are cut */
+    reset();
+    type(&session, "t \x01" "8\x1B\r");
+    CHECK_EQ(testNum[0], 8);
+    reset();
+    Console_input(&session, 't');
+    Console_input(&session, ' ');
+    while (session.lineLen < CONSOLE_LINE_SIZE - 1) {
+        Console_input(&session, '9');
+    }
+    type(&session, "999\b1\r");
+    CHECK_EQ(testCalls, 1);
+    CHECK_EQ(strlen(testStr[0]), CONSOLE_LINE_SIZE - 3);
+    CHECK(testStr[0][CONSOLE_LINE_SIZE - 4] == '1');
+
+    /* No echo */
+    Console_attach(&session, capture, NULL, false);
+    reset();
+    type(&session, "t 5\r");
+    CHECK_EQ(testNum[0], 5);
+    CHECK(strcmp(output, "> ") == 0);
+
+    /* A line function takes the line instead */
+    session.lineFxn = lineTaken;
+    reset();
+    type(&session, "t 9\r");
+    CHECK_EQ(testCalls, 0);
+    CHECK_EQ(lineCalls, 1);
+    CHECK(strcmp(lineSeen, "t 9") == 0);
+    CHECK(strcmp(output, "") == 0);
+    session.lineFxn = NULL;
+
+    /* Quit: no prompt after it */
+    reset();
+    type(&session, "q\r");
+    CHECK(session.closeRequested);
+    CHECK(strcmp(output, "Bye!\r\n") == 0);
+}
+
+/*
+ *  ======== testTelnet ========
+ */
+static void testTelnet(void)
+{
+    static const uint8_t negotiate[] = {
+        TELNET_IAC, TELNET_WILL, 1, TELNET_IAC, TELNET_DO, 3
+    };
+    static const uint8_t subneg[] = {
+        TELNET_IAC, TELNET_SB, 24, 0, 'x', 't', TELNET_IAC, TELNET_IAC,
+        '\r', TELNET_IAC, TELNET_SE
+    };
+    static const uint8_t nop[] = {TELNET_IAC, TELNET_NOP};
+    static const uint8_t escaped[] = {TELNET_IAC, TELNET_IAC};
+    Console_Session      session;
+
+    Console_attach(&session, capture, NULL, false);
+
+    /* Negotiation in the middle of a line */
+    reset();
+    type(&session, "t 4");
+    typeBytes(&session, negotiate, sizeof(negotiate));
+    type(&session, "2\r");
+    CHECK_EQ(testCalls, 1);
+    CHECK_EQ(testNum[0], 42);
+    CHECK_EQ(session.telnetState, 0);
+
+    /* A subnegotiation with a CR and an escaped IAC in it */
+    reset();
+    type(&session, "t 1");
+    typeBytes(&session, subneg, sizeof(subneg));
+    type(&session, "7\r");
+    CHECK_EQ(testCalls, 1);
+    CHECK_EQ(testNum[0], 17);
+    CHECK_EQ(session.telnetState, 0);
+
+    /* A command without an option, and an escaped 0xFF data byte */
+    reset();
+    type(&session, "t 3");
+    typeBytes(&session, nop, sizeof(nop));
+    typeBytes(&session, escaped, sizeof(escaped));
+    type(&session, "3\r");
+    CHECK_EQ(testCalls, 1);
+    CHECK_EQ(testNum[0], 33);
+    CHECK_EQ(session.telnetState, 0);
+
+    /* Raw clients with no telnet in them are unaffected */
+    reset();
+    type(&session, "t 8 raw\r");
+    CHECK_EQ(testCalls, 1);
+    CHECK(strcmp(testStr[1], "raw") == 0);
+}
+
+/*
+ *  ======== testWifi ========
+ *  The Wi-Fi commands, through the dispatcher.
+ */
+static void testWifi(void)
+{
+    Console_Session session;
+
+    Console_attach(&session, capture, NULL, false);
+
+    reset();
+    type(&session, "c \"my net\" secret\r");
+    CHECK(strcmp(connectSsid, "my net") == 0);
+    CHECK_EQ(connectType, SL_WLAN_SEC_TYPE_WPA_WPA2);
+    CHECK(strcmp(connectKey, "secret") == 0);
+    CHECK(strstr(output, "Wifi Connected to my net") != NULL);
+
+    reset();
+    type(&session, "c cafe\r");
+    CHECK(strcmp(connectSsid, "cafe") == 0);
+    CHECK_EQ(connectType, SL_WLAN_SEC_TYPE_OPEN);
+
+    reset();
+    type(&session, "s\r");
+    CHECK(strstr(output, "WLAN connected to: cafe") != NULL);
+    CHECK(strstr(output, "DHCP is ON IP 192.168.1.20 MASK 255.255.255.0 "
+            "GW 192.168.1.1 DNS 192.168.1.1") != NULL);
+
+    reset();
+    type(&session, "l\r");
+    CHECK(strstr(output, "Scanning, press l again") != NULL);
+    CHECK_EQ(scanRequests, 1);
+}
+
+/*
+ *  ======== sl_WlanConnect ========
+ */
+_i16 sl_WlanConnect(const _i8 *name, const _i16 nameLen, const _u8 *macAddr,
+        const SlWlanSecParams_t *secParams,
+        const SlWlanSecParamsExt_t *secExtParams)
+{
+    snprintf(connectSsid, sizeof(connectSsid), "%.*s", nameLen,
+            (const char *)name);
+    connectType = secParams->Type;
+    snprintf(connectKey, sizeof(connectKey), "%.*s", secParams->KeyLen,
+            (secParams->Key != NULL) ? (const char *)secParams->Key : "");
+
+    return (0);
+}
+
+/*
+ *  ======== sl_WlanGet ========
+ */
+_i16 sl_WlanGet(const _u16 configId, _u16 *configOpt, _u16 *configLen,
+        _u8 *values)
+{
+    SlWlanConnStatusParam_t *status = (SlWlanConnStatusParam_t *)values;
+
+    if (configId == SL_WLAN_CONNECTION_INFO) {
+        status->ConnectionInfo.StaConnect.SsidLen = strlen(connectSsid);
+        memcpy(status->ConnectionInfo.StaConnect.SsidName, connectSsid,
+                strlen(connectSsid));
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== sl_NetCfgGet ========
+ */
+_i16 sl_NetCfgGet(const _u16 configId, _u16 *configOpt, _u16 *configLen,
+        _u8 *values)
+{
+    SlNetCfgIpV4Args_t *ipV4 = (SlNetCfgIpV4Args_t *)values;
+
+    *configOpt = SL_NETCFG_ADDR_DHCP;
+    ipV4->Ip = 0xC0A80114;
+    ipV4->IpMask = 0xFFFFFF00;
+    ipV4->IpGateway = 0xC0A80101;
+    ipV4->IpDnsServer = 0xC0A80101;
+
+    return (0);
+}
+
+/*
+ *  ======== WifiScan_count ========
+ */
+int WifiScan_count(uint32_t *ageMs)
+{
+    *ageMs = UINT32_MAX;
+
+    return (0);
+}
+
+bool WifiScan_busy(void)
+{
+    return (false);
+}
+
+void WifiScan_request(void)
+{
+    scanRequests++;
+}
+
+bool WifiScan_get(int index, WifiScan_Entry *entry)
+{
+    return (false);
+}
+
+/*
+ *  ======== UartIo_write ========
+ *  The UART transport is not exercised here.
+ */
+void UartIo_write(const void *buf, size_t len)
+{
+}
+
+char UartIo_readChar(void)
+{
+    return ('\0');
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    testParse();
+    testDispatch();
+    testTelnet();
+    testWifi();
+
+    return (CHECK_DONE("console"));
+}
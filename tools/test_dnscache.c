@@ -0,0 +1,325 @@
+/*
+ *  ======== test_dnscache.c ========
+ *  Host test of dnscache.c against the stand-in DNS responder of
+ *  hostnet.c: fresh hits without traffic, stale entries served while
+ *  they are refreshed, failed lookups keeping the old address,
+ *  invalidation, eviction, and the server address carried across
+ *  hibernate.
+ *
+ *  The cache has no reset, so the boot before a hibernate runs in a
+ *  forked child; the hibernate record it leaves is handed back through
+ *  a pipe to this process, which then plays the wake-up. The other
+ *  wake-ups are played in children forked before the cache is used.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ti/net/slnetutils.h>
+
+#include "dnscache.h"
+#include "hibernate.h"
+#include "host/host.h"
+#include "host/hostnet.h"
+
+#include "check.h"
+
+#define SERVER          "reports.example.com"
+#define OTHER           "config.example.com"
+
+#define ADDR_1          (0x0A000001)
+#define ADDR_2          (0x0A000002)
+#define ADDR_3          (0x0A000003)
+
+#define MINUTE_US       (60ULL * 1000 * 1000)
+
+/*
+ *  ======== resolve ========
+ *  Host order address, or 0 if the resolve failed.
+ */
+static uint32_t resolve(const char *host)
+{
+    SlNetSock_AddrIn_t addr;
+
+    memset(&addr, 0, sizeof(addr));
+    if (DnsCache_resolve(host, &addr) < 0) {
+        return (0);
+    }
+
+    return (SlNetUtil_ntohl(addr.sin_addr.s_addr));
+}
+
+/*
+ *  ======== lookups ========
+ */
+static uint32_t lookups(void)
+{
+    HostNet_Stats s;
+
+    HostNet_getStats(&s);
+
+    return (s.lookups);
+}
+
+/*
+ *  ======== previousBoot ========
+ *  Runs in the child: resolve the server once, then hibernate.
+ */
+static void previousBoot(int fd)
+{
+    Host_wake(Hibernate_Wake_COLD);
+    HostNet_addHost(SERVER, ADDR_1);
+    if (resolve(SERVER) == ADDR_1) {
+        Hibernate_request(15 * 60 * 1000);
+        if (write(fd, &hibernateState, sizeof(hibernateState)) !=
+                (ssize_t)sizeof(hibernateState)) {
+            _exit(1);
+        }
+    }
+    _exit(0);
+}
+
+/*
+ *  ======== fallAsleep ========
+ *  The boot before the wake-up, in a child; this process gets the
+ *  hibernate record it leaves.
+ */
+static void fallAsleep(void)
+{
+    int   fds[2];
+    pid_t pid;
+    int   status;
+
+    CHECK(pipe(fds) == 0);
+    pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        previousBoot(fds[1]);
+    }
+    close(fds[1]);
+    CHECK_EQ(read(fds[0], &hibernateState, sizeof(hibernateState)),
+            sizeof(hibernateState));
+    close(fds[0]);
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+    CHECK(hibernateState.serverAddr != 0);
+}
+
+/*
+ *  ======== wakeOther ========
+ *  In a child with an unused cache: wake up as how, with the saved
+ *  host hash changed by flip. Exits 0 if the server was looked up
+ *  rather than taken from the record.
+ */
+static void wakeOther(Hibernate_Wake how, uint32_t flip)
+{
+    hibernateState.serverHash ^= flip;
+    Host_wake(how);
+    DnsCache_restore();
+    HostNet_addHost(SERVER, ADDR_2);
+    HostNet_resetStats();
+    _exit(((resolve(SERVER) == ADDR_2) && (lookups() == 1)) ? 0 : 1);
+}
+
+/*
+ *  ======== testMismatch ========
+ *  A saved address is only used for the host it was saved for, and
+ *  not after a cold boot. Run before this process uses the cache.
+ */
+static void testMismatch(void)
+{
+    pid_t pid;
+    int   status;
+
+    pid = fork();
+    if (pid == 0) {
+        wakeOther(Hibernate_Wake_TIMER, 1);
+    }
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+    pid = fork();
+    if (pid == 0) {
+        wakeOther(Hibernate_Wake_COLD, 0);
+    }
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+    /* The same, from the record as saved, is taken without a lookup */
+    pid = fork();
+    if (pid == 0) {
+        Host_wake(Hibernate_Wake_TIMER);
+        DnsCache_restore();
+        HostNet_resetStats();
+        _exit(((resolve(SERVER) == ADDR_1) && (lookups() == 0)) ? 0 : 1);
+    }
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
+
+/*
+ *  ======== testWake ========
+ *  The first resolves after the wake-up, on a cache with nothing in it
+ *  but what DnsCache_restore() brought back.
+ */
+static void testWake(void)
+{
+    DnsCache_Stats s;
+
+    Host_wake(Hibernate_Wake_TIMER);
+    DnsCache_restore();
+
+    /* The server moved while asleep, and the DNS is down for now */
+    HostNet_addHost(SERVER, ADDR_2);
+    HostNet_addHost(OTHER, ADDR_3);
+    HostNet_failLookups(1);
+    HostNet_resetStats();
+
+    /* Another host first: looked up, and the saved address is kept */
+    CHECK_EQ(resolve(OTHER), 0);
+    CHECK_EQ(resolve(OTHER), ADDR_3);
+    CHECK_EQ(lookups(), 2);
+
+    /* The saved address is served at once, as stale */
+    CHECK_EQ(resolve(SERVER), ADDR_1);
+    CHECK_EQ(lookups(), 2);
+    DnsCache_getStats(&s);
+    CHECK_EQ(s.stale, 1);
+    CHECK_EQ(s.misses, 2);
+
+    /* The refresh moves it on, and notes it for the next hibernate */
+    DnsCache_refresh();
+    CHECK_EQ(lookups(), 3);
+    CHECK_EQ(resolve(SERVER), ADDR_2);
+    CHECK_EQ(SlNetUtil_ntohl(hibernateState.serverAddr), ADDR_2);
+    DnsCache_getStats(&s);
+    CHECK_EQ(s.refreshes, 1);
+    CHECK_EQ(s.hits, 1);
+}
+
+/*
+ *  ======== testTtl ========
+ */
+static void testTtl(void)
+{
+    DnsCache_Stats before;
+    DnsCache_Stats s;
+
+    DnsCache_getStats(&before);
+    HostNet_resetStats();
+
+    /* Fresh for the whole TTL, without traffic */
+    Host_advanceUs((uint64_t)DNSCACHE_TTL_MS * 1000 - MINUTE_US);
+    CHECK_EQ(resolve(SERVER), ADDR_2);
+    CHECK_EQ(lookups(), 0);
+
+    /* Expired: still served at once, looked up only on refresh */
+    Host_advanceUs(MINUTE_US);
+    HostNet_addHost(SERVER, ADDR_3);
+    CHECK_EQ(resolve(SERVER), ADDR_2);
+    CHECK_EQ(lookups(), 0);
+
+    /* A failed refresh keeps the old address */
+    HostNet_failLookups(1);
+    DnsCache_refresh();
+    CHECK_EQ(lookups(), 1);
+    CHECK_EQ(resolve(SERVER), ADDR_2);
+
+    /* Nothing pending: a refresh is free */
+    DnsCache_refresh();
+    DnsCache_refresh();
+    CHECK_EQ(lookups(), 2);
+    CHECK_EQ(resolve(SERVER), ADDR_3);
+
+    DnsCache_getStats(&s);
+    CHECK_EQ(s.hits - before.hits, 2);
+    CHECK_EQ(s.stale - before.stale, 2);
+    CHECK_EQ(s.refreshes - before.refreshes, 1);
+    CHECK_EQ(s.failures - before.failures, 1);
+    CHECK_EQ(s.misses - before.misses, 0);
+}
+
+/*
+ *  ======== testInvalidate ========
+ */
+static void testInvalidate(void)
+{
+    HostNet_resetStats();
+
+    /* Looked up again on the next resolve */
+    DnsCache_invalidate(SERVER);
+    HostNet_addHost(SERVER, ADDR_1);
+    CHECK_EQ(resolve(SERVER), ADDR_1);
+    CHECK_EQ(lookups(), 1);
+
+    /* And with the DNS down there is no address at all */
+    DnsCache_invalidate(SERVER);
+    HostNet_failLookups(1);
+    CHECK_EQ(resolve(SERVER), 0);
+    CHECK_EQ(resolve(SERVER), ADDR_1);
+    CHECK_EQ(lookups(), 3);
+
+    /* Unknown names fail, and are not cached */
+    CHECK_EQ(resolve("nowhere.example.com"), 0);
+    CHECK_EQ(resolve("nowhere.example.com"), 0);
+    CHECK_EQ(lookups(), 5);
+
+    /* Invalidating a name never seen is harmless */
+    DnsCache_invalidate("nowhere.example.com");
+}
+
+/*
+ *  ======== testEviction ========
+ *  One more host than entries: the least recently resolved goes.
+ */
+static void testEviction(void)
+{
+    char name[DNSCACHE_ENTRIES + 1][32];
+    int  i;
+
+    HostNet_clearHosts();
+    for (i = 0; i <= DNSCACHE_ENTRIES; i++) {
+        snprintf(name[i], sizeof(name[i]), "host%d.example.com", i);
+        HostNet_addHost(name[i], ADDR_1 + i);
+    }
+
+    HostNet_resetStats();
+    for (i = 0; i < DNSCACHE_ENTRIES; i++) {
+        Host_advanceUs(MINUTE_US);
+        CHECK_EQ(resolve(name[i]), ADDR_1 + i);
+    }
+    CHECK_EQ(lookups(), DNSCACHE_ENTRIES);
+
+    Host_advanceUs(MINUTE_US);
+    CHECK_EQ(resolve(name[DNSCACHE_ENTRIES]), ADDR_1 + DNSCACHE_ENTRIES);
+    CHECK_EQ(lookups(), DNSCACHE_ENTRIES + 1);
+
+    /* The rest are still there */
+    for (i = 1; i <= DNSCACHE_ENTRIES; i++) {
+        CHECK_EQ(resolve(name[i]), ADDR_1 + i);
+    }
+    CHECK_EQ(lookups(), DNSCACHE_ENTRIES + 1);
+    CHECK_EQ(resolve(name[0]), ADDR_1);
+    CHECK_EQ(lookups(), DNSCACHE_ENTRIES + 2);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    Host_setClockUs(1000 * 1000);
+
+    fallAsleep();
+    testMismatch();
+    testWake();
+    testTtl();
+    testInvalidate();
+    testEviction();
+
+    return (CHECK_DONE("dnscache"));
+}
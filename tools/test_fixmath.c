@@ -0,0 +1,84 @@
+/*
+ *  ======== test_fixmath.c ========
+ *  Host test of fixmath.c: FixMath_isqrt() is floor(sqrt(x)) for every
+ *  x below 2^22, around every square at the ends of the range, and for
+ *  random 64-bit values.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "fixmath.h"
+
+#include "check.h"
+
+/*
+ *  ======== isRoot ========
+ *  r == floor(sqrt(x)), without overflowing on the largest r.
+ */
+static bool isRoot(uint64_t x, uint32_t r)
+{
+    uint64_t next = (uint64_t)r + 1;
+
+    if ((uint64_t)r * r > x) {
+        return (false);
+    }
+
+    return ((r == UINT32_MAX) || (next * next > x));
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    uint64_t x;
+    uint64_t random64 = 0x9E3779B97F4A7C15ULL;
+    uint32_t r;
+    uint32_t fails = 0;
+    int      i;
+
+    /* Exhaustive at the low end, counted as one check */
+    for (x = 0; x < (1 << 22); x++) {
+        if (!isRoot(x, FixMath_isqrt(x))) {
+            fails++;
+        }
+    }
+    CHECK_EQ(fails, 0);
+
+    CHECK_EQ(FixMath_isqrt(0), 0);
+    CHECK_EQ(FixMath_isqrt(1), 1);
+    CHECK_EQ(FixMath_isqrt(UINT64_MAX), UINT32_MAX);
+    CHECK_EQ(FixMath_isqrt((uint64_t)UINT32_MAX * UINT32_MAX), UINT32_MAX);
+    CHECK_EQ(FixMath_isqrt((uint64_t)UINT32_MAX * UINT32_MAX - 1),
+            UINT32_MAX - 1);
+    CHECK_EQ(FixMath_isqrt((uint64_t)1 << 62), 1U << 31);
+    CHECK_EQ(FixMath_isqrt(((uint64_t)1 << 62) - 1), (1U << 31) - 1);
+
+    /* Either side of squares at the top and bottom of the range */
+    for (i = 0; i < 4096; i++) {
+        r = (i < 2048) ? (uint32_t)(i + 2) : UINT32_MAX - (uint32_t)(i - 2048);
+        x = (uint64_t)r * r;
+        CHECK_EQ(FixMath_isqrt(x), r);
+        CHECK_EQ(FixMath_isqrt(x - 1), r - 1);
+        if (r != UINT32_MAX) {
+            CHECK_EQ(FixMath_isqrt(x + 2ULL * r), r);
+        }
+    }
+
+    /* Random values of every magnitude */
+    fails = 0;
+    for (i = 0; i < 1000000; i++) {
+        random64 ^= random64 << 13;
+        random64 ^= random64 >> 7;
+        random64 ^= random64 << 17;
+        x = random64 >> (i % 64);
+        if (!isRoot(x, FixMath_isqrt(x))) {
+            fails++;
+        }
+    }
+    CHECK_EQ(fails, 0);
+
+    return (CHECK_DONE("fixmath"));
+}
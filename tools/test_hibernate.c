@@ -0,0 +1,469 @@
+/*
+ *  ======== test_hibernate.c ========
+ *  Host model of the hibernate cycle in hibernate.c: the state saved to
+ *  the NWP file system and the sequence number in the retention
+ *  registers on the way down, and the checks that decide on the way up
+ *  whether the saved state is restored.
+ *
+ *  This file plays the hardware: the reset and wake-up cause, the OCR
+ *  registers (kept across hibernate, cleared at power-up) and the
+ *  shutdown, which jumps back out of the hibernate task the way the
+ *  device powers off. SRAM is scribbled over at every boot, so what
+ *  comes back can only have come from the file.
+ */
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ti/devices/cc32xx/driverlib/prcm.h>
+#include <ti/drivers/Power.h>
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "alarms.h"
+#include "boot.h"
+#include "hibernate.h"
+#include "host/host.h"
+#include "netsched.h"
+#include "totalizer.h"
+
+#include "check.h"
+
+#define OCR_REGISTERS   (4)
+
+static unsigned long    resetCause;
+static unsigned long    wakeCause;
+static unsigned long    ocr[OCR_REGISTERS];
+
+static jmp_buf          powerOff;
+static bool             refuseShutdown;
+static uint32_t         shutdownMs;
+static int              nwpStops;
+static int              nwpStarts;
+static int              persists;
+static uint32_t         toIpMs;
+
+static NetSched_Task   *hibernateTask;
+
+/*
+ *  ======== boot ========
+ *  Start over as the device does after a reset of the given cause.
+ */
+static Hibernate_Wake boot(unsigned long cause, unsigned long wakeUp)
+{
+    Hibernate_Wake how;
+
+    resetCause = cause;
+    wakeCause = wakeUp;
+    if (cause == PRCM_POWER_ON) {
+        memset(ocr, 0, sizeof(ocr));
+    }
+    memset(&hibernateState, 0xA5, sizeof(hibernateState));
+    hibernateTask = NULL;
+    persists = 0;
+
+    how = Hibernate_init();
+    Hibernate_restore();
+    Hibernate_start();
+
+    return (how);
+}
+
+/*
+ *  ======== hibernate ========
+ *  Request sleepMs and run the hibernate task.
+ *
+ *  @return true if the device powered off
+ */
+static bool hibernate(uint32_t sleepMs)
+{
+    Hibernate_request(sleepMs);
+    if (setjmp(powerOff) == 0) {
+        hibernateTask->fxn(hibernateTask);
+        return (false);
+    }
+
+    return (true);
+}
+
+/*
+ *  ======== fill ========
+ *  Note a recognizable value in every part of the state.
+ */
+static void fill(uint32_t salt)
+{
+    Hibernate_Clock    clock;
+    Hibernate_Alarms   alarms;
+    Hibernate_Schedule schedule;
+    uint8_t            bssid[6];
+    int                i;
+
+    for (i = 0; i < 6; i++) {
+        bssid[i] = (uint8_t)(salt + i);
+    }
+    Hibernate_noteAp(bssid);
+    Hibernate_noteServer(0x1000 + salt, 0x0A000000 + salt);
+
+    clock.baseMonoUs = 123456789012ULL + salt;
+    clock.baseUtcUs = 1700000000000000LL + salt;
+    clock.freqPpb = -4200 - (int32_t)salt;
+    clock.slewUs = 310 + (int32_t)salt;
+    Hibernate_noteClock(&clock);
+
+    memset(&alarms, 0, sizeof(alarms));
+    alarms.activeMask = 0x5 ^ salt;
+    alarms.pendingMask = 0x2;
+    for (i = 0; i < HIBERNATE_MAX_RULES; i++) {
+        alarms.heldMs[i] = 1000 * i + salt;
+    }
+    Hibernate_noteAlarms(&alarms);
+
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.monoMs = 50000 + salt;
+    schedule.routineInMs = 3600000 - salt;
+    schedule.pollInMs = 600000;
+    schedule.retryInMs = 30000;
+    schedule.deviceHash = 0xDEADBEEF ^ salt;
+    schedule.random = 0x12345678 + salt;
+    schedule.urgentFailures = 2;
+    schedule.identified = 1;
+    schedule.urgentPending = 1;
+    Hibernate_noteSchedule(&schedule);
+}
+
+/*
+ *  ======== checkFilled ========
+ *  What fill(salt) noted must be what the last* calls give back.
+ */
+static void checkFilled(uint32_t salt)
+{
+    Hibernate_Clock    clock;
+    Hibernate_Alarms   alarms;
+    Hibernate_Schedule schedule;
+    uint8_t            bssid[6];
+    uint32_t           hash;
+    uint32_t           addr;
+    int                i;
+
+    CHECK(Hibernate_lastAp(bssid));
+    for (i = 0; i < 6; i++) {
+        CHECK_EQ(bssid[i], (uint8_t)(salt + i));
+    }
+    CHECK(Hibernate_lastServer(&hash, &addr));
+    CHECK_EQ(hash, 0x1000 + salt);
+    CHECK_EQ(addr, 0x0A000000 + salt);
+
+    CHECK(Hibernate_lastClock(&clock));
+    CHECK(clock.baseMonoUs == 123456789012ULL + salt);
+    CHECK(clock.baseUtcUs == 1700000000000000LL + salt);
+    CHECK_EQ(clock.freqPpb, -4200 - (int32_t)salt);
+    CHECK_EQ(clock.slewUs, 310 + (int32_t)salt);
+
+    CHECK(Hibernate_lastAlarms(&alarms));
+    CHECK_EQ(alarms.activeMask, 0x5 ^ salt);
+    CHECK_EQ(alarms.pendingMask, 0x2);
+    for (i = 0; i < HIBERNATE_MAX_RULES; i++) {
+        CHECK_EQ(alarms.heldMs[i], 1000 * i + salt);
+    }
+
+    CHECK(Hibernate_lastSchedule(&schedule));
+    CHECK_EQ(schedule.monoMs, 50000 + salt);
+    CHECK_EQ(schedule.routineInMs, 3600000 - salt);
+    CHECK_EQ(schedule.pollInMs, 600000);
+    CHECK_EQ(schedule.retryInMs, 30000);
+    CHECK_EQ(schedule.deviceHash, 0xDEADBEEF ^ salt);
+    CHECK_EQ(schedule.random, 0x12345678 + salt);
+    CHECK_EQ(schedule.urgentFailures, 2);
+    CHECK_EQ(schedule.identified, 1);
+    CHECK_EQ(schedule.urgentPending, 1);
+}
+
+/*
+ *  ======== checkCold ========
+ *  Nothing from before is handed out.
+ */
+static void checkCold(void)
+{
+    Hibernate_Clock    clock;
+    Hibernate_Alarms   alarms;
+    Hibernate_Schedule schedule;
+    uint8_t            bssid[6];
+    uint32_t           hash;
+    uint32_t           addr;
+
+    CHECK_EQ(Hibernate_wake(), Hibernate_Wake_COLD);
+    CHECK(!Hibernate_lastAp(bssid));
+    CHECK(!Hibernate_lastServer(&hash, &addr));
+    CHECK(!Hibernate_lastClock(&clock));
+    CHECK(!Hibernate_lastAlarms(&alarms));
+    CHECK(!Hibernate_lastSchedule(&schedule));
+    CHECK_EQ(hibernateState.wakeCount, 0);
+}
+
+/*
+ *  ======== testCycle ========
+ *  Cold boot, then three hibernate cycles woken by the RTC and the
+ *  pulse input.
+ */
+static void testCycle(void)
+{
+    CHECK_EQ(boot(PRCM_POWER_ON, 0), Hibernate_Wake_COLD);
+    CHECK(!Hibernate_restore());
+    checkCold();
+
+    fill(1);
+    toIpMs = 2500;
+    CHECK(hibernate(15 * 60 * 1000));
+    CHECK_EQ(shutdownMs, 15 * 60 * 1000);
+    CHECK_EQ(nwpStops, 1);
+    CHECK_EQ(persists, 2);
+    CHECK_EQ(ocr[HIBERNATE_OCR_MAGIC_INDEX], HIBERNATE_OCR_MAGIC);
+    CHECK_EQ(ocr[HIBERNATE_OCR_SEQ_INDEX], 1);
+
+    /* RTC wake-up: all of it back */
+    CHECK_EQ(boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK),
+            Hibernate_Wake_TIMER);
+    CHECK_EQ(Hibernate_wake(), Hibernate_Wake_TIMER);
+    CHECK_EQ(ocr[HIBERNATE_OCR_MAGIC_INDEX], 0);
+    checkFilled(1);
+    CHECK_EQ(hibernateState.wakeCount, 1);
+    CHECK_EQ(hibernateState.sleepMs, 15 * 60 * 1000);
+    CHECK_EQ(hibernateState.coldToIpMs, 2500);
+    CHECK_EQ(hibernateState.warmToIpMs, 0);
+
+    /* A warm boot times the warm path and keeps the cold one */
+    fill(2);
+    toIpMs = 700;
+    CHECK(hibernate(60 * 60 * 1000));
+    CHECK_EQ(ocr[HIBERNATE_OCR_SEQ_INDEX], 2);
+
+    /* Woken by flow */
+    CHECK_EQ(boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_GPIO),
+            Hibernate_Wake_GPIO);
+    checkFilled(2);
+    CHECK_EQ(hibernateState.wakeCount, 2);
+    CHECK_EQ(hibernateState.sleepMs, 60 * 60 * 1000);
+    CHECK_EQ(hibernateState.coldToIpMs, 2500);
+    CHECK_EQ(hibernateState.warmToIpMs, 700);
+
+    /* No time to IP this boot: the last ones stand */
+    toIpMs = 0;
+    CHECK(hibernate(1000));
+    CHECK_EQ(boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK),
+            Hibernate_Wake_TIMER);
+    CHECK_EQ(hibernateState.wakeCount, 3);
+    CHECK_EQ(hibernateState.warmToIpMs, 700);
+}
+
+/*
+ *  ======== testStale ========
+ *  A file the OCR sequence number does not vouch for is not restored.
+ */
+static void testStale(void)
+{
+    static Hibernate_State old;
+
+    /* Keep the file of one cycle, then put it back after the next */
+    fill(3);
+    CHECK(hibernate(1000));
+    old = hibernateState;
+    CHECK_EQ(boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK),
+            Hibernate_Wake_TIMER);
+    fill(4);
+    CHECK(hibernate(1000));
+    Host_setFile(HIBERNATE_FILE_NAME, &old, sizeof(old));
+    CHECK_EQ(boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK),
+            Hibernate_Wake_TIMER);
+    checkCold();
+
+    /* Missing */
+    CHECK(hibernate(1000));
+    Host_clearFiles();
+    boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK);
+    checkCold();
+
+    /* Short, as from an older build with a smaller state */
+    fill(5);
+    CHECK(hibernate(1000));
+    old = hibernateState;
+    Host_setFile(HIBERNATE_FILE_NAME, &old, sizeof(old) - 4);
+    boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK);
+    checkCold();
+
+    /* Unreadable */
+    fill(6);
+    CHECK(hibernate(1000));
+    Host_failFs(1);
+    boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_GPIO);
+    checkCold();
+}
+
+/*
+ *  ======== testCold ========
+ *  Resets and power-ups after a hibernate are cold boots.
+ */
+static void testCold(void)
+{
+    /* Power lost while asleep: the OCR registers are gone */
+    fill(7);
+    CHECK(hibernate(1000));
+    CHECK_EQ(boot(PRCM_POWER_ON, 0), Hibernate_Wake_COLD);
+    checkCold();
+
+    /* A watchdog reset with the registers and the file still there */
+    fill(8);
+    CHECK(hibernate(1000));
+    CHECK_EQ(boot(PRCM_WDT_RESET, 0), Hibernate_Wake_COLD);
+    checkCold();
+
+    /* A reset after a restore: the magic was cleared at the wake-up */
+    fill(9);
+    CHECK(hibernate(1000));
+    CHECK_EQ(boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK),
+            Hibernate_Wake_TIMER);
+    checkFilled(9);
+    CHECK_EQ(boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK),
+            Hibernate_Wake_COLD);
+    checkCold();
+}
+
+/*
+ *  ======== testFailures ========
+ *  A save that fails or a shutdown that is refused leave no wake-up
+ *  behind that would restore.
+ */
+static void testFailures(void)
+{
+    int starts;
+
+    /* The file cannot be written: the registers are not armed */
+    fill(10);
+    Host_failFs(1);
+    CHECK(hibernate(1000));
+    CHECK_EQ(ocr[HIBERNATE_OCR_MAGIC_INDEX], 0);
+    boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK);
+    checkCold();
+
+    /* Refused: disarmed, the NWP restarted and the task waits again */
+    fill(11);
+    starts = nwpStarts;
+    refuseShutdown = true;
+    CHECK(!hibernate(1000));
+    refuseShutdown = false;
+    CHECK_EQ(ocr[HIBERNATE_OCR_MAGIC_INDEX], 0);
+    CHECK_EQ(nwpStarts, starts + 1);
+    CHECK(hibernate(2000));
+    CHECK_EQ(shutdownMs, 2000);
+    CHECK_EQ(boot(PRCM_HIB_EXIT, PRCM_HIB_WAKEUP_CAUSE_SLOW_CLOCK),
+            Hibernate_Wake_TIMER);
+    checkFilled(11);
+}
+
+/*
+ *  ======== PRCMSysResetCauseGet ========
+ */
+unsigned long PRCMSysResetCauseGet(void)
+{
+    return (resetCause);
+}
+
+unsigned long PRCMHibernateWakeupCauseGet(void)
+{
+    return (wakeCause);
+}
+
+void PRCMOCRRegisterWrite(unsigned char index, unsigned long regValue)
+{
+    ocr[index] = regValue;
+}
+
+unsigned long PRCMOCRRegisterRead(unsigned char index)
+{
+    return (ocr[index]);
+}
+
+/*
+ *  ======== Power_shutdown ========
+ */
+int_fast16_t Power_shutdown(uint_fast16_t shutdownState,
+        uint_fast32_t shutdownTime)
+{
+    shutdownMs = shutdownTime;
+    if (refuseShutdown) {
+        return (-1);
+    }
+    longjmp(powerOff, 1);
+}
+
+_i16 sl_Start(const void *ifHdl, _i8 *devName, const void *initCallBack)
+{
+    nwpStarts++;
+
+    return (0);
+}
+
+_i16 sl_Stop(const _u16 timeout)
+{
+    nwpStops++;
+
+    return (0);
+}
+
+/*
+ *  ======== Alarms_persist ========
+ */
+void Alarms_persist(void)
+{
+    persists++;
+}
+
+int32_t Totalizer_save(void)
+{
+    persists++;
+
+    return (0);
+}
+
+bool Boot_elapsedMs(Boot_Phase phase, uint32_t *ms)
+{
+    *ms = toIpMs;
+
+    return (toIpMs != 0);
+}
+
+/*
+ *  ======== NetSched_start ========
+ *  The hibernate task is the only one; hibernate() runs it.
+ */
+int NetSched_start(NetSched_Task *task, NetSched_TaskFxn fxn, void *arg)
+{
+    PT_INIT(&task->pt);
+    task->fxn = fxn;
+    task->arg = arg;
+    task->events = 0;
+    hibernateTask = task;
+
+    return (0);
+}
+
+void NetSched_signal(uint32_t events)
+{
+    if (hibernateTask != NULL) {
+        hibernateTask->events |= events;
+    }
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    testCycle();
+    testStale();
+    testCold();
+    testFailures();
+
+    return (CHECK_DONE("hibernate"));
+}
@@ -0,0 +1,719 @@
+/*
+ *  ======== test_netsched.c ========
+ *  Host simulation of netsched.c running dozens of transfers at once.
+ *
+ *  netSchedThread runs in its own thread, as on the device, against a
+ *  simulated peer behind the SlNetSock calls: connects take
+ *  TEST_CONNECT_MS, sends take at most TEST_SEND_CHUNK bytes and are
+ *  refused every other call, and the answer comes TEST_RESPONSE_MS
+ *  after the last byte of the request, a few bytes per recv. Every
+ *  transfer is one NetSched_Task, and all of them must be in flight
+ *  together on the one thread.
+ *
+ *  Also checked: restarting tasks as soon as they end, which is raced
+ *  from this thread against the scheduler clearing them, latched
+ *  events and timeouts, and that a socket wait polls at
+ *  NETSCHED_POLL_PERIOD_MS and an idle scheduler does not poll at all.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "netsched.h"
+#include "supervisor.h"
+
+#include "check.h"
+
+#define TEST_TRANSFERS          (48)
+#define TEST_SOCKETS            (64)
+#define TEST_MAX_REQUEST        (2048)
+#define TEST_CONNECT_MS         (40)
+#define TEST_RESPONSE_MS        (60)
+#define TEST_SEND_CHUNK         (256)
+#define TEST_RECV_CHUNK         (5)
+#define TEST_HAMMER_RUNS        (2000)
+
+/*
+ *  The simulated far end of one socket. The request starts with its
+ *  length, 16 bits little endian; the answer is "OK <length> <sum>".
+ */
+typedef struct Peer {
+    bool        open;
+    bool        nonBlocking;
+    bool        connected;
+    bool        refuse;             /* the next send is refused */
+    uint32_t    connectAt;          /* ms, 0 until connect is called */
+    uint32_t    respondAt;          /* ms, 0 until the request is in */
+    uint32_t    responseMs;
+    uint32_t    length;
+    uint32_t    got;
+    uint32_t    sum;
+    uint32_t    recvWaits;          /* recvs answered EAGAIN */
+    char        response[32];
+    uint32_t    responseLen;
+    uint32_t    responsePos;
+} Peer;
+
+typedef struct Transfer {
+    NetSched_Task   task;
+    int16_t         sd;
+    int32_t         ret;
+    int32_t         error;          /* first failure, 0 for none */
+    uint32_t        length;
+    uint32_t        sent;
+    uint32_t        received;
+    uint32_t        startMs;
+    uint32_t        endMs;
+    uint8_t         request[TEST_MAX_REQUEST];
+    char            rx[32];
+} Transfer;
+
+typedef struct Waiter {
+    NetSched_Task   task;
+    uint32_t        events[2];
+    uint32_t        wokeMs[3];
+} Waiter;
+
+static pthread_t          schedThread;
+static sem_t              doneSem;
+static Peer               peers[TEST_SOCKETS];
+static unsigned int       peerErrors;
+static unsigned int       creates;
+static uint32_t           nextResponseMs = TEST_RESPONSE_MS;
+static Transfer           transfers[TEST_TRANSFERS];
+static NetSched_Task      quickTask;
+static unsigned int       quickRuns;
+static NetSched_Task      canaryTask;
+static volatile uint32_t  canaryPasses;
+static volatile bool      stopCanary;
+static Waiter             waiter;
+static uint32_t           checkins;
+
+/*
+ *  ======== Supervisor_register ========
+ */
+Supervisor_Id Supervisor_register(const char *name, uint32_t deadlineMs)
+{
+    schedThread = pthread_self();
+
+    return (0);
+}
+
+/*
+ *  ======== Supervisor_checkin ========
+ *  Once per scheduler pass.
+ */
+void Supervisor_checkin(Supervisor_Id id, int32_t activity)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    checkins++;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== getPeer ========
+ *  Every socket call must come from netSchedThread, and all but
+ *  SlNetSock_setOpt() and SlNetSock_close() on a non-blocking socket.
+ */
+static Peer *getPeer(int16_t sd, bool needNonBlocking)
+{
+    Peer *p;
+
+    if (!pthread_equal(pthread_self(), schedThread) || (sd < 0) ||
+            (sd >= TEST_SOCKETS) || !peers[sd].open) {
+        peerErrors++;
+        return (NULL);
+    }
+    p = &peers[sd];
+    if (needNonBlocking && !p->nonBlocking) {
+        peerErrors++;
+    }
+
+    return (p);
+}
+
+/*
+ *  ======== SlNetSock_create ========
+ */
+int16_t SlNetSock_create(int16_t domain, int16_t type, int16_t protocol,
+        uint32_t ifBitmap, int16_t flags)
+{
+    int16_t sd;
+
+    for (sd = 0; sd < TEST_SOCKETS; sd++) {
+        if (!peers[sd].open) {
+            memset(&peers[sd], 0, sizeof(peers[sd]));
+            peers[sd].open = true;
+            peers[sd].responseMs = nextResponseMs;
+            creates++;
+            return (sd);
+        }
+    }
+
+    return (-1);
+}
+
+/*
+ *  ======== SlNetSock_setOpt ========
+ */
+int32_t SlNetSock_setOpt(int16_t sd, int16_t level, int16_t optname,
+        void *optval, SlNetSocklen_t optlen)
+{
+    Peer *p = getPeer(sd, false);
+
+    if ((p == NULL) || (level != SLNETSOCK_LVL_SOCKET) ||
+            (optname != SLNETSOCK_OPT_NONBLOCKING) ||
+            (optlen != sizeof(SlNetSock_Nonblocking_t))) {
+        return (SLNETERR_RET_CODE_INVALID_INPUT);
+    }
+    p->nonBlocking =
+            ((SlNetSock_Nonblocking_t *)optval)->nonBlockingEnabled != 0;
+
+    return (0);
+}
+
+/*
+ *  ======== SlNetSock_connect ========
+ */
+int32_t SlNetSock_connect(int16_t sd, const SlNetSock_Addr_t *addr,
+        SlNetSocklen_t addrlen)
+{
+    Peer *p = getPeer(sd, true);
+
+    if ((p == NULL) || p->connected) {
+        return (SLNETERR_RET_CODE_INVALID_INPUT);
+    }
+    if (p->connectAt == 0) {
+        p->connectAt = NetSched_nowMs() + TEST_CONNECT_MS;
+        return (SLNETERR_BSD_EALREADY);
+    }
+    if ((int32_t)(NetSched_nowMs() - p->connectAt) < 0) {
+        return (SLNETERR_BSD_EALREADY);
+    }
+    p->connected = true;
+
+    return (0);
+}
+
+/*
+ *  ======== SlNetSock_send ========
+ */
+int32_t SlNetSock_send(int16_t sd, const void *buf, uint32_t len,
+        uint32_t flags)
+{
+    const uint8_t *in = buf;
+    Peer          *p = getPeer(sd, true);
+    uint32_t       i;
+
+    if ((p == NULL) || !p->connected || (p->respondAt != 0) || (len == 0)) {
+        return (SLNETERR_RET_CODE_INVALID_INPUT);
+    }
+    p->refuse = !p->refuse;
+    if (p->refuse) {
+        return (SLNETERR_BSD_EAGAIN);
+    }
+
+    if (len > TEST_SEND_CHUNK) {
+        len = TEST_SEND_CHUNK;
+    }
+    if ((p->got == 0) && (len >= 2)) {
+        p->length = in[0] | ((uint32_t)in[1] << 8);
+    }
+    if ((p->length == 0) || (p->got + len > p->length)) {
+        peerErrors++;
+        return (SLNETERR_RET_CODE_INVALID_INPUT);
+    }
+    for (i = 0; i < len; i++) {
+        p->sum += in[i];
+    }
+    p->got += len;
+
+    if (p->got == p->length) {
+        p->responseLen = (uint32_t)snprintf(p->response,
+                sizeof(p->response), "OK %lu %lu", (unsigned long)p->got,
+                (unsigned long)p->sum);
+        p->respondAt = NetSched_nowMs() + p->responseMs;
+    }
+
+    return ((int32_t)len);
+}
+
+/*
+ *  ======== SlNetSock_recv ========
+ *  Returns 0 once the whole answer is read, as a peer closing.
+ */
+int32_t SlNetSock_recv(int16_t sd, void *buf, uint32_t len, uint32_t flags)
+{
+    Peer *p = getPeer(sd, true);
+
+    if ((p == NULL) || !p->connected) {
+        return (SLNETERR_RET_CODE_INVALID_INPUT);
+    }
+    if ((p->respondAt == 0) ||
+            ((int32_t)(NetSched_nowMs() - p->respondAt) < 0)) {
+        p->recvWaits++;
+        return (SLNETERR_BSD_EAGAIN);
+    }
+
+    if (len > p->responseLen - p->responsePos) {
+        len = p->responseLen - p->responsePos;
+    }
+    if (len > TEST_RECV_CHUNK) {
+        len = TEST_RECV_CHUNK;
+    }
+    memcpy(buf, p->response + p->responsePos, len);
+    p->responsePos += len;
+
+    return ((int32_t)len);
+}
+
+/*
+ *  ======== SlNetSock_close ========
+ */
+int32_t SlNetSock_close(int16_t sd)
+{
+    Peer *p = getPeer(sd, false);
+
+    if (p == NULL) {
+        return (SLNETERR_RET_CODE_INVALID_INPUT);
+    }
+    p->open = false;
+
+    return (0);
+}
+
+/*
+ *  ======== waitMs ========
+ */
+static void waitMs(uint32_t ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+}
+
+/*
+ *  ======== waitSem ========
+ *  False if sem was not posted within ms.
+ */
+static bool waitSem(sem_t *sem, uint32_t ms)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    return (sem_timedwait(sem, &ts) == 0);
+}
+
+/*
+ *  ======== getCheckins ========
+ */
+static uint32_t getCheckins(void)
+{
+    uint32_t  n;
+    uintptr_t key;
+
+    key = HwiP_disable();
+    n = checkins;
+    HwiP_restore(key);
+
+    return (n);
+}
+
+/*
+ *  ======== finish ========
+ */
+static void finish(Transfer *t, int32_t error)
+{
+    t->error = error;
+    if (t->sd >= 0) {
+        SlNetSock_close(t->sd);
+    }
+    t->endMs = NetSched_nowMs();
+    sem_post(&doneSem);
+}
+
+/*
+ *  ======== transferFxn ========
+ *  Once the IP is up: connect, send the request, read the answer until
+ *  the peer closes.
+ */
+static PT_THREAD(transferFxn(NetSched_Task *task))
+{
+    Transfer *t = task->arg;
+
+    PT_BEGIN(&task->pt);
+
+    NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_IP_ACQUIRED);
+    t->startMs = NetSched_nowMs();
+    t->sent = 0;
+    t->received = 0;
+
+    t->sd = SlNetSock_create(SLNETSOCK_AF_INET, SLNETSOCK_SOCK_STREAM,
+            SLNETSOCK_PROTO_TCP, 0, 0);
+    if ((t->sd < 0) || (NetSched_setNonBlocking(t->sd) < 0)) {
+        finish(t, -1);
+        PT_EXIT(&task->pt);
+    }
+
+    NETSCHED_WAIT_IO(task, t->ret, SlNetSock_connect(t->sd, NULL, 0));
+    if (t->ret < 0) {
+        finish(t, t->ret);
+        PT_EXIT(&task->pt);
+    }
+
+    while (t->sent < t->length) {
+        NETSCHED_WAIT_IO(task, t->ret, SlNetSock_send(t->sd,
+                t->request + t->sent, t->length - t->sent, 0));
+        if (t->ret <= 0) {
+            finish(t, (t->ret < 0) ? t->ret : -1);
+            PT_EXIT(&task->pt);
+        }
+        t->sent += t->ret;
+    }
+
+    do {
+        NETSCHED_WAIT_IO(task, t->ret, SlNetSock_recv(t->sd,
+                t->rx + t->received, sizeof(t->rx) - 1 - t->received, 0));
+        if (t->ret > 0) {
+            t->received += t->ret;
+        }
+    } while ((t->ret > 0) && (t->received < sizeof(t->rx) - 1));
+    t->rx[t->received] = '\0';
+
+    finish(t, (t->ret < 0) ? t->ret : 0);
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== prepare ========
+ */
+static void prepare(Transfer *t, uint32_t length, uint8_t seed)
+{
+    uint32_t i;
+
+    t->length = length;
+    t->request[0] = (uint8_t)length;
+    t->request[1] = (uint8_t)(length >> 8);
+    for (i = 2; i < length; i++) {
+        t->request[i] = (uint8_t)(seed + i * 7);
+    }
+    t->sd = -1;
+    t->error = 0;
+    memset(t->rx, 0, sizeof(t->rx));
+}
+
+/*
+ *  ======== checkAnswer ========
+ */
+static void checkAnswer(Transfer *t)
+{
+    char     expected[32];
+    uint32_t sum = 0;
+    uint32_t i;
+
+    for (i = 0; i < t->length; i++) {
+        sum += t->request[i];
+    }
+    snprintf(expected, sizeof(expected), "OK %lu %lu",
+            (unsigned long)t->length, (unsigned long)sum);
+
+    CHECK_EQ(t->error, 0);
+    CHECK_EQ(t->sent, t->length);
+    CHECK(strcmp(t->rx, expected) == 0);
+}
+
+/*
+ *  ======== startAll ========
+ *  Start the transfers, which then wait for the IP. A task that has
+ *  only just ended may not be free yet, so retry for a moment.
+ */
+static void startAll(unsigned int count)
+{
+    unsigned int i;
+    unsigned int tries;
+
+    for (i = 0; i < count; i++) {
+        tries = 0;
+        while ((NetSched_start(&transfers[i].task, transferFxn,
+                &transfers[i]) != 0) && (++tries < 1000)) {
+            waitMs(1);
+        }
+        CHECK(tries < 1000);
+    }
+}
+
+/*
+ *  ======== waitAll ========
+ */
+static void waitAll(unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        if (!waitSem(&doneSem, 10000)) {
+            CHECK(false);
+            return;
+        }
+    }
+}
+
+/*
+ *  ======== testConcurrent ========
+ */
+static void testConcurrent(unsigned int round)
+{
+    uint32_t     t0;
+    uint32_t     elapsed;
+    uint32_t     serialMs;
+    uint32_t     lastStart = 0;
+    uint32_t     firstEnd = UINT32_MAX;
+    unsigned int i;
+
+    for (i = 0; i < TEST_TRANSFERS; i++) {
+        prepare(&transfers[i], 300 + i * 37, (uint8_t)(i + round));
+    }
+    creates = 0;
+    startAll(TEST_TRANSFERS);
+
+    /* Started more than once */
+    CHECK_EQ(NetSched_start(&transfers[0].task, transferFxn,
+            &transfers[0]), -1);
+
+    /* Nothing happens before the IP is up */
+    waitMs(50);
+    CHECK_EQ(creates, 0);
+
+    t0 = NetSched_nowMs();
+    NetSched_signal(NETSCHED_EVENT_IP_ACQUIRED);
+    waitAll(TEST_TRANSFERS);
+    elapsed = NetSched_nowMs() - t0;
+
+    CHECK_EQ(creates, TEST_TRANSFERS);
+    for (i = 0; i < TEST_TRANSFERS; i++) {
+        checkAnswer(&transfers[i]);
+        CHECK(!peers[i].open);
+        if (transfers[i].startMs - t0 > lastStart - t0) {
+            lastStart = transfers[i].startMs;
+        }
+        if (transfers[i].endMs - t0 < firstEnd - t0) {
+            firstEnd = transfers[i].endMs;
+        }
+    }
+    CHECK_EQ(peerErrors, 0);
+
+    /* All in flight at once: every one started before any ended */
+    CHECK((int32_t)(firstEnd - lastStart) > 0);
+
+    /* And well under the time they would take one after another */
+    serialMs = TEST_TRANSFERS * (TEST_CONNECT_MS + TEST_RESPONSE_MS);
+    CHECK(elapsed * 4 < serialMs);
+
+    if (round == 0) {
+        printf("netsched: %d transfers in %lu ms (%lu ms one after "
+                "another), %u byte task, %d byte stack\n",
+                TEST_TRANSFERS, (unsigned long)elapsed,
+                (unsigned long)serialMs, (unsigned int)sizeof(NetSched_Task),
+                NETSCHED_STACK_SIZE);
+    }
+}
+
+/*
+ *  ======== quickFxn ========
+ */
+static PT_THREAD(quickFxn(NetSched_Task *task))
+{
+    PT_BEGIN(&task->pt);
+
+    quickRuns++;
+    sem_post(&doneSem);
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== canaryFxn ========
+ */
+static PT_THREAD(canaryFxn(NetSched_Task *task))
+{
+    PT_BEGIN(&task->pt);
+
+    while (!stopCanary) {
+        NETSCHED_SLEEP(task, 1);
+        canaryPasses++;
+    }
+    sem_post(&doneSem);
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== testRestart ========
+ *  A task is restarted from this thread the moment it is free again,
+ *  while the scheduler is still taking it off the run list. The canary
+ *  behind it on the list must keep running.
+ */
+static void testRestart(void)
+{
+    uint32_t     passes;
+    unsigned int i;
+
+    stopCanary = false;
+    CHECK_EQ(NetSched_start(&canaryTask, canaryFxn, NULL), 0);
+    waitMs(20);
+
+    quickRuns = 0;
+    for (i = 0; i < TEST_HAMMER_RUNS; i++) {
+        while (NetSched_start(&quickTask, quickFxn, NULL) != 0) {
+            sched_yield();
+        }
+        if (!waitSem(&doneSem, 1000)) {
+            CHECK(false);
+            break;
+        }
+    }
+    CHECK_EQ(quickRuns, TEST_HAMMER_RUNS);
+
+    passes = canaryPasses;
+    waitMs(50);
+    CHECK(canaryPasses - passes >= 10);
+
+    stopCanary = true;
+    CHECK(waitSem(&doneSem, 1000));
+}
+
+/*
+ *  ======== waiterFxn ========
+ */
+static PT_THREAD(waiterFxn(NetSched_Task *task))
+{
+    Waiter *w = task->arg;
+
+    PT_BEGIN(&task->pt);
+
+    NETSCHED_WAIT_EVENT_TIMEOUT(task, NETSCHED_EVENT_SCAN_DONE, 100);
+    w->events[0] = task->events & NETSCHED_EVENT_SCAN_DONE;
+    w->wokeMs[0] = NetSched_nowMs();
+    NetSched_clearEvents(task, NETSCHED_EVENT_SCAN_DONE);
+    sem_post(&doneSem);
+
+    NETSCHED_WAIT_EVENT_TIMEOUT(task, NETSCHED_EVENT_SCAN_DONE, 5000);
+    w->events[1] = task->events & NETSCHED_EVENT_SCAN_DONE;
+    w->wokeMs[1] = NetSched_nowMs();
+    NetSched_clearEvents(task, NETSCHED_EVENT_SCAN_DONE);
+    sem_post(&doneSem);
+
+    /* Posted before this wait began, and latched since */
+    NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_HIBERNATE);
+    w->wokeMs[2] = NetSched_nowMs();
+    sem_post(&doneSem);
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== testEvents ========
+ */
+static void testEvents(void)
+{
+    uint32_t t0;
+
+    memset(&waiter, 0, sizeof(waiter));
+    t0 = NetSched_nowMs();
+    CHECK_EQ(NetSched_start(&waiter.task, waiterFxn, &waiter), 0);
+
+    /* Nothing posted: the timeout, on time */
+    CHECK(waitSem(&doneSem, 1000));
+    CHECK_EQ(waiter.events[0], 0);
+    CHECK(waiter.wokeMs[0] - t0 >= 100);
+    CHECK(waiter.wokeMs[0] - t0 < 100 + 50);
+
+    /* Events, long before the timeout */
+    NetSched_signal(NETSCHED_EVENT_HIBERNATE);
+    waitMs(20);
+    t0 = NetSched_nowMs();
+    NetSched_signal(NETSCHED_EVENT_SCAN_DONE);
+    CHECK(waitSem(&doneSem, 1000));
+    CHECK_EQ(waiter.events[1], NETSCHED_EVENT_SCAN_DONE);
+    CHECK(waiter.wokeMs[1] - t0 < 50);
+
+    CHECK(waitSem(&doneSem, 1000));
+    CHECK(waiter.wokeMs[2] - waiter.wokeMs[1] < 50);
+}
+
+/*
+ *  ======== testPolling ========
+ *  A socket wait is retried once a poll period, and an idle scheduler
+ *  only wakes for its idle period.
+ */
+static void testPolling(void)
+{
+    Transfer *t = &transfers[0];
+    uint32_t  expected;
+    uint32_t  before;
+
+    nextResponseMs = 500;
+    prepare(t, 2, 0);
+    startAll(1);
+    waitMs(20);
+    NetSched_signal(NETSCHED_EVENT_IP_ACQUIRED);
+    waitAll(1);
+    nextResponseMs = TEST_RESPONSE_MS;
+    checkAnswer(t);
+
+    expected = 500 / NETSCHED_POLL_PERIOD_MS;
+    CHECK(peers[t->sd].recvWaits >= expected / 2);
+    CHECK(peers[t->sd].recvWaits <= expected + 5);
+
+    waitMs(20);
+    before = getCheckins();
+    waitMs(300);
+    CHECK(getCheckins() - before <= 2);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    pthread_t thread;
+
+    CHECK(sizeof(NetSched_Task) * 10 < NETSCHED_STACK_SIZE);
+
+    sem_init(&doneSem, 0, 0);
+    CHECK_EQ(NetSched_init(), 0);
+    if (pthread_create(&thread, NULL, netSchedThread, NULL) != 0) {
+        CHECK(false);
+        return (CHECK_DONE("netsched"));
+    }
+    waitMs(20);
+
+    testConcurrent(0);
+    testConcurrent(1);
+    testRestart();
+    testEvents();
+    testPolling();
+    CHECK_EQ(peerErrors, 0);
+
+    return (CHECK_DONE("netsched"));
+}
@@ -0,0 +1,241 @@
+/*
+ *  ======== test_packbits.c ========
+ *  Host test of the PackBits encoder that compresses crash dumps.
+ *
+ *  Every encoding is decoded again with the reference decoder below and
+ *  must give back the input, fit PACKBITS_MAX_SIZE() and use the short
+ *  form the encoder promises: runs of 3 or more as repeats, nothing
+ *  shorter.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "crashdump.h"
+#include "packbits.h"
+
+#include "check.h"
+
+#define TEST_MAX_LEN                (2048)
+
+static uint8_t  src[TEST_MAX_LEN];
+static uint8_t  dst[PACKBITS_MAX_SIZE(TEST_MAX_LEN) + 16];
+static uint8_t  back[TEST_MAX_LEN + 128];
+static uint32_t randomState = 1;
+
+/*
+ *  ======== nextRandom ========
+ */
+static uint32_t nextRandom(void)
+{
+    uint32_t x = randomState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomState = x;
+
+    return (x);
+}
+
+/*
+ *  ======== decode ========
+ *  Returns the decoded length, or -1 for a malformed or wasteful stream.
+ */
+static long decode(const uint8_t *in, size_t len, uint8_t *out,
+        size_t outSize)
+{
+    size_t  pos = 0;
+    size_t  n = 0;
+    size_t  count;
+    int8_t  control;
+
+    while (pos < len) {
+        control = (int8_t)in[pos++];
+        if (control == -128) {
+            return (-1);                /* a no-op, never written */
+        }
+        if (control < 0) {
+            count = 1 - control;
+            if ((count < 3) || (pos >= len) || (n + count > outSize)) {
+                return (-1);
+            }
+            memset(out + n, in[pos++], count);
+        }
+        else {
+            count = (size_t)control + 1;
+            if ((pos + count > len) || (n + count > outSize)) {
+                return (-1);
+            }
+            memcpy(out + n, in + pos, count);
+            pos += count;
+        }
+        n += count;
+    }
+
+    return ((long)n);
+}
+
+/*
+ *  ======== roundTrip ========
+ */
+static void roundTrip(size_t len)
+{
+    size_t encoded;
+
+    encoded = PackBits_encode(src, len, dst, sizeof(dst));
+    CHECK(encoded <= PACKBITS_MAX_SIZE(len));
+    CHECK((len == 0) || (encoded != 0));
+    CHECK_EQ(decode(dst, encoded, back, sizeof(back)), len);
+    CHECK(memcmp(back, src, len) == 0);
+
+    /* Exactly enough room is enough, one byte less is not */
+    if (encoded != 0) {
+        CHECK_EQ(PackBits_encode(src, len, dst, encoded), encoded);
+        CHECK_EQ(PackBits_encode(src, len, dst, encoded - 1), 0);
+    }
+}
+
+/*
+ *  ======== fill ========
+ *  runPct of the data in runs, the rest random bytes from an alphabet
+ *  of alphabet symbols.
+ */
+static void fill(size_t len, unsigned int runPct, unsigned int alphabet)
+{
+    size_t   i = 0;
+    size_t   run;
+    uint8_t  value;
+
+    while (i < len) {
+        value = (uint8_t)(nextRandom() % alphabet);
+        if ((nextRandom() % 100) < runPct) {
+            run = 1 + nextRandom() % 300;
+        }
+        else {
+            run = 1;
+        }
+        while ((run-- > 0) && (i < len)) {
+            src[i++] = value;
+        }
+    }
+}
+
+/*
+ *  ======== testShapes ========
+ *  Hand-made inputs with a known encoding.
+ */
+static void testShapes(void)
+{
+    static const uint8_t two[] = {7, 7, 1, 2};
+    static const uint8_t three[] = {7, 7, 7, 1};
+    size_t               i;
+
+    /* Nothing in, nothing out */
+    CHECK_EQ(PackBits_encode(src, 0, dst, sizeof(dst)), 0);
+
+    /* A pair stays literal */
+    CHECK_EQ(PackBits_encode(two, sizeof(two), dst, sizeof(dst)), 5);
+    CHECK_EQ(dst[0], 3);
+    CHECK(memcmp(dst + 1, two, sizeof(two)) == 0);
+
+    /* Three make a repeat */
+    CHECK_EQ(PackBits_encode(three, sizeof(three), dst, sizeof(dst)), 4);
+    CHECK_EQ((int8_t)dst[0], -2);
+    CHECK_EQ(dst[1], 7);
+    CHECK_EQ(dst[2], 0);
+    CHECK_EQ(dst[3], 1);
+
+    /* Repeats end at 128; what is left over starts the next piece */
+    memset(src, 0xEE, 131);
+    CHECK_EQ(PackBits_encode(src, 128, dst, sizeof(dst)), 2);
+    CHECK_EQ((int8_t)dst[0], -127);
+    CHECK_EQ(PackBits_encode(src, 129, dst, sizeof(dst)), 4);
+    CHECK_EQ(dst[2], 0);
+    CHECK_EQ(PackBits_encode(src, 130, dst, sizeof(dst)), 5);
+    CHECK_EQ(dst[2], 1);
+    CHECK_EQ(PackBits_encode(src, 131, dst, sizeof(dst)), 4);
+    CHECK_EQ((int8_t)dst[2], -2);
+
+    /* Literals end at 128 as well */
+    for (i = 0; i < 257; i++) {
+        src[i] = (uint8_t)i;
+    }
+    CHECK_EQ(PackBits_encode(src, 128, dst, sizeof(dst)), 129);
+    CHECK_EQ(dst[0], 127);
+    CHECK_EQ(PackBits_encode(src, 129, dst, sizeof(dst)), 131);
+    CHECK_EQ(dst[129], 0);
+    CHECK_EQ(PackBits_encode(src, 257, dst, sizeof(dst)),
+            PACKBITS_MAX_SIZE(257));
+    roundTrip(257);
+}
+
+/*
+ *  ======== testRandom ========
+ */
+static void testRandom(void)
+{
+    static const unsigned int runPcts[] = {0, 5, 30, 90, 100};
+    static const unsigned int alphabets[] = {2, 3, 256};
+    size_t                    len;
+    size_t                    r;
+    size_t                    a;
+
+    for (len = 0; len <= TEST_MAX_LEN; len += (len < 300) ? 1 : 37) {
+        for (r = 0; r < sizeof(runPcts) / sizeof(runPcts[0]); r++) {
+            for (a = 0; a < sizeof(alphabets) / sizeof(alphabets[0]); a++) {
+                fill(len, runPcts[r], alphabets[a]);
+                roundTrip(len);
+            }
+        }
+    }
+}
+
+/*
+ *  ======== testRecord ========
+ *  A dump as crashdump.c sends it: mostly zeros around the text and
+ *  stack, which is where the compression pays.
+ */
+static void testRecord(void)
+{
+    static CrashDump_Record rec;
+    static uint8_t          packed[PACKBITS_MAX_SIZE(sizeof(rec))];
+    size_t                  encoded;
+    size_t                  i;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = CRASHDUMP_MAGIC;
+    rec.version = CRASHDUMP_VERSION;
+    rec.cause = CrashDump_Cause_EXCEPTION;
+    strcpy(rec.reason, "exception");
+    for (i = 0; i < 17; i++) {
+        rec.regs[i] = 0x20010000 + nextRandom() % 0x1000;
+    }
+    rec.logLen = (uint16_t)snprintf(rec.log, sizeof(rec.log),
+            "Upload OK 204\nSampling 120 s\nUpload failed -2003\n");
+    rec.stackLen = 200;
+    for (i = 0; i < rec.stackLen; i++) {
+        rec.stack[i] = (i % 4 == 3) ? 0x20 : (uint8_t)nextRandom();
+    }
+
+    encoded = PackBits_encode((const uint8_t *)&rec, sizeof(rec), packed,
+            sizeof(packed));
+    CHECK(encoded != 0);
+    CHECK(encoded < sizeof(rec) / 4);
+    CHECK_EQ(decode(packed, encoded, back, sizeof(back)), sizeof(rec));
+    CHECK(memcmp(back, &rec, sizeof(rec)) == 0);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    testShapes();
+    testRandom();
+    testRecord();
+
+    return (CHECK_DONE("packbits"));
+}
@@ -0,0 +1,287 @@
+/*
+ *  ======== test_payloadsec.c ========
+ *  Host test of swcrypto.c against published vectors, and of the
+ *  payloadsec.c framing built on it.
+ *
+ *  The framing is checked from the outside: for every length a sealed
+ *  payload must be header | IV | AES-128-CBC of the PKCS#7 padded
+ *  plaintext | HMAC-SHA256 of everything before, whatever the chunking.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host/host.h"
+#include "payloadsec.h"
+#include "swcrypto.h"
+
+#include "check.h"
+
+static uint8_t aesKey[PAYLOADSEC_AES_KEY_SIZE];
+static uint8_t hmacKey[PAYLOADSEC_HMAC_KEY_SIZE];
+
+/*
+ *  ======== unhex ========
+ */
+static size_t unhex(const char *hex, uint8_t *out)
+{
+    size_t   n = 0;
+    unsigned v;
+
+    while ((hex[0] != '\0') && (sscanf(hex, "%2x", &v) == 1)) {
+        out[n++] = (uint8_t)v;
+        hex += 2;
+    }
+
+    return (n);
+}
+
+/*
+ *  ======== testAes ========
+ *  FIPS-197 appendix C.1, and the first block of SP 800-38A F.2.1.
+ */
+static void testAes(void)
+{
+    SwCrypto_Aes aes;
+    uint8_t      key[16];
+    uint8_t      in[64];
+    uint8_t      out[64];
+    uint8_t      expect[64];
+    uint8_t      iv[16];
+
+    unhex("000102030405060708090a0b0c0d0e0f", key);
+    unhex("00112233445566778899aabbccddeeff", in);
+    unhex("69c4e0d86a7b0430d8cdb78070b4c55a", expect);
+    SwCrypto_aesSetKey(&aes, key);
+    SwCrypto_aesEncrypt(&aes, in, out);
+    CHECK(memcmp(out, expect, 16) == 0);
+
+    /* In place */
+    SwCrypto_aesEncrypt(&aes, in, in);
+    CHECK(memcmp(in, expect, 16) == 0);
+
+    unhex("2b7e151628aed2a6abf7158809cf4f3c", key);
+    unhex("000102030405060708090a0b0c0d0e0f", iv);
+    unhex("6bc1bee22e409f96e93d7e117393172a"
+          "ae2d8a571e03ac9c9eb76fac45af8e51"
+          "30c81c46a35ce411e5fbc1191a0a52ef"
+          "f69f2445df4f9b17ad2b417be66c3710", in);
+    unhex("7649abac8119b246cee98e9b12e9197d"
+          "5086cb9b507219ee95db113a917678b2"
+          "73bed6b8e3c1743b7116e69e22229516"
+          "3ff1caa1681fac09120eca307586e1a7", expect);
+    SwCrypto_aesSetKey(&aes, key);
+
+    /* In two calls, so the chaining through iv is covered */
+    SwCrypto_cbcEncrypt(&aes, iv, in, 16, out);
+    SwCrypto_cbcEncrypt(&aes, iv, in + 16, 48, out + 16);
+    CHECK(memcmp(out, expect, 64) == 0);
+    CHECK(memcmp(iv, expect + 48, 16) == 0);
+}
+
+/*
+ *  ======== testSha256 ========
+ *  FIPS 180-2 examples, fed in odd sized pieces.
+ */
+static void testSha256(void)
+{
+    static const char *msg2 =
+            "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    SwCrypto_Sha256 sha;
+    uint8_t         digest[32];
+    uint8_t         expect[32];
+    uint8_t         a[1000];
+    size_t          i;
+
+    SwCrypto_sha256Init(&sha);
+    SwCrypto_sha256Update(&sha, "abc", 3);
+    SwCrypto_sha256Final(&sha, digest);
+    unhex("ba7816bf8f01cfea414140de5dae2223"
+          "b00361a396177a9cb410ff61f20015ad", expect);
+    CHECK(memcmp(digest, expect, 32) == 0);
+
+    SwCrypto_sha256Init(&sha);
+    for (i = 0; i < strlen(msg2); i += 7) {
+        SwCrypto_sha256Update(&sha, msg2 + i,
+                (strlen(msg2) - i < 7) ? strlen(msg2) - i : 7);
+    }
+    SwCrypto_sha256Final(&sha, digest);
+    unhex("248d6a61d20638b8e5c026930c3e6039"
+          "a33ce45964ff2167f6ecedd419db06c1", expect);
+    CHECK(memcmp(digest, expect, 32) == 0);
+
+    /* One million 'a' */
+    memset(a, 'a', sizeof(a));
+    SwCrypto_sha256Init(&sha);
+    for (i = 0; i < 1000; i++) {
+        SwCrypto_sha256Update(&sha, a, sizeof(a));
+    }
+    SwCrypto_sha256Final(&sha, digest);
+    unhex("cdc76e5c9914fb9281a1c7e284d73e67"
+          "f1809a48a497200e046d39ccc7112cd0", expect);
+    CHECK(memcmp(digest, expect, 32) == 0);
+}
+
+/*
+ *  ======== testHmac ========
+ *  RFC 4231 cases 2 (short key) and 6 (key longer than a block).
+ */
+static void testHmac(void)
+{
+    SwCrypto_Hmac hmac;
+    uint8_t       key[131];
+    uint8_t       tag[32];
+    uint8_t       expect[32];
+    const char   *msg;
+
+    SwCrypto_hmacInit(&hmac, (const uint8_t *)"Jefe", 4);
+    msg = "what do ya want for nothing?";
+    SwCrypto_hmacUpdate(&hmac, msg, 10);
+    SwCrypto_hmacUpdate(&hmac, msg + 10, strlen(msg) - 10);
+    SwCrypto_hmacFinal(&hmac, tag);
+    unhex("5bdcc146bf60754e6a042426089575c7"
+          "5a003f089d2739839dec58b964ec3843", expect);
+    CHECK(memcmp(tag, expect, 32) == 0);
+
+    memset(key, 0xAA, sizeof(key));
+    SwCrypto_hmacInit(&hmac, key, sizeof(key));
+    msg = "Test Using Larger Than Block-Size Key - Hash Key First";
+    SwCrypto_hmacUpdate(&hmac, msg, strlen(msg));
+    SwCrypto_hmacFinal(&hmac, tag);
+    unhex("60e431591ee0b67f0d8a26aacbf5b77f"
+          "8e0bc6213728c5140546040f0ee37f54", expect);
+    CHECK(memcmp(tag, expect, 32) == 0);
+}
+
+/*
+ *  ======== checkSealed ========
+ *  Rebuild what a sealed payload of plain must be and compare.
+ */
+static void checkSealed(const uint8_t *sealed, int32_t sealedLen,
+        const uint8_t *plain, size_t len, uint32_t *seq)
+{
+    static uint8_t padded[2048];
+    static uint8_t cipher[2048];
+    SwCrypto_Aes   aes;
+    SwCrypto_Hmac  hmac;
+    uint32_t       header[4];
+    uint8_t        iv[16];
+    uint8_t        tag[32];
+    size_t         padLen = (len / 16 + 1) * 16;
+
+    CHECK_EQ(sealedLen, 16 + 16 + padLen + 32);
+    if (sealedLen != (int32_t)(16 + 16 + padLen + 32)) {
+        return;
+    }
+
+    memcpy(header, sealed, sizeof(header));
+    CHECK_EQ(header[0], PAYLOADSEC_MAGIC);
+    if (*seq != 0) {
+        CHECK_EQ(header[1], *seq + 1);
+    }
+    *seq = header[1];
+    CHECK_EQ(header[2], len);
+    CHECK_EQ(header[3], 0);
+
+    memcpy(padded, plain, len);
+    memset(padded + len, (int)(padLen - len), padLen - len);
+    memcpy(iv, sealed + 16, sizeof(iv));
+    SwCrypto_aesSetKey(&aes, aesKey);
+    SwCrypto_cbcEncrypt(&aes, iv, padded, padLen, cipher);
+    CHECK(memcmp(sealed + 32, cipher, padLen) == 0);
+
+    SwCrypto_hmacInit(&hmac, hmacKey, sizeof(hmacKey));
+    SwCrypto_hmacUpdate(&hmac, sealed, 32 + padLen);
+    SwCrypto_hmacFinal(&hmac, tag);
+    CHECK(memcmp(sealed + 32 + padLen, tag, 32) == 0);
+}
+
+/*
+ *  ======== testFraming ========
+ */
+static void testFraming(void)
+{
+    static uint32_t    plain[1100 / 4];
+    static uint32_t    sealed[(1100 + PAYLOADSEC_OVERHEAD) / 4 + 1];
+    uint8_t            keys[PAYLOADSEC_AES_KEY_SIZE +
+                            PAYLOADSEC_HMAC_KEY_SIZE];
+    PayloadSec_Context ctx;
+    uint8_t           *out = (uint8_t *)sealed;
+    uint32_t           seq = 0;
+    int32_t            ret;
+    int32_t            pos;
+    size_t             len;
+    size_t             i;
+
+    for (i = 0; i < sizeof(keys); i++) {
+        keys[i] = (uint8_t)(0x40 + i);
+    }
+    memcpy(aesKey, keys, sizeof(aesKey));
+    memcpy(hmacKey, keys + sizeof(aesKey), sizeof(hmacKey));
+    for (i = 0; i < sizeof(plain); i++) {
+        ((uint8_t *)plain)[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    /* No key file: nothing is sealed */
+    Host_clearFiles();
+    CHECK_EQ(PayloadSec_init(), 0);
+    CHECK(!PayloadSec_loadKey());
+    CHECK(PayloadSec_seal((uint8_t *)plain, 16, out, sizeof(sealed)) < 0);
+
+    /* A short key file is refused too */
+    Host_setFile(PAYLOADSEC_KEY_FILE, keys, sizeof(keys) - 1);
+    CHECK(!PayloadSec_loadKey());
+
+    Host_setFile(PAYLOADSEC_KEY_FILE, keys, sizeof(keys));
+    CHECK(PayloadSec_loadKey());
+
+    /* Every length around the block, HMAC block and chunk boundaries */
+    for (len = 0; len <= 1100; len++) {
+        if ((len > 80) && (len < 1000) && ((len % 64) > 2) &&
+                ((len % 64) < 62)) {
+            continue;
+        }
+        ret = PayloadSec_seal((uint8_t *)plain, len, out, sizeof(sealed));
+        checkSealed(out, ret, (uint8_t *)plain, len, &seq);
+    }
+
+    /* Too small an output buffer */
+    CHECK(PayloadSec_seal((uint8_t *)plain, 100, out,
+            100 + PAYLOADSEC_OVERHEAD - 1) < 0);
+
+    /* The chunk interface by hand, in uneven chunks */
+    pos = PayloadSec_begin(&ctx, 200, out);
+    CHECK_EQ(pos, 32);
+    CHECK(PayloadSec_update(&ctx, (uint8_t *)plain, 15, out + pos) < 0);
+    ret = PayloadSec_update(&ctx, (uint8_t *)plain, 48, out + pos);
+    CHECK_EQ(ret, 48);
+    pos += ret;
+    ret = PayloadSec_update(&ctx, (uint8_t *)plain + 48, 112, out + pos);
+    CHECK_EQ(ret, 112);
+    pos += ret;
+    /* The rest must go through finish, which pads */
+    CHECK(PayloadSec_update(&ctx, (uint8_t *)plain + 160, 48,
+            out + pos) < 0);
+    CHECK(PayloadSec_finish(&ctx, (uint8_t *)plain + 160, 39,
+            out + pos) < 0);
+    ret = PayloadSec_finish(&ctx, (uint8_t *)plain + 160, 40, out + pos);
+    CHECK_EQ(ret, 48 + 32);
+    checkSealed(out, pos + ret, (uint8_t *)plain, 200, &seq);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    Host_seedRandom(1);
+
+    testAes();
+    testSha256();
+    testHmac();
+    testFraming();
+
+    return (CHECK_DONE("payloadsec"));
+}
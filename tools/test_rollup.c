@@ -0,0 +1,221 @@
+/*
+ *  ======== test_rollup.c ========
+ *  Host test of rollup.c: interval boundaries, the statistics of each
+ *  period against a double precision reference, histogram buckets and
+ *  the raw rate ring. The clock starts just short of the 32-bit wrap,
+ *  so every period also closes across it.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "host/host.h"
+#include "rollup.h"
+
+#include "check.h"
+
+#define START_MS        (UINT32_MAX - 90000)
+
+typedef struct Reference {
+    uint32_t    count;
+    uint32_t    min;
+    uint32_t    max;
+    double      sum;
+    double      sumSq;
+    uint64_t    volumeNl;
+    uint32_t    hist[ROLLUP_HIST_BUCKETS];
+} Reference;
+
+static Reference    ref[Rollup_Period_COUNT];
+static uint32_t     random32 = 12345;
+
+/*
+ *  ======== nextRandom ========
+ */
+static uint32_t nextRandom(void)
+{
+    random32 ^= random32 << 13;
+    random32 ^= random32 >> 17;
+    random32 ^= random32 << 5;
+
+    return (random32);
+}
+
+/*
+ *  ======== bucketOf ========
+ */
+static int bucketOf(uint32_t rate)
+{
+    int i = 0;
+
+    while ((i < ROLLUP_HIST_BUCKETS - 1) && (rate >= Rollup_bucketLimit(i))) {
+        i++;
+    }
+
+    return (i);
+}
+
+/*
+ *  ======== addRef ========
+ */
+static void addRef(Reference *r, uint32_t rate, uint32_t volume)
+{
+    if ((r->count == 0) || (rate < r->min)) {
+        r->min = rate;
+    }
+    if ((r->count == 0) || (rate > r->max)) {
+        r->max = rate;
+    }
+    r->count++;
+    r->sum += rate;
+    r->sumSq += (double)rate * rate;
+    r->volumeNl += volume;
+    r->hist[bucketOf(rate)]++;
+}
+
+/*
+ *  ======== checkSummary ========
+ */
+static void checkSummary(Rollup_Period p, uint32_t startMs,
+        uint32_t durationMs)
+{
+    Reference     *r = &ref[p];
+    Rollup_Summary s;
+    double         mean = r->sum / r->count;
+    double         sd = sqrt(r->sumSq / r->count - mean * mean);
+    uint32_t       histSum = 0;
+    int            i;
+
+    CHECK(Rollup_get(p, &s));
+    CHECK_EQ(s.startMs, startMs);
+    CHECK_EQ(s.durationMs, durationMs);
+    CHECK_EQ(s.count, r->count);
+    CHECK_EQ(s.min, r->min);
+    CHECK_EQ(s.max, r->max);
+    CHECK_EQ(s.mean, (uint32_t)floor(mean));
+    CHECK_EQ(s.volumeNl, r->volumeNl);
+    /* The variance is taken in steps of 2^ROLLUP_VAR_SHIFT nL/s */
+    CHECK(fabs(s.stddev - sd) <= 2.0 * (1 << ROLLUP_VAR_SHIFT) + sd / 1000);
+    for (i = 0; i < ROLLUP_HIST_BUCKETS; i++) {
+        CHECK_EQ(s.hist[i], r->hist[i]);
+        histSum += s.hist[i];
+    }
+    CHECK_EQ(histSum, s.count);
+}
+
+/*
+ *  ======== testBuckets ========
+ */
+static void testBuckets(void)
+{
+    int i;
+
+    for (i = 0; i < ROLLUP_HIST_BUCKETS - 1; i++) {
+        CHECK(Rollup_bucketLimit(i) < Rollup_bucketLimit(i + 1));
+    }
+    CHECK_EQ(Rollup_bucketLimit(ROLLUP_HIST_BUCKETS - 1), UINT32_MAX);
+    CHECK_EQ(bucketOf(0), 0);
+    CHECK_EQ(bucketOf(Rollup_bucketLimit(0) - 1), 0);
+    CHECK_EQ(bucketOf(Rollup_bucketLimit(0)), 1);
+    CHECK_EQ(bucketOf(UINT32_MAX), ROLLUP_HIST_BUCKETS - 1);
+}
+
+/*
+ *  ======== testPeriods ========
+ *  Two hours of one sample a second, from still water through a
+ *  dripping tap to a full flow, and a few outliers at the extremes.
+ */
+static void testPeriods(void)
+{
+    Rollup_Summary s;
+    uint32_t       start[Rollup_Period_COUNT];
+    uint32_t       lengthMs[Rollup_Period_COUNT] = {
+        60 * 1000, 15 * 60 * 1000, 60 * 60 * 1000
+    };
+    uint32_t       closes[Rollup_Period_COUNT] = {0};
+    uint32_t       t = START_MS;
+    uint32_t       rate;
+    uint32_t       volume;
+    uint32_t       i;
+    int            p;
+
+    for (p = 0; p < Rollup_Period_COUNT; p++) {
+        CHECK(!Rollup_get((Rollup_Period)p, &s));
+        start[p] = t;
+    }
+    CHECK(!Rollup_get(Rollup_Period_COUNT, &s));
+
+    for (i = 0; i < 2 * 3600; i++, t += 1000) {
+        switch ((i / 600) % 4) {
+            case 0:  rate = 0; break;
+            case 1:  rate = 5000 + nextRandom() % 20000; break;
+            case 2:  rate = 100000000 + nextRandom() % 200000000; break;
+            default: rate = nextRandom() % 1000000; break;
+        }
+        if (i % 997 == 0) {
+            rate = UINT32_MAX;
+        }
+        volume = rate / 1000;
+
+        Rollup_add(rate, volume, t);
+
+        /* The first sample past a period closes it and opens the next */
+        for (p = 0; p < Rollup_Period_COUNT; p++) {
+            if ((uint32_t)(t - start[p]) >= lengthMs[p]) {
+                checkSummary((Rollup_Period)p, start[p], t - start[p]);
+                closes[p]++;
+                memset(&ref[p], 0, sizeof(ref[p]));
+                start[p] = t;
+            }
+            addRef(&ref[p], rate, volume);
+        }
+    }
+    CHECK_EQ(closes[Rollup_Period_MINUTE], 119);
+    CHECK_EQ(closes[Rollup_Period_HOUR], 1);
+}
+
+/*
+ *  ======== testRaw ========
+ */
+static void testRaw(void)
+{
+    uint32_t rates[ROLLUP_RAW_SIZE + 4];
+    uint32_t t = 5000;
+    int      n;
+    int      i;
+
+    /* Rollup_raw() keeps the last ROLLUP_RAW_SIZE, oldest first */
+    for (i = 0; i < 100; i++, t += 1000) {
+        Rollup_add(1000 + i, 1, t);
+    }
+    n = Rollup_raw(rates, ROLLUP_RAW_SIZE + 4);
+    CHECK_EQ(n, ROLLUP_RAW_SIZE);
+    for (i = 0; i < n; i++) {
+        CHECK_EQ(rates[i], 1000 + 100 - ROLLUP_RAW_SIZE + i);
+    }
+
+    /* Fewer asked for: the newest */
+    n = Rollup_raw(rates, 3);
+    CHECK_EQ(n, 3);
+    CHECK_EQ(rates[0], 1097);
+    CHECK_EQ(rates[2], 1099);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    uint32_t rates[4];
+
+    CHECK_EQ(Rollup_raw(rates, 4), 0);
+
+    testBuckets();
+    testPeriods();
+    testRaw();
+
+    return (CHECK_DONE("rollup"));
+}
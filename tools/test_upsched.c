@@ -0,0 +1,295 @@
+/*
+ *  ======== test_upsched.c ========
+ *  Host test of upsched.c: slot placement, server assigned slots,
+ *  backoff bounds, link loss, suspend and resume, and the spread of
+ *  device offsets over neighbouring MAC addresses.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "upsched.h"
+
+#include "check.h"
+
+#define PERIOD_MS       (15 * 60 * 1000)
+#define FIRST_MS        (30 * 1000)
+#define POLL_MS         (60 * 60 * 1000)
+#define RETRY_MS        (10 * 1000)
+#define URGENT_CAP_MS   (5 * 60 * 1000)
+#define ROUTINE_CAP_MS  (60 * 60 * 1000)
+
+/* Some UTC, not on a period boundary */
+#define UTC_MS          (1700000123456LL)
+
+static const UpSched_Params params = {
+    .periodMs = PERIOD_MS,
+    .firstMs = FIRST_MS,
+    .pollPeriodMs = POLL_MS,
+    .retryMs = RETRY_MS,
+    .urgentCapMs = URGENT_CAP_MS,
+    .routineCapMs = ROUTINE_CAP_MS
+};
+
+/*
+ *  ======== setMac ========
+ */
+static void setMac(uint8_t *mac, uint32_t n)
+{
+    mac[0] = 0x00;
+    mac[1] = 0x12;
+    mac[2] = 0x4B;
+    mac[3] = (uint8_t)(n >> 16);
+    mac[4] = (uint8_t)(n >> 8);
+    mac[5] = (uint8_t)n;
+}
+
+/*
+ *  ======== testFirst ========
+ */
+static void testFirst(uint32_t start)
+{
+    UpSched_Plan plan;
+    uint8_t      mac[6];
+    uint32_t     offset;
+
+    UpSched_init(&plan, &params, start);
+    CHECK_EQ(UpSched_waitMs(&plan, start), FIRST_MS);
+    CHECK(!UpSched_routineDue(&plan, start + FIRST_MS - 1));
+    CHECK(UpSched_routineDue(&plan, start + FIRST_MS));
+
+    setMac(mac, 42);
+    UpSched_identify(&plan, mac, sizeof(mac));
+    offset = UpSched_offsetMs(&plan, UPSCHED_FIRST_SPREAD_MS);
+    CHECK(offset < UPSCHED_FIRST_SPREAD_MS);
+    CHECK_EQ(UpSched_waitMs(&plan, start), FIRST_MS + offset);
+    CHECK(plan.identified);
+
+    /* Identified once; a second call does not move the report */
+    setMac(mac, 43);
+    UpSched_identify(&plan, mac, sizeof(mac));
+    CHECK_EQ(UpSched_waitMs(&plan, start), FIRST_MS + offset);
+
+    /* Overdue work waits 0, not a wrapped 49 days */
+    CHECK_EQ(UpSched_waitMs(&plan, start + FIRST_MS + offset + 5000), 0);
+    CHECK(UpSched_pollDue(&plan, start + FIRST_MS + offset));
+}
+
+/*
+ *  ======== testSlots ========
+ */
+static void testSlots(void)
+{
+    UpSched_Plan plan;
+    uint8_t      mac[6];
+    uint32_t     offset;
+    uint32_t     wait;
+    uint32_t     now = 1000;
+    int64_t      utc = UTC_MS;
+    int          i;
+
+    UpSched_init(&plan, &params, 0);
+    setMac(mac, 7);
+    UpSched_identify(&plan, mac, sizeof(mac));
+    offset = UpSched_offsetMs(&plan, PERIOD_MS);
+
+    /* With UTC every report lands on the offset into the period */
+    for (i = 0; i < 20; i++) {
+        UpSched_routineDone(&plan, true, 0, 0, utc, now);
+        wait = UpSched_waitMs(&plan, now);
+        CHECK_EQ((uint64_t)(utc + wait) % PERIOD_MS, offset);
+        CHECK(wait >= PERIOD_MS / 4);
+        CHECK(wait < PERIOD_MS + PERIOD_MS / 4);
+        now += wait + 300;
+        utc += wait + 300;
+    }
+
+    /* Without UTC the phase is kept */
+    UpSched_routineDone(&plan, true, 0, 0, 0, now);
+    CHECK_EQ(UpSched_waitMs(&plan, now), PERIOD_MS);
+
+    /* A server slot wins, within bounds */
+    UpSched_routineDone(&plan, true, 0, 600, utc, now);
+    CHECK_EQ(UpSched_waitMs(&plan, now), 600 * 1000);
+    UpSched_routineDone(&plan, true, 0, 1, utc, now);
+    CHECK_EQ(UpSched_waitMs(&plan, now), UPSCHED_MIN_SLOT_S * 1000);
+    UpSched_routineDone(&plan, true, 0, 10 * UPSCHED_MAX_SLOT_S, utc, now);
+    CHECK_EQ(UpSched_waitMs(&plan, now), UPSCHED_MAX_SLOT_S * 1000);
+
+    /* Polls follow their own period, and back off only when told */
+    UpSched_pollDone(&plan, true, 0, now);
+    CHECK(!UpSched_pollDue(&plan, now + POLL_MS - 1));
+    CHECK(UpSched_pollDue(&plan, now + POLL_MS));
+    UpSched_pollDone(&plan, false, 0, now + POLL_MS);
+    CHECK(UpSched_pollDue(&plan, now + POLL_MS));
+    UpSched_pollDone(&plan, false, 120, now + POLL_MS);
+    CHECK(!UpSched_pollDue(&plan, now + POLL_MS + 119999));
+    CHECK(UpSched_pollDue(&plan, now + POLL_MS + 120000));
+}
+
+/*
+ *  ======== testBackoff ========
+ *  Decorrelated jitter: base <= wait <= min(3 * last, cap).
+ */
+static void testBackoff(uint32_t start)
+{
+    UpSched_Plan plan;
+    uint8_t      mac[6];
+    uint32_t     last = RETRY_MS;
+    uint32_t     wait;
+    uint32_t     limit;
+    uint32_t     now = start;
+    bool         capped = false;
+    int          i;
+
+    UpSched_init(&plan, &params, start);
+    setMac(mac, 99);
+    UpSched_identify(&plan, mac, sizeof(mac));
+
+    for (i = 0; i < 40; i++) {
+        UpSched_routineDone(&plan, false, 0, 0, 0, now);
+        wait = UpSched_waitMs(&plan, now);
+        limit = (last * 3 < ROUTINE_CAP_MS) ? last * 3 : ROUTINE_CAP_MS;
+        CHECK(wait >= RETRY_MS);
+        CHECK(wait <= limit);
+        CHECK_EQ(plan.routine.failures, i + 1);
+        capped |= (wait == ROUTINE_CAP_MS);
+        last = wait;
+        now += wait;
+    }
+    CHECK(capped);
+
+    /* Retry-After replaces the computed wait, plus less than a base */
+    UpSched_routineDone(&plan, false, 90, 0, 0, now);
+    wait = UpSched_waitMs(&plan, now);
+    CHECK(wait >= 90000);
+    CHECK(wait < 90000 + RETRY_MS);
+
+    /* A success starts over */
+    UpSched_routineDone(&plan, true, 0, 0, 0, now);
+    CHECK_EQ(plan.routine.failures, 0);
+    CHECK_EQ(plan.routine.lastMs, 0);
+
+    /* Urgent retries are capped shorter and come first */
+    for (i = 0; i < 20; i++) {
+        UpSched_urgentDone(&plan, false, 0, now);
+        CHECK(plan.urgentPending);
+        wait = UpSched_waitMs(&plan, now);
+        CHECK(wait >= RETRY_MS);
+        CHECK(wait <= URGENT_CAP_MS);
+    }
+    UpSched_urgentDone(&plan, true, 0, now);
+    CHECK(!plan.urgentPending);
+    CHECK_EQ(UpSched_waitMs(&plan, now), PERIOD_MS);
+}
+
+/*
+ *  ======== testLinkDown ========
+ */
+static void testLinkDown(void)
+{
+    UpSched_Plan plan;
+    uint32_t     now = FIRST_MS + 100;
+
+    UpSched_init(&plan, &params, 0);
+    UpSched_urgentDone(&plan, false, 0, 0);
+    CHECK(UpSched_routineDue(&plan, now));
+
+    /* Overdue work moves to one base retry from now */
+    UpSched_linkDown(&plan, now);
+    CHECK(!UpSched_routineDue(&plan, now));
+    CHECK_EQ(UpSched_waitMs(&plan, now), RETRY_MS);
+
+    /* Work not yet due is left alone */
+    UpSched_routineDone(&plan, true, 0, 0, 0, now);
+    UpSched_urgentDone(&plan, true, 0, now);
+    UpSched_linkDown(&plan, now);
+    CHECK_EQ(UpSched_waitMs(&plan, now), PERIOD_MS);
+}
+
+/*
+ *  ======== testSuspend ========
+ *  A plan taken through hibernate continues where it was.
+ */
+static void testSuspend(void)
+{
+    UpSched_Plan       plan;
+    UpSched_Plan       resumed;
+    Hibernate_Schedule saved;
+    uint8_t            mac[6];
+    uint32_t           now = 5000;
+
+    UpSched_init(&plan, &params, 0);
+    setMac(mac, 3);
+    UpSched_identify(&plan, mac, sizeof(mac));
+    UpSched_routineDone(&plan, true, 0, 0, UTC_MS, now);
+    UpSched_pollDone(&plan, true, 0, now);
+    UpSched_urgentDone(&plan, false, 0, now);
+    UpSched_urgentDone(&plan, false, 0, now);
+
+    UpSched_suspend(&plan, &saved, now + 1000);
+
+    /* After a reboot the clock starts over */
+    UpSched_init(&resumed, &params, 0);
+    UpSched_resume(&resumed, &saved, 400, 50);
+    CHECK_EQ(UpSched_waitMs(&resumed, 50),
+            UpSched_waitMs(&plan, now + 1400));
+    CHECK_EQ(resumed.nextRoutineMs - 50, plan.nextRoutineMs - now - 1400);
+    CHECK_EQ(resumed.nextPollMs - 50, plan.nextPollMs - now - 1400);
+    CHECK_EQ(resumed.deviceHash, plan.deviceHash);
+    CHECK_EQ(resumed.random, plan.random);
+    CHECK_EQ(resumed.urgent.failures, 2);
+    CHECK_EQ(resumed.urgent.lastMs, plan.urgent.lastMs);
+    CHECK(resumed.identified);
+    CHECK(resumed.urgentPending);
+
+    /* Asleep past everything: all of it is due at once */
+    UpSched_resume(&resumed, &saved, 2 * POLL_MS, 50);
+    CHECK_EQ(UpSched_waitMs(&resumed, 50), 0);
+    CHECK(UpSched_routineDue(&resumed, 50));
+    CHECK(UpSched_pollDue(&resumed, 50));
+}
+
+/*
+ *  ======== testSpread ========
+ *  Sequential MAC addresses must cover the period evenly.
+ */
+static void testSpread(void)
+{
+    enum { METERS = 10000, BUCKETS = 15 };
+    UpSched_Plan plan;
+    uint32_t     buckets[BUCKETS] = {0};
+    uint8_t      mac[6];
+    uint32_t     i;
+
+    for (i = 0; i < METERS; i++) {
+        UpSched_init(&plan, &params, 0);
+        setMac(mac, i);
+        UpSched_identify(&plan, mac, sizeof(mac));
+        buckets[UpSched_offsetMs(&plan, PERIOD_MS) /
+                (PERIOD_MS / BUCKETS)]++;
+    }
+    for (i = 0; i < BUCKETS; i++) {
+        CHECK(buckets[i] > METERS / BUCKETS * 8 / 10);
+        CHECK(buckets[i] < METERS / BUCKETS * 12 / 10);
+    }
+}
+
+/*
+ *  ======== main ========
+ */
+int main(void)
+{
+    testFirst(0);
+    testFirst(UINT32_MAX - 10000);      /* across the wrap */
+    testSlots();
+    testBackoff(0);
+    testBackoff(UINT32_MAX - 100000);
+    testLinkDown();
+    testSuspend();
+    testSpread();
+
+    return (CHECK_DONE("upsched"));
+}
@@ -0,0 +1,217 @@
+/*
+ *  ======== uploadsim.c ========
+ *  Host simulation of the upload session under scripted network
+ *  conditions.
+ *
+ *  Runs the firmware's httpreq.c, dnscache.c and netshim.c against the
+ *  stand-in network of host/hostnet.c, on the simulated clock: no
+ *  sockets, no sleeping, and the same run gives the same numbers every
+ *  time. The device wakes every period and sends a batch of reports on
+ *  one session, each retried a few times, then closes the connection
+ *  and runs the deferred DNS refresh, as uploaderThread() does. With
+ *  keep-alive off the connection is closed after every request instead,
+ *  so the cost of a handshake per report shows.
+ *
+ *  The scenario (see ``shim`` and netshim.c) adds latency, loss, AP
+ *  drops and DHCP waits in front of the client; the stand-in server
+ *  adds the connect, TLS, lookup and request times. Prints what was
+ *  delivered, the requests and connects it took, the time the device
+ *  spent uploading and the radio time and energy of it all.
+ *
+ *  usage: uploadsim [-p period s] [-t minutes] [-b batch] [-k 0|1]
+ *                   [-r retries] [-l bytes] [-u server] [scenario]
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "appconfig.h"
+#include "dnscache.h"
+#include "host/host.h"
+#include "host/hostnet.h"
+#include "httpreq.h"
+#include "netshim.h"
+#include "netsched.h"
+#include "uploader.h"
+
+#define SIM_SERVER_ADDR             (0x0A000001)    /* 10.0.0.1 */
+
+static const HttpReq_Endpoint reportEndpoint = {
+    HTTP_METHOD_POST, UPLOADER_ROUTINE_URI, "application/json"
+};
+
+static char body[4096];
+
+/*
+ *  ======== usage ========
+ */
+static void usage(const char *name)
+{
+    unsigned int i;
+
+    fprintf(stderr, "usage: %s [-p period s] [-t minutes] [-b batch] "
+            "[-k 0|1] [-r retries] [-l bytes] [-u server] [scenario]\n"
+            "scenarios:", name);
+    for (i = 0; NetShim_scenario(i) != NULL; i++) {
+        fprintf(stderr, " %s", NetShim_scenario(i));
+    }
+    fprintf(stderr, "\n");
+    exit(2);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(int argc, char *argv[])
+{
+    HostNet_Server  server = {
+        .connectMs = 40,
+        .tlsMs = 600,
+        .requestMs = 80,
+        .lookupMs = 30,
+        .phyKbps = 0,
+        .status = 200,
+        .retryAfterS = 0,
+        .body = "{\"ok\":true}"
+    };
+    const char     *scenario = NULL;
+    const char     *url = "http://reports.example.net";
+    char            host[DNSCACHE_MAX_HOST];
+    AppConfig       config;
+    HttpReq_Session session;
+    HostNet_Stats   net;
+    NetShim_Stats   shim;
+    DnsCache_Stats  dns;
+    uint32_t        periodMs = 60000;
+    uint32_t        endMs = 60 * 60000;
+    uint32_t        batch = 4;
+    uint32_t        retries = 2;
+    uint32_t        len = 512;
+    bool            keepAlive = true;
+    uint32_t        wakeMs;
+    uint32_t        startMs;
+    uint32_t        uploadMs = 0;
+    uint32_t        wakes = 0;
+    uint32_t        reports = 0;
+    uint32_t        delivered = 0;
+    uint32_t        failures = 0;
+    uint32_t        i;
+    uint32_t        attempt;
+    size_t          n;
+    int16_t         ret;
+    int             opt;
+
+    while ((opt = getopt(argc, argv, "p:t:b:k:r:l:u:")) != -1) {
+        switch (opt) {
+            case 'p': periodMs = strtoul(optarg, NULL, 0) * 1000; break;
+            case 't': endMs = strtoul(optarg, NULL, 0) * 60000; break;
+            case 'b': batch = strtoul(optarg, NULL, 0); break;
+            case 'k': keepAlive = (strtoul(optarg, NULL, 0) != 0); break;
+            case 'r': retries = strtoul(optarg, NULL, 0); break;
+            case 'l': len = strtoul(optarg, NULL, 0); break;
+            case 'u': url = optarg; break;
+            default:  usage(argv[0]);
+        }
+    }
+    if (optind < argc) {
+        scenario = argv[optind];
+    }
+    if ((periodMs == 0) || (endMs == 0) || (endMs > 24 * 3600000) ||
+            (batch == 0) || (len > sizeof(body))) {
+        usage(argv[0]);
+    }
+
+    /* The server's name, as httpreq.c splits it */
+    n = strcspn(url, ":");
+    n = ((url[n] == ':') && (url[n + 1] == '/')) ? n + 3 : 0;
+    strncpy(host, url + n, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+    host[strcspn(host, ":/")] = '\0';
+
+    Host_setClockUs(0);
+    Host_wake(Hibernate_Wake_COLD);
+    HostNet_setServer(&server);
+    HostNet_addHost(host, SIM_SERVER_ADDR);
+
+    AppConfig_init();
+    AppConfig_copy(&config);
+    if (!AppConfig_set(&config, "server", url)) {
+        usage(argv[0]);
+    }
+    AppConfig_publish(&config);
+
+    memset(body, '7', sizeof(body));
+    if (HttpReq_init(&session) < 0) {
+        fprintf(stderr, "no client\n");
+        return (1);
+    }
+    if ((scenario != NULL) && !NetShim_start(scenario)) {
+        usage(argv[0]);
+    }
+
+    for (wakeMs = 0; wakeMs < endMs; wakeMs += periodMs) {
+        /* Asleep until the wake; a long upload delays the next one */
+        if (NetSched_nowMs() < wakeMs) {
+            Host_advanceUs((uint64_t)(wakeMs - NetSched_nowMs()) * 1000);
+        }
+        startMs = NetSched_nowMs();
+        wakes++;
+
+        for (i = 0; i < batch; i++) {
+            reports++;
+            for (attempt = 0; attempt <= retries; attempt++) {
+                ret = HttpReq_send(&session, &reportEndpoint, body, len);
+                if (!keepAlive) {
+                    HttpReq_close(&session);
+                }
+                if (ret == 200) {
+                    delivered++;
+                    break;
+                }
+                failures++;
+            }
+        }
+        HttpReq_close(&session);
+        DnsCache_refresh();
+
+        uploadMs += NetSched_nowMs() - startMs;
+    }
+
+    HostNet_getStats(&net);
+    NetShim_getStats(&shim);
+    DnsCache_getStats(&dns);
+
+    printf("%s, %lu min, a batch of %lu x %lu bytes every %lu s, "
+            "keep-alive %s, %lu retries\n",
+            (scenario != NULL) ? scenario : "clean",
+            (unsigned long)(endMs / 60000), (unsigned long)batch,
+            (unsigned long)len, (unsigned long)(periodMs / 1000),
+            keepAlive ? "on" : "off", (unsigned long)retries);
+    printf("reports %lu: delivered %lu, lost %lu; %lu failed attempts\n",
+            (unsigned long)reports, (unsigned long)delivered,
+            (unsigned long)(reports - delivered), (unsigned long)failures);
+    printf("requests %lu (%lu reused), connects %lu (%lu tls), "
+            "lookups %lu (%lu failed)\n",
+            (unsigned long)session.stats.requests,
+            (unsigned long)session.stats.reused,
+            (unsigned long)net.connects, (unsigned long)net.tlsConnects,
+            (unsigned long)net.lookups, (unsigned long)net.lookupFailures);
+    printf("dns hits %lu, stale %lu, misses %lu\n", (unsigned long)dns.hits,
+            (unsigned long)dns.stale, (unsigned long)dns.misses);
+    printf("upload %.1f s in %lu wakes (%.0f ms each), connected %.1f s\n",
+            uploadMs / 1000.0, (unsigned long)wakes,
+            (double)uploadMs / wakes, session.stats.activeMs / 1000.0);
+    printf("shim %lu dropped, %lu disconnects, %.1f s delay of which "
+            "%.1f s DHCP\n", (unsigned long)shim.dropped,
+            (unsigned long)shim.disconnects, shim.delayMs / 1000.0,
+            shim.dhcpMs / 1000.0);
+    printf("radio %.1f s, %.3f J\n",
+            (net.radioMs + shim.delayMs) / 1000.0,
+            ((double)net.energyUj + shim.energyUj) / 1000000.0);
+
+    return (0);
+}
@@ -0,0 +1,307 @@
+/*
+ *  ======== upschedload.c ========
+ *  Host load generator for the upload schedule.
+ *
+ *  Drives many UpSched_Plan instances, one per simulated meter, from one
+ *  event loop on a simulated clock, the way uploaderThread() drives the
+ *  firmware's plan. All meters power up together, as after a site wide
+ *  power restore. A stand-in server accepts a fixed number of requests
+ *  per second and answers 503 beyond that, with Retry-After if asked
+ *  to; on top of that a fraction of all requests can be made to fail
+ *  as if the network had dropped them.
+ *
+ *  Prints the server load and the report latency: from the moment a
+ *  report fell due on its meter until the server accepted it.
+ *
+ *  usage: upschedload [-n meters] [-p period min] [-c capacity/s]
+ *                     [-r retry-after s] [-f fail %] [-l service ms]
+ *                     [-t hours] [-s seed]
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "upsched.h"
+#include "uploader.h"
+
+/* Simulated UTC at power-up, so slots land on whole periods of UTC */
+#define LOAD_UTC_BASE_MS            (1700000000000LL)
+
+typedef struct Meter {
+    UpSched_Plan    plan;
+    uint32_t        dueMs;          /* report due since, while retrying */
+    bool            waiting;        /* a report is due */
+} Meter;
+
+typedef struct Event {
+    uint32_t        timeMs;
+    uint32_t        meter;
+} Event;
+
+static Meter       *meters;
+static Event       *heap;
+static uint32_t     heapLen = 0;
+
+static uint32_t    *latencies;
+static size_t       latencyLen = 0;
+static size_t       latencySize = 0;
+
+static uint32_t     random32 = 1;
+
+/*
+ *  ======== nextRandom ========
+ */
+static uint32_t nextRandom(void)
+{
+    random32 ^= random32 << 13;
+    random32 ^= random32 >> 17;
+    random32 ^= random32 << 5;
+
+    return (random32);
+}
+
+/*
+ *  ======== push ========
+ */
+static void push(uint32_t timeMs, uint32_t meter)
+{
+    uint32_t i = heapLen++;
+    Event    e = {timeMs, meter};
+
+    while ((i > 0) && (heap[(i - 1) / 2].timeMs > timeMs)) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = e;
+}
+
+/*
+ *  ======== pop ========
+ */
+static Event pop(void)
+{
+    Event    top = heap[0];
+    Event    last = heap[--heapLen];
+    uint32_t i = 0;
+    uint32_t child;
+
+    while ((child = 2 * i + 1) < heapLen) {
+        if ((child + 1 < heapLen) &&
+                (heap[child + 1].timeMs < heap[child].timeMs)) {
+            child++;
+        }
+        if (last.timeMs <= heap[child].timeMs) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+
+    return (top);
+}
+
+/*
+ *  ======== addLatency ========
+ */
+static void addLatency(uint32_t ms)
+{
+    if (latencyLen == latencySize) {
+        latencySize = latencySize ? latencySize * 2 : 4096;
+        latencies = realloc(latencies, latencySize * sizeof(*latencies));
+        if (latencies == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    latencies[latencyLen++] = ms;
+}
+
+/*
+ *  ======== compare ========
+ */
+static int compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return ((x > y) - (x < y));
+}
+
+/*
+ *  ======== percentile ========
+ */
+static uint32_t percentile(unsigned int p)
+{
+    if (latencyLen == 0) {
+        return (0);
+    }
+
+    return (latencies[(latencyLen - 1) * p / 100]);
+}
+
+/*
+ *  ======== usage ========
+ */
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n meters] [-p period min] "
+            "[-c capacity/s] [-r retry-after s] [-f fail %%] "
+            "[-l service ms] [-t hours] [-s seed]\n", name);
+    exit(2);
+}
+
+/*
+ *  ======== main ========
+ */
+int main(int argc, char *argv[])
+{
+    UpSched_Params params = {
+        .periodMs = UPLOADER_ROUTINE_MS,
+        .firstMs = UPLOADER_FIRST_REPORT_MS,
+        .pollPeriodMs = UPLOADER_POLL_MS,
+        .retryMs = UPLOADER_RETRY_MS,
+        .urgentCapMs = UPLOADER_URGENT_CAP_MS,
+        .routineCapMs = UPLOADER_ROUTINE_CAP_MS
+    };
+    uint32_t    count = 10000;
+    uint32_t    capacity = 50;
+    uint32_t    retryAfterS = 0;
+    uint32_t    failPercent = 0;
+    uint32_t    serviceMs = 200;
+    uint32_t    hours = 24;
+    uint32_t    endMs;
+    uint32_t    second = UINT32_MAX;
+    uint32_t    inSecond = 0;
+    uint32_t    peak = 0;
+    uint64_t    requests = 0;
+    uint64_t    accepted = 0;
+    uint64_t    refused = 0;
+    uint64_t    failed = 0;
+    uint8_t     mac[6] = {0x00, 0x12, 0x4B, 0, 0, 0};
+    Meter      *m;
+    Event       e;
+    uint32_t    i;
+    uint32_t    now;
+    uint32_t    hint;
+    bool        ok;
+    int         opt;
+
+    while ((opt = getopt(argc, argv, "n:p:c:r:f:l:t:s:")) != -1) {
+        switch (opt) {
+            case 'n': count = strtoul(optarg, NULL, 0); break;
+            case 'p': params.periodMs = strtoul(optarg, NULL, 0) * 60000;
+                      break;
+            case 'c': capacity = strtoul(optarg, NULL, 0); break;
+            case 'r': retryAfterS = strtoul(optarg, NULL, 0); break;
+            case 'f': failPercent = strtoul(optarg, NULL, 0); break;
+            case 'l': serviceMs = strtoul(optarg, NULL, 0); break;
+            case 't': hours = strtoul(optarg, NULL, 0); break;
+            case 's': random32 = strtoul(optarg, NULL, 0) | 1; break;
+            default:  usage(argv[0]);
+        }
+    }
+    if ((count == 0) || (params.periodMs == 0) || (hours == 0) ||
+            (hours > 24 * 40)) {
+        usage(argv[0]);
+    }
+    endMs = hours * 3600000;
+
+    meters = calloc(count, sizeof(*meters));
+    heap = calloc(count, sizeof(*heap));
+    if ((meters == NULL) || (heap == NULL)) {
+        perror("calloc");
+        return (1);
+    }
+
+    /* Power restore: every meter boots at 0 */
+    for (i = 0; i < count; i++) {
+        m = &meters[i];
+        UpSched_init(&m->plan, &params, 0);
+        mac[3] = (uint8_t)(i >> 16);
+        mac[4] = (uint8_t)(i >> 8);
+        mac[5] = (uint8_t)i;
+        UpSched_identify(&m->plan, mac, sizeof(mac));
+        push(UpSched_waitMs(&m->plan, 0), i);
+    }
+
+    while (heapLen > 0) {
+        e = pop();
+        now = e.timeMs;
+        if (now >= endMs) {
+            break;
+        }
+        m = &meters[e.meter];
+
+        if (!UpSched_routineDue(&m->plan, now)) {
+            push(now + UpSched_waitMs(&m->plan, now), e.meter);
+            continue;
+        }
+        if (!m->waiting) {
+            m->waiting = true;
+            m->dueMs = now;
+        }
+
+        /* The stand-in server: capacity per second, 503 beyond */
+        requests++;
+        hint = 0;
+        if ((failPercent != 0) && (nextRandom() % 100 < failPercent)) {
+            failed++;
+            ok = false;
+        }
+        else {
+            if (now / 1000 != second) {
+                second = now / 1000;
+                inSecond = 0;
+            }
+            ok = (inSecond < capacity);
+            inSecond++;
+            if (inSecond > peak) {
+                peak = inSecond;
+            }
+            if (!ok) {
+                refused++;
+                hint = retryAfterS;
+            }
+        }
+
+        now += serviceMs;
+        if (ok) {
+            accepted++;
+            addLatency(now - m->dueMs);
+            m->waiting = false;
+        }
+        UpSched_routineDone(&m->plan, ok, hint, 0, LOAD_UTC_BASE_MS + now,
+                now);
+        push(now + UpSched_waitMs(&m->plan, now), e.meter);
+    }
+
+    qsort(latencies, latencyLen, sizeof(*latencies), compare);
+
+    printf("meters %lu, period %lu min, %lu h simulated\n",
+            (unsigned long)count, (unsigned long)(params.periodMs / 60000),
+            (unsigned long)hours);
+    printf("server %lu/s, retry-after %lu s, %lu%% dropped, %lu ms "
+            "service\n", (unsigned long)capacity,
+            (unsigned long)retryAfterS, (unsigned long)failPercent,
+            (unsigned long)serviceMs);
+    printf("requests %llu: accepted %llu, 503 %llu, dropped %llu\n",
+            (unsigned long long)requests, (unsigned long long)accepted,
+            (unsigned long long)refused, (unsigned long long)failed);
+    printf("throughput %.2f reports/s (%.2f expected), peak %lu "
+            "requests/s\n", (double)accepted * 1000.0 / endMs,
+            (double)count * 1000.0 / params.periodMs, (unsigned long)peak);
+    printf("latency p50 %.1f s, p99 %.1f s, max %.1f s\n",
+            percentile(50) / 1000.0, percentile(99) / 1000.0,
+            percentile(100) / 1000.0);
+
+    free(latencies);
+    free(heap);
+    free(meters);
+
+    return (0);
+}
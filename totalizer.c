@@ -0,0 +1,521 @@
+/*
+ *  ======== totalizer.c ========
+ *  Flow measurement model, volume totalizer and checkpoints
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+
+#include <ti/drivers/Capture.h>
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "Board.h"
+#include "alarms.h"
+#include "console.h"
+#include "cycles.h"
+#include "hibernate.h"
+#include "i2cbus.h"
+#include "netsched.h"
+#include "rollup.h"
+#include "sensorspi.h"
+#include "supervisor.h"
+#include "timebase.h"
+#include "totalizer.h"
+
+#define TOTALIZER_THREAD_PRIORITY   (2)
+#define TOTALIZER_STACK_SIZE        (1024)
+#define TOTALIZER_DEADLINE_MS       (5000)
+
+/* Wait for a front-end block; pulses are still counted without one */
+#define TOTALIZER_BLOCK_WAIT_MS     (250)
+
+/*!
+ *  @brief  Checkpoint record, one per file
+ */
+typedef struct Totalizer_Checkpoint {
+    uint32_t    magic;
+    uint32_t    sequence;           /* the higher valid one wins */
+    uint64_t    totalNl;
+    uint64_t    pulses;
+    uint32_t    gainQ16;
+    uint32_t    checksum;           /* FNV-1a of the fields above */
+} Totalizer_Checkpoint;
+
+static Capture_Handle    captureHandle = NULL;
+static volatile uint32_t pulseCount = 0;
+
+/* Owned by the measurement thread */
+static uint32_t         lastPulseCount;
+static uint64_t         pulseRemainder;     /* nL * 1e6 */
+static uint64_t         analogRemainder;    /* nL * rate * 2^16 */
+static uint64_t         analogSinceNl;      /* since the last pulse */
+static uint64_t         driftPulseNl;
+static uint64_t         driftAnalogNl;
+static bool             analogFlowing = false;
+
+/* Shared, updated under HwiP_disable() */
+static Totalizer_Reading reading = {.gainQ16 = 0x10000,
+                                    .tempMilliC = TOTALIZER_TREF_MILLIC};
+static uint64_t         committedNl;        /* whole pulses and takeovers */
+static uint32_t         checkpointSequence = 0;
+static uint32_t         checkpointMs = 0;
+static bool             checkpointPending = false;
+static volatile uint32_t lastFlowMs = 0;
+
+static NetSched_Task    checkpointTask;
+
+/*
+ *  ======== checksum ========
+ */
+static uint32_t checksum(const Totalizer_Checkpoint *cp)
+{
+    const uint8_t *p = (const uint8_t *)cp;
+    uint32_t       hash = 0x811C9DC5;
+    size_t         i;
+
+    for (i = 0; i < offsetof(Totalizer_Checkpoint, checksum); i++) {
+        hash = (hash ^ p[i]) * 0x01000193;
+    }
+
+    return (hash);
+}
+
+/*
+ *  ======== captureCallback ========
+ */
+static void captureCallback(Capture_Handle handle, uint32_t interval)
+{
+    pulseCount++;
+}
+
+/*
+ *  ======== compensationPpm ========
+ *  Pulse volume scale for the meter temperature, 1e6 = none.
+ */
+static uint32_t compensationPpm(int32_t *tempMilliC)
+{
+    I2cBus_Reading r;
+
+    if (I2cBus_read(I2cBus_Value_TEMPERATURE, &r)) {
+        *tempMilliC = r.value;
+    }
+
+    return ((uint32_t)(1000000 + (int32_t)TOTALIZER_ALPHA_PPM_PER_C *
+            (*tempMilliC - TOTALIZER_TREF_MILLIC) / 1000));
+}
+
+/*
+ *  ======== analogVolume ========
+ *  Volume of one front-end block, nL, with the current gain.
+ */
+static uint64_t analogVolume(const int16_t *samples, uint32_t gainQ16)
+{
+    const uint64_t divisor = (uint64_t)TOTALIZER_SAMPLE_RATE_HZ << 16;
+    uint32_t       sum = 0;
+    uint64_t       volume;
+    int32_t        v;
+    int            i;
+
+    for (i = 0; i < SENSORSPI_BLOCK_SAMPLES; i++) {
+        v = samples[i] - TOTALIZER_ZERO_OFFSET;
+        if (v > TOTALIZER_DEADBAND) {
+            sum += (uint32_t)v;
+        }
+    }
+
+    analogRemainder += (uint64_t)sum * TOTALIZER_NL_PER_LSB_S * gainQ16;
+    volume = analogRemainder / divisor;
+    analogRemainder -= volume * divisor;
+
+    return (volume);
+}
+
+/*
+ *  ======== trimGain ========
+ *  Move the analog gain an eighth of the way towards the value that
+ *  would have made the analog volume match the pulses.
+ */
+static uint32_t trimGain(uint32_t gainQ16)
+{
+    uint64_t target;
+
+    if (driftPulseNl < TOTALIZER_DRIFT_WINDOW_NL) {
+        return (gainQ16);
+    }
+    if (driftAnalogNl != 0) {
+        target = (uint64_t)gainQ16 * driftPulseNl / driftAnalogNl;
+        if (target > (uint64_t)gainQ16 * 2) {
+            target = (uint64_t)gainQ16 * 2;
+        }
+        else if (target < gainQ16 / 2) {
+            target = gainQ16 / 2;
+        }
+        gainQ16 = (uint32_t)((int64_t)gainQ16 +
+                (((int64_t)target - (int64_t)gainQ16) / 8));
+    }
+    driftPulseNl = 0;
+    driftAnalogNl = 0;
+
+    return (gainQ16);
+}
+
+/*
+ *  ======== update ========
+ *  One step of the model: new pulses, and a front-end block if there
+ *  is one.
+ */
+static void update(const int16_t *samples)
+{
+    uint32_t  now = Timebase_monoMs();
+    uint32_t  pulses = pulseCount;
+    uint32_t  delta = pulses - lastPulseCount;
+    uint64_t  pulseNl = 0;
+    uint64_t  blockNl = 0;
+    uint64_t  fraction;
+    uint64_t  sinceCheckpoint;
+    uint32_t  rate = 0;
+    uint32_t  startGain = reading.gainQ16;
+    uint32_t  gainQ16 = startGain;
+    uint32_t  ppm;
+    int32_t   tempMilliC = reading.tempMilliC;
+    bool      takeover = false;
+    bool      signal = false;
+    uintptr_t key;
+
+    lastPulseCount = pulses;
+    ppm = compensationPpm(&tempMilliC);
+
+    if (samples != NULL) {
+        blockNl = analogVolume(samples, gainQ16);
+        rate = (uint32_t)(blockNl * TOTALIZER_SAMPLE_RATE_HZ /
+                SENSORSPI_BLOCK_SAMPLES);
+        analogSinceNl += blockNl;
+        driftAnalogNl += blockNl;
+        Rollup_add(rate, (uint32_t)blockNl, now);
+        Alarms_feed(Alarms_Source_FLOW, (int32_t)rate, now);
+    }
+    if (rate >= TOTALIZER_FLOW_START_NL_S) {
+        analogFlowing = true;
+    }
+    else if (rate < TOTALIZER_FLOW_STOP_NL_S) {
+        analogFlowing = false;
+    }
+    if ((delta != 0) || analogFlowing) {
+        lastFlowMs = now;
+    }
+
+    if (delta != 0) {
+        pulseRemainder += (uint64_t)delta * TOTALIZER_PULSE_NL * ppm;
+        pulseNl = pulseRemainder / 1000000;
+        pulseRemainder -= pulseNl * 1000000;
+        driftPulseNl += pulseNl;
+        analogSinceNl = 0;
+        gainQ16 = trimGain(gainQ16);
+    }
+    else if (analogSinceNl >= TOTALIZER_TAKEOVER_NL) {
+        /* No pulses: either very low flow or a dead pulse input */
+        pulseNl = analogSinceNl;
+        analogSinceNl = 0;
+        driftPulseNl = 0;
+        driftAnalogNl = 0;
+        takeover = true;
+    }
+
+    /* The fraction of a pulse seen by the analog path */
+    fraction = (analogSinceNl < TOTALIZER_PULSE_NL) ?
+            analogSinceNl : TOTALIZER_PULSE_NL - 1;
+
+    key = HwiP_disable();
+    committedNl += pulseNl;
+    reading.totalNl = committedNl + fraction;
+    reading.pulses += delta;
+    reading.rateNlPerS = rate;
+    if (gainQ16 != startGain) {
+        /* Only when trimmed, so a restore in between is not undone */
+        reading.gainQ16 = gainQ16;
+    }
+    reading.tempMilliC = tempMilliC;
+    reading.updates++;
+    if (takeover) {
+        reading.takeovers++;
+    }
+    sinceCheckpoint = committedNl - reading.checkpointNl;
+    if (reading.restored && !checkpointPending && (sinceCheckpoint != 0) &&
+            ((now - checkpointMs) >= TOTALIZER_CHECKPOINT_MIN_MS) &&
+            ((sinceCheckpoint >= TOTALIZER_CHECKPOINT_NL) ||
+             ((now - checkpointMs) >= TOTALIZER_CHECKPOINT_MS))) {
+        checkpointPending = true;
+        signal = true;
+    }
+    HwiP_restore(key);
+
+    if (signal) {
+        NetSched_signal(NETSCHED_EVENT_CHECKPOINT);
+    }
+}
+
+/*
+ *  ======== totalizerThread ========
+ */
+static void *totalizerThread(void *arg)
+{
+    const int16_t *block;
+    Supervisor_Id  watchdogId;
+    uint32_t       start;
+    uint32_t       cycles;
+
+    watchdogId = Supervisor_register("totalizer", TOTALIZER_DEADLINE_MS);
+
+    while (1) {
+        Supervisor_checkin(watchdogId, (int32_t)reading.updates);
+
+        block = SensorSpi_acquire(TOTALIZER_BLOCK_WAIT_MS);
+
+        start = Cycles_now();
+        update(block);
+        cycles = Cycles_now() - start;
+        if (cycles > reading.maxCycles) {
+            reading.maxCycles = cycles;
+        }
+
+        if (block != NULL) {
+            SensorSpi_release();
+        }
+    }
+}
+
+/*
+ *  ======== checkpointFxn ========
+ *  Writes checkpoints on the network scheduler, where the NWP may be
+ *  called.
+ */
+static PT_THREAD(checkpointFxn(NetSched_Task *task))
+{
+    PT_BEGIN(&task->pt);
+
+    while (1) {
+        NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_CHECKPOINT);
+        Totalizer_save();
+        checkpointPending = false;
+    }
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== Totalizer_init ========
+ */
+int Totalizer_init(void)
+{
+    Capture_Params     captureParams;
+    pthread_t          thread;
+    pthread_attr_t     pAttrs;
+    struct sched_param priParam;
+
+    Cycles_enable();
+
+    /* The edge that woke us from hibernate was a pulse; count it */
+    if (Hibernate_wake() == Hibernate_Wake_GPIO) {
+        pulseCount = 1;
+    }
+    lastFlowMs = Timebase_monoMs();
+
+    Capture_Params_init(&captureParams);
+    captureParams.mode = Capture_RISING_EDGE;
+    captureParams.callbackFxn = captureCallback;
+    captureParams.periodUnit = Capture_PERIOD_US;
+    captureHandle = Capture_open(Board_CAPTURE0, &captureParams);
+    if ((captureHandle == NULL) ||
+            (Capture_start(captureHandle) != Capture_STATUS_SUCCESS)) {
+        return (-1);
+    }
+
+    NetSched_start(&checkpointTask, checkpointFxn, NULL);
+
+    pthread_attr_init(&pAttrs);
+    priParam.sched_priority = TOTALIZER_THREAD_PRIORITY;
+    pthread_attr_setschedparam(&pAttrs, &priParam);
+    pthread_attr_setstacksize(&pAttrs, TOTALIZER_STACK_SIZE);
+    pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &pAttrs, totalizerThread, NULL) != 0) {
+        return (-1);
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== readCheckpoint ========
+ */
+static bool readCheckpoint(const char *name, Totalizer_Checkpoint *cp)
+{
+    _u32 token = 0;
+    _i32 fd;
+    _i32 len;
+
+    fd = sl_FsOpen((const _u8 *)name, SL_FS_READ, &token);
+    if (fd < 0) {
+        return (false);
+    }
+    len = sl_FsRead(fd, 0, (_u8 *)cp, sizeof(*cp));
+    sl_FsClose(fd, NULL, NULL, 0);
+
+    return ((len == sizeof(*cp)) && (cp->magic == TOTALIZER_MAGIC) &&
+            (cp->checksum == checksum(cp)));
+}
+
+/*
+ *  ======== Totalizer_restore ========
+ */
+bool Totalizer_restore(void)
+{
+    Totalizer_Checkpoint cp[2];
+    const Totalizer_Checkpoint *best = NULL;
+    bool      valid0;
+    bool      valid1;
+    uintptr_t key;
+
+    valid0 = readCheckpoint(TOTALIZER_FILE_NAME_0, &cp[0]);
+    valid1 = readCheckpoint(TOTALIZER_FILE_NAME_1, &cp[1]);
+    if (valid0 && valid1) {
+        best = ((int32_t)(cp[1].sequence - cp[0].sequence) > 0) ?
+                &cp[1] : &cp[0];
+    }
+    else if (valid0 || valid1) {
+        best = valid0 ? &cp[0] : &cp[1];
+    }
+
+    key = HwiP_disable();
+    if ((best != NULL) && !reading.restored) {
+        committedNl += best->totalNl;
+        reading.totalNl += best->totalNl;
+        reading.pulses += best->pulses;
+        reading.gainQ16 = best->gainQ16;
+        reading.checkpointNl = best->totalNl;
+        checkpointSequence = best->sequence;
+    }
+    reading.restored = true;
+    checkpointMs = Timebase_monoMs();
+    HwiP_restore(key);
+
+    return (best != NULL);
+}
+
+/*
+ *  ======== Totalizer_save ========
+ */
+int32_t Totalizer_save(void)
+{
+    Totalizer_Checkpoint cp;
+    _u32      token = 0;
+    _i32      fd;
+    _i32      ret;
+    uintptr_t key;
+
+    key = HwiP_disable();
+    if (!reading.restored) {
+        /* Would overwrite the real total with the one since boot */
+        HwiP_restore(key);
+        return (-1);
+    }
+    cp.magic = TOTALIZER_MAGIC;
+    cp.sequence = checkpointSequence + 1;
+    cp.totalNl = committedNl;
+    cp.pulses = reading.pulses;
+    cp.gainQ16 = reading.gainQ16;
+    HwiP_restore(key);
+    cp.checksum = checksum(&cp);
+
+    fd = sl_FsOpen((const _u8 *)((cp.sequence & 1) ?
+            TOTALIZER_FILE_NAME_1 : TOTALIZER_FILE_NAME_0),
+            SL_FS_CREATE | SL_FS_OVERWRITE |
+            SL_FS_CREATE_MAX_SIZE(sizeof(Totalizer_Checkpoint)), &token);
+    if (fd < 0) {
+        ret = fd;
+    }
+    else {
+        ret = sl_FsWrite(fd, 0, (_u8 *)&cp, sizeof(cp));
+        sl_FsClose(fd, NULL, NULL, 0);
+        if (ret == sizeof(cp)) {
+            ret = 0;
+        }
+        else if (ret >= 0) {
+            ret = -1;
+        }
+    }
+
+    /*
+     *  A failed write also restarts the spacing, or every update would
+     *  ask for another checkpoint straight away.
+     */
+    key = HwiP_disable();
+    if (ret == 0) {
+        checkpointSequence = cp.sequence;
+        reading.checkpointNl = cp.totalNl;
+        reading.checkpoints++;
+    }
+    else {
+        reading.checkpointErrors++;
+    }
+    checkpointMs = Timebase_monoMs();
+    HwiP_restore(key);
+
+    return (ret);
+}
+
+/*
+ *  ======== Totalizer_getReading ========
+ */
+void Totalizer_getReading(Totalizer_Reading *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = reading;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== Totalizer_idle ========
+ */
+bool Totalizer_idle(void)
+{
+    return ((Timebase_monoMs() - lastFlowMs) >= TOTALIZER_IDLE_MS);
+}
+
+/*
+ *  ======== cmdTotal ========
+ */
+static void cmdTotal(Console_Session *session, const Console_Args *args)
+{
+    char              printString[CONSOLE_PRINT_SIZE];
+    Totalizer_Reading r;
+
+    Totalizer_getReading(&r);
+    snprintf(printString, sizeof(printString),
+            "total %lu.%06lu L, %lu pulses, rate %lu nL/s, gain %lu/65536, "
+            "temp %ld mC",
+            (unsigned long)(r.totalNl / 1000000000ULL),
+            (unsigned long)((r.totalNl / 1000) % 1000000),
+            (unsigned long)r.pulses, (unsigned long)r.rateNlPerS,
+            (unsigned long)r.gainQ16, (long)r.tempMilliC);
+    Console_print(session, printString);
+
+    snprintf(printString, sizeof(printString),
+            "updates %lu (max %lu cycles), takeovers %lu, checkpoints %lu "
+            "(%lu failed)%s",
+            (unsigned long)r.updates, (unsigned long)r.maxCycles,
+            (unsigned long)r.takeovers, (unsigned long)r.checkpoints,
+            (unsigned long)r.checkpointErrors,
+            r.restored ? "" : " (not restored yet)");
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(total, "total", cmdTotal, "", "",
+                "volume total and flow rate");
@@ -0,0 +1,137 @@
+/*
+ *  ======== totalizer.h ========
+ *  Flow measurement model and volume totalizer.
+ *
+ *  Volume comes from two sources:
+ *   - pulses on Board_CAPTURE0, TOTALIZER_PULSE_NL each at the reference
+ *     temperature, corrected for the meter body temperature read by
+ *     i2cbus.c. The pulse count is the long term reference.
+ *   - the analog flow rate from the front-end blocks (sensorspi.c),
+ *     integrated between pulses. Its gain is continuously trimmed so the
+ *     analog volume over a drift window matches the pulse volume, which
+ *     removes sensor drift. Between pulses it fills in the fraction of a
+ *     pulse that has flowed; if pulses stop while the analog path keeps
+ *     seeing flow, the analog volume is committed on its own.
+ *
+ *  All arithmetic is integer. Volumes are 64-bit nanolitres and every
+ *  division carries its remainder forward, so nothing is lost to
+ *  rounding however long the device runs.
+ *
+ *  The total is checkpointed to the NWP file system, alternating between
+ *  two files so a power loss during a write leaves the other intact. A
+ *  checkpoint is written after TOTALIZER_CHECKPOINT_NL of flow, or
+ *  TOTALIZER_CHECKPOINT_MS after any flow, but never sooner than
+ *  TOTALIZER_CHECKPOINT_MIN_MS after the previous one. That caps flash
+ *  wear at 288 writes a day, 144 per file, whatever the flow; a failed
+ *  write waits out the same spacing before it is tried again. A power
+ *  loss costs at most TOTALIZER_CHECKPOINT_NL, or at high flow what
+ *  flowed in TOTALIZER_CHECKPOINT_MIN_MS if that is more (83 L at
+ *  1 m3/h), or 15 minutes of low flow.
+ *
+ *  Every block's flow rate goes to rollup.c for the interval summaries.
+ */
+#ifndef __TOTALIZER_H
+#define __TOTALIZER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TOTALIZER_FILE_NAME_0       "/flowness/tot0.bin"
+#define TOTALIZER_FILE_NAME_1       "/flowness/tot1.bin"
+#define TOTALIZER_MAGIC             (0x544F5431)    /* "TOT1" */
+
+/* Pulse output: 1 mL per pulse at the reference temperature */
+#define TOTALIZER_PULSE_NL          (1000000)
+
+/* Meter body expansion, ppm per degree C, around the reference */
+#define TOTALIZER_ALPHA_PPM_PER_C   (50)
+#define TOTALIZER_TREF_MILLIC       (20000)
+
+/* Front-end samples: rate, zero flow reading and nL/s per LSB */
+#define TOTALIZER_SAMPLE_RATE_HZ    (1024)
+#define TOTALIZER_ZERO_OFFSET       (0)
+#define TOTALIZER_DEADBAND          (8)
+#define TOTALIZER_NL_PER_LSB_S      (1000)
+
+/* Pulse volume over which the analog gain is re-trimmed */
+#define TOTALIZER_DRIFT_WINDOW_NL   (100 * TOTALIZER_PULSE_NL)
+
+/* Analog volume without a pulse after which the analog path is trusted */
+#define TOTALIZER_TAKEOVER_NL       (4 * TOTALIZER_PULSE_NL)
+
+/* No pulse and no analog flow for this long counts as idle */
+#define TOTALIZER_IDLE_MS           (2 * 60 * 1000)
+
+/*
+ *  Analog flow starts above START and stops below STOP, so noise that
+ *  gets past the deadband does not keep the meter awake
+ */
+#define TOTALIZER_FLOW_START_NL_S   (1000)
+#define TOTALIZER_FLOW_STOP_NL_S    (500)
+
+/* Checkpoint bounds: 10 L, or 15 minutes of any flow */
+#define TOTALIZER_CHECKPOINT_NL     (10000000000ULL)
+#define TOTALIZER_CHECKPOINT_MS     (15 * 60 * 1000)
+
+/* Spacing between checkpoints at any flow, for flash wear */
+#define TOTALIZER_CHECKPOINT_MIN_MS (5 * 60 * 1000)
+
+/*!
+ *  @brief  Snapshot of the measurement
+ */
+typedef struct Totalizer_Reading {
+    uint64_t    totalNl;            /* including the fraction of a pulse */
+    uint64_t    pulses;
+    uint32_t    rateNlPerS;         /* last block */
+    uint32_t    gainQ16;            /* analog trim, 1.0 = 0x10000 */
+    int32_t     tempMilliC;         /* used for compensation */
+    uint32_t    updates;
+    uint32_t    takeovers;          /* analog volume committed alone */
+    uint32_t    maxCycles;          /* most expensive update */
+    uint32_t    checkpoints;        /* written since boot */
+    uint32_t    checkpointErrors;   /* failed writes since boot */
+    uint64_t    checkpointNl;       /* total in the last checkpoint */
+    bool        restored;           /* the boot total came from flash */
+} Totalizer_Reading;
+
+/*!
+ *  @brief  Open the pulse input and start the measurement thread
+ *
+ *  @return 0 on success
+ */
+extern int Totalizer_init(void);
+
+/*!
+ *  @brief  Add the last checkpoint to the total. Needs the NWP; until
+ *          it has run no checkpoint is written.
+ *
+ *  @return true if a checkpoint was found
+ */
+extern bool Totalizer_restore(void);
+
+/*!
+ *  @brief  Write a checkpoint now. Needs the NWP.
+ *
+ *  @return 0 on success, negative SimpleLink error otherwise
+ */
+extern int32_t Totalizer_save(void);
+
+extern void Totalizer_getReading(Totalizer_Reading *reading);
+
+/*!
+ *  @brief  True once neither a pulse nor analog flow (see
+ *          TOTALIZER_FLOW_START_NL_S) has been seen for
+ *          TOTALIZER_IDLE_MS. Only then may the device hibernate; see
+ *          hibernate.h.
+ */
+extern bool Totalizer_idle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TOTALIZER_H */
@@ -0,0 +1,410 @@
+/*
+ *  ======== uartio.c ========
+ *  Buffered UART I/O for the console and logs
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <ti/drivers/UART.h>
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "Board.h"
+#include "console.h"
+#include "netsched.h"
+#include "uartio.h"
+
+#define UARTIO_TX_MASK              (UARTIO_TX_RING_SIZE - 1)
+#define UARTIO_RX_MASK              (UARTIO_RX_RING_SIZE - 1)
+
+static UART_Handle      uartHandle = NULL;
+static UART_Params      uartParams;
+static volatile bool    reopening = false;
+
+/* Transmit ring: head moved by writers, tail by the write callback */
+static uint8_t          txRing[UARTIO_TX_RING_SIZE];
+static volatile uint32_t txHead = 0;
+static volatile uint32_t txTail = 0;
+static volatile uint32_t txInFlight = 0;
+static volatile bool    txWaiting = false;  /* a writer waits for space */
+static pthread_mutex_t  txMutex;
+static volatile bool    claimed = false;
+static pthread_t        owner;              /* valid while claimed */
+static sem_t            txSpaceSem;
+
+/* Receive ring: head moved by the read callback, tail by the reader */
+static uint8_t          rxRing[UARTIO_RX_RING_SIZE];
+static volatile uint32_t rxHead = 0;
+static volatile uint32_t rxTail = 0;
+static uint8_t          rxByte;
+static sem_t            rxSem;
+
+static UartIo_Stats     stats;
+
+/*
+ *  ======== nextChunk ========
+ *  Claim the longest contiguous run of queued bytes for the next
+ *  transfer. Returns 0 if a transfer is already running or nothing is
+ *  queued. Call with interrupts disabled.
+ */
+static uint32_t nextChunk(uint32_t *start)
+{
+    uint32_t len;
+
+    if ((txInFlight != 0) || (txHead == txTail)) {
+        return (0);
+    }
+
+    *start = txTail & UARTIO_TX_MASK;
+    len = txHead - txTail;
+    if (*start + len > UARTIO_TX_RING_SIZE) {
+        len = UARTIO_TX_RING_SIZE - *start;
+    }
+    txInFlight = len;
+    stats.txTransfers++;
+
+    return (len);
+}
+
+/*
+ *  ======== kickTx ========
+ */
+static void kickTx(void)
+{
+    uintptr_t key;
+    uint32_t  start;
+    uint32_t  len;
+
+    key = HwiP_disable();
+    len = nextChunk(&start);
+    HwiP_restore(key);
+
+    if (len > 0) {
+        UART_write(uartHandle, &txRing[start], len);
+    }
+}
+
+/*
+ *  ======== writeCallback ========
+ */
+static void writeCallback(UART_Handle handle, void *buf, size_t count)
+{
+    uint32_t start;
+    uint32_t len;
+
+    txTail += txInFlight;
+    stats.txBytes += txInFlight;
+    txInFlight = 0;
+
+    /* UART_close() cancels the transfer; the handle is going away */
+    if (!reopening) {
+        len = nextChunk(&start);
+        if (len > 0) {
+            UART_write(handle, &txRing[start], len);
+        }
+    }
+
+    if (txWaiting) {
+        txWaiting = false;
+        sem_post(&txSpaceSem);
+    }
+}
+
+/*
+ *  ======== readCallback ========
+ */
+static void readCallback(UART_Handle handle, void *buf, size_t count)
+{
+    if (count > 0) {
+        if ((rxHead - rxTail) < UARTIO_RX_RING_SIZE) {
+            rxRing[rxHead & UARTIO_RX_MASK] = rxByte;
+            rxHead++;
+            stats.rxBytes++;
+            sem_post(&rxSem);
+        }
+        else {
+            stats.rxOverflows++;
+        }
+    }
+
+    /* UART_close() cancels the pending read; do not re-arm it */
+    if (!reopening) {
+        UART_read(handle, &rxByte, 1);
+    }
+}
+
+/*
+ *  ======== UartIo_init ========
+ */
+int UartIo_init(void)
+{
+    pthread_mutex_init(&txMutex, NULL);
+    sem_init(&txSpaceSem, 0, 0);
+    sem_init(&rxSem, 0, 0);
+
+    UART_init();
+
+    UART_Params_init(&uartParams);
+    uartParams.writeDataMode  = UART_DATA_BINARY;
+    uartParams.readDataMode   = UART_DATA_BINARY;
+    uartParams.readReturnMode = UART_RETURN_FULL;
+    uartParams.readEcho       = UART_ECHO_OFF;
+    uartParams.writeMode      = UART_MODE_CALLBACK;
+    uartParams.writeCallback  = writeCallback;
+    uartParams.readMode       = UART_MODE_CALLBACK;
+    uartParams.readCallback   = readCallback;
+    uartParams.baudRate       = UARTIO_DEFAULT_BAUD;
+    uartHandle = UART_open(Board_UART0, &uartParams);
+    if (uartHandle == NULL) {
+        return (-1);
+    }
+
+    UART_read(uartHandle, &rxByte, 1);
+
+    return (0);
+}
+
+/*
+ *  ======== UartIo_write ========
+ */
+void UartIo_write(const void *buf, size_t len)
+{
+    const uint8_t *src = (const uint8_t *)buf;
+    uint32_t       space;
+    uint32_t       offset;
+    uint32_t       first;
+    uint32_t       n;
+    uint32_t       blockedAt;
+    uint32_t       blockedMs;
+    uintptr_t      key;
+
+    if (uartHandle == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&txMutex);
+    if (claimed && !pthread_equal(pthread_self(), owner)) {
+        stats.txDropped += len;
+        pthread_mutex_unlock(&txMutex);
+        return;
+    }
+    while (len > 0) {
+        /* Flagged with the check, so the callback cannot slip between */
+        key = HwiP_disable();
+        space = UARTIO_TX_RING_SIZE - (txHead - txTail);
+        if (space == 0) {
+            txWaiting = true;
+        }
+        HwiP_restore(key);
+
+        if (space == 0) {
+            /* A transfer is always running while the ring is full */
+            blockedAt = NetSched_nowMs();
+            stats.txBlocked++;
+            sem_wait(&txSpaceSem);
+            blockedMs = NetSched_nowMs() - blockedAt;
+            if (blockedMs > stats.txMaxBlockedMs) {
+                stats.txMaxBlockedMs = blockedMs;
+            }
+            continue;
+        }
+
+        n = (len < space) ? len : space;
+        offset = txHead & UARTIO_TX_MASK;
+        first = UARTIO_TX_RING_SIZE - offset;
+        if (first > n) {
+            first = n;
+        }
+        memcpy(&txRing[offset], src, first);
+        memcpy(txRing, src + first, n - first);
+
+        key = HwiP_disable();
+        txHead += n;
+        HwiP_restore(key);
+
+        src += n;
+        len -= n;
+        kickTx();
+    }
+    pthread_mutex_unlock(&txMutex);
+}
+
+/*
+ *  ======== UartIo_readChar ========
+ */
+char UartIo_readChar(void)
+{
+    char c;
+
+    sem_wait(&rxSem);
+    c = (char)rxRing[rxTail & UARTIO_RX_MASK];
+    rxTail++;
+
+    return (c);
+}
+
+/*
+ *  ======== UartIo_readTimeout ========
+ */
+bool UartIo_readTimeout(char *c, uint32_t timeoutMs)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeoutMs / 1000;
+    ts.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    if (sem_timedwait(&rxSem, &ts) != 0) {
+        return (false);
+    }
+    *c = (char)rxRing[rxTail & UARTIO_RX_MASK];
+    rxTail++;
+
+    return (true);
+}
+
+/*
+ *  ======== UartIo_discardInput ========
+ */
+void UartIo_discardInput(void)
+{
+    while (sem_trywait(&rxSem) == 0) {
+        rxTail++;
+    }
+}
+
+/*
+ *  ======== UartIo_setBaud ========
+ *  The driver cannot change the rate of an open port, so drain the
+ *  transmit ring and reopen it.
+ */
+int UartIo_setBaud(uint32_t baudRate)
+{
+    int ret = 0;
+
+    UartIo_flush(UARTIO_FLUSH_MS);
+
+    pthread_mutex_lock(&txMutex);
+    reopening = true;
+    UART_close(uartHandle);
+    reopening = false;
+
+    /* Anything still queued was meant for the old rate */
+    txTail = txHead;
+    txInFlight = 0;
+
+    uartParams.baudRate = baudRate;
+    uartHandle = UART_open(Board_UART0, &uartParams);
+    if (uartHandle == NULL) {
+        uartParams.baudRate = UARTIO_DEFAULT_BAUD;
+        uartHandle = UART_open(Board_UART0, &uartParams);
+        ret = -1;
+    }
+    if (uartHandle != NULL) {
+        UART_read(uartHandle, &rxByte, 1);
+    }
+    pthread_mutex_unlock(&txMutex);
+
+    return (ret);
+}
+
+/*
+ *  ======== UartIo_baud ========
+ */
+uint32_t UartIo_baud(void)
+{
+    return (uartParams.baudRate);
+}
+
+/*
+ *  ======== UartIo_flush ========
+ */
+void UartIo_flush(uint32_t timeoutMs)
+{
+    uint32_t start = NetSched_nowMs();
+
+    while ((txHead != txTail) && (NetSched_nowMs() - start < timeoutMs)) {
+        usleep(1000);
+    }
+}
+
+/*
+ *  ======== UartIo_claim ========
+ *  Taken under txMutex, so a writer that is already copying finishes
+ *  its message before the owner's first byte.
+ */
+bool UartIo_claim(void)
+{
+    bool ok = false;
+
+    pthread_mutex_lock(&txMutex);
+    if (!claimed || pthread_equal(pthread_self(), owner)) {
+        owner = pthread_self();
+        claimed = true;
+        ok = true;
+    }
+    pthread_mutex_unlock(&txMutex);
+
+    return (ok);
+}
+
+/*
+ *  ======== UartIo_release ========
+ */
+void UartIo_release(void)
+{
+    pthread_mutex_lock(&txMutex);
+    if (claimed && pthread_equal(pthread_self(), owner)) {
+        claimed = false;
+    }
+    pthread_mutex_unlock(&txMutex);
+}
+
+/*
+ *  ======== UartIo_getStats ========
+ */
+void UartIo_getStats(UartIo_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdUart ========
+ */
+static void cmdUart(Console_Session *session, const Console_Args *args)
+{
+    char         printString[CONSOLE_PRINT_SIZE];
+    UartIo_Stats s;
+
+    UartIo_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "tx %lu bytes in %lu transfers, blocked %lu (max %lu ms)",
+            (unsigned long)s.txBytes, (unsigned long)s.txTransfers,
+            (unsigned long)s.txBlocked, (unsigned long)s.txMaxBlockedMs);
+    Console_print(session, printString);
+    snprintf(printString, sizeof(printString),
+            "tx %lu bytes dropped while claimed",
+            (unsigned long)s.txDropped);
+    Console_print(session, printString);
+    snprintf(printString, sizeof(printString),
+            "rx %lu bytes, %lu dropped",
+            (unsigned long)s.rxBytes, (unsigned long)s.rxOverflows);
+    Console_print(session, printString);
+}
+
+CONSOLE_COMMAND(uart, "uart", cmdUart, "", "", "UART I/O counters");
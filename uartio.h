@@ -0,0 +1,119 @@
+/*
+ *  ======== uartio.h ========
+ *  Buffered UART I/O for the console and logs.
+ *
+ *  UART0 runs in callback mode on the UARTCC32XXDMA driver. Writers copy
+ *  into a transmit ring and return; whatever is queued when the previous
+ *  transfer completes goes out as one DMA transfer, so several queued
+ *  messages cost one interrupt instead of one per byte. A writer only
+ *  blocks when the ring is full.
+ *
+ *  Received bytes are collected from the read callback into a receive
+ *  ring; bytes arriving while it is full are counted and dropped.
+ *
+ *  A thread that needs the port to itself (bulk transfers) claims it;
+ *  until it releases the port, writes from every other thread are
+ *  counted and dropped, so log and echo output cannot land inside its
+ *  byte stream.
+ */
+#ifndef __UARTIO_H
+#define __UARTIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define UARTIO_DEFAULT_BAUD         (115200)
+
+/* Longest UartIo_setBaud() waits for queued output at the old rate */
+#define UARTIO_FLUSH_MS             (500)
+
+/* Ring sizes, powers of two */
+#ifndef UARTIO_TX_RING_SIZE
+#define UARTIO_TX_RING_SIZE         (2048)
+#endif
+#ifndef UARTIO_RX_RING_SIZE
+#define UARTIO_RX_RING_SIZE         (256)
+#endif
+
+/*!
+ *  @brief  I/O counters
+ */
+typedef struct UartIo_Stats {
+    uint32_t    txBytes;
+    uint32_t    txTransfers;        /* DMA transfers started */
+    uint32_t    txBlocked;          /* writes that waited for ring space */
+    uint32_t    txMaxBlockedMs;
+    uint32_t    txDropped;          /* bytes dropped, port claimed */
+    uint32_t    rxBytes;
+    uint32_t    rxOverflows;        /* bytes dropped, receive ring full */
+} UartIo_Stats;
+
+/*!
+ *  @brief  Open UART0 in callback mode and start receiving
+ *
+ *  @return 0 on success
+ */
+extern int UartIo_init(void);
+
+/*!
+ *  @brief  Queue len bytes. Blocks only while the transmit ring is full.
+ *          Thread context only.
+ */
+extern void UartIo_write(const void *buf, size_t len);
+
+/*!
+ *  @brief  Block until a byte is received
+ */
+extern char UartIo_readChar(void);
+
+/*!
+ *  @brief  Wait up to timeoutMs for a byte
+ *
+ *  @return false on timeout
+ */
+extern bool UartIo_readTimeout(char *c, uint32_t timeoutMs);
+
+/*!
+ *  @brief  Drop everything in the receive ring
+ */
+extern void UartIo_discardInput(void);
+
+/*!
+ *  @brief  Drain the transmit ring and reopen the port at baudRate.
+ *          Falls back to UARTIO_DEFAULT_BAUD if the rate is refused.
+ *
+ *  @return 0 on success
+ */
+extern int UartIo_setBaud(uint32_t baudRate);
+
+extern uint32_t UartIo_baud(void);
+
+/*!
+ *  @brief  Wait up to timeoutMs for the transmit ring to drain
+ */
+extern void UartIo_flush(uint32_t timeoutMs);
+
+/*!
+ *  @brief  Give the calling thread the transmit side to itself
+ *
+ *  @return false if another thread holds it
+ */
+extern bool UartIo_claim(void);
+
+/*!
+ *  @brief  Let every thread write again
+ */
+extern void UartIo_release(void);
+
+extern void UartIo_getStats(UartIo_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UARTIO_H */
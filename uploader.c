@@ -0,0 +1,710 @@
+/*
+ *  ======== uploader.c ========
+ *  Alarm and routine reports to the server
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <ti/drivers/dpl/HwiP.h>
+#include <ti/drivers/net/wifi/simplelink.h>
+#include <ti/net/http/httpclient.h>
+
+#include "acoustic.h"
+#include "alarms.h"
+#include "appconfig.h"
+#include "boot.h"
+#include "console.h"
+#include "dnscache.h"
+#include "hibernate.h"
+#include "httpcache.h"
+#include "httpreq.h"
+#include "i2cbus.h"
+#include "netsched.h"
+#include "payloadsec.h"
+#include "rollup.h"
+#include "supervisor.h"
+#include "timebase.h"
+#include "totalizer.h"
+#include "uploader.h"
+#include "upsched.h"
+
+#define UPLOADER_PRIORITY           (1)
+#define UPLOADER_STACK_SIZE         (3072)
+
+/*
+ *  Longest one HTTP call may block: a connect the NWP gives up on
+ *  (lookup, TCP and TLS handshake), or a server that stops answering in
+ *  the middle of a response. The thread checks in before every call,
+ *  so the deadline only has to cover one, with a margin for the SNTP
+ *  and DNS refresh calls that follow the last one of a pass.
+ */
+#define UPLOADER_HTTP_TIMEOUT_MS    (40 * 1000)
+#define UPLOADER_DEADLINE_MS        (UPLOADER_HTTP_TIMEOUT_MS + 20 * 1000)
+
+/* Long waits are cut into pieces so the thread keeps checking in */
+#define UPLOADER_CHECKIN_MS         (UPLOADER_DEADLINE_MS / 2)
+
+static sem_t            wakeSem;
+static NetSched_Task    linkTask;
+static volatile bool    ipUp = false;
+static volatile bool    reportNow = false;
+static volatile bool    rawRequested = false;
+static bool             keysChecked = false;
+static bool             reported = false;   /* a routine report went out */
+static Supervisor_Id    watchdogId;
+
+/* Both word aligned for the crypto engine's DMA */
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_ALIGN(body, 4)
+#elif defined(__IAR_SYSTEMS_ICC__)
+#pragma data_alignment=4
+#elif defined(__GNUC__)
+__attribute__ ((aligned (4)))
+#endif
+static char             body[UPLOADER_BODY_SIZE];
+static uint32_t         sealed[(UPLOADER_BODY_SIZE + PAYLOADSEC_OVERHEAD + 3) /
+                               4];
+static Uploader_Stats   stats;
+static bool             cacheLoaded = false;
+static HttpReq_Session  httpSession;
+
+static UpSched_Plan     plan;
+
+static const UpSched_Params schedParams = {
+    .periodMs = UPLOADER_ROUTINE_MS,
+    .firstMs = UPLOADER_FIRST_REPORT_MS,
+    .pollPeriodMs = UPLOADER_POLL_MS,
+    .retryMs = UPLOADER_RETRY_MS,
+    .urgentCapMs = UPLOADER_URGENT_CAP_MS,
+    .routineCapMs = UPLOADER_ROUTINE_CAP_MS
+};
+
+static const HttpReq_Endpoint alarmEndpoint = {
+    HTTP_METHOD_POST, UPLOADER_ALARM_URI, "application/json"
+};
+static const HttpReq_Endpoint sealedAlarmEndpoint = {
+    HTTP_METHOD_POST, UPLOADER_ALARM_URI, "application/octet-stream"
+};
+static const HttpReq_Endpoint routineEndpoint = {
+    HTTP_METHOD_POST, UPLOADER_ROUTINE_URI, "application/json"
+};
+static const HttpReq_Endpoint sealedRoutineEndpoint = {
+    HTTP_METHOD_POST, UPLOADER_ROUTINE_URI, "application/octet-stream"
+};
+
+static HttpCache_Resource configResource = {
+    .uri = UPLOADER_CONFIG_URI,
+    .fileName = UPLOADER_CONFIG_FILE_NAME
+};
+static HttpCache_Resource manifestResource = {
+    .uri = UPLOADER_MANIFEST_URI,
+    .fileName = UPLOADER_MANIFEST_FILE_NAME
+};
+
+/*
+ *  ======== checkin ========
+ */
+static void checkin(void)
+{
+    Supervisor_checkin(watchdogId, stats.lastStatus);
+}
+
+/*
+ *  ======== waitWake ========
+ *
+ *  @return true if woken before the timeout
+ */
+static bool waitWake(uint32_t timeoutMs)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += timeoutMs / 1000;
+    ts.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    return (sem_timedwait(&wakeSem, &ts) == 0);
+}
+
+/*
+ *  ======== post ========
+ *
+ *  @return HTTP status, or a negative HTTPClient error
+ */
+static int16_t post(const HttpReq_Endpoint *endpoint, const char *data,
+        size_t len)
+{
+    int16_t ret;
+
+    checkin();
+    ret = HttpReq_send(&httpSession, endpoint, data, len);
+    stats.lastStatus = ret;
+
+    return (ret);
+}
+
+/*
+ *  ======== postBody ========
+ *  len bytes of body, sealed to sealedEndpoint if a payload key is
+ *  provisioned, else in clear to plainEndpoint.
+ *
+ *  @return HTTP status, negative if it could not be sent
+ */
+static int16_t postBody(const HttpReq_Endpoint *plainEndpoint,
+        const HttpReq_Endpoint *sealedEndpoint, int len)
+{
+    int32_t sealedLen;
+
+    if (!keysChecked) {
+        /* Needs the NWP, hence here and not at init */
+        PayloadSec_loadKey();
+        keysChecked = true;
+    }
+    if (!PayloadSec_ready()) {
+        return (post(plainEndpoint, body, len));
+    }
+
+    sealedLen = PayloadSec_seal((const uint8_t *)body, len,
+            (uint8_t *)sealed, sizeof(sealed));
+    if (sealedLen < 0) {
+        return (-1);
+    }
+
+    return (post(sealedEndpoint, (const char *)sealed, sealedLen));
+}
+
+/*
+ *  ======== applyConfig ========
+ *  Remote configuration: one "key=value" per line, applied through
+ *  AppConfig_set() and published and saved, all at once, if anything
+ *  changed.
+ */
+static void applyConfig(const char *text)
+{
+    char        line[sizeof(((AppConfig *)0)->serverHost) + 16];
+    char        current[sizeof(((AppConfig *)0)->serverHost)];
+    AppConfig   config;
+    char       *value;
+    size_t      n;
+    bool        changed = false;
+
+    AppConfig_copy(&config);
+
+    while (*text) {
+        n = strcspn(text, "\r\n");
+        if ((n > 0) && (n < sizeof(line))) {
+            memcpy(line, text, n);
+            line[n] = '\0';
+            value = strchr(line, '=');
+            if (value != NULL) {
+                *value++ = '\0';
+                if (AppConfig_get(line, current, sizeof(current)) &&
+                        (strcmp(current, value) != 0) &&
+                        AppConfig_set(&config, line, value)) {
+                    changed = true;
+                }
+            }
+        }
+        text += n;
+        text += strspn(text, "\r\n");
+    }
+
+    if (changed) {
+        AppConfig_publish(&config);
+        AppConfig_save();
+    }
+}
+
+/*
+ *  ======== pollResources ========
+ *  Conditional GETs of the remote configuration and the firmware
+ *  manifest on one connection. Unchanged resources cost a 304 each.
+ *
+ *  @return false if a resource could not be checked or the server asked
+ *          to be left alone (httpSession.retryAfterS)
+ */
+static bool pollResources(void)
+{
+    int16_t ret;
+
+    if (!cacheLoaded) {
+        HttpCache_load(&configResource);
+        HttpCache_load(&manifestResource);
+        cacheLoaded = true;
+    }
+
+    checkin();
+    ret = HttpCache_get(&configResource, &httpSession);
+    if (ret == HTTP_SC_OK) {
+        applyConfig(configResource.record.body);
+    }
+    /* A server that asked for time gets it before the next resource */
+    if ((ret >= 0) && (httpSession.retryAfterS == 0)) {
+        checkin();
+        ret = HttpCache_get(&manifestResource, &httpSession);
+    }
+    stats.lastStatus = ret;
+
+    return ((ret >= 0) && (httpSession.retryAfterS == 0));
+}
+
+/*
+ *  ======== sendAlarms ========
+ *
+ *  @return false if the queued events could not be delivered
+ */
+static bool sendAlarms(void)
+{
+    Alarms_Event events[UPLOADER_MAX_EVENTS];
+    AppConfig    config;
+    uint32_t     latency;
+    int16_t      ret;
+    int          count;
+    int          len;
+    int          i;
+
+    AppConfig_copy(&config);
+    while ((count = Alarms_peek(events, UPLOADER_MAX_EVENTS)) > 0) {
+        len = snprintf(body, sizeof(body), "{\"device\":\"%s\",\"alarms\":[",
+                config.deviceName);
+        for (i = 0; (i < count) && (len < (int)sizeof(body)); i++) {
+            len += snprintf(body + len, sizeof(body) - len,
+                    "%s{\"seq\":%lu,\"rule\":\"%s\",\"raised\":%d,"
+                    "\"value\":%ld,\"ageMs\":%lu}",
+                    (i > 0) ? "," : "", (unsigned long)events[i].seq,
+                    Alarms_rule(events[i].rule)->name,
+                    events[i].raised, (long)events[i].value,
+                    (unsigned long)(Timebase_monoMs() - events[i].timeMs));
+        }
+        if (len < (int)sizeof(body)) {
+            len += snprintf(body + len, sizeof(body) - len, "]}");
+        }
+        if (len >= (int)sizeof(body)) {
+            /* Cannot happen with UPLOADER_MAX_EVENTS; do not get stuck */
+            Alarms_ack(events[count - 1].seq);
+            continue;
+        }
+
+        ret = postBody(&alarmEndpoint, &sealedAlarmEndpoint, len);
+        if ((ret < 200) || (ret >= 300)) {
+            stats.urgentFailed++;
+            return (false);
+        }
+
+        Alarms_ack(events[count - 1].seq);
+        stats.urgentOk++;
+        latency = Timebase_monoMs() - events[0].timeMs;
+        stats.lastAlarmLatencyMs = latency;
+        if (latency > stats.maxAlarmLatencyMs) {
+            stats.maxAlarmLatencyMs = latency;
+        }
+    }
+
+    return (true);
+}
+
+/*
+ *  ======== putSummary ========
+ *  [duration, count, min, mean, max, sd, volume, [histogram]]
+ */
+static int putSummary(char *out, int size, const char *name,
+                      const Rollup_Summary *s)
+{
+    int len;
+    int i;
+
+    len = snprintf(out, size, ",\"%s\":[%lu,%lu,%lu,%lu,%lu,%lu,%llu,[",
+            name, (unsigned long)s->durationMs, (unsigned long)s->count,
+            (unsigned long)s->min, (unsigned long)s->mean,
+            (unsigned long)s->max, (unsigned long)s->stddev,
+            (unsigned long long)s->volumeNl);
+    for (i = 0; (i < ROLLUP_HIST_BUCKETS) && (len < size); i++) {
+        len += snprintf(out + len, size - len, "%s%u", (i > 0) ? "," : "",
+                s->hist[i]);
+    }
+    if (len < size) {
+        len += snprintf(out + len, size - len, "]]");
+    }
+
+    return (len);
+}
+
+/*
+ *  ======== sendRoutine ========
+ */
+static bool sendRoutine(void)
+{
+    Totalizer_Reading r;
+    Rollup_Summary    s;
+    I2cBus_Reading    pressure;
+    Acoustic_Features f;
+    AppConfig         config;
+    uint32_t          rates[ROLLUP_RAW_SIZE];
+    bool              withRaw = rawRequested;
+    int64_t           utc;
+    int16_t           ret;
+    int               count;
+    int               len;
+    int               i;
+
+    AppConfig_copy(&config);
+    Totalizer_getReading(&r);
+    len = snprintf(body, sizeof(body),
+            "{\"device\":\"%s\",\"uptimeMs\":%lu,\"totalNl\":%llu,"
+            "\"rateNlPerS\":%lu,\"tempMilliC\":%ld,\"alarms\":%lu",
+            config.deviceName, (unsigned long)NetSched_nowMs(),
+            (unsigned long long)r.totalNl, (unsigned long)r.rateNlPerS,
+            (long)r.tempMilliC, (unsigned long)Alarms_active());
+    if (Timebase_utcUs(&utc)) {
+        len += snprintf(body + len, sizeof(body) - len, ",\"utcMs\":%lld",
+                (long long)(utc / 1000));
+    }
+    if (I2cBus_read(I2cBus_Value_PRESSURE, &pressure)) {
+        len += snprintf(body + len, sizeof(body) - len,
+                ",\"pressurePa\":%ld", (long)pressure.value);
+    }
+    if ((len < (int)sizeof(body)) &&
+            Rollup_get(Rollup_Period_QUARTER, &s)) {
+        len += putSummary(body + len, sizeof(body) - len, "quarter", &s);
+    }
+    if ((len < (int)sizeof(body)) && Rollup_get(Rollup_Period_HOUR, &s)) {
+        len += putSummary(body + len, sizeof(body) - len, "hour", &s);
+    }
+    if (withRaw && (len < (int)sizeof(body))) {
+        count = Rollup_raw(rates, ROLLUP_RAW_SIZE);
+        len += snprintf(body + len, sizeof(body) - len, ",\"raw\":[");
+        for (i = 0; (i < count) && (len < (int)sizeof(body)); i++) {
+            len += snprintf(body + len, sizeof(body) - len, "%s%lu",
+                    (i > 0) ? "," : "", (unsigned long)rates[i]);
+        }
+        if (len < (int)sizeof(body)) {
+            len += snprintf(body + len, sizeof(body) - len, "]");
+        }
+    }
+    if ((len < (int)sizeof(body)) && Acoustic_getFeatures(&f)) {
+        len += snprintf(body + len, sizeof(body) - len,
+                ",\"acoustic\":{\"rms\":%u,\"peakBin\":%u,\"bands\":[",
+                f.rms, f.peakBin);
+        for (i = 0; (i < ACOUSTIC_NUM_BANDS) && (len < (int)sizeof(body));
+                i++) {
+            len += snprintf(body + len, sizeof(body) - len, "%s%lu",
+                    (i > 0) ? "," : "", (unsigned long)f.band[i]);
+        }
+        if (len < (int)sizeof(body)) {
+            len += snprintf(body + len, sizeof(body) - len, "]}");
+        }
+    }
+    if (len < (int)sizeof(body)) {
+        len += snprintf(body + len, sizeof(body) - len, "}");
+    }
+    if (len >= (int)sizeof(body)) {
+        stats.routineFailed++;
+        return (false);
+    }
+
+    ret = postBody(&routineEndpoint, &sealedRoutineEndpoint, len);
+    if ((ret < 200) || (ret >= 300)) {
+        stats.routineFailed++;
+        return (false);
+    }
+    stats.routineOk++;
+    reported = true;
+    if (withRaw) {
+        rawRequested = false;
+    }
+    Boot_mark(Boot_Phase_FIRST_UPLOAD);
+
+    return (true);
+}
+
+/*
+ *  ======== identify ========
+ *  The MAC address places this device's slots.
+ */
+static void identify(void)
+{
+    uint8_t  mac[SL_MAC_ADDR_LEN];
+    uint16_t len = sizeof(mac);
+
+    if (sl_NetCfgGet(SL_NETCFG_MAC_ADDRESS_GET, NULL, &len, mac) >= 0) {
+        UpSched_identify(&plan, mac, sizeof(mac));
+    }
+}
+
+/*
+ *  ======== uploaderThread ========
+ *  Carries out the plan; all timing decisions are in upsched.c.
+ */
+static void *uploaderThread(void *arg0)
+{
+    Hibernate_Schedule saved;
+    uint32_t           waitMs;
+    int64_t            utc;
+    bool               ok;
+
+    watchdogId = Supervisor_register("uploader", UPLOADER_DEADLINE_MS);
+
+    /* The client lives as long as the thread; only connections come and go */
+    HttpReq_init(&httpSession);
+
+    while (1) {
+        HttpReq_close(&httpSession);
+
+        waitMs = UpSched_waitMs(&plan, NetSched_nowMs());
+        while (waitMs > 0) {
+            checkin();
+            if (waitWake((waitMs < UPLOADER_CHECKIN_MS) ?
+                    waitMs : UPLOADER_CHECKIN_MS)) {
+                break;
+            }
+            waitMs = UpSched_waitMs(&plan, NetSched_nowMs());
+        }
+        checkin();
+        if (!ipUp) {
+            /* The link task wakes us when the address comes back */
+            UpSched_linkDown(&plan, NetSched_nowMs());
+            continue;
+        }
+        if (!plan.identified) {
+            /* Needs the NWP, so not before the first link up */
+            identify();
+        }
+
+        /* Urgent work first, every time round */
+        ok = sendAlarms();
+        UpSched_urgentDone(&plan, ok, httpSession.retryAfterS,
+                NetSched_nowMs());
+        if (!ok) {
+            continue;
+        }
+        /* Expired server addresses are looked up once the alarms are out */
+        checkin();
+        DnsCache_refresh();
+
+        if (!reportNow && !UpSched_routineDue(&plan, NetSched_nowMs())) {
+            continue;
+        }
+        reportNow = false;
+        ok = sendRoutine();
+        if (!Timebase_utcUs(&utc)) {
+            utc = 0;
+        }
+        UpSched_routineDone(&plan, ok, httpSession.retryAfterS,
+                httpSession.nextSlotS, utc / 1000, NetSched_nowMs());
+        if (!ok) {
+            continue;
+        }
+
+        /* Polls ride on the routine wake-up, the radio is up anyway */
+        if (UpSched_pollDue(&plan, NetSched_nowMs())) {
+            ok = pollResources();
+            UpSched_pollDone(&plan, ok, httpSession.retryAfterS,
+                    NetSched_nowMs());
+        }
+        HttpReq_close(&httpSession);
+        checkin();
+        DnsCache_refresh();
+        if (Timebase_syncDue()) {
+            checkin();
+            Timebase_sync();
+        }
+
+        /*
+         *  Asleep, nothing is measured but the first pulse that wakes
+         *  us; so only with the water still and no rule part way
+         *  through its hold time. After a cold boot, not before the
+         *  server has had a first report; a wake-up from hibernate has
+         *  had one already.
+         */
+        if ((reported || (Hibernate_wake() != Hibernate_Wake_COLD)) &&
+                (Alarms_active() == 0) && (Alarms_pending() == 0) &&
+                Totalizer_idle()) {
+            UpSched_suspend(&plan, &saved, NetSched_nowMs());
+            saved.monoMs = Timebase_monoMs();
+            Hibernate_noteSchedule(&saved);
+            Hibernate_request(UpSched_waitMs(&plan, NetSched_nowMs()));
+        }
+    }
+}
+
+/*
+ *  ======== linkFxn ========
+ *  Tracks the IP address for the upload thread.
+ */
+static PT_THREAD(linkFxn(NetSched_Task *task))
+{
+    const uint32_t mask = NETSCHED_EVENT_IP_ACQUIRED |
+            NETSCHED_EVENT_IP_LOST | NETSCHED_EVENT_WLAN_DISCONNECTED;
+
+    PT_BEGIN(&task->pt);
+
+    while (1) {
+        PT_WAIT_UNTIL(&task->pt, (task->events & mask) != 0);
+        if (task->events &
+                (NETSCHED_EVENT_IP_LOST | NETSCHED_EVENT_WLAN_DISCONNECTED)) {
+            ipUp = false;
+        }
+        if (task->events & NETSCHED_EVENT_IP_ACQUIRED) {
+            ipUp = true;
+            sem_post(&wakeSem);
+        }
+        task->events &= ~mask;
+    }
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== Uploader_init ========
+ */
+void Uploader_init(void)
+{
+    pthread_t          thread;
+    pthread_attr_t     pAttrs;
+    struct sched_param priParam;
+
+    sem_init(&wakeSem, 0, 0);
+    UpSched_init(&plan, &schedParams, NetSched_nowMs());
+    NetSched_start(&linkTask, linkFxn, NULL);
+
+    pthread_attr_init(&pAttrs);
+    priParam.sched_priority = UPLOADER_PRIORITY;
+    pthread_attr_setschedparam(&pAttrs, &priParam);
+    pthread_attr_setstacksize(&pAttrs, UPLOADER_STACK_SIZE);
+    pthread_attr_setdetachstate(&pAttrs, PTHREAD_CREATE_DETACHED);
+    pthread_create(&thread, &pAttrs, uploaderThread, NULL);
+}
+
+/*
+ *  ======== Uploader_restore ========
+ *  Runs during boot, before the first link up, while the upload thread
+ *  still waits for its first report.
+ */
+void Uploader_restore(void)
+{
+    Hibernate_Schedule saved;
+
+    if (!Hibernate_lastSchedule(&saved)) {
+        return;
+    }
+    UpSched_resume(&plan, &saved, Timebase_monoMs() - saved.monoMs,
+            NetSched_nowMs());
+
+    /* Its wait was taken from the fresh plan */
+    sem_post(&wakeSem);
+}
+
+/*
+ *  ======== Uploader_urgent ========
+ */
+void Uploader_urgent(void)
+{
+    sem_post(&wakeSem);
+}
+
+/*
+ *  ======== Uploader_reportNow ========
+ */
+void Uploader_reportNow(void)
+{
+    reportNow = true;
+    sem_post(&wakeSem);
+}
+
+/*
+ *  ======== Uploader_requestRaw ========
+ */
+void Uploader_requestRaw(void)
+{
+    rawRequested = true;
+}
+
+/*
+ *  ======== Uploader_getStats ========
+ */
+void Uploader_getStats(Uploader_Stats *out)
+{
+    uintptr_t key;
+
+    key = HwiP_disable();
+    *out = stats;
+    HwiP_restore(key);
+}
+
+/*
+ *  ======== cmdUpload ========
+ */
+static void cmdUpload(Console_Session *session, const Console_Args *args)
+{
+    char                printString[CONSOLE_PRINT_SIZE];
+    Uploader_Stats      s;
+    HttpCache_Resource *res;
+    int                 i;
+
+    if (args->argc > 0) {
+        if (strcmp(args->str[0], "raw") == 0) {
+            Uploader_requestRaw();
+        }
+        else if (strcmp(args->str[0], "now") != 0) {
+            Console_print(session, "Unknown option");
+            return;
+        }
+        Uploader_reportNow();
+        Console_print(session, "Report queued");
+        return;
+    }
+
+    Uploader_getStats(&s);
+    snprintf(printString, sizeof(printString),
+            "routine %lu ok %lu failed, urgent %lu ok %lu failed, "
+            "alarm latency %lu ms (max %lu), last status %d%s",
+            (unsigned long)s.routineOk, (unsigned long)s.routineFailed,
+            (unsigned long)s.urgentOk, (unsigned long)s.urgentFailed,
+            (unsigned long)s.lastAlarmLatencyMs,
+            (unsigned long)s.maxAlarmLatencyMs, s.lastStatus,
+            ipUp ? "" : ", no IP");
+    Console_print(session, printString);
+
+    snprintf(printString, sizeof(printString),
+            "slot offset %lu s, failures in a row: urgent %lu, routine %lu",
+            (unsigned long)(UpSched_offsetMs(&plan, UPLOADER_ROUTINE_MS) /
+                    1000),
+            (unsigned long)plan.urgent.failures,
+            (unsigned long)plan.routine.failures);
+    Console_print(session, printString);
+
+    snprintf(printString, sizeof(printString),
+            "requests %lu (%lu on an open connection), connects %lu, "
+            "header builds %lu, connected %lu ms",
+            (unsigned long)httpSession.stats.requests,
+            (unsigned long)httpSession.stats.reused,
+            (unsigned long)httpSession.stats.connects,
+            (unsigned long)httpSession.stats.headerSets,
+            (unsigned long)httpSession.stats.activeMs);
+    Console_print(session, printString);
+
+    for (i = 0; i < 2; i++) {
+        res = (i == 0) ? &configResource : &manifestResource;
+        snprintf(printString, sizeof(printString),
+                "%s: %lu full, %lu not modified, %lu failed, %lu bytes%s%s",
+                res->uri, (unsigned long)res->full,
+                (unsigned long)res->notModified, (unsigned long)res->failed,
+                (unsigned long)res->bytes, res->valid ? ", etag " : "",
+                res->valid ? res->record.etag : "");
+        Console_print(session, printString);
+    }
+}
+
+CONSOLE_COMMAND(upload, "up", cmdUpload, "s", "[now|raw]",
+                "upload counters, or send a report (with raw rates) now");
@@ -0,0 +1,104 @@
+/*
+ *  ======== uploader.h ========
+ *  Reports to the server.
+ *
+ *  One thread does all HTTP posting, because HTTPClient blocks. It has
+ *  two queues of work:
+ *   - urgent: alarm events (alarms.c). Uploader_urgent() wakes the
+ *     thread at once and urgent work always goes before routine work,
+ *     so an alarm reaches the server within seconds of being raised.
+ *   - routine: a report of the totals and the 15 minute and hourly
+ *     rollups (rollup.c) every UPLOADER_ROUTINE_MS. Raw flow rates are
+ *     only added to the next report after Uploader_requestRaw().
+ *     Every UPLOADER_POLL_MS the routine wake-up also polls the remote
+ *     configuration and the firmware manifest with conditional GETs
+ *     (httpcache.c). A changed configuration is applied at once.
+ *
+ *  The time of the first report after boot, the routine slot, and the
+ *  retry waits come from upsched.c, so a fleet that boots together does
+ *  not report together.
+ *
+ *  After a wake-up from hibernate the device goes back to hibernate
+ *  after a routine report, once the flow has stopped (Totalizer_idle())
+ *  and no alarm is raised or pending. The schedule is kept in
+ *  Hibernate_State, so a timer wake reports at once rather than after
+ *  the first report spread of a cold boot.
+ */
+#ifndef __UPLOADER_H
+#define __UPLOADER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UPLOADER_ROUTINE_URI        "/post"
+#define UPLOADER_ALARM_URI          "/post"
+
+#define UPLOADER_ROUTINE_MS         (15 * 60 * 1000)
+
+/* Remote configuration and firmware manifest, polled with a routine report */
+#define UPLOADER_CONFIG_URI         "/config"
+#define UPLOADER_MANIFEST_URI       "/manifest"
+#define UPLOADER_CONFIG_FILE_NAME   "/flowness/remcfg.bin"
+#define UPLOADER_MANIFEST_FILE_NAME "/flowness/manifest.bin"
+#define UPLOADER_POLL_MS            (60 * 60 * 1000)
+
+/* Routine report after power-up, once the measurement has settled */
+#define UPLOADER_FIRST_REPORT_MS    (30 * 1000)
+
+/* Retry backoff (upsched.h): shortest wait, longest for each kind */
+#define UPLOADER_RETRY_MS           (10 * 1000)
+#define UPLOADER_URGENT_CAP_MS      (5 * 60 * 1000)
+#define UPLOADER_ROUTINE_CAP_MS     (60 * 60 * 1000)
+
+/* Alarm events per request */
+#define UPLOADER_MAX_EVENTS         (8)
+
+#define UPLOADER_BODY_SIZE          (1024)
+
+typedef struct Uploader_Stats {
+    uint32_t    routineOk;
+    uint32_t    routineFailed;
+    uint32_t    urgentOk;
+    uint32_t    urgentFailed;
+    uint32_t    lastAlarmLatencyMs; /* event to server acknowledgement */
+    uint32_t    maxAlarmLatencyMs;
+    int16_t     lastStatus;         /* HTTP status or HTTPClient error */
+} Uploader_Stats;
+
+/*!
+ *  @brief  Start the upload thread
+ */
+extern void Uploader_init(void);
+
+/*!
+ *  @brief  Continue the schedule from before hibernate. Call after
+ *          Uploader_init() and Hibernate_restore().
+ */
+extern void Uploader_restore(void);
+
+/*!
+ *  @brief  Wake the uploader for urgent work. Callable from any thread.
+ */
+extern void Uploader_urgent(void);
+
+/*!
+ *  @brief  Send a routine report as soon as possible
+ */
+extern void Uploader_reportNow(void);
+
+/*!
+ *  @brief  Include the recent raw flow rates in the next routine report
+ */
+extern void Uploader_requestRaw(void);
+
+extern void Uploader_getStats(Uploader_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UPLOADER_H */
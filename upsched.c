@@ -0,0 +1,296 @@
+/*
+ *  ======== upsched.c ========
+ *  Upload slots, per-device jitter and retry backoff
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "upsched.h"
+
+/*
+ *  ======== nextRandom ========
+ *  xorshift32; only spreads retries, nothing depends on its quality.
+ */
+static uint32_t nextRandom(UpSched_Plan *plan)
+{
+    uint32_t x = plan->random;
+
+    if (x == 0) {
+        x = 0x9E3779B9;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    plan->random = x;
+
+    return (x);
+}
+
+/*
+ *  ======== backoffMs ========
+ *  Wait before retrying after a failure.
+ */
+static uint32_t backoffMs(UpSched_Plan *plan, UpSched_Backoff *backoff,
+        uint32_t retryAfterS)
+{
+    uint32_t last = backoff->lastMs;
+    uint32_t wait;
+
+    if (last == 0) {
+        last = backoff->baseMs;
+    }
+    backoff->failures++;
+
+    if (retryAfterS != 0) {
+        /* What the server asked for, plus jitter so retries do not align */
+        if (retryAfterS > UPSCHED_MAX_SLOT_S) {
+            retryAfterS = UPSCHED_MAX_SLOT_S;
+        }
+        wait = retryAfterS * 1000 + nextRandom(plan) % backoff->baseMs;
+    }
+    else {
+        wait = backoff->baseMs +
+                nextRandom(plan) % (last * 3 - backoff->baseMs + 1);
+        if (wait > backoff->capMs) {
+            wait = backoff->capMs;
+        }
+    }
+    backoff->lastMs = wait;
+
+    return (wait);
+}
+
+/*
+ *  ======== reset ========
+ */
+static void reset(UpSched_Backoff *backoff)
+{
+    backoff->lastMs = 0;
+    backoff->failures = 0;
+}
+
+/*
+ *  ======== UpSched_init ========
+ */
+void UpSched_init(UpSched_Plan *plan, const UpSched_Params *params,
+        uint32_t nowMs)
+{
+    memset(plan, 0, sizeof(*plan));
+    plan->periodMs = params->periodMs;
+    plan->pollPeriodMs = params->pollPeriodMs;
+    plan->firstMs = params->firstMs;
+    plan->startMs = nowMs;
+    plan->random = nowMs;
+    plan->nextRoutineMs = nowMs + params->firstMs;
+    plan->nextPollMs = plan->nextRoutineMs;
+    plan->urgent.baseMs = params->retryMs;
+    plan->urgent.capMs = params->urgentCapMs;
+    plan->routine.baseMs = params->retryMs;
+    plan->routine.capMs = params->routineCapMs;
+}
+
+/*
+ *  ======== UpSched_identify ========
+ */
+void UpSched_identify(UpSched_Plan *plan, const uint8_t *id, size_t len)
+{
+    uint32_t hash = 0x811C9DC5;
+    size_t   i;
+
+    /* FNV-1a; neighbouring MAC addresses must land far apart */
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ id[i]) * 0x01000193;
+    }
+    plan->deviceHash = hash;
+    plan->random ^= hash;
+
+    if (!plan->identified) {
+        plan->nextRoutineMs = plan->startMs + plan->firstMs +
+                UpSched_offsetMs(plan, UPSCHED_FIRST_SPREAD_MS);
+        plan->nextPollMs = plan->nextRoutineMs;
+        plan->identified = true;
+    }
+}
+
+/*
+ *  ======== leftMs ========
+ */
+static uint32_t leftMs(uint32_t deadlineMs, uint32_t nowMs)
+{
+    int32_t left = (int32_t)(deadlineMs - nowMs);
+
+    return ((left > 0) ? (uint32_t)left : 0);
+}
+
+/*
+ *  ======== UpSched_suspend ========
+ */
+void UpSched_suspend(const UpSched_Plan *plan, Hibernate_Schedule *saved,
+        uint32_t nowMs)
+{
+    memset(saved, 0, sizeof(*saved));
+    saved->routineInMs = leftMs(plan->nextRoutineMs, nowMs);
+    saved->pollInMs = leftMs(plan->nextPollMs, nowMs);
+    saved->retryInMs = leftMs(plan->retryAtMs, nowMs);
+    saved->deviceHash = plan->deviceHash;
+    saved->random = plan->random;
+    saved->urgentLastMs = plan->urgent.lastMs;
+    saved->urgentFailures = plan->urgent.failures;
+    saved->routineLastMs = plan->routine.lastMs;
+    saved->routineFailures = plan->routine.failures;
+    saved->identified = plan->identified;
+    saved->urgentPending = plan->urgentPending;
+}
+
+/*
+ *  ======== UpSched_resume ========
+ */
+void UpSched_resume(UpSched_Plan *plan, const Hibernate_Schedule *saved,
+        uint32_t elapsedMs, uint32_t nowMs)
+{
+    plan->nextRoutineMs = nowMs + ((saved->routineInMs > elapsedMs) ?
+            saved->routineInMs - elapsedMs : 0);
+    plan->nextPollMs = nowMs + ((saved->pollInMs > elapsedMs) ?
+            saved->pollInMs - elapsedMs : 0);
+    plan->retryAtMs = nowMs + ((saved->retryInMs > elapsedMs) ?
+            saved->retryInMs - elapsedMs : 0);
+    plan->deviceHash = saved->deviceHash;
+    plan->random = saved->random;
+    plan->urgent.lastMs = saved->urgentLastMs;
+    plan->urgent.failures = saved->urgentFailures;
+    plan->routine.lastMs = saved->routineLastMs;
+    plan->routine.failures = saved->routineFailures;
+    plan->identified = saved->identified;
+    plan->urgentPending = saved->urgentPending;
+}
+
+/*
+ *  ======== UpSched_offsetMs ========
+ */
+uint32_t UpSched_offsetMs(const UpSched_Plan *plan, uint32_t periodMs)
+{
+    return (plan->deviceHash % periodMs);
+}
+
+/*
+ *  ======== UpSched_waitMs ========
+ */
+uint32_t UpSched_waitMs(const UpSched_Plan *plan, uint32_t nowMs)
+{
+    int32_t until = (int32_t)(plan->nextRoutineMs - nowMs);
+
+    if (plan->urgentPending &&
+            ((int32_t)(plan->retryAtMs - nowMs) < until)) {
+        until = (int32_t)(plan->retryAtMs - nowMs);
+    }
+
+    return ((until > 0) ? (uint32_t)until : 0);
+}
+
+/*
+ *  ======== UpSched_linkDown ========
+ */
+void UpSched_linkDown(UpSched_Plan *plan, uint32_t nowMs)
+{
+    /* A link up event ends the wait early */
+    if ((int32_t)(plan->nextRoutineMs - nowMs) <= 0) {
+        plan->nextRoutineMs = nowMs + plan->routine.baseMs;
+    }
+    if (plan->urgentPending && ((int32_t)(plan->retryAtMs - nowMs) <= 0)) {
+        plan->retryAtMs = nowMs + plan->urgent.baseMs;
+    }
+}
+
+/*
+ *  ======== UpSched_routineDue ========
+ */
+bool UpSched_routineDue(const UpSched_Plan *plan, uint32_t nowMs)
+{
+    return ((int32_t)(plan->nextRoutineMs - nowMs) <= 0);
+}
+
+/*
+ *  ======== UpSched_pollDue ========
+ */
+bool UpSched_pollDue(const UpSched_Plan *plan, uint32_t nowMs)
+{
+    return ((int32_t)(plan->nextPollMs - nowMs) <= 0);
+}
+
+/*
+ *  ======== UpSched_urgentDone ========
+ */
+void UpSched_urgentDone(UpSched_Plan *plan, bool ok, uint32_t retryAfterS,
+        uint32_t nowMs)
+{
+    if (ok) {
+        plan->urgentPending = false;
+        reset(&plan->urgent);
+    }
+    else {
+        plan->urgentPending = true;
+        plan->retryAtMs = nowMs + backoffMs(plan, &plan->urgent,
+                retryAfterS);
+    }
+}
+
+/*
+ *  ======== UpSched_routineDone ========
+ */
+void UpSched_routineDone(UpSched_Plan *plan, bool ok, uint32_t retryAfterS,
+        uint32_t slotS, int64_t utcMs, uint32_t nowMs)
+{
+    uint32_t phase;
+    uint32_t delay;
+
+    if (!ok) {
+        plan->nextRoutineMs = nowMs + backoffMs(plan, &plan->routine,
+                retryAfterS);
+        return;
+    }
+    reset(&plan->routine);
+
+    if (slotS != 0) {
+        if (slotS < UPSCHED_MIN_SLOT_S) {
+            slotS = UPSCHED_MIN_SLOT_S;
+        }
+        else if (slotS > UPSCHED_MAX_SLOT_S) {
+            slotS = UPSCHED_MAX_SLOT_S;
+        }
+        delay = slotS * 1000;
+    }
+    else if (utcMs == 0) {
+        /* No common clock; keep the phase the first report got */
+        delay = plan->periodMs;
+    }
+    else {
+        phase = (uint32_t)((uint64_t)utcMs % plan->periodMs);
+        delay = (UpSched_offsetMs(plan, plan->periodMs) + plan->periodMs -
+                phase) % plan->periodMs;
+
+        /* Late after retries; skip the slot rather than report twice */
+        if (delay < plan->periodMs / 4) {
+            delay += plan->periodMs;
+        }
+    }
+    plan->nextRoutineMs = nowMs + delay;
+}
+
+/*
+ *  ======== UpSched_pollDone ========
+ */
+void UpSched_pollDone(UpSched_Plan *plan, bool ok, uint32_t retryAfterS,
+        uint32_t nowMs)
+{
+    if (ok) {
+        plan->nextPollMs = nowMs + plan->pollPeriodMs;
+    }
+    else if (retryAfterS != 0) {
+        if (retryAfterS > UPSCHED_MAX_SLOT_S) {
+            retryAfterS = UPSCHED_MAX_SLOT_S;
+        }
+        plan->nextPollMs = nowMs + retryAfterS * 1000;
+    }
+}
@@ -0,0 +1,165 @@
+/*
+ *  ======== upsched.h ========
+ *  When to upload, so that a fleet of meters spreads its load.
+ *
+ *  After a site wide power restore every meter boots at once. To keep
+ *  them from all connecting together:
+ *   - each device has a fixed offset derived from its identity (the MAC
+ *     address). It delays the first report after boot by up to
+ *     UPSCHED_FIRST_SPREAD_MS and, once the wall clock is set, places
+ *     the routine report at that offset into each period of UTC.
+ *     Devices stay spread however long they run.
+ *   - a server that wants a device elsewhere names the next slot in its
+ *     response (see httpreq.h), and the slot is used in place of the
+ *     device's own for the next report.
+ *   - failures back off with decorrelated jitter: each wait is random
+ *     between the base and three times the last wait, capped. A
+ *     Retry-After from the server replaces the computed wait.
+ *
+ *  All state is in an UpSched_Plan and every call takes the current
+ *  time, so the module reads no clock and touches no hardware. The
+ *  caller does the blocking work and reports the outcome; any number of
+ *  plans can be driven from one thread or event loop.
+ *
+ *  A plan outlives hibernate through UpSched_suspend() and
+ *  UpSched_resume(): a warm wake-up keeps its slot and its backoff
+ *  instead of starting over with the first report spread.
+ */
+#ifndef __UPSCHED_H
+#define __UPSCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hibernate.h"
+
+#define UPSCHED_FIRST_SPREAD_MS     (5 * 60 * 1000)
+
+/* Bounds on a server assigned slot */
+#define UPSCHED_MIN_SLOT_S          (60)
+#define UPSCHED_MAX_SLOT_S          (24 * 60 * 60)
+
+typedef struct UpSched_Params {
+    uint32_t    periodMs;           /* routine reports */
+    uint32_t    firstMs;            /* first report after start, least */
+    uint32_t    pollPeriodMs;       /* resource polls, with a report */
+    uint32_t    retryMs;            /* shortest retry wait */
+    uint32_t    urgentCapMs;        /* longest retry waits */
+    uint32_t    routineCapMs;
+} UpSched_Params;
+
+/*!
+ *  @brief  Retry state of one kind of work
+ */
+typedef struct UpSched_Backoff {
+    uint32_t    baseMs;
+    uint32_t    capMs;
+    uint32_t    lastMs;             /* 0 after a success */
+    uint32_t    failures;           /* in a row */
+} UpSched_Backoff;
+
+/*!
+ *  @brief  Schedule of one device. Owned by the caller, see
+ *          UpSched_init().
+ */
+typedef struct UpSched_Plan {
+    uint32_t        periodMs;
+    uint32_t        pollPeriodMs;
+    uint32_t        firstMs;
+    uint32_t        startMs;
+    uint32_t        deviceHash;
+    uint32_t        random;
+    uint32_t        nextRoutineMs;
+    uint32_t        nextPollMs;
+    uint32_t        retryAtMs;
+    bool            identified;     /* first report placed by offset */
+    bool            urgentPending;  /* failed urgent work to retry */
+    UpSched_Backoff urgent;
+    UpSched_Backoff routine;
+} UpSched_Plan;
+
+/*!
+ *  @brief  Start a plan at nowMs
+ */
+extern void UpSched_init(UpSched_Plan *plan, const UpSched_Params *params,
+        uint32_t nowMs);
+
+/*!
+ *  @brief  Give the plan the device identity, e.g. its MAC address,
+ *          and place the first report by the device offset
+ */
+extern void UpSched_identify(UpSched_Plan *plan, const uint8_t *id,
+        size_t len);
+
+/*!
+ *  @brief  Time until the plan has work, 0 if it has some now
+ */
+extern uint32_t UpSched_waitMs(const UpSched_Plan *plan, uint32_t nowMs);
+
+/*!
+ *  @brief  The network is down; push overdue work to a retry
+ */
+extern void UpSched_linkDown(UpSched_Plan *plan, uint32_t nowMs);
+
+extern bool UpSched_routineDue(const UpSched_Plan *plan, uint32_t nowMs);
+
+extern bool UpSched_pollDue(const UpSched_Plan *plan, uint32_t nowMs);
+
+/*!
+ *  @brief  Outcome of the urgent work
+ *
+ *  @param  retryAfterS   Retry-After from the server, or 0
+ */
+extern void UpSched_urgentDone(UpSched_Plan *plan, bool ok,
+        uint32_t retryAfterS, uint32_t nowMs);
+
+/*!
+ *  @brief  Outcome of a routine report
+ *
+ *  @param  slotS   next slot assigned by the server, in seconds from
+ *                  now, or 0 for the device's own slot
+ *  @param  utcMs   wall clock, or 0 if not set
+ */
+extern void UpSched_routineDone(UpSched_Plan *plan, bool ok,
+        uint32_t retryAfterS, uint32_t slotS, int64_t utcMs,
+        uint32_t nowMs);
+
+/*!
+ *  @brief  Outcome of the resource polls. A failed poll is tried again
+ *          with the next report, or after retryAfterS if the server
+ *          asked for that.
+ */
+extern void UpSched_pollDone(UpSched_Plan *plan, bool ok,
+        uint32_t retryAfterS, uint32_t nowMs);
+
+/*!
+ *  @brief  The plan as time left from nowMs, for Hibernate_State. The
+ *          caller sets saved->monoMs.
+ */
+extern void UpSched_suspend(const UpSched_Plan *plan,
+        Hibernate_Schedule *saved, uint32_t nowMs);
+
+/*!
+ *  @brief  Continue a suspended plan elapsedMs after UpSched_suspend().
+ *          Whatever fell due meanwhile is due at once.
+ */
+extern void UpSched_resume(UpSched_Plan *plan,
+        const Hibernate_Schedule *saved, uint32_t elapsedMs,
+        uint32_t nowMs);
+
+/*!
+ *  @brief  The device offset into period
+ */
+extern uint32_t UpSched_offsetMs(const UpSched_Plan *plan,
+        uint32_t periodMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UPSCHED_H */
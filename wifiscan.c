@@ -0,0 +1,239 @@
+/*
+ *  ======== wifiscan.c ========
+ *  Background Wi-Fi scan service with a cached result table
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* POSIX Header files */
+#include <pthread.h>
+
+#include <ti/drivers/net/wifi/simplelink.h>
+
+#include "netsched.h"
+#include "wifiscan.h"
+
+/* Scan interval handed to the NWP scan policy, in seconds */
+#define WIFISCAN_POLICY_INTERVAL_S  (10)
+
+/* Time for one scan cycle over all channels to complete */
+#define WIFISCAN_SETTLE_MS          (1500)
+
+/* Give up collecting results after this many retries */
+#define WIFISCAN_MAX_RETRIES        (5)
+
+/* Results fetched from the NWP per sl_WlanGetNetworkList() call */
+#define WIFISCAN_FETCH_CHUNK        (4)
+
+typedef struct WifiScan_Ctx {
+    NetSched_Task       task;
+    int                 retries;
+    int16_t             fetched;
+    volatile bool       busy;
+} WifiScan_Ctx;
+
+static WifiScan_Ctx     scanCtx;
+
+/* Result cache, guarded by cacheMutex */
+static pthread_mutex_t  cacheMutex;
+static WifiScan_Entry   cache[WIFISCAN_MAX_ENTRIES];
+static int              cacheCount = 0;
+static uint32_t         cacheTime;
+static bool             cacheValid = false;
+
+/* Staging table, only touched by the scan task */
+static WifiScan_Entry   staging[WIFISCAN_MAX_ENTRIES];
+
+/*
+ *  ======== fetchResults ========
+ *  Pull the NWP's result list into the staging table, strongest first.
+ *  Reading the list does not touch the radio, so this is short.
+ */
+static int16_t fetchResults(void)
+{
+    SlWlanNetworkEntry_t netEntries[WIFISCAN_FETCH_CHUNK];
+    WifiScan_Entry       entry;
+    int16_t              count = 0;
+    int16_t              ret;
+    int16_t              i;
+    int16_t              j;
+
+    while (count < WIFISCAN_MAX_ENTRIES) {
+        ret = sl_WlanGetNetworkList(count, WIFISCAN_FETCH_CHUNK, netEntries);
+        if (ret < 0) {
+            return ((count > 0) ? count : ret);
+        }
+
+        for (i = 0; (i < ret) && (count < WIFISCAN_MAX_ENTRIES); i++) {
+            memset(&entry, 0, sizeof(entry));
+            memcpy(entry.ssid, netEntries[i].Ssid,
+                    (netEntries[i].SsidLen < 32) ? netEntries[i].SsidLen : 32);
+            memcpy(entry.bssid, netEntries[i].Bssid, sizeof(entry.bssid));
+            entry.channel = netEntries[i].Channel;
+            entry.rssi = netEntries[i].Rssi;
+            entry.securityInfo = netEntries[i].SecurityInfo;
+
+            /* Insertion sort on RSSI; the table is tiny */
+            for (j = count; (j > 0) && (staging[j - 1].rssi < entry.rssi); j--) {
+                staging[j] = staging[j - 1];
+            }
+            staging[j] = entry;
+            count++;
+        }
+
+        if (ret < WIFISCAN_FETCH_CHUNK) {
+            break;
+        }
+    }
+
+    return (count);
+}
+
+/*
+ *  ======== setScanPolicy ========
+ */
+static int16_t setScanPolicy(bool enable)
+{
+    uint32_t intervalInSeconds = WIFISCAN_POLICY_INTERVAL_S;
+
+    if (enable) {
+        return (sl_WlanPolicySet(SL_WLAN_POLICY_SCAN, SL_WLAN_SCAN_POLICY(1, 0),
+                (_u8 *)&intervalInSeconds, sizeof(intervalInSeconds)));
+    }
+
+    return (sl_WlanPolicySet(SL_WLAN_POLICY_SCAN, SL_WLAN_SCAN_POLICY(0, 0),
+            NULL, 0));
+}
+
+/*
+ *  ======== scanFxn ========
+ */
+static PT_THREAD(scanFxn(NetSched_Task *task))
+{
+    WifiScan_Ctx *ctx = (WifiScan_Ctx *)task->arg;
+
+    PT_BEGIN(&task->pt);
+
+    while (1) {
+        NETSCHED_WAIT_EVENT(task, NETSCHED_EVENT_SCAN_REQUEST);
+        ctx->busy = true;
+
+        if (setScanPolicy(true) < 0) {
+            ctx->busy = false;
+            continue;
+        }
+
+        /* Results trickle in; retry while the NWP has none yet */
+        for (ctx->retries = 0; ctx->retries < WIFISCAN_MAX_RETRIES;
+                ctx->retries++) {
+            NETSCHED_SLEEP(task, WIFISCAN_SETTLE_MS);
+            ctx->fetched = fetchResults();
+            if (ctx->fetched > 0) {
+                break;
+            }
+        }
+
+        /* Background scanning costs power; only scan on demand */
+        setScanPolicy(false);
+
+        if (ctx->fetched >= 0) {
+            pthread_mutex_lock(&cacheMutex);
+            memcpy(cache, staging, ctx->fetched * sizeof(WifiScan_Entry));
+            cacheCount = ctx->fetched;
+            cacheTime = NetSched_nowMs();
+            cacheValid = true;
+            pthread_mutex_unlock(&cacheMutex);
+        }
+
+        /* Requests that arrived while scanning are served by this scan */
+        NetSched_clearEvents(task, NETSCHED_EVENT_SCAN_REQUEST);
+        ctx->busy = false;
+        NetSched_signal(NETSCHED_EVENT_SCAN_DONE);
+    }
+
+    PT_END(&task->pt);
+}
+
+/*
+ *  ======== WifiScan_init ========
+ */
+void WifiScan_init(void)
+{
+    pthread_mutex_init(&cacheMutex, NULL);
+    NetSched_start(&scanCtx.task, scanFxn, &scanCtx);
+}
+
+/*
+ *  ======== WifiScan_request ========
+ */
+void WifiScan_request(void)
+{
+    NetSched_signal(NETSCHED_EVENT_SCAN_REQUEST);
+}
+
+/*
+ *  ======== WifiScan_busy ========
+ */
+bool WifiScan_busy(void)
+{
+    return (scanCtx.busy);
+}
+
+/*
+ *  ======== WifiScan_count ========
+ */
+int WifiScan_count(uint32_t *ageMs)
+{
+    int count;
+
+    pthread_mutex_lock(&cacheMutex);
+    count = cacheCount;
+    if (ageMs != NULL) {
+        *ageMs = cacheValid ? (NetSched_nowMs() - cacheTime) : UINT32_MAX;
+    }
+    pthread_mutex_unlock(&cacheMutex);
+
+    return (count);
+}
+
+/*
+ *  ======== WifiScan_get ========
+ */
+bool WifiScan_get(int index, WifiScan_Entry *entry)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&cacheMutex);
+    if ((index >= 0) && (index < cacheCount)) {
+        *entry = cache[index];
+        found = true;
+    }
+    pthread_mutex_unlock(&cacheMutex);
+
+    return (found);
+}
+
+/*
+ *  ======== WifiScan_findBest ========
+ *  The cache is sorted by RSSI, so the first match is the strongest.
+ */
+bool WifiScan_findBest(const char *ssid, WifiScan_Entry *entry)
+{
+    bool found = false;
+    int  i;
+
+    pthread_mutex_lock(&cacheMutex);
+    if (cacheValid && ((NetSched_nowMs() - cacheTime) < WIFISCAN_MAX_AGE_MS)) {
+        for (i = 0; i < cacheCount; i++) {
+            if (strcmp(cache[i].ssid, ssid) == 0) {
+                *entry = cache[i];
+                found = true;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&cacheMutex);
+
+    return (found);
+}
@@ -0,0 +1,82 @@
+/*
+ *  ======== wifiscan.h ========
+ *  Background Wi-Fi scan service with a cached result table.
+ *
+ *  Scans are triggered through the NWP scan policy and the results are
+ *  collected by a task on the network scheduler, so callers never block
+ *  on the radio. Readers (the console, the connection manager) only ever
+ *  look at the cache.
+ */
+#ifndef __WIFISCAN_H
+#define __WIFISCAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Size of the cached result table */
+#define WIFISCAN_MAX_ENTRIES        (20)
+
+/* Results older than this are refreshed on the next request */
+#define WIFISCAN_MAX_AGE_MS         (60000)
+
+/* Entries printed per 'l' console command */
+#define WIFISCAN_PAGE_SIZE          (5)
+
+/*!
+ *  @brief  One cached scan result
+ */
+typedef struct WifiScan_Entry {
+    char        ssid[33];       /* NUL terminated */
+    uint8_t     bssid[6];
+    uint8_t     channel;
+    int8_t      rssi;
+    uint16_t    securityInfo;   /* SL_WLAN_SCAN_RESULT_* bitmaps */
+} WifiScan_Entry;
+
+/*!
+ *  @brief  Register the scan task with the network scheduler
+ */
+extern void WifiScan_init(void);
+
+/*!
+ *  @brief  Ask for a fresh scan. Returns immediately; the cache is
+ *          replaced and NETSCHED_EVENT_SCAN_DONE posted when done.
+ */
+extern void WifiScan_request(void);
+
+/*!
+ *  @brief  True while a scan is in progress
+ */
+extern bool WifiScan_busy(void);
+
+/*!
+ *  @brief  Number of cached entries
+ *
+ *  @param  ageMs   If not NULL, receives the age of the cache in ms
+ *                  (UINT32_MAX when nothing has been scanned yet)
+ */
+extern int WifiScan_count(uint32_t *ageMs);
+
+/*!
+ *  @brief  Copy out cached entry index (0 = strongest)
+ *
+ *  @return true if index is valid
+ */
+extern bool WifiScan_get(int index, WifiScan_Entry *entry);
+
+/*!
+ *  @brief  Strongest fresh cached entry advertising ssid
+ *
+ *  @return true if one was found
+ */
+extern bool WifiScan_findBest(const char *ssid, WifiScan_Entry *entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WIFISCAN_H */